@@ -56,6 +56,8 @@ SSE.
 
 #include "config.h"
 #include "6301.h"
+#include "input_queue.h"
+#include "core_channel.h"
 
 #pragma GCC diagnostic ignored "-Wimplicit-function-declaration"
 
@@ -101,11 +103,12 @@ int crashed = 0;
 #include "sci.c"
 #include "timer.c"
 #include "callstac.c"
+#include "watch.c"
 
 // Interface with Steem
 
-// Global flag for external reset trigger (e.g. from keyboard shortcut)
-static volatile int pending_reset = 0;
+// Emulation speed multiplier, set from the console on Core 0 (cc word)
+static uint32_t overclock = HD6301_OVERCLOCK_NUM;
 
 #include "pico/platform.h"
 
@@ -127,6 +130,9 @@ int __not_in_flash_func(hd6301_reset)(int Cold) {
   TRACE("6301 emu cpu reset (cold %d)\n",Cold);
   crashed = 0;
   cpu_reset();
+#if ENABLE_INPUT_QUEUE
+  iq_reset(); // ncycles restarts from 0
+#endif
   if(Cold)
   {
     WORD rnd=rand()%16;
@@ -147,27 +153,13 @@ int __not_in_flash_func(hd6301_reset)(int Cold) {
   TRACE("6301: Serial registers cleared (TRCSR=0x20, RDR=0x00, TDR=0x00)\n");
 }
 
-void __not_in_flash_func(hd6301_trigger_reset)() {
-  // Called from external source (e.g. keyboard handler) to trigger a reset
-  TRACE("6301: Reset triggered externally\n");
-  pending_reset = 1;
-}
-
  
 void __not_in_flash_func(hd6301_run_clocks)(COUNTER_VAR clocks) {
-  clocks *= HD6301_OVERCLOCK_NUM;
+  clocks *= cc_get(&overclock);
   // Called by Steem to run some cycles (per scanline or to update before IO)
   int pc;
   COUNTER_VAR starting_cycles=cpu.ncycles;
 
-  // Check for pending reset request (e.g. from keyboard shortcut)
-  if (pending_reset) {
-    TRACE("6301: Executing pending reset\n");
-    pending_reset = 0;
-    hd6301_reset(1);  // Cold reset
-    return;  // Don't run cycles this iteration
-  }
-
   // make sure our 6301 is running OK
   if(!cpu_isrunning())
   {
@@ -181,10 +173,21 @@ void __not_in_flash_func(hd6301_run_clocks)(COUNTER_VAR clocks) {
   }
   pc=reg_getpc();
 
+#if ENABLE_INPUT_QUEUE
+  // Input changes land between instructions at their emulated time
+  iq_poll(cpu.ncycles);
+  while(!crashed && ((cpu.ncycles-starting_cycles) < clocks))
+  {
+    if(cpu.ncycles>=iq_due)
+      iq_service(cpu.ncycles);
+    instr_exec (); // execute one instruction
+  }
+#else
   while(!crashed && ((cpu.ncycles-starting_cycles) < clocks))
   {
     instr_exec (); // execute one instruction
   }
+#endif
 }
 
 int __not_in_flash_func(hd6301_receive_byte)(u_char byte_in) {
@@ -206,3 +209,34 @@ int __not_in_flash_func(hd6301_sci_busy)() {
 uint16_t __not_in_flash_func(hd6301_get_pc)(void) {
   return reg_getpc();
 }
+
+void hd6301_set_overclock(int mult) {
+  if (mult > 0)
+    cc_put(&overclock, (uint32_t)mult);
+}
+
+int hd6301_get_overclock(void) {
+  return (int)cc_get(&overclock);
+}
+
+BYTE hd6301_peek(WORD addr) {
+  // Internal registers straight from iram[] so peeking RDR/TRCSR does not
+  // clear status flags the ROM is waiting on
+  if (addr < NIREGS)
+    return iram[addr];
+  if (addr >= 0xF000)
+    return ram[addr-0xF000+256];
+  if (addr >= 0x80 && addr < 256)
+    return ram[addr];
+  return 0xFF;
+}
+
+void hd6301_print_state(void) {
+  // Core 1 keeps running, so this is a snapshot rather than a consistent state
+  printf("PC=%04x A=%02x B=%02x X=%04x SP=%04x CCR=%02x cycles=%lld%s\n",
+    reg_getpc(), reg_getacca(), reg_getaccb(), reg_getix(), reg_getsp(),
+    reg_getccr(), (long long)cpu_getncycles(), crashed ? " CRASHED" : "");
+  printf("P1=%02x P2=%02x P3=%02x P4=%02x TCSR=%02x RMCR=%02x TRCSR=%02x RDR=%02x\n",
+    iram[P1], iram[P2], iram[P3], iram[P4], iram[TCSR], iram[RMCR],
+    iram[TRCSR], iram[RDR]);
+}
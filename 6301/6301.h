@@ -79,12 +79,37 @@ extern COUNTER_VAR cycles_run;
 BYTE* hd6301_init();
 int hd6301_destroy(); // like a C++ destructor
 int hd6301_reset(int Cold); 
-void hd6301_trigger_reset(); // Trigger reset from external source (e.g. keyboard)
 void hd6301_run_clocks(COUNTER_VAR clocks);
 int hd6301_receive_byte(u_char byte_in); // just passing through
 void hd6301_tx_empty(int empty);
 int hd6301_sci_busy();
 uint16_t hd6301_get_pc(void);
+void hd6301_set_overclock(int mult); // runtime HD6301_OVERCLOCK_NUM
+int hd6301_get_overclock(void);
+BYTE hd6301_peek(WORD addr); // side-effect free read for the console
+void hd6301_print_state(void); // registers and SCI/port state to stdout
+
+// Watchpoints on RAM and internal registers (HD6301_WATCHPOINTS builds)
+#define HD6301_WATCH_READ   0x01 // trigger on ROM reads
+#define HD6301_WATCH_WRITE  0x02 // trigger on ROM writes
+#define HD6301_WATCH_VALUE  0x04 // only when (value & mask) == match
+#define HD6301_WATCH_LOG    0x08 // record each hit in the ring, else count only
+
+typedef struct {
+  COUNTER_VAR cycles;   // cpu.ncycles at the access
+  WORD addr;
+  WORD pc;              // PC after the opcode/operand fetch
+  BYTE value;           // value read or written
+  BYTE access;          // HD6301_WATCH_READ or HD6301_WATCH_WRITE
+  BYTE slot;
+} hd6301_watch_hit_t;
+
+int hd6301_watch_set(WORD addr, BYTE flags, BYTE match, BYTE mask); // slot or -1
+int hd6301_watch_clear(int slot);
+void hd6301_watch_clear_all(void);
+uint32_t hd6301_watch_hits(int slot);
+int hd6301_watch_pop_hit(hd6301_watch_hit_t* hit); // 1 if a hit was returned
+void hd6301_watch_print(void);
 
 #define MOUSE_MASK 0x33333333 // 20bit on real HW?
 
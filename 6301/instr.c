@@ -94,7 +94,7 @@ void __not_in_flash_func(instr_exec)() {
     }
 #endif
 
-    opptr = &opcodetab [mem_getb (reg_getpc ())];
+    opptr = &opcodetab [mem_fetchb (reg_getpc ())];
     reg_incpc (1);
     (*opptr->op_func) ();
   }
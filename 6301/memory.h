@@ -17,6 +17,7 @@
 #include "defs.h"   /* general definitions */
 #include "chip.h"   /* chip specific: NIREGS */
 #include "ireg.h"   /* chip specific: ireg_getb/putb_func[], ireg_start/end */
+#include "watch.h"  /* watch_page_armed[], watch_getb/putb */
 
 #define MEMSIZE 65536   /* Size of ram and breakpoint arrays */
 /*
@@ -30,10 +31,10 @@ extern u_int  ram_end;  /* Last valid RAM address */
 extern u_char  *ram;    /* Physical storage for simulated RAM */
 
 /*
- *  mem_getb - called to get a byte from an address
+ *  mem_getb_nowatch - decode a read without watchpoint checks
  */
 static u_char
-mem_getb (addr)
+mem_getb_nowatch (addr)
   u_int addr;
 {
   int offs = addr - ireg_start;
@@ -67,6 +68,20 @@ mem_getb (addr)
   }
 }
 
+/*
+ *  mem_getb - called to get a byte from an address
+ */
+static u_char
+mem_getb (addr)
+  u_int addr;
+{
+#if HD6301_WATCHPOINTS
+  if (watch_page_armed[(addr >> 8) & 0xFF])
+    return watch_getb (addr);
+#endif
+  return mem_getb_nowatch (addr);
+}
+
 static u_short
 mem_getw (addr)
   u_int addr;
@@ -78,10 +93,44 @@ mem_getw (addr)
 }
 
 /*
- * mem_putb - called to write a byte to an address
+ *  mem_fetchb - read an instruction byte (opcode or operand at PC)
+ *
+ *  Code runs from the mask ROM at F000-FFFF, or from internal RAM at
+ *  0080-00FF when the ST uploads a routine with the IKBD memory load
+ *  command (0x20) and starts it with controller execute (0x22). Both are
+ *  read straight from ram[], so a fetch costs the same in either. Nothing
+ *  is cached: self-modifying code sees its own stores on the next fetch.
+ *  Any other PC takes the full mem_getb decode.
+ */
+static u_char
+mem_fetchb (addr)
+  u_int addr;
+{
+#if HD6301_WATCHPOINTS
+  if (watch_page_armed[(addr >> 8) & 0xFF])
+    return watch_getb (addr);
+#endif
+  if (addr - 0xF000 < 0x1000)
+    return ram[addr - 0xF000 + 256];
+  if (addr - 0x80 < 0x80)
+    return ram[addr];
+  return mem_getb_nowatch (addr);
+}
+
+static u_short
+mem_fetchw (addr)
+  u_int addr;
+{
+  u_char hi = mem_fetchb (addr);
+  u_char lo = mem_fetchb (addr + 1);
+  return (hi << 8) | lo;
+}
+
+/*
+ * mem_putb_nowatch - decode a write without watchpoint checks
  */ 
 static void
-mem_putb (addr, value)
+mem_putb_nowatch (addr, value)
   u_int   addr;
   u_char  value;
 {
@@ -112,6 +161,23 @@ mem_putb (addr, value)
   }
 }
 
+/*
+ * mem_putb - called to write a byte to an address
+ */
+static void
+mem_putb (addr, value)
+  u_int   addr;
+  u_char  value;
+{
+#if HD6301_WATCHPOINTS
+  if (watch_page_armed[(addr >> 8) & 0xFF]) {
+    watch_putb (addr, value);
+    return;
+  }
+#endif
+  mem_putb_nowatch (addr, value);
+}
+
 static void
 mem_putw (addr, value)
   u_int addr;
@@ -42,25 +42,25 @@
  * Functions returning a memory address
  */
 #if defined(NDEBUG)
-getaddr_dir ()  {return mem_getb (reg_postincpc (1));}
+getaddr_dir ()  {return mem_fetchb (reg_postincpc (1));}
 #else
 getaddr_dir ()  {
   int operand_addr=reg_postincpc(1);
-  int addr=mem_getb (operand_addr);
+  int addr=mem_fetchb (operand_addr);
   return addr;
 }
 #endif
-getaddr_ext ()  {return mem_getw (reg_postincpc (2));}
-getaddr_ix  ()  {return (mem_getb (reg_postincpc (1)) + reg_getix()) & 0xffff;}
+getaddr_ext ()  {return mem_fetchw (reg_postincpc (2));}
+getaddr_ix  ()  {return (mem_fetchb (reg_postincpc (1)) + reg_getix()) & 0xffff;}
 
 /*
  * Functions returning the value of a memory address
  */
-u_char getbyte_imm () {return mem_getb (reg_postincpc (1));}
+u_char getbyte_imm () {return mem_fetchb (reg_postincpc (1));}
 u_char getbyte_dir () {return mem_getb (getaddr_dir ());}
 u_char getbyte_ext () {return mem_getb (getaddr_ext ());}
 u_char getbyte_ix  () {return mem_getb (getaddr_ix  ());}
-u_short getword_imm () {return mem_getw (reg_postincpc (2));}
+u_short getword_imm () {return mem_fetchw (reg_postincpc (2));}
 #if defined(NDEBUG)
 u_short getword_dir () {return mem_getw (getaddr_dir ());}
 #else
@@ -617,7 +617,7 @@ slp_inh ()
 /*
  * Functions returning a memory address
  */
-getaddr_iy  ()  {return (mem_getb (reg_postincpc (1)) + reg_getiy ()) & 0xffff;}
+getaddr_iy  ()  {return (mem_fetchb (reg_postincpc (1)) + reg_getiy ()) & 0xffff;}
 
 /*
  * Functions returning the value of a memory address
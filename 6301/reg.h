@@ -54,6 +54,17 @@ struct regs {
 
 extern struct regs regs;
 
+#if defined(__STDC__) || defined(__cplusplus)
+# define P_(s) s
+#else
+# define P_(s) ()
+#endif
+
+/* reg.c; the stack helpers below call it */
+extern int reg_setsp P_((u_int value));
+
+#undef P_
+
 /*
  * The get/setccr() are normally mostly used when interrupt occurs
  */
@@ -0,0 +1,223 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <stdio.h>
+
+#include "defs.h"
+#include "cpu.h"
+#include "reg.h"
+#include "memory.h"
+#include "watch.h"
+#include "6301.h"
+#include "pico/platform.h"
+#include "core_channel.h"
+
+/*
+ * Watchpoints are armed from Core 0 (console, host code) while Core 1 is
+ * running the ROM. A slot is disarmed by clearing its flags before any other
+ * field changes and re-armed by writing the flags last, so Core 1 never acts
+ * on a half-written slot. The hit ring has a single producer (Core 1, from
+ * mem_getb/mem_putb) and a single consumer (hd6301_watch_pop_hit).
+ *
+ * Useful ROM addresses:
+ *   $00-$14  internal registers (P2 buttons, P4 joystick, TRCSR, RDR, TDR)
+ *   $D5-$D7  TX queue pointers
+ */
+
+#if HD6301_WATCHPOINTS
+
+struct watchpoint {
+  volatile u_char flags;  /* HD6301_WATCH_*, 0 = slot free */
+  u_short addr;
+  u_char  match;
+  u_char  mask;
+  volatile uint32_t hits;
+};
+
+static struct watchpoint watch_slots[WATCH_MAX];
+static hd6301_watch_hit_t watch_ring[WATCH_RING_SIZE];
+static cc_spsc_t watch_chan;  /* Core 1 logs hits, the console on Core 0 pops */
+static volatile uint32_t watch_ring_dropped = 0;
+
+volatile u_char watch_page_armed[256];
+
+/*
+ * watch_rebuild_pages - recompute the per-page armed flags from the slots
+ */
+static void
+watch_rebuild_pages (void)
+{
+  u_char pages[256] = {0};
+  int i;
+
+  for (i = 0; i < WATCH_MAX; i++)
+    if (watch_slots[i].flags)
+      pages[watch_slots[i].addr >> 8] = 1;
+  for (i = 0; i < 256; i++)
+    watch_page_armed[i] = pages[i];
+  __sync_synchronize ();
+}
+
+static void __not_in_flash_func(watch_check)(u_int addr, u_char value, u_char access)
+{
+  int i;
+
+  for (i = 0; i < WATCH_MAX; i++) {
+    struct watchpoint *wp = &watch_slots[i];
+    u_char flags = wp->flags;
+
+    if (!(flags & access) || wp->addr != addr)
+      continue;
+    if ((flags & HD6301_WATCH_VALUE) && ((value & wp->mask) != wp->match))
+      continue;
+
+    wp->hits++;
+    if (flags & HD6301_WATCH_LOG) {
+      if (cc_spsc_space (&watch_chan, WATCH_RING_SIZE) == 0) {
+        watch_ring_dropped++;
+      } else {
+        hd6301_watch_hit_t *hit = &watch_ring[cc_spsc_head (&watch_chan) & (WATCH_RING_SIZE - 1)];
+        hit->cycles = cpu_getncycles ();
+        hit->addr = addr;
+        hit->pc = reg_getpc ();
+        hit->value = value;
+        hit->access = access;
+        hit->slot = i;
+        cc_spsc_push (&watch_chan);
+      }
+    }
+  }
+}
+
+u_char __not_in_flash_func(watch_getb)(u_int addr)
+{
+  u_char value = mem_getb_nowatch (addr);
+  watch_check (addr, value, HD6301_WATCH_READ);
+  return value;
+}
+
+void __not_in_flash_func(watch_putb)(u_int addr, u_char value)
+{
+  watch_check (addr, value, HD6301_WATCH_WRITE);
+  mem_putb_nowatch (addr, value);
+}
+
+int hd6301_watch_set(WORD addr, BYTE flags, BYTE match, BYTE mask) {
+  int i;
+
+  if (!(flags & (HD6301_WATCH_READ | HD6301_WATCH_WRITE)))
+    return -1;
+  for (i = 0; i < WATCH_MAX; i++) {
+    if (!watch_slots[i].flags) {
+      watch_slots[i].addr = addr;
+      watch_slots[i].match = match;
+      watch_slots[i].mask = mask;
+      watch_slots[i].hits = 0;
+      __sync_synchronize ();
+      watch_slots[i].flags = flags;
+      watch_rebuild_pages ();
+      return i;
+    }
+  }
+  return -1;
+}
+
+int hd6301_watch_clear(int slot) {
+  if (slot < 0 || slot >= WATCH_MAX || !watch_slots[slot].flags)
+    return -1;
+  watch_slots[slot].flags = 0;
+  watch_rebuild_pages ();
+  return 0;
+}
+
+void hd6301_watch_clear_all(void) {
+  int i;
+
+  for (i = 0; i < WATCH_MAX; i++)
+    watch_slots[i].flags = 0;
+  watch_rebuild_pages ();
+  cc_spsc_pop_to (&watch_chan, cc_spsc_tail (&watch_chan) + cc_spsc_count (&watch_chan));
+  watch_ring_dropped = 0;
+}
+
+uint32_t hd6301_watch_hits(int slot) {
+  if (slot < 0 || slot >= WATCH_MAX)
+    return 0;
+  return watch_slots[slot].hits;
+}
+
+int hd6301_watch_pop_hit(hd6301_watch_hit_t *hit) {
+  if (cc_spsc_count (&watch_chan) == 0)
+    return 0;
+  *hit = watch_ring[cc_spsc_tail (&watch_chan) & (WATCH_RING_SIZE - 1)];
+  cc_spsc_pop (&watch_chan);
+  return 1;
+}
+
+void hd6301_watch_print(void) {
+  hd6301_watch_hit_t hit;
+  int i;
+
+  for (i = 0; i < WATCH_MAX; i++) {
+    struct watchpoint *wp = &watch_slots[i];
+    if (!wp->flags)
+      continue;
+    printf ("watch %d: %04x %c%c", i, wp->addr,
+      (wp->flags & HD6301_WATCH_READ) ? 'r' : '-',
+      (wp->flags & HD6301_WATCH_WRITE) ? 'w' : '-');
+    if (wp->flags & HD6301_WATCH_VALUE)
+      printf (" =%02x/%02x", wp->match, wp->mask);
+    printf ("%s hits=%lu\n", (wp->flags & HD6301_WATCH_LOG) ? " log" : "",
+      (unsigned long)wp->hits);
+  }
+  while (hd6301_watch_pop_hit (&hit))
+    printf ("  [%d] %c %04x=%02x pc=%04x cyc=%lld\n", hit.slot,
+      (hit.access & HD6301_WATCH_WRITE) ? 'w' : 'r',
+      hit.addr, hit.value, hit.pc, (long long)hit.cycles);
+  if (watch_ring_dropped) {
+    printf ("  (%lu hits dropped, ring full)\n", (unsigned long)watch_ring_dropped);
+    watch_ring_dropped = 0;
+  }
+}
+
+#else /* !HD6301_WATCHPOINTS */
+
+int hd6301_watch_set(WORD addr, BYTE flags, BYTE match, BYTE mask) {
+  return -1;
+}
+
+int hd6301_watch_clear(int slot) {
+  return -1;
+}
+
+void hd6301_watch_clear_all(void) {
+}
+
+uint32_t hd6301_watch_hits(int slot) {
+  return 0;
+}
+
+int hd6301_watch_pop_hit(hd6301_watch_hit_t *hit) {
+  return 0;
+}
+
+void hd6301_watch_print(void) {
+  printf ("watchpoints not built (HD6301_WATCHPOINTS=0)\n");
+}
+
+#endif /* HD6301_WATCHPOINTS */
@@ -0,0 +1,60 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ *  Memory and internal register watchpoints
+ *
+ *  mem_getb/mem_putb test one byte of watch_page_armed[] per access and
+ *  only divert to watch_getb/watch_putb when a watchpoint is armed in the
+ *  256 byte page being accessed. With nothing armed the table is all zero
+ *  and the diversion is never taken. Compiled out entirely when
+ *  HD6301_WATCHPOINTS is 0.
+ */
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "defs.h"
+
+#ifndef HD6301_WATCHPOINTS
+#define HD6301_WATCHPOINTS 0
+#endif
+
+#define WATCH_MAX       8   /* Simultaneously armed watchpoints */
+#define WATCH_RING_SIZE 32  /* Logged hits kept for the console (power of 2) */
+
+#if HD6301_WATCHPOINTS
+
+/* Non-zero for each 256 byte page holding at least one armed watchpoint */
+extern volatile u_char watch_page_armed[256];
+
+#if defined(__STDC__) || defined(__cplusplus)
+# define P_(s) s
+#else
+# define P_(s) ()
+#endif
+
+/* watch.c */
+extern u_char watch_getb P_((u_int addr));
+extern void   watch_putb P_((u_int addr, u_char value));
+
+#undef P_
+
+#endif /* HD6301_WATCHPOINTS */
+
+#endif /* WATCH_H */
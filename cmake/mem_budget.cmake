@@ -0,0 +1,91 @@
+# Atari ST RP2040 IKDB Emulator
+# Copyright (C) 2021 Roy Hopkins
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+# Static RAM budget check, run after linking:
+#   cmake -DELF=<file> -DSIZE_TOOL=<size> -DNM_TOOL=<nm>
+#         -DRAM_ORIGIN=<addr> -DRAM_LENGTH=<bytes> -DRAM_BUDGET=<bytes>
+#         -P mem_budget.cmake
+#
+# Prints every section placed in main RAM (this includes code in copy_to_ram
+# builds) and the largest RAM objects, then fails if the sections add up to
+# more than RAM_BUDGET. Whatever is left of RAM_LENGTH goes to heap and the
+# core 0 stack.
+
+foreach(var ELF SIZE_TOOL NM_TOOL RAM_ORIGIN RAM_LENGTH RAM_BUDGET)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "mem_budget: ${var} not set")
+    endif()
+endforeach()
+
+math(EXPR ram_start "${RAM_ORIGIN}")
+math(EXPR ram_end "${ram_start} + ${RAM_LENGTH}")
+
+execute_process(
+    COMMAND ${SIZE_TOOL} -A -d ${ELF}
+    OUTPUT_VARIABLE size_out
+    RESULT_VARIABLE size_rc
+)
+if(NOT size_rc EQUAL 0)
+    message(FATAL_ERROR "mem_budget: ${SIZE_TOOL} failed on ${ELF}")
+endif()
+
+set(total 0)
+set(table "")
+string(REPLACE "\n" ";" size_lines "${size_out}")
+foreach(line IN LISTS size_lines)
+    if(line MATCHES "^(\\.[A-Za-z0-9_.]+)[ \t]+([0-9]+)[ \t]+([0-9]+)")
+        set(name ${CMAKE_MATCH_1})
+        set(bytes ${CMAKE_MATCH_2})
+        set(addr ${CMAKE_MATCH_3})
+        if(bytes GREATER 0 AND NOT addr LESS ram_start AND addr LESS ram_end)
+            math(EXPR total "${total} + ${bytes}")
+            string(APPEND table "  ${name}\t${bytes}\n")
+        endif()
+    endif()
+endforeach()
+
+# Largest .data/.bss objects; nm sorts ascending, so keep the tail
+execute_process(
+    COMMAND ${NM_TOOL} -S --size-sort -t d ${ELF}
+    OUTPUT_VARIABLE nm_out
+)
+set(objects "")
+string(REPLACE "\n" ";" nm_lines "${nm_out}")
+foreach(line IN LISTS nm_lines)
+    if(line MATCHES "^[0-9]+ ([0-9]+) [bBdD] (.+)$")
+        math(EXPR bytes "${CMAKE_MATCH_1}")
+        list(APPEND objects "  ${CMAKE_MATCH_2}\t${bytes}")
+    endif()
+endforeach()
+list(LENGTH objects object_count)
+if(object_count GREATER 12)
+    math(EXPR first "${object_count} - 12")
+    list(SUBLIST objects ${first} 12 objects)
+endif()
+list(REVERSE objects)
+string(REPLACE ";" "\n" objects "${objects}")
+
+math(EXPR headroom "${RAM_BUDGET} - ${total}")
+message("RAM budget (${ELF}):\n"
+        "${table}"
+        "  total\t${total} of ${RAM_BUDGET} (${headroom} spare, ${RAM_LENGTH} RAM)\n"
+        "Largest RAM objects:\n"
+        "${objects}")
+
+if(total GREATER RAM_BUDGET)
+    message(FATAL_ERROR "mem_budget: static RAM ${total} exceeds RAM_BUDGET ${RAM_BUDGET}")
+endif()
@@ -62,9 +62,10 @@ private:
     absolute_time_t last_x_us;
     absolute_time_t last_y_us;
 
-    // The mouse registers (Core 0 writes, Core 1 reads via mouse_tick)
-    volatile unsigned int x_reg;
-    volatile unsigned int y_reg;
+    // The mouse registers (cc words: Core 0 writes, Core 1 reads via mouse_tick).
+    // The axes are independent encoders, so they need no common snapshot.
+    uint32_t x_reg;
+    uint32_t y_reg;
 };
 
 extern "C" {
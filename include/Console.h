@@ -0,0 +1,65 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CONSOLE_LINE_MAX    64
+#define CONSOLE_MAX_ARGS    8
+#define CONSOLE_POLL_CHARS  32  // Max characters consumed per poll() (UART0 FIFO depth)
+
+/**
+ * Line-oriented command shell on the UART0 debug console.
+ * Type "help" for the command list.
+ */
+class Console {
+private:
+    Console() = default;
+
+public:
+    static Console& instance();
+
+    /**
+     * Consume pending UART0 input without blocking. A completed line is
+     * executed before returning, so call this from the main loop only.
+     */
+    void poll();
+
+    /**
+     * Parse and run one command line (modified in place).
+     * Returns false if the command was unknown or its arguments invalid.
+     */
+    bool execute(char* line);
+
+    /**
+     * Split line in place on spaces/tabs. Returns the number of arguments.
+     */
+    static int tokenize(char* line, char* argv[], int max_args);
+
+    /**
+     * Parse a decimal, 0x-prefixed or $-prefixed hex integer, optionally
+     * negative. Returns false on any trailing garbage or overflow.
+     */
+    static bool parse_int(const char* s, int32_t& out);
+
+private:
+    char    line[CONSOLE_LINE_MAX];
+    size_t  len = 0;
+};
@@ -25,6 +25,7 @@
 #include <vector>
 #include <atomic>
 #include "UserInterface.h"
+#include "joy_arbiter.h"
 
 class HidInputException: public std::runtime_error {
 public:
@@ -69,8 +70,12 @@ private:
     bool get_gamecube_joystick(int joystick_num, uint8_t& axis, uint8_t& button);
     bool get_switch_joystick(int joystick_num, uint8_t& axis, uint8_t& button);
     bool get_stadia_joystick(int joystick_num, uint8_t& axis, uint8_t& button);
+    void publish_source(int joystick, joy_src_t src, bool present, uint8_t& axis, uint8_t& button,
+                        bool fresh = true);
     
     void set_mouse_state_bits(int clear_mask, int set_bits);
+    void sync_mouse_buttons(uint32_t t_us);
+    void publish_input(uint32_t t_us);
     void set_joystick_low_nibble(uint8_t axis);
     void set_joystick_high_nibble(uint8_t axis);
     
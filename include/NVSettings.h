@@ -21,6 +21,10 @@
 #include <stdint.h>
 #include <hardware/flash.h>
 
+#define NV_TUNABLE_SLOTS    32
+#define NV_TUNABLE_MAGIC    0x314E5554  // "TUN1"
+#define NV_PAD_KEY_ROWS     16
+
 struct Settings {
     // Version - used to detect if this is the first time we have read from flash.
     // Should be 1.
@@ -36,8 +40,18 @@ struct Settings {
     // Bit0 = Joystick 0
     // Bit1 = Joystick 1
     uint8_t     joy_device;
+
+    // Console tunables (tunables.h) and the custom gamepad key bindings
+    // (pad_keymap.h), written by the "save" command. Only used when
+    // tunable_magic is NV_TUNABLE_MAGIC; older firmware left this area zeroed.
+    uint32_t    tunable_magic;
+    int32_t     tunables[NV_TUNABLE_SLOTS];
+    uint16_t    pad_keys[NV_PAD_KEY_ROWS];
 };
 
+// NVSettings programs one flash page
+static_assert(sizeof(Settings) <= FLASH_PAGE_SIZE, "Settings must fit one flash page");
+
 class NVSettings {
 public:
     NVSettings();
@@ -21,6 +21,7 @@
 #ifdef __cplusplus 
 #include <stdexcept>
 #include "UserInterface.h"
+#include "st_link.h"
 
 class SerialPortException: public std::runtime_error {
 public:
@@ -84,10 +85,42 @@ public:
      */
     void drain_tx_log();
 
+    /**
+     * Recompute the baud rate divider after a system clock change.
+     * clk_peri follows clk_sys, so the ST link drifts off its rate otherwise.
+     * Nothing to do before open(), which sets the divider itself.
+     */
+    void reclock();
+
+    /**
+     * Change the ST link rate. Waits for the byte on the wire to go out at
+     * the old rate first. Returns false, and keeps the rate, unless
+     * baud_supported(). The 6301 needs no change: TDRE follows the UART
+     * holding register, so the ROM is paced by the new rate.
+     */
+    bool set_baud(uint32_t baud);
+    uint32_t get_baud() const;
+    static bool baud_supported(uint32_t baud);
+
+    /**
+     * Watch the RX line for a break or a long low level, which is how an ST
+     * reset or power-down looks from here. Call from the main loop. Returns
+     * true once when the line is idle again after such an event; the receive
+     * buffer has been flushed and the caller should re-sync the 6301.
+     */
+    bool poll_link();
+
+    /**
+     * True from the moment poll_link() sees a break or a long low level
+     * until the line idles high again
+     */
+    bool link_is_down() const { return link.down; }
+
 private:
     void configure();
 private:
     UserInterface*              ui = nullptr;
+    st_link_t                   link = {};
 };
 
 extern "C" {
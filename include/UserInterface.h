@@ -21,8 +21,7 @@
 #include "ssd1306.h"
 #include "NVSettings.h"
 #include "mount_splash.h"
-#include <string>
-#include <deque>
+#include "ui_redraw.h"
 
 #define MOUSE_MIN -7
 #define MOUSE_MAX 8
@@ -37,11 +36,14 @@ public:
         PAGE_SPLASH,
         PAGE_DEVICES,
         PAGE_MAPPING,
+        PAGE_TELEMETRY,
         PAGE_SERIAL,
         PAGE_USB_DEBUG,
         PAGE_PRO_INIT
     };
 
+    static constexpr uint32_t page_bit(PAGE p) { return 1u << p; }
+
     void init();
 
     /**
@@ -84,8 +86,12 @@ public:
      */
     void update();
 
-    /** Request OLED redraw (e.g. map labels changed without count change). */
-    void invalidate() { dirty = true; }
+    /**
+     * Mark pages as needing a redraw (a page_bit() mask, all by default).
+     * Only the page on screen is drawn, at most once per its refresh
+     * interval, so a burst of calls costs one redraw.
+     */
+    void invalidate(uint32_t pages = ~0u) { ui_redraw_invalidate(&redraw, pages); }
 
     /**
      * Serial transmission for logging to screen
@@ -93,27 +99,35 @@ public:
     void serial(bool send, uint8_t data);
 
 private:
-    void update_serial();
-    void update_devices();
-    void update_mapping();
-    void update_usb_debug();
-    void update_pro_init();
+    // Text pages return false when no cell changed (nothing to send)
+    bool update_serial();
+    bool update_devices();
+    bool update_mapping();
+    bool update_usb_debug();
+    bool update_pro_init();
+    bool update_telemetry();
     void update_splash();
     void handle_buttons();
     void on_button_down(int i);
+    void redraw_now();
 
 private:
     PAGE        page = PAGE_SPLASH;
     NVSettings  settings;
-    bool        dirty = true;
+    ui_redraw_t redraw;                 // Dirty pages and the redraw rate limit
     int         usb_kb = 0;
     int         usb_mouse = 0;
     int         usb_joy = 0;
     int         bt_kb = 0;
     int         bt_mouse = 0;
     int         bt_joy = 0;
-    std::deque<std::string> serial_lines;
-    absolute_time_t serial_tm;
+    // Last SERIAL_LINES bytes on the ST link, formatted only when the serial page is drawn
+    static const int SERIAL_LINES = 7;
+    uint8_t     serial_data[SERIAL_LINES];
+    bool        serial_sent[SERIAL_LINES];
+    int         serial_head = 0;
+    int         serial_count = 0;
+    int         telemetry_first = 0;   // First metric shown on the telemetry page
     uint        btn_gpio[3];
     int         btn_count[3];
 };
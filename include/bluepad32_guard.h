@@ -0,0 +1,37 @@
+/*
+ * Core 1 guard for Bluetooth gamepad enumeration
+ *
+ * BTstack stores pairing keys with flash_safe_execute() while a gamepad
+ * enumerates, and Bluetooth builds run the 6301 emulator on Core 1 from XIP
+ * flash. Discovery holds Core 1 in its pause loop. When the gamepad is ready
+ * or drops, the hold is let go once no flash write is in progress and none
+ * has finished for BT_FLASH_QUIET_MS. A BTstack run-loop timer does the
+ * waiting, so no callback blocks. BT_ENUM_PAUSE_MAX_MS caps the hold.
+ *
+ * flash_safe_execute() is wrapped at link time (-Wl,--wrap) to see the
+ * writes. Every write also parks Core 1 itself for its duration.
+ */
+
+#ifndef BLUEPAD32_GUARD_H
+#define BLUEPAD32_GUARD_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A gamepad is enumerating: pause Core 1. Repeat calls while held do nothing.
+void bluepad32_guard_hold(void);
+
+// Enumeration is over (ready or disconnected): resume Core 1 once flash is quiet
+void bluepad32_guard_release(void);
+
+// True while the guard holds Core 1 paused
+bool bluepad32_guard_active(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLUEPAD32_GUARD_H
@@ -0,0 +1,34 @@
+/*
+ * Bluetooth link latency tuning for HID peers
+ *
+ * BLE links are asked for the shortest connection interval in
+ * BT_LE_CONN_INTERVAL_MIN..MAX with zero peripheral latency. Classic links
+ * are kept out of sniff mode. Both only apply while low latency is on, which
+ * main.cpp turns off while the ST is switched off.
+ */
+
+#ifndef BLUEPAD32_LINK_H
+#define BLUEPAD32_LINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Register for HCI events and set the default link parameters.
+// Call once BTstack is up (platform on_init_complete).
+void bluepad32_link_init(void);
+
+// Low latency on (ST running) or off (ST idle: let peers save power)
+void bluepad32_link_set_low_latency(bool enabled);
+
+// Print the parameters negotiated for each connection (console 'btlink')
+void bluepad32_link_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLUEPAD32_LINK_H
@@ -7,6 +7,7 @@
 #define BLUEPAD32_PLATFORM_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +39,9 @@ bool bluepad32_peek_keyboard(int idx, void* out_keyboard);
 // out_mouse must point to a struct matching uni_mouse_t layout
 bool bluepad32_get_mouse(int idx, void* out_mouse);
 
+// True while the mouse in slot idx is connected
+bool bluepad32_mouse_connected(int idx);
+
 // Get count of connected Bluetooth keyboards
 int bluepad32_get_keyboard_count(void);
 
@@ -49,6 +53,12 @@ int bluepad32_get_mouse_count(void);
 bool bluepad32_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                                uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+// Right stick of the first connected gamepad, -128..127, negative = left/up
+bool bluepad32_right_stick(int8_t* x, int8_t* y);
+
+// Buttons of the first connected gamepad as a PAD_BTN_* mask (pad_keymap.h)
+bool bluepad32_pad_buttons(uint32_t* buttons);
+
 // Delete all stored Bluetooth pairing keys
 void bluepad32_delete_pairing_keys(void);
 
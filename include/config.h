@@ -36,6 +36,19 @@
 #define UART_RX             5
 #define UART_DEVICE         uart1
 
+// ST link rate. A stock ACIA expects 7812 baud; accelerated machines and
+// emulator bridges can run it faster (console tunable "ikbd_baud", one of
+// 7812, 15625, 31250 or 62500)
+#ifndef IKBD_BAUD_DEFAULT
+  #define IKBD_BAUD_DEFAULT 7812
+#endif
+
+// RX held low this long (or a UART break) means the ST went away; the 6301
+// is re-synced when the line idles high again
+#ifndef ST_LINK_LOW_US
+  #define ST_LINK_LOW_US    20000
+#endif
+
 // Joystick 1
 #define JOY1_UP             10
 #define JOY1_DOWN           11
@@ -55,6 +68,8 @@
 // 150000 = 150MHz (default/safe)
 // 270000 = 270MHz (maximum performance)
 #define DEFAULT_CPU_CLOCK_KHZ   270000
+// Bluetooth builds: CYW43 is unreliable at 270MHz (STALL timeouts)
+#define BT_CPU_CLOCK_KHZ        225000
 
 // Debug features (set to 0 to disable for production)
 // Can be overridden by CMake with -DENABLE_DEBUG=1
@@ -72,6 +87,175 @@
   #define HD6301_OVERCLOCK_NUM 1
 #endif
 
+// 6301 RAM/register watchpoints (hd6301_watch_*). Costs one page-flag test per
+// emulated memory access while built in, nothing extra until one is armed.
+#ifndef HD6301_WATCHPOINTS
+  #define HD6301_WATCHPOINTS ENABLE_DEBUG
+#endif
+
+// Right analog stick as mouse (stick_mouse.h): defaults for the stick_* tunables.
+// Dead zone is in stick units (0-126), speed in mouse counts per second.
+#ifndef STICK_MOUSE_DEAD_ZONE
+  #define STICK_MOUSE_DEAD_ZONE 16
+#endif
+#ifndef STICK_MOUSE_EXPONENT
+  #define STICK_MOUSE_EXPONENT 2
+#endif
+#ifndef STICK_MOUSE_MAX_SPEED
+  #define STICK_MOUSE_MAX_SPEED 600
+#endif
+
+// Gamepad button to ST key bindings (pad_keymap.h): profile selected at
+// startup, 0 = off. Tunable pad_keys.
+#ifndef PAD_KEYMAP_DEFAULT_PROFILE
+  #define PAD_KEYMAP_DEFAULT_PROFILE 0
+#endif
+
+// Keyboard joystick (key_joystick.h): key profile at startup (0 = off,
+// 1 cursor, 2 numpad, 3 WASD) and the ST port it drives. Tunables key_joy,
+// key_joy_port and key_joy_pass.
+#ifndef KEY_JOY_DEFAULT_PROFILE
+  #define KEY_JOY_DEFAULT_PROFILE 0
+#endif
+#ifndef KEY_JOY_DEFAULT_PORT
+  #define KEY_JOY_DEFAULT_PORT 1
+#endif
+
+// Joystick arbitration (joy_arbiter.h): how a port combines several pads
+// and the keyboard joystick. 0 = first active source by fixed priority,
+// 1 = most recently changed active source, 2 = OR of all sources.
+// Tunables joy0_arb and joy1_arb.
+#ifndef JOY_ARB_DEFAULT_POLICY
+  #define JOY_ARB_DEFAULT_POLICY 0
+#endif
+
+// Mouse resolution normalisation (mouse_merge.h): each mouse's typical
+// speed is scaled to this many counts per second, about an 800 CPI mouse
+// moved at 2 inches per second. Tunables mouse_norm and mouse_norm_cps.
+#ifndef MOUSE_NORM_DEFAULT
+  #define MOUSE_NORM_DEFAULT 1
+#endif
+#ifndef MOUSE_NORM_TARGET_CPS
+  #define MOUSE_NORM_TARGET_CPS 1600
+#endif
+
+// Timestamped input event queue (input_queue.h): the 6301 sees each key,
+// button and joystick transition in order and spaced in emulated time.
+// 0 makes the port reads sample the live HidInput state instead.
+#ifndef ENABLE_INPUT_QUEUE
+  #define ENABLE_INPUT_QUEUE 1
+#endif
+
+// Low-power idle while the ST is off (st_power.h). The ST counts as absent
+// when its TX line is held low (ST_LINK_LOW_US), or when ST_SENSE_GPIO
+// (e.g. wired to the ST's +5V through a divider) is not at ST_SENSE_ACTIVE.
+// The RX line only goes low for an ST that is switched off with the cable
+// still in: RX has a pull-up, so an unplugged cable reads as an idle line
+// and needs ST_SENSE_GPIO to be seen. Tunable st_idle turns it on and off.
+#ifndef ST_IDLE_DEFAULT
+  #define ST_IDLE_DEFAULT       1
+#endif
+#ifndef ST_SENSE_GPIO
+  #define ST_SENSE_GPIO         -1      // -1: use the RX line only
+#endif
+#ifndef ST_SENSE_ACTIVE
+  #define ST_SENSE_ACTIVE       1
+#endif
+#ifndef ST_IDLE_DELAY_US
+  #define ST_IDLE_DELAY_US      2000000 // Absent this long before going idle
+#endif
+#ifndef ST_IDLE_CPU_KHZ
+  #if ENABLE_BLUEPAD32
+    #define ST_IDLE_CPU_KHZ     125000  // CYW43 PIO SPI is clocked from clk_sys
+  #else
+    #define ST_IDLE_CPU_KHZ     48000   // Lowest clk_sys that keeps up with USB
+  #endif
+#endif
+#ifndef ST_IDLE_TICK_US
+  #define ST_IDLE_TICK_US       100000  // HID/UI tick while idle (10 ms when on)
+#endif
+#ifndef ST_IDLE_BT_POLL_US
+  #define ST_IDLE_BT_POLL_US    20000   // Bluetooth poll while idle (1 ms when on)
+#endif
+#ifndef ST_IDLE_SLEEP_US
+  #define ST_IDLE_SLEEP_US      1000    // Core 0 sleep per idle pass: bounds the wake latency
+#endif
+// Supply current estimates (uA) for the residency-weighted average shown by
+// the console 'power' command: both cores busy at 225-270 MHz, and one core
+// parked with the other mostly asleep at ST_IDLE_CPU_KHZ
+#ifndef ST_POWER_ACTIVE_UA
+  #define ST_POWER_ACTIVE_UA    55000
+#endif
+#ifndef ST_POWER_IDLE_UA
+  #define ST_POWER_IDLE_UA      12000
+#endif
+
+// Parsed HID report descriptors kept for devices that re-enumerate
+// (hid_desc_cache.h). Entries share HID_DESC_CACHE_ITEMS report items and
+// HID_DESC_CACHE_COLLECTIONS collections, as the layout pool below does.
+#ifndef HID_DESC_CACHE_ENTRIES
+  #define HID_DESC_CACHE_ENTRIES 8
+#endif
+#ifndef HID_DESC_CACHE_ITEMS
+  #define HID_DESC_CACHE_ITEMS 48
+#endif
+#ifndef HID_DESC_CACHE_COLLECTIONS
+  #define HID_DESC_CACHE_COLLECTIONS 16
+#endif
+// Parsed layouts for mounted HID interfaces (hid_report_pool.h). Only generic
+// HID mice, keyboards and joysticks take one; controllers with their own
+// drivers do not. Each keeps just the items it uses (~50 bytes each: a mouse
+// 5-10, a pad up to 20) and their collections (12 bytes each), out of shared
+// arrays. When there is no room, a boot-protocol mouse is read in boot
+// protocol and any other interface is not mounted (logged, usb.ri_full).
+#ifndef HID_REPORT_INFO_POOL
+  #define HID_REPORT_INFO_POOL 8      // Layouts
+#endif
+#ifndef HID_LAYOUT_ITEMS
+  #define HID_LAYOUT_ITEMS 64         // Report items, shared
+#endif
+#ifndef HID_LAYOUT_COLLECTIONS
+  #define HID_LAYOUT_COLLECTIONS 24   // Collections, shared
+#endif
+
+// GameCube adapter bring-up (gamecube_adapter.c), run from gc_task(): time
+// allowed for the mode-switch control request, time to wait for the first
+// report after the 0x13 start command, and how often the command is resent
+#ifndef GC_MODE_SWITCH_TIMEOUT_MS
+  #define GC_MODE_SWITCH_TIMEOUT_MS  500
+#endif
+#ifndef GC_FIRST_REPORT_TIMEOUT_MS
+  #define GC_FIRST_REPORT_TIMEOUT_MS 1000
+#endif
+#ifndef GC_START_RETRIES
+  #define GC_START_RETRIES           3
+#endif
+
+// Switch Pro Controller USB handshake (switch_controller.c): time allowed for
+// each step's reply, and resends of a step before moving on without it
+#ifndef SWITCH_HS_REPLY_TIMEOUT_MS
+  #define SWITCH_HS_REPLY_TIMEOUT_MS 200
+#endif
+#ifndef SWITCH_HS_RETRIES
+  #define SWITCH_HS_RETRIES          3
+#endif
+
+// OLED refresh (ui_redraw.c): a page is redrawn at most once per
+// UI_REDRAW_MIN_MS however often it is invalidated. The telemetry and serial
+// pages use the slower UI_LIVE_REFRESH_MS.
+#ifndef UI_REDRAW_MIN_MS
+  #define UI_REDRAW_MIN_MS           50
+#endif
+#ifndef UI_LIVE_REFRESH_MS
+  #define UI_LIVE_REFRESH_MS         500
+#endif
+
+// Telemetry registry (telemetry.h): counters, gauges, min/max and histograms
+// shown on the console and the OLED telemetry page. 0 compiles it out.
+#ifndef ENABLE_TELEMETRY
+  #define ENABLE_TELEMETRY 1
+#endif
+
 // Enables detailed Xbox/PS4/HID diagnostic counters on USB Debug page
 #define ENABLE_CONTROLLER_DEBUG ENABLE_DEBUG
 
@@ -101,14 +285,41 @@
   #define ENABLE_SERIAL_LOGGING 1
 #endif
 
-// Delay before resuming Core 1 after BT gamepad enumeration (flash-safe pairing).
-#ifndef BT_GAMEPAD_CORE1_RESUME_DELAY_MS
-  #define BT_GAMEPAD_CORE1_RESUME_DELAY_MS 100
+// Bluetooth gamepad enumeration guard (bluepad32_guard.h). Core 1 stays
+// paused until no flash write has finished for BT_FLASH_QUIET_MS after the
+// gamepad is ready, and never longer than BT_ENUM_PAUSE_MAX_MS. Each flash
+// write waits up to BT_CORE1_PARK_TIMEOUT_MS for Core 1 to reach its pause loop.
+#ifndef BT_FLASH_QUIET_MS
+  #define BT_FLASH_QUIET_MS 20
+#endif
+#ifndef BT_ENUM_PAUSE_MAX_MS
+  #define BT_ENUM_PAUSE_MAX_MS 5000
+#endif
+#ifndef BT_CORE1_PARK_TIMEOUT_MS
+  #define BT_CORE1_PARK_TIMEOUT_MS 20
+#endif
+
+// Bluetooth link latency (bluepad32_link.h). BLE intervals in 1.25 ms units:
+// 6..8 = 7.5..10 ms, the shortest most HID peers accept. Supervision timeout
+// in 10 ms units. Scan interval/window in 0.625 ms units (BTstack defaults).
+#ifndef BT_LE_CONN_INTERVAL_MIN
+  #define BT_LE_CONN_INTERVAL_MIN   6
+#endif
+#ifndef BT_LE_CONN_INTERVAL_MAX
+  #define BT_LE_CONN_INTERVAL_MAX   8
+#endif
+#ifndef BT_LE_SUPERVISION_TIMEOUT
+  #define BT_LE_SUPERVISION_TIMEOUT 200
+#endif
+#ifndef BT_LE_SCAN_INTERVAL
+  #define BT_LE_SCAN_INTERVAL       0x0060
+#endif
+#ifndef BT_LE_SCAN_WINDOW
+  #define BT_LE_SCAN_WINDOW         0x0030
 #endif
-// After pausing Core 1 on gamepad discovery, wait before BTstack pairing flash writes.
-// Debug logi/printf masked a race; production needs an explicit settle window.
-#ifndef BT_GAMEPAD_DISCOVERY_SETTLE_MS
-  #define BT_GAMEPAD_DISCOVERY_SETTLE_MS 30
+// Parameter updates / sniff exits requested per link before giving in to the peer
+#ifndef BT_LINK_MAX_REQUESTS
+  #define BT_LINK_MAX_REQUESTS      3
 #endif
 
 // If the OLED display is disabled, also disable all OLED-based debug displays
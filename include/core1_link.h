@@ -0,0 +1,81 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Core 0 side of the Core 1 (6301) control channels, in main.cpp. Every
+ * function here is called from Core 0; core_channel.h carries the state.
+ *
+ * The 6301 SCI and reset are only ever touched by Core 1. Core 0 queues
+ * bytes for the ROM and asks for a reset; Core 1 applies them between
+ * run_clocks batches.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Queue a byte for the 6301 to receive, as if the ST had sent it. Core 1
+ * puts it in RDR once the ROM has read the previous one. False if full.
+ */
+bool core1_queue_rx_byte(uint8_t data);
+
+/**
+ * Bytes queued for the 6301 and not yet in RDR
+ */
+uint32_t core1_rx_queued(void);
+
+/**
+ * Cold reset the 6301. Bytes queued before the call are dropped.
+ */
+void core1_request_reset(void);
+
+/**
+ * Park Core 1 in its WFE pause loop (nests), and let it go again.
+ * core1_wait_for_pause_active() polls until Core 1 is parked or the
+ * timeout passes; it only busy-waits, as it runs under flash_safe_execute.
+ */
+void core1_pause_for_bt_enumeration(void);
+void core1_resume_after_bt_enumeration(void);
+void core1_wait_for_pause_active(uint32_t timeout_ms);
+uint32_t core1_get_pause_depth(void);
+int core1_is_paused(void);
+
+/**
+ * False until main() launches Core 1. Before that, Core 0 owns the 6301
+ * side too and has nothing to park.
+ */
+bool core1_launched(void);
+
+// Emulated cycles per Core 1 loop iteration (console tunable "cycles_per_loop")
+void core1_set_cycles_per_loop(uint32_t cycles);
+uint32_t core1_get_cycles_per_loop(void);
+
+// Core 1 breadcrumbs for freeze diagnosis
+uint32_t core1_get_diag_phase(void);
+uint32_t core1_get_diag_pc(void);
+uint32_t core1_get_pause_spins(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Lock-free channels between Core 0 and Core 1.
+ *
+ * Contract: every variable shared between the cores has exactly one writer
+ * core and is only accessed through one of these. Nothing else is shared.
+ *
+ * - Words, cc_put() / cc_get(): one 32-bit value (flag, tunable, breadcrumb).
+ *   Relaxed: never torn, but orders nothing else. cc_put_release() and
+ *   cc_get_acquire() pair up when the reader must also see everything the
+ *   writer did before the store (Core 1 parking, for instance).
+ *
+ * - Queues, cc_spsc_t: one producer core, one consumer core, a ring of
+ *   slots the caller owns (size a power of two, index & (size - 1)).
+ *   The producer fills the slot at cc_spsc_head() and calls cc_spsc_push(),
+ *   a release store of head. The consumer's cc_spsc_count() is an acquire
+ *   load of head, so a slot it can see is complete. cc_spsc_pop() is a
+ *   release store of tail once the consumer is done with the slot, and the
+ *   producer's cc_spsc_space() is an acquire load of tail, so a slot is not
+ *   refilled while it is still being read. Neither side ever waits.
+ *
+ * - State blocks, cc_seq_t: one writer, any number of readers (sequence
+ *   lock). The writer stores the fields with cc_seq_put() between
+ *   cc_seq_write_begin() and cc_seq_write_end(). A reader loads them with
+ *   cc_seq_get() between cc_seq_read_begin() and cc_seq_read_retry(), and
+ *   goes again on retry, so it always sees one whole update. A field load
+ *   that sees a new value also sees the odd sequence stored before it,
+ *   which is what makes the retry check work without fences. The writer
+ *   never waits for readers.
+ *
+ * These are GCC __atomic builtins on plain loads and stores: a relaxed
+ * access is an LDR/STR, acquire and release add one DMB, the same as the
+ * volatile accesses and __dmb() calls they replace. There is no read-modify-
+ * write (the Cortex-M0+ has no exclusive access); the one-writer rule makes
+ * it unnecessary. No standalone fences either, so the same code builds on
+ * a host and can be stress tested under ThreadSanitizer.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Always inlined: Core 1 callers run from RAM and must not call into flash
+#define CC_INLINE static inline __attribute__((always_inline))
+
+// ---- Words ------------------------------------------------------------
+
+CC_INLINE void cc_put(uint32_t* word, uint32_t value) {
+    __atomic_store_n(word, value, __ATOMIC_RELAXED);
+}
+
+CC_INLINE uint32_t cc_get(const uint32_t* word) {
+    return __atomic_load_n(word, __ATOMIC_RELAXED);
+}
+
+// Everything written before this store is visible to a cc_get_acquire() that reads it
+CC_INLINE void cc_put_release(uint32_t* word, uint32_t value) {
+    __atomic_store_n(word, value, __ATOMIC_RELEASE);
+}
+
+CC_INLINE uint32_t cc_get_acquire(const uint32_t* word) {
+    return __atomic_load_n(word, __ATOMIC_ACQUIRE);
+}
+
+// ---- Queues -----------------------------------------------------------
+
+typedef struct {
+    uint32_t head;      // Slots pushed, written by the producer only
+    uint32_t tail;      // Slots popped, written by the consumer only
+} cc_spsc_t;
+
+// Producer: free slots
+CC_INLINE uint32_t cc_spsc_space(const cc_spsc_t* q, uint32_t size) {
+    return size - (cc_get(&q->head) - cc_get_acquire(&q->tail));
+}
+
+// Producer: index of the slot to fill next
+CC_INLINE uint32_t cc_spsc_head(const cc_spsc_t* q) {
+    return cc_get(&q->head);
+}
+
+// Producer: publish the filled slot
+CC_INLINE void cc_spsc_push(cc_spsc_t* q) {
+    cc_put_release(&q->head, cc_get(&q->head) + 1);
+}
+
+// Consumer: slots ready to read
+CC_INLINE uint32_t cc_spsc_count(const cc_spsc_t* q) {
+    return cc_get_acquire(&q->head) - cc_get(&q->tail);
+}
+
+// Consumer: index of the oldest slot
+CC_INLINE uint32_t cc_spsc_tail(const cc_spsc_t* q) {
+    return cc_get(&q->tail);
+}
+
+// Consumer: done with the oldest slot
+CC_INLINE void cc_spsc_pop(cc_spsc_t* q) {
+    cc_put_release(&q->tail, cc_get(&q->tail) + 1);
+}
+
+// Consumer: drop every slot before index (no-op if already past it)
+CC_INLINE void cc_spsc_pop_to(cc_spsc_t* q, uint32_t index) {
+    if ((int32_t)(index - cc_get(&q->tail)) > 0) {
+        cc_put_release(&q->tail, index);
+    }
+}
+
+// ---- State blocks -----------------------------------------------------
+
+typedef struct {
+    uint32_t seq;       // Odd while the writer is updating
+} cc_seq_t;
+
+CC_INLINE void cc_seq_write_begin(cc_seq_t* s) {
+    cc_put(&s->seq, cc_get(&s->seq) + 1);
+}
+
+// Writer: store a field (orders the odd sequence before it)
+CC_INLINE void cc_seq_put(uint32_t* field, uint32_t value) {
+    cc_put_release(field, value);
+}
+
+CC_INLINE void cc_seq_write_end(cc_seq_t* s) {
+    cc_put_release(&s->seq, cc_get(&s->seq) + 1);
+}
+
+CC_INLINE uint32_t cc_seq_read_begin(const cc_seq_t* s) {
+    uint32_t seq;
+    while ((seq = cc_get_acquire(&s->seq)) & 1) {
+    }
+    return seq;
+}
+
+// Reader: load a field
+CC_INLINE uint32_t cc_seq_get(const uint32_t* field) {
+    return cc_get_acquire(field);
+}
+
+// True if the fields read since cc_seq_read_begin() may be torn
+CC_INLINE bool cc_seq_read_retry(const cc_seq_t* s, uint32_t seq) {
+    return cc_get(&s->seq) != seq;
+}
+
+#ifdef __cplusplus
+}
+#endif
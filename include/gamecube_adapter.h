@@ -106,12 +106,25 @@ typedef struct {
 // GameCube Adapter State
 //--------------------------------------------------------------------
 
+// Bring-up, driven by transfer completions and gc_task(); nothing waits
+typedef enum {
+    GC_STATE_MODE_SWITCH = 0,   // Class request 11 (PC mode) in flight on the control pipe
+    GC_STATE_START,             // 0x13 start command to queue on the interrupt OUT pipe
+    GC_STATE_WAIT_REPORT,       // Start sent, IN armed, no 0x21 report yet
+    GC_STATE_STREAMING          // Reports arriving
+} gc_state_t;
+
 typedef struct {
     uint8_t dev_addr;           // USB device address
     bool connected;             // Adapter connection status
     gc_adapter_report_t report; // Latest report (all 4 ports)
     int16_t deadzone;           // Stick deadzone
     uint8_t active_port;        // Which port has a controller (0-3, or 0xFF if none)
+    uint8_t state;              // gc_state_t
+    uint8_t itf;                // HID instance being brought up
+    uint8_t itf_pending;        // Further instances waiting for bring-up (bit mask)
+    uint8_t retries;            // Start commands resent while waiting for a report
+    uint32_t deadline_ms;       // When gc_task() gives up on the current state
 } gc_adapter_t;
 
 //--------------------------------------------------------------------
@@ -173,17 +186,19 @@ void gc_to_atari(const gc_adapter_t* gc, uint8_t joystick_num,
 void gc_set_deadzone(uint8_t dev_addr, int16_t deadzone);
 
 /**
- * Send initialization command to a specific instance
+ * Start bringing up a mounted adapter interface: PC-mode request, 0x13
+ * start command, then the first IN transfer. Returns at once; the steps
+ * run from transfer completions and gc_task().
  * @param dev_addr USB device address
- * @param instance USB interface instance
+ * @param instance HID instance
+ * @return false if no adapter slot is free
  */
-void gc_send_init(uint8_t dev_addr, uint8_t instance);
+bool gc_attach(uint8_t dev_addr, uint8_t instance);
 
 /**
- * Mount callback
- * @param dev_addr USB device address
+ * Bring-up timeouts and retries; call from the main loop after tuh_task()
  */
-void gc_mount_cb(uint8_t dev_addr);
+void gc_task(void);
 
 /**
  * Unmount callback
@@ -207,6 +222,17 @@ uint8_t gc_connected_count(void);
 bool gc_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                        uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+/**
+ * C-stick of the first active controller, -128..127, negative = left/up
+ */
+bool gc_right_stick(int8_t* x, int8_t* y);
+
+/**
+ * Buttons of the first active controller as a PAD_BTN_* mask (pad_keymap.h).
+ * Z is R1, the L/R trigger clicks are L2/R2.
+ */
+bool gc_pad_buttons(uint32_t* buttons);
+
 #ifdef __cplusplus
 }
 #endif
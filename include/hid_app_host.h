@@ -8,6 +8,7 @@
 
 #include "tusb.h"
 #include "HIDParser.h"
+#include "hid_report_pool.h"
 
 /** HID Report Descriptor Usage Page value for a Generic Desktop Control. */
 #define USAGE_PAGE_GENERIC_DCTRL    0x01
@@ -16,6 +17,9 @@
 #define USAGE_X                     0x30
 #define USAGE_Y                     0x31
 #define USAGE_PAGE_BUTTON           0x09
+#define USAGE_PAGE_DIGITIZER        0x0D
+#define USAGE_DIGITIZER_IN_RANGE    0x32
+#define USAGE_DIGITIZER_TIP_SWITCH  0x42
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,29 +38,32 @@ bool tuh_hid_is_mounted(uint8_t dev_addr);
 // Get the type of the HID device if known
 HID_TYPE tuh_hid_get_type(uint8_t dev_addr);
 
-// Check if the interface is currently busy or not
+// Busy until a report has arrived for the app to parse
 bool tuh_hid_is_busy(uint8_t dev_addr);
 
-// Queue a buffer to receive the next report (legacy API wrapper)
+// Ask for the next report, handing the current one back to TinyUSB.
 // Renamed from tuh_hid_get_report to avoid collision with TinyUSB 0.19+ API
-bool hid_app_request_report(uint8_t dev_addr, void * p_report);
+bool hid_app_request_report(uint8_t dev_addr);
+
+// Latest report, parsed in place from TinyUSB's IN buffer (no copy). NULL
+// while busy. Valid until the next hid_app_request_report() for dev_addr.
+const uint8_t* hid_app_get_report(uint8_t dev_addr);
+
+// time_us_32() at which the current report arrived, for stamping the input
+// events it produces
+uint32_t hid_app_get_report_time(uint8_t dev_addr);
 
 // Get the size of the HID report in bytes
 uint16_t tuh_hid_get_report_size(uint8_t dev_addr);
 
-// Get the report info structure used for parsing a report
-HID_ReportInfo_t* tuh_hid_get_report_info(uint8_t dev_addr);
+// Get the report layout used for parsing a report
+hid_layout_t* tuh_hid_get_report_info(uint8_t dev_addr);
 
 // Application callbacks
 void tuh_hid_mounted_cb(uint8_t dev_addr);
 void tuh_hid_unmounted_cb(uint8_t dev_addr);
 
-// Debug functions
-uint32_t hid_debug_get_mount_calls(void);
-uint32_t hid_debug_get_report_calls(void);
-uint32_t hid_debug_get_report_copied(void);
-uint32_t hid_debug_get_unmount_calls(void);
-uint32_t hid_debug_get_active_devices(void);
+// Debug functions (mount/report counters are in telemetry.h)
 uint32_t hid_debug_get_last_addr_inst(void);  // Returns (addr << 8) | instance
 
 #ifdef __cplusplus
@@ -0,0 +1,69 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Cache of parsed HID report descriptors.
+ *
+ * A device that re-enumerates (re-plug, hub reset, power glitch) hands over
+ * the same descriptor again. Entries are keyed by VID/PID, descriptor length
+ * and an FNV-1a hash of the descriptor, so a known device gets its layout
+ * back without running the parser. The hash costs one pass over the
+ * descriptor bytes.
+ *
+ * Layouts are kept as in hid_report_pool.h, only the items and collections
+ * used, in arrays of HID_DESC_CACHE_ITEMS and HID_DESC_CACHE_COLLECTIONS.
+ * The parse result and the device type picked by the parser filter are
+ * cached too, including failed parses. The least recently used entries are
+ * evicted when there are no free entries or items.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "HIDParser.h"
+#include "hid_report_pool.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * FNV-1a over a report descriptor
+ */
+uint32_t hid_desc_hash(const uint8_t* desc, uint16_t len);
+
+/**
+ * Look up a descriptor. On a hit, returns the USB_ProcessHIDReport() result
+ * and filter type stored with it, and points layout at the cached layout
+ * (NULL for a failed parse). That stays valid until the next store.
+ */
+bool hid_desc_cache_lookup(uint16_t vid, uint16_t pid, uint32_t hash, uint16_t len,
+                           const hid_layout_t** layout, uint8_t* result, uint8_t* type);
+
+/**
+ * Remember the outcome of parsing a descriptor. layout is copied; pass NULL
+ * for a failed parse.
+ */
+void hid_desc_cache_store(uint16_t vid, uint16_t pid, uint32_t hash, uint16_t len,
+                          const hid_layout_t* layout, uint8_t result, uint8_t type);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,110 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Storage for parsed HID report layouts, sized by what each interface uses.
+ *
+ * The parser fills a whole HID_ReportInfo_t (~1.3 KB: HID_MAX_REPORTITEMS
+ * items and HID_MAX_COLLECTIONS collections), but a mounted interface only
+ * reads the items the filter kept. hid_app_host.c parses into one scratch
+ * HID_ReportInfo_t and keeps a hid_layout_t: those items and the collections
+ * they sit in, copied into arrays shared by all interfaces. A mouse takes 5 to
+ * 10 items, a pad up to 20, and controllers with their own drivers none.
+ *
+ * The shared arrays stay packed: removing a layout moves the ones stored after
+ * it down and fixes up their pointers, so any mix of devices fits as long as
+ * the totals do. Running out is counted as usb.ri_full in telemetry.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "HIDParser.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The part of a HID_ReportInfo_t a report reader uses, under the same names
+ */
+typedef struct {
+    uint8_t               TotalReportItems;
+    uint8_t               TotalCollections;
+    HID_ReportItem_t*     ReportItems;
+    HID_CollectionPath_t* CollectionPaths;
+} hid_layout_t;
+
+/**
+ * Layouts packed into fixed arrays. Free headers have no ReportItems.
+ */
+typedef struct {
+    hid_layout_t*         layouts;
+    HID_ReportItem_t*     items;
+    HID_CollectionPath_t* collections;
+    uint8_t               max_layouts;
+    uint8_t               max_items;
+    uint8_t               max_collections;
+    uint8_t               items_used;
+    uint8_t               collections_used;
+} hid_layout_store_t;
+
+/**
+ * Describe a parse result as a layout, in place: its items, and its
+ * collections up to the last one an item or a parent of one refers to
+ */
+void hid_layout_of(HID_ReportInfo_t* info, hid_layout_t* layout);
+
+/**
+ * Copy a layout with at least one item into the store. NULL when there is no
+ * free header or not enough room left for its items and collections.
+ */
+hid_layout_t* hid_layout_store_add(hid_layout_store_t* store, const hid_layout_t* src);
+
+/**
+ * Remove a layout and pack the ones after it. NULL is ignored.
+ */
+void hid_layout_store_remove(hid_layout_store_t* store, hid_layout_t* layout);
+
+/**
+ * A copy of src in the pool for a mounted interface, or NULL when the pool
+ * (HID_REPORT_INFO_POOL layouts, HID_LAYOUT_ITEMS items,
+ * HID_LAYOUT_COLLECTIONS collections) cannot take it
+ */
+hid_layout_t* hid_report_pool_alloc(const hid_layout_t* src);
+
+/**
+ * Give a layout back. NULL and layouts from elsewhere are ignored.
+ */
+void hid_report_pool_free(hid_layout_t* layout);
+
+/**
+ * Number of layouts taken
+ */
+int hid_report_pool_used(void);
+
+/**
+ * Number of report items taken by those layouts
+ */
+int hid_report_pool_items_used(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -28,6 +28,7 @@ typedef struct {
     uint8_t dpad;
     uint8_t axis_x, axis_y, axis_z, axis_rz;
     uint8_t b, a, y, x, l1, r1, l2, r2;
+    uint8_t minus, plus, l3, r3, home;
     int16_t deadzone;
 } horipad_controller_t;
 
@@ -42,6 +43,9 @@ uint8_t horipad_connected_count(void);
 bool horipad_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                             uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+bool horipad_right_stick(int8_t* x, int8_t* y);
+bool horipad_pad_buttons(uint32_t* buttons);  // PAD_BTN_* mask (pad_keymap.h), first pad
+
 void horipad_mount_cb(uint8_t dev_addr);
 void horipad_unmount_cb(uint8_t dev_addr);
 
@@ -0,0 +1,111 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Timestamped input event queue between Core 0 (HidInput) and the 6301.
+ *
+ * Core 0 publishes the state it wants the ST to see, via iq_set_keys(),
+ * iq_set_mouse_buttons() and iq_set_joystick(). Each change to the published
+ * state queues an event stamped with the time_us_32() at which the report
+ * behind it arrived, not when it was published. Core 1 keeps its
+ * own copy of the input state and applies each event when emulated time
+ * reaches it. The port reads in ireg.c only ever see that copy.
+ *
+ * Mapping to emulated time: the first event after the queue runs dry is
+ * applied IQ_LATENCY_CYCLES after Core 1 sees it. Later events keep their
+ * real-time spacing (1 cycle per us), but are at least IQ_MIN_GAP_CYCLES
+ * apart, so the ROM's keyboard scan sees every transition. An event older
+ * than IQ_MAX_AGE_US restarts the mapping, so a slow or paused Core 1 never
+ * builds up lag.
+ *
+ * If the queue is full, Core 0 keeps the change unpublished and retries on
+ * its next publish. The final state always arrives; only intermediate
+ * transitions can be lost under overflow (counted in telemetry).
+ *
+ * Single producer (Core 0 main loop), single consumer (Core 1).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+#define IQ_SIZE             64      // Power of two
+#define IQ_LATENCY_CYCLES   500     // Fixed delay before the first event of a burst
+#define IQ_MIN_GAP_CYCLES   2000    // Minimum emulated spacing between events
+#define IQ_MAX_AGE_US       20000   // Re-anchor when an event is this old
+
+#define IQ_NEVER            INT64_MAX
+
+typedef enum {
+    IQ_KEY = 0,                     // index = ST scancode, value = 0/1
+    IQ_MOUSE_BUTTONS,               // value = st_mouse_buttons() bits
+    IQ_JOYSTICK                     // value = st_joystick() bits
+} iq_kind_t;
+
+typedef struct {
+    uint32_t t_us;
+    uint8_t  kind;
+    uint8_t  index;
+    uint8_t  value;
+} iq_event_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Core 1: cpu.ncycles at which iq_service() must next run (IQ_NEVER if idle)
+extern int64_t iq_due;
+
+/**
+ * Core 0: publish a state seen at t_us. Queues an event only for what
+ * differs from the last successful publish. keys is the 128-key bitmap,
+ * bit (code & 31) of keys[code >> 5]; one event per key that changed.
+ */
+void iq_set_keys(const uint32_t keys[4], uint32_t t_us);
+void iq_set_mouse_buttons(uint8_t buttons, uint32_t t_us);
+void iq_set_joystick(uint8_t joystick, uint32_t t_us);
+
+/**
+ * Core 1: forget the emulated-time mapping. Call when cpu.ncycles restarts
+ * from zero (hd6301_reset), or every later event would wait for the old
+ * count. Queued events are kept and rescheduled by the next iq_poll().
+ */
+void iq_reset(void);
+
+/**
+ * Core 1: pick up newly queued events. Call once per run_clocks batch.
+ */
+void iq_poll(int64_t ncycles);
+
+/**
+ * Core 1: apply every event due at ncycles and set iq_due to the next one.
+ */
+void iq_service(int64_t ncycles);
+
+/**
+ * Core 1 view of the input state, as applied so far
+ */
+bool iq_keydown(uint8_t code);
+uint8_t iq_mouse_buttons(void);
+uint8_t iq_joystick(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Joystick arbitration: decides what an ST joystick port shows when more
+ * than one source (USB pads by driver, Bluetooth, keyboard) drives it.
+ *
+ * Each source publishes its direction nibble and fire state for a port, or
+ * withdraws when it has no device there. A device that is there but sent no
+ * new report publishes nothing, so its last state stands. Publishing an
+ * unchanged state is a no-op, and the port is only resolved again after a
+ * change. A source is active while it reports a direction or fire. The
+ * port's policy then picks:
+ *
+ * - JOY_ARB_PRIORITY: the first active source in joy_src_t order.
+ * - JOY_ARB_RECENT: the active source that changed last. When it goes idle,
+ *   the port falls back to the next most recent active source.
+ * - JOY_ARB_MERGE: every source ORed together.
+ *
+ * With no active source the port is neutral, so an idle pad never masks
+ * another one.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JOY_ARB_PORTS   2
+
+// Sources, in JOY_ARB_PRIORITY order (first wins)
+typedef enum {
+    JOY_SRC_HID = 0,        // Generic USB HID joystick
+    JOY_SRC_PS4,
+    JOY_SRC_PS5,
+    JOY_SRC_PSC,
+    JOY_SRC_PS3,
+    JOY_SRC_GAMECUBE,
+    JOY_SRC_SWITCH,
+    JOY_SRC_HORIPAD,
+    JOY_SRC_XBOX,
+    JOY_SRC_BLUETOOTH,
+    JOY_SRC_KEYBOARD,       // key_joystick.h
+    JOY_SRC_COUNT
+} joy_src_t;
+
+typedef enum {
+    JOY_ARB_PRIORITY = 0,
+    JOY_ARB_RECENT,
+    JOY_ARB_MERGE,
+    JOY_ARB_POLICY_COUNT
+} joy_arb_policy_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void joy_arb_set_policy(int port, int policy);
+int joy_arb_get_policy(int port);
+const char* joy_arb_policy_name(int policy);
+
+/**
+ * Source src reports axis (KEY_JOY_UP..RIGHT bits) and fire on port
+ */
+void joy_arb_publish(int port, joy_src_t src, uint8_t axis, uint8_t fire);
+
+/**
+ * Source src has nothing on port (no device, or the device was read as absent)
+ */
+void joy_arb_withdraw(int port, joy_src_t src);
+
+/**
+ * Withdraw every source from port (port switched to DB9, Llamatron took it)
+ */
+void joy_arb_clear(int port);
+
+/**
+ * Port state under its policy. Returns false, with both outputs 0, when no
+ * source is present on the port.
+ */
+bool joy_arb_resolve(int port, uint8_t* axis, uint8_t* fire);
+
+#ifdef __cplusplus
+}
+#endif
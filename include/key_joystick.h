@@ -0,0 +1,93 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Keyboard joystick: a profile of ST keys (cursor keys, numpad or WASD,
+ * plus fire) drives one ST joystick port.
+ *
+ * key_joy_update() reads only the profile's keys from the ST key matrix
+ * HidInput has already built, so no extra scanning is done. A key press
+ * since the previous update is stamped, and the stamps settle conflicts:
+ *
+ * - Orthogonal keys combine into a diagonal. Numpad 7/9/1/3 are diagonals
+ *   on their own.
+ * - Opposing directions (left and right, up and down): the one pressed
+ *   last wins, and releasing it returns to the other. Both pressed in the
+ *   same update cancel out.
+ *
+ * With pass-through off, the profile's keys are held back from the ST
+ * keyboard while the profile is active.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Port nibble bits as read by the 6301 (joystick 1 is the high nibble)
+#define KEY_JOY_UP              0x01
+#define KEY_JOY_DOWN            0x02
+#define KEY_JOY_LEFT            0x04
+#define KEY_JOY_RIGHT           0x08
+#define KEY_JOY_FIRE            0x80    // Binding flag only, reported through *fire
+
+#define KEY_JOY_MAX_KEYS        12
+
+typedef enum {
+    KEY_JOY_OFF = 0,
+    KEY_JOY_CURSOR,         // Cursor keys, Space fires
+    KEY_JOY_NUMPAD,         // Numpad 1-9, 0 or 5 fires
+    KEY_JOY_WASD,           // W A S D, Space fires
+    KEY_JOY_PROFILE_COUNT
+} key_joy_profile_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void key_joy_set_profile(int profile);
+int key_joy_get_profile(void);
+const char* key_joy_profile_name(int profile);
+
+/**
+ * ST joystick port driven (0 or 1)
+ */
+void key_joy_set_port(int port);
+int key_joy_get_port(void);
+
+/**
+ * true: the profile's keys also reach the ST keyboard
+ */
+void key_joy_set_passthrough(bool on);
+bool key_joy_get_passthrough(void);
+
+/**
+ * Read the profile's keys from keys[128] (ST scancode, non-zero = down) and
+ * resolve them to a port nibble (KEY_JOY_UP..RIGHT) and fire state.
+ * Returns false, with both outputs 0, when no profile is active.
+ */
+bool key_joy_update(const uint8_t* keys, uint8_t* axis, uint8_t* fire);
+
+/**
+ * True if code is held back from the ST keyboard by the active profile
+ */
+bool key_joy_consumes(uint8_t code);
+
+#ifdef __cplusplus
+}
+#endif
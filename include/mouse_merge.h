@@ -0,0 +1,158 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Merges every connected pointing device (USB and Bluetooth) into the single
+ * ST mouse. handle_mouse() calls mouse_merge_begin(), feeds every report it
+ * drains in that pass, then collects the result with mouse_merge_end().
+ *
+ * - Motion is summed after per-class speed scaling. Each source keeps its
+ *   sub-count remainder, so scaling never loses displacement.
+ * - Buttons are the OR of the last state held by each source. A source that
+ *   sent nothing this pass, or a report without buttons (a wheel-only report
+ *   of a report-ID mouse), keeps its buttons pressed.
+ * - Absolute sources (tablets, touch screens) are turned into relative motion
+ *   against their previous position. The first sample after a source appears
+ *   or comes back into range only sets the position, so the pointer never
+ *   jumps.
+ * - Relative USB and Bluetooth mice are normalised for resolution. Passes
+ *   are grouped into MOUSE_NORM_SAMPLE_US samples, long enough that a low
+ *   resolution mouse at a slow report rate still reports several counts.
+ *   The speed of each sample in which the mouse moved, in counts per second,
+ *   goes into a quarter-octave histogram. The median of that histogram is
+ *   the device's typical speed, and motion is scaled by target / median
+ *   (Q12, clamped), so a 400 and a 16000 DPI mouse move the ST pointer alike.
+ *   The factor follows the histogram from MOUSE_NORM_MIN_SAMPLES on and is
+ *   frozen after MOUSE_NORM_WINDOW samples.
+ *
+ * Nothing is buffered between passes, so the result never lags the
+ * fastest device.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MOUSE_MERGE_SOURCES     8
+#define MOUSE_MERGE_ABS_SPAN    640     // Counts across an absolute device's full range (ST high res width)
+#define MOUSE_MERGE_SCALE_ONE   100     // Scale is in percent
+
+#define MOUSE_NORM_ONE          4096    // Normalisation factors are Q12
+#define MOUSE_NORM_MIN          (MOUSE_NORM_ONE / 32)   // Fastest mouse slowed at most this much
+#define MOUSE_NORM_MAX          (MOUSE_NORM_ONE * 4)    // Slowest mouse sped up at most this much
+#define MOUSE_NORM_SAMPLE_US    50000   // Passes are grouped into samples this long
+#define MOUSE_NORM_WINDOW       120     // Moving samples in the calibration window (< 256)
+#define MOUSE_NORM_MIN_SAMPLES  10      // Moving samples before the factor is used
+#define MOUSE_NORM_MAX_PASS_US  50000   // A longer pass (stall) discards the sample
+#define MOUSE_NORM_BUCKETS      96      // Quarter octaves up to 2^24 counts/s
+
+// HID button bits as reported by the merge
+#define MOUSE_MERGE_LEFT        0x01
+#define MOUSE_MERGE_RIGHT       0x02
+#define MOUSE_MERGE_BUTTONS_KEEP 0xFF   // Report carried no buttons: keep the source's last state
+
+typedef enum {
+    MOUSE_CLASS_USB = 0,
+    MOUSE_CLASS_BT,
+    MOUSE_CLASS_STICK,      // Gamepad analog stick (stick_mouse.h), scaled by its own curve
+    MOUSE_CLASS_COUNT
+} mouse_class_t;
+
+// Source ids: USB device keys as used by HidInput, Bluetooth slots offset by this
+#define MOUSE_MERGE_BT_ID(slot) (0x100 + (slot))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint16_t id;
+    uint8_t  cls;
+    bool     calibrated;        // Window complete, factor frozen
+    uint8_t  samples;           // Moving samples seen so far
+    uint32_t median_cps;        // Typical speed, counts per second (0 = not known yet)
+    uint32_t report_hz;         // Report rate while moving
+    int32_t  norm;              // Factor applied now, Q12
+} mouse_merge_info_t;
+
+/**
+ * Start a merge pass at now_us (time_us_32()). Clears the motion accumulated
+ * by the last pass, and feeds that pass to the resolution calibration.
+ */
+void mouse_merge_begin(uint32_t now_us);
+
+/**
+ * Add a relative report from source id. Pass MOUSE_MERGE_BUTTONS_KEEP as
+ * buttons when the report has no button items.
+ */
+void mouse_merge_relative(uint16_t id, mouse_class_t cls, int32_t dx, int32_t dy, uint8_t buttons);
+
+/**
+ * Add an absolute report from source id. The position is in the device's
+ * logical range [0, max_x] x [0, max_y]. Set in_range to false when the
+ * stylus or finger lifts, so the next touch does not move the pointer.
+ */
+void mouse_merge_absolute(uint16_t id, mouse_class_t cls, int32_t x, int32_t y,
+                          int32_t max_x, int32_t max_y, bool in_range, uint8_t buttons);
+
+/**
+ * Forget a source that was unplugged or disconnected, releasing its buttons.
+ */
+void mouse_merge_remove(uint16_t id);
+
+/**
+ * Merged buttons of every source as of now. Returns true if they changed
+ * since the previous call, so a caller can apply them after each report.
+ */
+bool mouse_merge_take_buttons(uint8_t* buttons);
+
+/**
+ * Finish the pass and return the merged motion.
+ */
+void mouse_merge_end(int32_t* dx, int32_t* dy);
+
+/**
+ * Number of sources currently tracked
+ */
+int mouse_merge_active(void);
+
+/**
+ * Speed scale for a device class, in percent (MOUSE_MERGE_SCALE_ONE = 1x)
+ */
+void mouse_merge_set_scale(mouse_class_t cls, int32_t percent);
+int32_t mouse_merge_get_scale(mouse_class_t cls);
+
+/**
+ * Resolution normalisation on or off, and the typical speed in counts per
+ * second that every mouse is normalised to
+ */
+void mouse_merge_set_normalise(bool enabled);
+bool mouse_merge_get_normalise(void);
+void mouse_merge_set_target_cps(int32_t cps);
+int32_t mouse_merge_get_target_cps(void);
+
+/**
+ * Calibration state of source slot 0..MOUSE_MERGE_SOURCES-1. Returns false
+ * for an empty slot.
+ */
+bool mouse_merge_source_info(int slot, mouse_merge_info_t* info);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,68 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Text pages as a grid of character cells.
+ *
+ * A page is composed between oled_text_begin() and oled_text_end() as lines
+ * of scale-1 text. oled_text_end() compares the cells with the frame already
+ * in the framebuffer and redraws only the cells that changed: each one is
+ * cleared and its glyph columns written straight into the buffer.
+ *
+ * The whole page is redrawn instead when the lines have moved, when two lines
+ * overlap, or when something else has cleared the framebuffer since (mount
+ * splash, controller debug screens).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ssd1306.h"
+
+#define OLED_TEXT_LINES     10      // Lines per page; extra lines are dropped
+#define OLED_TEXT_COLS      16      // Cells per line (128 px / 8 px advance)
+#define OLED_TEXT_CELL_W    8       // Glyph advance of font_8x5 at scale 1
+#define OLED_TEXT_CELL_H    8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void oled_text_begin(ssd1306_t* p);
+
+/**
+ * Add a line of scale-1 text at pixel position (x, y). Cells past the right
+ * edge of the display are dropped.
+ */
+void oled_text_draw(uint8_t x, uint8_t y, const char* s);
+
+/**
+ * Bring the framebuffer up to date with the page. Returns false if no pixel
+ * changed, so the caller can skip sending it to the display.
+ */
+bool oled_text_end(void);
+
+/**
+ * The framebuffer was drawn by other means; the next page is drawn in full
+ */
+void oled_text_invalidate(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,131 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Gamepad button to ST key bindings.
+ *
+ * The controller drivers report their buttons as a PAD_BTN_* mask named by
+ * position (south = Xbox A / PlayStation Cross / Switch B), so one binding
+ * works on every pad. A profile is a list of (button, scancode) rows; a
+ * button listed twice presses both keys, modifier first, which gives chords
+ * such as Alt+X.
+ *
+ * The active profile is flattened into a per-button key table when it is
+ * selected or edited, never per report. pad_keymap_update() then costs one
+ * XOR against the previous mask and a table lookup per changed button.
+ * Keys are reference counted, so two buttons bound to the same key hold it
+ * until both are released.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Normalised buttons, by position on the pad
+#define PAD_BTN_SOUTH           0x0001  // Xbox A, PlayStation Cross, Switch B
+#define PAD_BTN_EAST            0x0002  // Xbox B, PlayStation Circle, Switch A
+#define PAD_BTN_WEST            0x0004  // Xbox X, PlayStation Square, Switch Y
+#define PAD_BTN_NORTH           0x0008  // Xbox Y, PlayStation Triangle, Switch X
+#define PAD_BTN_L1              0x0010
+#define PAD_BTN_R1              0x0020
+#define PAD_BTN_L2              0x0040
+#define PAD_BTN_R2              0x0080
+#define PAD_BTN_SELECT          0x0100  // Back, Share, Minus
+#define PAD_BTN_START           0x0200  // Start, Options, Plus
+#define PAD_BTN_L3              0x0400
+#define PAD_BTN_R3              0x0800
+#define PAD_BTN_HOME            0x1000  // Guide, PS, Home
+#define PAD_BTN_COUNT           13
+
+#define PAD_KEYMAP_KEYS_PER_BUTTON  2   // Longest chord one button can press
+#define PAD_KEYMAP_CUSTOM_MAX       16  // Rows in the custom profile
+#define PAD_KEYMAP_MAX_EDGES        (2 * PAD_BTN_COUNT * PAD_KEYMAP_KEYS_PER_BUTTON)
+
+typedef enum {
+    PAD_KEYMAP_OFF = 0,
+    PAD_KEYMAP_MENUS,       // Return, Esc, Space, Y/N
+    PAD_KEYMAP_FKEYS,       // Shoulders and triggers on F1-F4
+    PAD_KEYMAP_CUSTOM,      // Edited with the console 'padkeys' command
+    PAD_KEYMAP_PROFILE_COUNT
+} pad_keymap_profile_t;
+
+typedef struct {
+    uint8_t button;         // Bit index of a PAD_BTN_* flag
+    uint8_t key;            // ST scancode, 1..127
+} pad_keymap_binding_t;
+
+typedef struct {
+    uint8_t key;
+    bool    down;
+} pad_key_edge_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Select the active profile. The keys it holds are released by the next
+ * pad_keymap_update(), and buttons still held press the new profile's keys.
+ */
+void pad_keymap_set_profile(int profile);
+int pad_keymap_get_profile(void);
+const char* pad_keymap_profile_name(int profile);
+
+/**
+ * Rows of a profile, for display
+ */
+int pad_keymap_binding_count(int profile);
+bool pad_keymap_binding(int profile, int idx, pad_keymap_binding_t* binding);
+
+/**
+ * Edit the custom profile. Binding key 0 removes every row for the button.
+ * Returns false if the button or key is out of range or the profile is full.
+ */
+bool pad_keymap_custom_bind(uint8_t button, uint8_t key);
+void pad_keymap_custom_clear(void);
+
+/**
+ * Custom profile packed as (button << 8) | key per row, 0 for an empty row,
+ * for NVSettings
+ */
+void pad_keymap_custom_export(uint16_t rows[PAD_KEYMAP_CUSTOM_MAX]);
+void pad_keymap_custom_import(const uint16_t rows[PAD_KEYMAP_CUSTOM_MAX]);
+
+/**
+ * Button names ("south", "l1", "start", ...) by bit index, and back.
+ * pad_keymap_button_find() returns -1 for an unknown name.
+ */
+const char* pad_keymap_button_name(int button);
+int pad_keymap_button_find(const char* name);
+
+/**
+ * Feed the current PAD_BTN_* mask. Writes the key transitions it causes to
+ * edges (at most PAD_KEYMAP_MAX_EDGES) and returns how many there are.
+ */
+int pad_keymap_update(uint32_t buttons, pad_key_edge_t* edges);
+
+/**
+ * Forget held keys without reporting them (the key matrix was cleared).
+ * Buttons still held press their keys again on the next update.
+ */
+void pad_keymap_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -99,8 +99,6 @@ typedef struct {
     bool connected;             // Connection status
     ps3_report_t report;        // Latest report
     int16_t deadzone;           // Stick deadzone (default 50)
-    uint8_t raw_report[64];     // Store raw report for debugging
-    uint16_t raw_len;           // Raw report length
 } ps3_controller_t;
 
 //--------------------------------------------------------------------
@@ -156,6 +154,16 @@ uint8_t ps3_connected_count(void);
 bool ps3_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                         uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+/**
+ * Right stick of the first connected controller, -128..127, negative = left/up
+ */
+bool ps3_right_stick(int8_t* x, int8_t* y);
+
+/**
+ * Buttons of the first connected controller as a PAD_BTN_* mask (pad_keymap.h)
+ */
+bool ps3_pad_buttons(uint32_t* buttons);
+
 /**
  * Set stick deadzone
  * @param dev_addr USB device address
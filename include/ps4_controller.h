@@ -141,6 +141,18 @@ uint8_t ps4_connected_count(void);
 bool ps4_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                         uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+/**
+ * Right stick of the first connected controller, -128..127, negative = left/up
+ * @return true if a controller was available
+ */
+bool ps4_right_stick(int8_t* x, int8_t* y);
+
+/**
+ * Buttons of the first connected controller as a PAD_BTN_* mask (pad_keymap.h)
+ * @return true if a controller was available
+ */
+bool ps4_pad_buttons(uint32_t* buttons);
+
 /**
  * Set stick deadzone
  * @param dev_addr USB device address
@@ -87,6 +87,16 @@ uint8_t ps5_connected_count(void);
 bool ps5_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                         uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+/**
+ * Right stick of the first connected controller, -128..127, negative = left/up
+ */
+bool ps5_right_stick(int8_t* x, int8_t* y);
+
+/**
+ * Buttons of the first connected controller as a PAD_BTN_* mask (pad_keymap.h)
+ */
+bool ps5_pad_buttons(uint32_t* buttons);
+
 void ps5_set_deadzone(uint8_t dev_addr, int16_t deadzone);
 void ps5_mount_cb(uint8_t dev_addr);
 void ps5_unmount_cb(uint8_t dev_addr);
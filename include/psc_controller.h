@@ -36,6 +36,8 @@ void psc_to_atari(const psc_controller_t* psc, uint8_t joystick_num,
                   uint8_t* direction, uint8_t* fire);
 
 uint8_t psc_connected_count(void);
+bool psc_pad_buttons(uint32_t* buttons);  // PAD_BTN_* mask (pad_keymap.h), first pad
+
 void psc_mount_cb(uint8_t dev_addr);
 void psc_unmount_cb(uint8_t dev_addr);
 
@@ -0,0 +1,74 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * ST link (UART1 RX) error decode and reset/power-down detection, kept free
+ * of hardware access so it runs on the host.
+ *
+ * st_link_decode() classifies one UARTDR read from the RX interrupt. Only
+ * clean bytes, and bytes that merely flag an earlier overrun, go to the 6301.
+ *
+ * st_link_poll() runs from the main loop with one sample of the RX pin. A
+ * break, or the line held low for ST_LINK_LOW_US, takes the link down. The
+ * main loop can stall for longer than that while bytes arrive, so two low
+ * samples only count as one low period if the interrupt received nothing in
+ * between: a byte means the line went high again.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Link rates SerialPort::set_baud() accepts. 7812 is the ST's own ACIA
+// (500 kHz / 64); the others are 2x, 4x and 8x for accelerated hosts.
+#define ST_LINK_RATES   7812, 15625, 31250, 62500
+
+typedef enum {
+    ST_LINK_RX_BYTE = 0,    // Pass the byte on
+    ST_LINK_RX_BREAK,       // Line low for a whole frame: ST reset or power-down
+    ST_LINK_RX_ERROR        // Framing or parity error, drop the byte
+} st_link_rx_t;
+
+typedef struct {
+    bool     line_low;      // Last sample was low
+    bool     down;
+    uint32_t low_since;
+    uint32_t rx_count;      // Interrupt byte count at the last poll
+} st_link_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Classify a UARTDR value and count its errors in telemetry
+ */
+st_link_rx_t st_link_decode(uint32_t dr);
+
+/**
+ * Advance the link state with the RX pin level, the number of characters
+ * the interrupt has read so far (any class, wrapping), and whether it saw a
+ * break since the last call. Returns true once when the line is idle high
+ * after the link went down; the caller re-syncs the 6301.
+ */
+bool st_link_poll(st_link_t* link, bool rx_low, uint32_t rx_count, bool break_seen, uint32_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
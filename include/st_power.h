@@ -0,0 +1,83 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * ST power-state tracking for the low-power idle mode.
+ *
+ *   ON ---(ST absent)---> LEAVING ---(absent for ST_IDLE_DELAY_US)---> IDLE
+ *    ^                       |                                           |
+ *    +-----(ST present)------+------------------(ST present)-------------+
+ *
+ * The state machine only decides; main.cpp carries out the returned action
+ * (clock change, Core 1 park, slower servicing). Time spent in each state is
+ * kept so the console can show residency and an estimated average current.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    ST_POWER_ON = 0,
+    ST_POWER_LEAVING,       // ST just went away, still running at full speed
+    ST_POWER_IDLE,          // Low-power idle
+    ST_POWER_STATE_COUNT
+} st_power_state_t;
+
+typedef enum {
+    ST_POWER_NONE = 0,
+    ST_POWER_ENTER_IDLE,
+    ST_POWER_EXIT_IDLE
+} st_power_action_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Advance the state machine. Call every main loop pass with whether the ST
+ * looks powered, and act on the result.
+ */
+st_power_action_t st_power_update(bool st_present, uint32_t now_us);
+
+st_power_state_t st_power_state(void);
+bool st_power_idle(void);
+
+/**
+ * Idle mode on or off. Turning it off while idle makes the next update
+ * return ST_POWER_EXIT_IDLE.
+ */
+void st_power_set_enabled(bool enabled);
+bool st_power_enabled(void);
+
+/**
+ * Time spent in a state since boot, and the number of idle entries
+ */
+uint64_t st_power_residency_us(st_power_state_t state);
+uint32_t st_power_idle_entries(void);
+
+/**
+ * Average current since boot in uA, from residency weighted by the
+ * ST_POWER_*_UA estimates in config.h
+ */
+uint32_t st_power_estimate_ua(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -134,6 +134,16 @@ uint8_t stadia_connected_count(void);
 bool stadia_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                            uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+/**
+ * Right stick of the first connected controller, -128..127, negative = left/up
+ */
+bool stadia_right_stick(int8_t* x, int8_t* y);
+
+/**
+ * Buttons of the first connected controller as a PAD_BTN_* mask (pad_keymap.h)
+ */
+bool stadia_pad_buttons(uint32_t* buttons);
+
 /**
  * Mount callback - called when Stadia controller connected
  * @param dev_addr USB device address
@@ -0,0 +1,80 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Analog stick to mouse conversion, integer only.
+ *
+ * Stick deflection is normalised by the controller drivers to -127..127 per
+ * axis, negative being left/up. Each axis goes through a response curve:
+ *
+ *   t     = (|v| - dead_zone) / (127 - dead_zone)     0..1, Q16
+ *   speed = t^exponent * max_speed                    counts per second
+ *
+ * Motion is integrated over the elapsed time in Q16 count-microseconds, and
+ * whatever is short of a whole count is carried into the next update, so
+ * slow deflections still move and nothing is lost to rounding.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STICK_MOUSE_AXIS_MAX    127
+#define STICK_MOUSE_Q16_ONE     65536
+#define STICK_MOUSE_EXP_MAX     4
+
+typedef struct {
+    int32_t dead_zone;      // 0..STICK_MOUSE_AXIS_MAX-1
+    int32_t exponent;       // 1 (linear) .. STICK_MOUSE_EXP_MAX
+    int32_t max_speed;      // Counts per second at full deflection
+} stick_curve_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Live settings used by the HidInput stick mode, edited through the
+ * stick_* tunables
+ */
+stick_curve_t* stick_mouse_curve(void);
+bool stick_mouse_enabled(void);
+void stick_mouse_set_enabled(bool enabled);
+
+/**
+ * Curve output for one axis: signed speed in counts per second, Q16.
+ * Monotonic in v and zero inside the dead zone.
+ */
+int64_t stick_curve_eval(const stick_curve_t* curve, int32_t v);
+
+/**
+ * Advance by elapsed_us with the stick at (x, y) and return whole counts to
+ * move. The sub-count remainder is kept for the next call.
+ */
+void stick_mouse_update(const stick_curve_t* curve, int32_t x, int32_t y,
+                        uint32_t elapsed_us, int32_t* dx, int32_t* dy);
+
+/**
+ * Drop any accumulated remainder (mode switched off or stick released).
+ */
+void stick_mouse_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -50,6 +50,17 @@ extern "C" {
 
 #define MAX_SWITCH_CONTROLLERS  2
 
+// Pro Controller USB handshake, advanced by report/transfer callbacks and
+// switch_check_delayed_init(); nothing waits on the device
+typedef enum {
+    SWITCH_HS_NONE = 0,         // No handshake (not a Pro Controller)
+    SWITCH_HS_DELAY,            // Mounted, waiting PRO_INIT_DELAY_MS before starting
+    SWITCH_HS_SEND,             // Current step to be queued on the OUT pipe
+    SWITCH_HS_SENT,             // OUT transfer in flight
+    SWITCH_HS_REPLY,            // Sent, waiting for the step's reply
+    SWITCH_HS_DONE
+} switch_hs_state_t;
+
 typedef struct {
     uint8_t dev_addr;           // USB device address
     uint8_t instance;           // Instance number
@@ -66,6 +77,13 @@ typedef struct {
     // Configuration
     int16_t  deadzone;          // Stick deadzone (default 20)
     
+    // Handshake
+    uint8_t  hs_state;          // switch_hs_state_t
+    uint8_t  hs_step;           // Index into the handshake script
+    uint8_t  hs_tries;          // Sends of the current step
+    uint8_t  hs_counter;        // Subcommand packet counter (0-15)
+    uint32_t hs_deadline_ms;    // Start time (DELAY), busy pipe limit (SEND) or reply timeout
+    
 } switch_controller_t;
 
 //--------------------------------------------------------------------
@@ -150,6 +168,16 @@ uint8_t switch_connected_count(void);
 bool switch_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                            uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+/**
+ * Right stick of the first connected controller, -128..127, negative = left/up
+ */
+bool switch_right_stick(int8_t* x, int8_t* y);
+
+/**
+ * Buttons of the first connected controller as a PAD_BTN_* mask (pad_keymap.h)
+ */
+bool switch_pad_buttons(uint32_t* buttons);
+
 /**
  * Mount callback - called when Switch controller connected
  * @param dev_addr USB device address
@@ -222,15 +250,22 @@ void switch_get_raw_bytes(uint8_t* bytes, uint16_t* len);
 uint8_t switch_get_init_cmd_success(void);
 
 /**
- * Initialize Pro Controller (send USB handshake)
+ * Start the Pro Controller USB handshake now. Returns at once; each step is
+ * queued when the previous one has been answered.
  * @param dev_addr USB device address
- * @return true if initialization successful
+ * @return false if no controller is mounted at dev_addr
  */
 bool switch_init_pro_controller(uint8_t dev_addr);
 
 /**
- * Check and perform delayed Pro Controller initialization
- * Call this periodically from main loop
+ * Interrupt OUT transfer to a Switch controller completed
+ * @param dev_addr USB device address
+ */
+void switch_report_sent(uint8_t dev_addr);
+
+/**
+ * Start delayed Pro Controller handshakes and handle reply timeouts and
+ * retries. Call this periodically from main loop
  */
 void switch_check_delayed_init(void);
 
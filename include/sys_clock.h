@@ -0,0 +1,57 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Owner of the system clock. The console tunable "cpu_khz" and the
+ * low-power idle path both go through here, so the clock the firmware
+ * returns to after idle is always the one last configured.
+ *
+ * clk_peri follows clk_sys, so every change also recomputes the UART0
+ * console and ST link baud rate dividers.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Set the clock to run at while the ST is on. Applied at once, or only
+ * recorded while idle and applied by sys_clock_exit_idle(). False, with
+ * nothing changed, if the PLL cannot make the frequency.
+ */
+bool sys_clock_set_khz(uint32_t khz);
+
+/**
+ * The configured active clock, which is not the idle clock while idle
+ */
+uint32_t sys_clock_get_khz(void);
+
+/**
+ * Drop to idle_khz, and come back to the configured clock
+ */
+void sys_clock_enter_idle(uint32_t idle_khz);
+void sys_clock_exit_idle(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,263 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Telemetry registry: named counters, gauges, min/max and log2 histograms.
+ *
+ * Storage is sharded per core. Each core only ever writes its own shard, so
+ * the tm_* recorders are plain loads and stores with no locks or atomics.
+ * Readers sum the shards on demand. A metric must not be recorded from both
+ * thread and IRQ context on the same core (the increment is not atomic).
+ *
+ * Adding a metric: append it to one of the lists below. The short name is
+ * what the console and OLED page show, so keep it under 13 characters.
+ *
+ * Build with ENABLE_TELEMETRY=0 to compile every recorder to nothing.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+
+#if ENABLE_TELEMETRY
+#include "pico/platform.h"
+#endif
+
+#define TELEMETRY_CORES         2
+#define TELEMETRY_HIST_BUCKETS  12  // Bucket n holds values in [2^(n-1), 2^n), last is open ended
+
+// Monotonic event counts
+#define TELEMETRY_COUNTERS(X) \
+    X(CORE1_LOOPS,        "c1.loops")     \
+    X(CORE1_RUN_ENTER,    "c1.run_in")    \
+    X(CORE1_RUN_EXIT,     "c1.run_out")   \
+    X(CORE1_HEARTBEAT,    "c1.hb")        \
+    X(MAIN_LOOPS,         "main.loops")   \
+    X(MAIN_BT_POLLS,      "main.bt_poll") \
+    X(UART_TX_WAIT_SPINS, "uart.tx_spin") \
+    X(UART_RX_DEFERRED,   "uart.rx_def")  \
+    X(UART_RX_DROPPED,    "uart.rx_drop") \
+    X(UART_RX_FULL,       "uart.rx_full") \
+    X(UART_OVERRUN,       "uart.overrun") \
+    X(UART_FRAMING,       "uart.frame")   \
+    X(UART_PARITY,        "uart.parity")  \
+    X(UART_BREAK,         "uart.break")   \
+    X(ST_LINK_RESYNC,     "st.resync")    \
+    X(ST_IDLE_ENTER,      "st.idle_in")   \
+    X(SCI_OVERRUN,        "sci.overrun")  \
+    X(IQ_EVENTS,          "iq.events")    \
+    X(IQ_APPLIED,         "iq.applied")   \
+    X(IQ_OVERFLOW,        "iq.overflow")  \
+    X(IQ_REANCHOR,        "iq.reanchor")  \
+    X(USB_HID_MOUNTS,     "usb.mount")    \
+    X(USB_HID_UNMOUNTS,   "usb.unmount")  \
+    X(USB_HID_REPORTS,    "usb.report")   \
+    X(USB_HID_LENT,       "usb.lent")     \
+    X(USB_DESC_HIT,       "usb.dc_hit")   \
+    X(USB_DESC_MISS,      "usb.dc_miss")  \
+    X(USB_RI_FULL,        "usb.ri_full")  \
+    X(XBOX_REPORTS,       "xbox.report")  \
+    X(XBOX_LOOKUPS,       "xbox.lookup")  \
+    X(XBOX_READS,         "xbox.read")    \
+    X(XBOX_GIP_ACKS,      "xbox.gip_ack") \
+    X(XBOX_GIP_DUPS,      "xbox.gip_dup") \
+    X(GC_START_RETRY,     "gc.start_rty") \
+    X(SWITCH_HS_RETRY,    "sw.hs_retry")  \
+    X(SWITCH_HS_BUSY,     "sw.hs_busy")   \
+    X(UI_REDRAWS,         "ui.redraws")   \
+    X(JOY_GPIO_PATH,      "joy.gpio")     \
+    X(JOY_USB_PATH,       "joy.usb")      \
+    X(JOY_HID_OK,         "joy.hid_ok")   \
+    X(JOY_PS4_OK,         "joy.ps4_ok")   \
+    X(JOY_XBOX_OK,        "joy.xbox_ok")  \
+    X(JOY_SWITCH_OK,      "joy.sw_ok")    \
+    X(JOY_PAD_KEYS,       "joy.pad_keys") \
+    X(JOY_ARB_RESOLVE,    "joy.arb_run")  \
+    X(BT_KB_REPORTS,      "bt.kb_rpt")    \
+    X(BT_MOUSE_REPORTS,   "bt.ms_rpt")    \
+    X(BT_JOY_REPORTS,     "bt.joy_rpt")   \
+    X(BT_LE_UPDATES,      "bt.le_update") \
+    X(BT_SNIFF_EXITS,     "bt.sniff_out") \
+    X(BT_ENUM_PAUSES,     "bt.pauses")    \
+    X(BT_PAUSE_CAPPED,    "bt.pause_cap") \
+    X(BT_FLASH_WRITES,    "bt.flash_wr")  \
+    X(BT_KB_CB_DROP,      "bt.kb_drop")   \
+    X(BT_MOUSE_CB_DROP,   "bt.ms_drop")   \
+    X(BT_JOY_CB_DROP,     "bt.joy_drop")  \
+    X(BT_JOY_CB_EARLY,    "bt.joy_early") \
+    X(BT_KB_GET_OK,       "bt.kb_get")    \
+    X(BT_KB_GET_NOUPD,    "bt.kb_noupd")  \
+    X(BT_MOUSE_GET_OK,    "bt.ms_get")    \
+    X(BT_MOUSE_GET_NOUPD, "bt.ms_noupd")  \
+    X(BT_JOY_GET_OK,      "bt.joy_get")   \
+    X(BT_JOY_GET_NOUPD,   "bt.joy_noupd") \
+    X(HID_BT_KB_GET,      "hid.kb_get")   \
+    X(HID_BT_KB_PEEK,     "hid.kb_peek")  \
+    X(HID_BT_KB_NONE,     "hid.kb_none")  \
+    X(HID_BT_KB_KEYS,     "hid.kb_keys")  \
+    X(HID_BT_MS_GET,      "hid.ms_get")   \
+    X(HID_BT_MS_MISS,     "hid.ms_miss")  \
+    X(HID_BT_MS_MOVE,     "hid.ms_move")  \
+    X(HID_BT_JOY_GET,     "hid.joy_get")
+
+// Last written value wins
+#define TELEMETRY_GAUGES(X) \
+    X(CORE1_CYCLES,       "c1.cycles")    \
+    X(USB_HID_ACTIVE,     "usb.active")
+
+// Running minimum and maximum of sampled values
+#define TELEMETRY_MINMAX(X) \
+    X(UART_RX_QUEUE,      "uart.rx_q")
+
+// log2 distribution of sampled values
+#define TELEMETRY_HISTOGRAMS(X) \
+    X(MAIN_TICK_US,       "main.tick_us") \
+    X(BT_PAUSE_MS,        "bt.pause_ms")
+
+#define TM_ENUM(id, name) TM_##id,
+typedef enum { TELEMETRY_COUNTERS(TM_ENUM) TM_COUNTER_COUNT } tm_counter_t;
+typedef enum { TELEMETRY_GAUGES(TM_ENUM) TM_GAUGE_COUNT } tm_gauge_t;
+typedef enum { TELEMETRY_MINMAX(TM_ENUM) TM_MINMAX_COUNT } tm_minmax_t;
+typedef enum { TELEMETRY_HISTOGRAMS(TM_ENUM) TM_HIST_COUNT } tm_hist_t;
+#undef TM_ENUM
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+} tm_range_t;
+
+// One core's share of every metric. Only that core writes it.
+typedef struct {
+    volatile uint32_t  counter[TM_COUNTER_COUNT];
+    volatile tm_range_t range[TM_MINMAX_COUNT];
+    volatile uint32_t  hist[TM_HIST_COUNT][TELEMETRY_HIST_BUCKETS];
+} tm_shard_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if ENABLE_TELEMETRY
+
+extern tm_shard_t tm_shards[TELEMETRY_CORES];
+extern volatile uint32_t tm_gauges[TM_GAUGE_COUNT];
+
+static inline void tm_add(tm_counter_t id, uint32_t n) {
+    tm_shards[get_core_num()].counter[id] += n;
+}
+
+static inline void tm_inc(tm_counter_t id) {
+    tm_add(id, 1);
+}
+
+static inline void tm_set(tm_gauge_t id, uint32_t value) {
+    tm_gauges[id] = value;
+}
+
+static inline void tm_sample(tm_minmax_t id, uint32_t value) {
+    volatile tm_range_t* r = &tm_shards[get_core_num()].range[id];
+    if (value < r->min) r->min = value;
+    if (value > r->max) r->max = value;
+}
+
+static inline void tm_hist(tm_hist_t id, uint32_t value) {
+    uint32_t bucket = value ? 32 - __builtin_clz(value) : 0;
+    if (bucket >= TELEMETRY_HIST_BUCKETS) bucket = TELEMETRY_HIST_BUCKETS - 1;
+    tm_shards[get_core_num()].hist[id][bucket]++;
+}
+
+#else
+
+static inline void tm_add(tm_counter_t id, uint32_t n) { (void)id; (void)n; }
+static inline void tm_inc(tm_counter_t id) { (void)id; }
+static inline void tm_set(tm_gauge_t id, uint32_t value) { (void)id; (void)value; }
+static inline void tm_sample(tm_minmax_t id, uint32_t value) { (void)id; (void)value; }
+static inline void tm_hist(tm_hist_t id, uint32_t value) { (void)id; (void)value; }
+
+#endif
+
+/**
+ * Initialise min/max ranges. Call once from main() before Core 1 starts.
+ */
+void telemetry_init(void);
+
+/**
+ * Counter value summed over both cores, relative to the last reset.
+ */
+uint32_t telemetry_counter(tm_counter_t id);
+
+/**
+ * Current gauge value.
+ */
+uint32_t telemetry_gauge(tm_gauge_t id);
+
+/**
+ * Combined min/max over both cores. Returns false if nothing was sampled.
+ */
+bool telemetry_range(tm_minmax_t id, uint32_t* min, uint32_t* max);
+
+/**
+ * Histogram buckets summed over both cores, relative to the last reset.
+ */
+void telemetry_histogram(tm_hist_t id, uint32_t buckets[TELEMETRY_HIST_BUCKETS]);
+
+/**
+ * Zero counters and histograms without writing the other core's shard
+ * (a baseline is recorded instead). Min/max ranges are cleared in place, so
+ * a sample racing with the reset may survive it.
+ */
+void telemetry_reset(void);
+
+/**
+ * Number of lines telemetry_format_line() can produce (one per metric).
+ */
+int telemetry_line_count(void);
+
+/**
+ * Format metric number idx as a short "name value" line for the OLED page.
+ * Returns false if idx is out of range.
+ */
+bool telemetry_format_line(int idx, char* buf, size_t len);
+
+/**
+ * Print every metric to stdout, one per line.
+ */
+void telemetry_print_text(void);
+
+/**
+ * Print only what moved since the previous call: counters with a nonzero
+ * delta and gauges with a new value. For the periodic heartbeat; the
+ * console "tm" command prints everything.
+ */
+void telemetry_print_changes(void);
+
+/**
+ * Emit a binary snapshot through put(), framed as:
+ *   'T' 'M' version len_lo len_hi payload... checksum
+ * The payload is the counters, gauges, ranges (min,max) and histogram
+ * buckets as little-endian uint32 in list order. The checksum is the 8-bit
+ * two's complement of the sum of all preceding bytes after the 'T' 'M' marker.
+ */
+void telemetry_write_binary(void (*put)(uint8_t byte));
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * A runtime tunable. Every tunable is declared once, as a row of the table
+ * in tunables.cpp, with its bounds and default. Values outside [min, max]
+ * are rejected before set() is called.
+ */
+struct Tunable {
+    const char* name;
+    const char* help;
+    int32_t     min;
+    int32_t     max;
+    int32_t     def;
+    int8_t      nv_slot;    // Index into Settings::tunables, -1 if stored elsewhere
+    int32_t   (*get)();
+    bool      (*set)(int32_t value);   // Apply; false if the hardware refused
+};
+
+/**
+ * Number of registered tunables
+ */
+int tunable_count();
+
+/**
+ * Tunable by index, or nullptr if out of range
+ */
+const Tunable* tunable_at(int idx);
+
+/**
+ * Tunable by name, or nullptr if unknown
+ */
+const Tunable* tunable_find(const char* name);
+
+/**
+ * Bounds-checked set. Returns false if the value is out of range or could
+ * not be applied.
+ */
+bool tunable_set(const Tunable* t, int32_t value);
+
+/**
+ * Apply persisted values from NVSettings (defaults where none are saved).
+ * Call once at startup, after the system clock and UARTs are configured.
+ */
+void tunables_init();
+
+/**
+ * Restore every tunable to its default (not saved until tunables_save())
+ */
+void tunables_defaults();
+
+/**
+ * Write the current tunable values to flash
+ */
+void tunables_save();
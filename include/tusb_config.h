@@ -58,8 +58,8 @@ extern "C" {
 //--------------------------------------------------------------------
 
 #define CFG_TUH_HUB                 1
-#define CFG_TUH_DEVICE_MAX          4  // Number of non-hub devices
-#define CFG_TUH_HID                 8  // Number of HID interfaces (increased for multi-interface devices)
+#define CFG_TUH_DEVICE_MAX          6  // Number of non-hub devices
+#define CFG_TUH_HID                 12 // Number of HID interfaces (report layouts are pooled, hid_report_pool.h)
 #define CFG_TUH_MSC                 0
 #define CFG_TUH_CDC                 0
 // #define CFG_TUH_VENDOR              1  // Disabled - causes build errors with this TinyUSB version
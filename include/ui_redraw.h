@@ -0,0 +1,72 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Redraw scheduling for the OLED pages, apart from the display so it runs
+ * on the host.
+ *
+ * Each page has a dirty bit. The page on screen is drawn when its bit is
+ * set and its interval has passed since the last redraw of any page, so the
+ * notifications in between collapse into one redraw. A live page is drawn
+ * whenever its interval runs out, dirty or not. ui_redraw_now() lets the
+ * next check through at once (button feedback).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/time.h"
+
+#define UI_REDRAW_PAGES     7       // UserInterface::PAGE, in that order
+
+typedef struct {
+    uint32_t        dirty;          // Bit per page with stale content
+    absolute_time_t last;           // Last redraw of any page
+} ui_redraw_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Every page dirty, nothing drawn yet
+ */
+void ui_redraw_init(ui_redraw_t* r);
+
+/**
+ * Mark pages (a mask of 1 << page) as needing a redraw
+ */
+static inline void ui_redraw_invalidate(ui_redraw_t* r, uint32_t pages) {
+    r->dirty |= pages;
+}
+
+/**
+ * Draw page at the next ui_redraw_due(), whatever its interval
+ */
+void ui_redraw_now(ui_redraw_t* r, int page);
+
+/**
+ * True if page, on screen, should be drawn at now. Clears its dirty bit and
+ * starts the next interval.
+ */
+bool ui_redraw_due(ui_redraw_t* r, int page, absolute_time_t now);
+
+#ifdef __cplusplus
+}
+#endif
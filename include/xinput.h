@@ -195,6 +195,17 @@ uint8_t xinput_connected_count(void);
 bool xinput_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                            uint8_t* joy0_axis, uint8_t* joy0_fire);
 
+/**
+ * Right stick of the first connected controller, -128..127, negative = left/up
+ */
+bool xinput_right_stick(int8_t* x, int8_t* y);
+
+/**
+ * Buttons of the first connected controller as a PAD_BTN_* mask (pad_keymap.h).
+ * The analog triggers count as pressed past half travel.
+ */
+bool xinput_pad_buttons(uint32_t* buttons);
+
 #ifdef __cplusplus
 }
 #endif
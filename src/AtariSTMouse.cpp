@@ -20,9 +20,10 @@
 #include <math.h>
 #include "util.h"
 #include <stdio.h>
+#include "core_channel.h"
 
 #define MOUSE_MASK 0x33333333
-#define MAX_SPEED 50000.0
+#define MAX_SPEED 50000
 #define MIN_SPEED 480
 
 AtariSTMouse& AtariSTMouse::instance() {
@@ -59,7 +60,8 @@ void AtariSTMouse::update() {
         if (absolute_time_diff_us(tm, cycle_time) < 0) {
             // Time to cycle
             last_x_us = tm;
-            x_reg = (x_period_us > 0) ? _rotr(x_reg, 1) : _rotl(x_reg, 1);
+            uint32_t x = cc_get(&x_reg);
+            cc_put(&x_reg, (x_period_us > 0) ? _rotr(x, 1) : _rotl(x, 1));
             //gpio_put(14, x_reg & 1);
             //gpio_put(15, (x_reg & 2) ? 1 : 0);
         }
@@ -70,7 +72,8 @@ void AtariSTMouse::update() {
         if (absolute_time_diff_us(tm, cycle_time) < 0) {
             // Time to cycle
             last_y_us = tm;
-            y_reg = (y_period_us > 0) ? _rotr(y_reg, 1) : _rotl(y_reg, 1);
+            uint32_t y = cc_get(&y_reg);
+            cc_put(&y_reg, (y_period_us > 0) ? _rotr(y, 1) : _rotl(y, 1));
         }
     }
 }
@@ -85,7 +88,7 @@ void AtariSTMouse::set_speed_internal(int speed, int& period) {
         period = 0;
     }
     else {
-        period = (int)((MAX_SPEED / speed) * 1.0);
+        period = MAX_SPEED / speed;
         if ((speed > 0) && (period < MIN_SPEED)) {
             period = MIN_SPEED;
         }
@@ -96,11 +99,11 @@ void AtariSTMouse::set_speed_internal(int speed, int& period) {
 }
 
 const int AtariSTMouse::get_x_reg() const {
-    return x_reg;
+    return cc_get(&x_reg);
 }
 
 const int AtariSTMouse::get_y_reg() const{
-    return y_reg;
+    return cc_get(&y_reg);
 }
 
 void mouse_tick(int64_t cpu_cycles, int* x_counter, int* y_counter) {
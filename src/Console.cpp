@@ -0,0 +1,392 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "Console.h"
+#include "tunables.h"
+#include "telemetry.h"
+#include "6301.h"
+#include "core1_link.h"
+#include "mouse_merge.h"
+#include "st_power.h"
+#include "pad_keymap.h"
+#if ENABLE_BLUEPAD32
+#include "bluepad32_link.h"
+#endif
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+#include "hardware/watchdog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CONSOLE_UART    uart0
+#define MEM_DUMP_MAX    256
+
+typedef bool (*CommandFn)(int argc, char* argv[]);
+
+struct Command {
+    const char* name;
+    const char* usage;
+    CommandFn   fn;
+};
+
+static bool cmd_help(int argc, char* argv[]);
+
+static void print_tunable(const Tunable* t) {
+    printf("%-16s %-8ld [%ld..%ld] %s\n", t->name, (long)t->get(),
+           (long)t->min, (long)t->max, t->help);
+}
+
+static bool cmd_get(int argc, char* argv[]) {
+    if (argc < 2) {
+        for (int i = 0; i < tunable_count(); ++i) {
+            print_tunable(tunable_at(i));
+        }
+        return true;
+    }
+    const Tunable* t = tunable_find(argv[1]);
+    if (!t) {
+        printf("unknown tunable '%s'\n", argv[1]);
+        return false;
+    }
+    print_tunable(t);
+    return true;
+}
+
+static bool cmd_set(int argc, char* argv[]) {
+    int32_t value;
+    if (argc < 3) {
+        printf("usage: set <name> <value>\n");
+        return false;
+    }
+    const Tunable* t = tunable_find(argv[1]);
+    if (!t) {
+        printf("unknown tunable '%s'\n", argv[1]);
+        return false;
+    }
+    if (!Console::parse_int(argv[2], value)) {
+        printf("bad number '%s'\n", argv[2]);
+        return false;
+    }
+    if (value < t->min || value > t->max) {
+        printf("%s must be %ld..%ld\n", t->name, (long)t->min, (long)t->max);
+        return false;
+    }
+    if (!tunable_set(t, value)) {
+        printf("%s: could not apply %ld\n", t->name, (long)value);
+        return false;
+    }
+    print_tunable(t);
+    return true;
+}
+
+static bool cmd_save(int argc, char* argv[]) {
+    tunables_save();
+    printf("saved\n");
+    return true;
+}
+
+static bool cmd_defaults(int argc, char* argv[]) {
+    tunables_defaults();
+    printf("defaults restored (not saved)\n");
+    return true;
+}
+
+static void put_stdout(uint8_t byte) {
+    putchar_raw(byte);
+}
+
+static bool cmd_tm(int argc, char* argv[]) {
+    if (argc < 2) {
+        telemetry_print_text();
+    } else if (strcmp(argv[1], "reset") == 0) {
+        telemetry_reset();
+    } else if (strcmp(argv[1], "bin") == 0) {
+        telemetry_write_binary(put_stdout);
+    } else {
+        printf("usage: tm [reset|bin]\n");
+        return false;
+    }
+    return true;
+}
+
+static bool cmd_mice(int argc, char* argv[]) {
+    static const char* const class_names[MOUSE_CLASS_COUNT] = { "usb", "bt", "stick" };
+    mouse_merge_info_t info;
+    bool any = false;
+    for (int i = 0; i < MOUSE_MERGE_SOURCES; ++i) {
+        if (!mouse_merge_source_info(i, &info)) {
+            continue;
+        }
+        any = true;
+        printf("%03x %-5s %3u samples%s  %6lu cps  %4lu Hz  x%lu.%03lu\n", info.id,
+               info.cls < MOUSE_CLASS_COUNT ? class_names[info.cls] : "?",
+               info.samples, info.calibrated ? " (done)" : "       ",
+               (unsigned long)info.median_cps, (unsigned long)info.report_hz,
+               (unsigned long)(info.norm / MOUSE_NORM_ONE),
+               (unsigned long)((info.norm % MOUSE_NORM_ONE) * 1000 / MOUSE_NORM_ONE));
+    }
+    if (!any) {
+        printf("no mice\n");
+    }
+    return true;
+}
+
+static bool cmd_power(int argc, char* argv[]) {
+    static const char* const state_names[ST_POWER_STATE_COUNT] = { "on", "leaving", "idle" };
+    printf("state %s, idle %s, %lu idle entries\n", state_names[st_power_state()],
+           st_power_enabled() ? "enabled" : "disabled", (unsigned long)st_power_idle_entries());
+    for (int i = 0; i < ST_POWER_STATE_COUNT; ++i) {
+        printf("%-8s %10lu s\n", state_names[i],
+               (unsigned long)(st_power_residency_us((st_power_state_t)i) / 1000000u));
+    }
+    uint32_t ua = st_power_estimate_ua();
+    printf("est. average %lu.%lu mA\n", (unsigned long)(ua / 1000), (unsigned long)(ua % 1000 / 100));
+    return true;
+}
+
+static void print_pad_profile(int profile) {
+    pad_keymap_binding_t b;
+    printf("%d %s%s\n", profile, pad_keymap_profile_name(profile),
+           profile == pad_keymap_get_profile() ? " (active)" : "");
+    for (int i = 0; pad_keymap_binding(profile, i, &b); ++i) {
+        printf("  %-7s $%02x\n", pad_keymap_button_name(b.button), b.key);
+    }
+}
+
+static bool cmd_padkeys(int argc, char* argv[]) {
+    if (argc < 2) {
+        for (int p = 1; p < PAD_KEYMAP_PROFILE_COUNT; ++p) {
+            print_pad_profile(p);
+        }
+        return true;
+    }
+    if (strcmp(argv[1], "clear") == 0) {
+        pad_keymap_custom_clear();
+        return true;
+    }
+    int button = (argc > 2) ? pad_keymap_button_find(argv[2]) : -1;
+    int32_t key = 0;
+    bool ok = false;
+    if (button >= 0 && strcmp(argv[1], "bind") == 0 && argc > 3 &&
+        Console::parse_int(argv[3], key) && key > 0 && key < 128) {
+        ok = pad_keymap_custom_bind((uint8_t)button, (uint8_t)key);
+    } else if (button >= 0 && strcmp(argv[1], "unbind") == 0) {
+        ok = pad_keymap_custom_bind((uint8_t)button, 0);
+    }
+    if (!ok) {
+        printf("usage: padkeys [bind <button> <scancode> | unbind <button> | clear]\nbuttons:");
+        for (int i = 0; i < PAD_BTN_COUNT; ++i) {
+            printf(" %s", pad_keymap_button_name(i));
+        }
+        printf("\nscancode 1..$7f, %d rows, %d keys per button\n",
+               PAD_KEYMAP_CUSTOM_MAX, PAD_KEYMAP_KEYS_PER_BUTTON);
+        return false;
+    }
+    return true;
+}
+
+#if ENABLE_BLUEPAD32
+static bool cmd_btlink(int argc, char* argv[]) {
+    bluepad32_link_print();
+    return true;
+}
+#endif
+
+static bool cmd_regs(int argc, char* argv[]) {
+    hd6301_print_state();
+    return true;
+}
+
+static bool cmd_mem(int argc, char* argv[]) {
+    int32_t addr;
+    int32_t count = 16;
+    if (argc < 2 || !Console::parse_int(argv[1], addr) ||
+        (argc > 2 && !Console::parse_int(argv[2], count))) {
+        printf("usage: mem <addr> [len]\n");
+        return false;
+    }
+    if (addr < 0 || addr > 0xFFFF || count < 1 || count > MEM_DUMP_MAX) {
+        printf("addr 0..$ffff, len 1..%d\n", MEM_DUMP_MAX);
+        return false;
+    }
+    for (int32_t i = 0; i < count && addr + i <= 0xFFFF; ++i) {
+        if ((i & 15) == 0) {
+            printf("%s%04lx:", i ? "\n" : "", (unsigned long)(addr + i));
+        }
+        printf(" %02x", hd6301_peek((WORD)(addr + i)));
+    }
+    printf("\n");
+    return true;
+}
+
+static bool cmd_watch(int argc, char* argv[]) {
+    int32_t addr;
+    int32_t match = 0;
+    int32_t mask = 0xFF;
+    BYTE flags = 0;
+    int arg = 3;
+
+    if (argc < 2) {
+        hd6301_watch_print();
+        return true;
+    }
+    if (argc < 3 || !Console::parse_int(argv[1], addr) || addr < 0 || addr > 0xFFFF) {
+        printf("usage: watch <addr> <r|w|rw> [value [mask]] [log]\n");
+        return false;
+    }
+    for (const char* p = argv[2]; *p; ++p) {
+        if (*p == 'r') flags |= HD6301_WATCH_READ;
+        else if (*p == 'w') flags |= HD6301_WATCH_WRITE;
+    }
+    if (arg < argc && strcmp(argv[arg], "log") != 0) {
+        if (!Console::parse_int(argv[arg++], match)) {
+            printf("bad value\n");
+            return false;
+        }
+        flags |= HD6301_WATCH_VALUE;
+        if (arg < argc && strcmp(argv[arg], "log") != 0 &&
+            !Console::parse_int(argv[arg++], mask)) {
+            printf("bad mask\n");
+            return false;
+        }
+    }
+    if (arg < argc && strcmp(argv[arg], "log") == 0) {
+        flags |= HD6301_WATCH_LOG;
+    }
+    int slot = hd6301_watch_set((WORD)addr, flags, (BYTE)match, (BYTE)mask);
+    if (slot < 0) {
+        printf("watch not set (no free slot, bad access or not built)\n");
+        return false;
+    }
+    printf("watch %d set\n", slot);
+    return true;
+}
+
+static bool cmd_unwatch(int argc, char* argv[]) {
+    int32_t slot;
+    if (argc < 2) {
+        printf("usage: unwatch <slot|all>\n");
+        return false;
+    }
+    if (strcmp(argv[1], "all") == 0) {
+        hd6301_watch_clear_all();
+        return true;
+    }
+    if (!Console::parse_int(argv[1], slot) || hd6301_watch_clear(slot) < 0) {
+        printf("no watch %s\n", argv[1]);
+        return false;
+    }
+    return true;
+}
+
+static bool cmd_reset(int argc, char* argv[]) {
+    core1_request_reset();
+    printf("6301 reset requested\n");
+    return true;
+}
+
+static bool cmd_reboot(int argc, char* argv[]) {
+    printf("rebooting\n");
+    watchdog_reboot(0, 0, 10);
+    while (true) {
+        tight_loop_contents();
+    }
+    return true;
+}
+
+static const Command commands[] = {
+    { "help",     "list commands",                             cmd_help },
+    { "get",      "get [name]: show tunables",                 cmd_get },
+    { "set",      "set <name> <value>: change a tunable",      cmd_set },
+    { "save",     "save tunables to flash",                    cmd_save },
+    { "defaults", "restore default tunables",                  cmd_defaults },
+    { "tm",       "tm [reset|bin]: telemetry",                 cmd_tm },
+    { "mice",     "mouse sources and resolution calibration",  cmd_mice },
+    { "power",    "ST power state and idle residency",         cmd_power },
+    { "padkeys",  "padkeys [bind|unbind|clear]: gamepad keys", cmd_padkeys },
+#if ENABLE_BLUEPAD32
+    { "btlink",   "Bluetooth link intervals and sniff state",  cmd_btlink },
+#endif
+    { "regs",     "6301 registers",                            cmd_regs },
+    { "mem",      "mem <addr> [len]: 6301 memory dump",        cmd_mem },
+    { "watch",    "watch [<addr> <r|w|rw> [val [mask]] [log]]", cmd_watch },
+    { "unwatch",  "unwatch <slot|all>",                        cmd_unwatch },
+    { "reset",    "reset the 6301",                            cmd_reset },
+    { "reboot",   "reboot the adapter",                        cmd_reboot },
+};
+
+#define COMMAND_COUNT ((int)(sizeof(commands) / sizeof(commands[0])))
+
+static bool cmd_help(int argc, char* argv[]) {
+    for (int i = 0; i < COMMAND_COUNT; ++i) {
+        printf("%-9s %s\n", commands[i].name, commands[i].usage);
+    }
+    return true;
+}
+
+Console& Console::instance() {
+    static Console console;
+    return console;
+}
+
+bool Console::execute(char* cmdline) {
+    char* argv[CONSOLE_MAX_ARGS];
+    int argc = tokenize(cmdline, argv, CONSOLE_MAX_ARGS);
+
+    if (argc == 0) {
+        return true;
+    }
+    for (int i = 0; i < COMMAND_COUNT; ++i) {
+        if (strcmp(argv[0], commands[i].name) == 0) {
+            return commands[i].fn(argc, argv);
+        }
+    }
+    printf("unknown command '%s' (try help)\n", argv[0]);
+    return false;
+}
+
+void Console::poll() {
+    for (int n = 0; n < CONSOLE_POLL_CHARS && uart_is_readable(CONSOLE_UART); ++n) {
+        char c = (char)uart_getc(CONSOLE_UART);
+
+        if (c == '\r' || c == '\n') {
+            if (len == 0) {
+                continue;   // Second half of CRLF, or an empty line
+            }
+            printf("\n");
+            line[len] = '\0';
+            len = 0;
+            execute(line);
+            printf("> ");
+            return;         // At most one command per main loop pass
+        }
+        if (c == '\b' || c == 0x7F) {
+            if (len > 0) {
+                --len;
+                printf("\b \b");
+            }
+            continue;
+        }
+        if (c < ' ' || len >= CONSOLE_LINE_MAX - 1) {
+            continue;
+        }
+        line[len++] = c;
+        putchar_raw(c);
+    }
+}
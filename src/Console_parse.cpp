@@ -0,0 +1,80 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Console line parsing, kept apart from the UART and command code so the
+// host tests can build it on its own
+#include "Console.h"
+#include <stdlib.h>
+#include <errno.h>
+
+int Console::tokenize(char* line, char* argv[], int max_args) {
+    int argc = 0;
+    char* p = line;
+
+    while (*p && argc < max_args) {
+        while (*p == ' ' || *p == '\t') {
+            *p++ = '\0';
+        }
+        if (!*p) {
+            break;
+        }
+        argv[argc++] = p;
+        while (*p && *p != ' ' && *p != '\t') {
+            ++p;
+        }
+        if (*p) {
+            *p++ = '\0';       // End the token even when it is the last one taken
+        }
+    }
+    return argc;
+}
+
+bool Console::parse_int(const char* s, int32_t& out) {
+    bool neg = false;
+    int base = 10;
+    char* end;
+
+    if (*s == '-') {
+        neg = true;
+        ++s;
+    }
+    if (*s == '$') {
+        base = 16;
+        ++s;
+    } else if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        base = 16;
+        s += 2;
+    }
+    if (!*s || *s == '-' || *s == '+') {
+        return false;
+    }
+    errno = 0;
+    long long v = strtoll(s, &end, base);
+    if (*end || errno == ERANGE) {
+        return false;
+    }
+    if (neg) {
+        v = -v;
+    }
+    if (v < INT32_MIN || v > INT32_MAX) {
+        return false;
+    }
+    out = (int32_t)v;
+    return true;
+}
@@ -23,7 +23,6 @@
 #include "hid_app_host.h"
 #include "config.h"
 #include "hardware/clocks.h"
-#include "6301.h"
 #include "ssd1306.h"
 // xinput.h removed - using official xinput_host.h driver now
 #include "ps4_controller.h"
@@ -35,9 +34,17 @@
 #include "switch_controller.h"
 #include "stadia_controller.h"
 #include "usb_device_map.h"
+#include "telemetry.h"
+#include "tunables.h"
+#include "mouse_merge.h"
+#include "stick_mouse.h"
+#include "pad_keymap.h"
+#include "key_joystick.h"
+#include "input_queue.h"
+#include "core1_link.h"
+#include "core_channel.h"
 #include "xinput.h"
 #include "runtime_toggle.h"  // For usb_runtime_is_enabled() and bt_runtime_is_enabled()
-#include <map>
 #include <set>
 #include <deque>
 #include <algorithm>
@@ -47,14 +54,6 @@
 #if ENABLE_SERIAL_LOGGING
 #include "pico/time.h"
 
-static uint32_t hid_bt_kb_get = 0;
-static uint32_t hid_bt_kb_peek = 0;
-static uint32_t hid_bt_kb_none = 0;
-static uint32_t hid_bt_kb_keys_sent = 0;
-static uint32_t hid_bt_ms_get = 0;
-static uint32_t hid_bt_ms_miss = 0;
-static uint32_t hid_bt_ms_move = 0;
-static uint32_t hid_bt_joy_get = 0;
 static absolute_time_t hid_diag_last_snapshot = {0};
 #endif
 
@@ -97,7 +96,7 @@ extern ssd1306_t disp;  // External reference to display
 #define ATARI_KEY_P       25  // Atari ST scancode for 'P'
 #define ATARI_KEY_O       24  // Atari ST scancode for 'O'
 #define MAX_WHEEL_PULSES  32
-#define WHEEL_HOLD_TICKS  4   // 10 ms ticks; Core 1 reads via keydown(), not key_states directly
+#define WHEEL_HOLD_TICKS  4   // 10 ms ticks; folded into keydown(), not key_states directly
 #if ENABLE_BLUEPAD32
 #define BT_MOUSE_SLOTS    2  // MAX_BT_MICE in bluepad32_platform.c
 #endif
@@ -105,21 +104,13 @@ extern ssd1306_t disp;  // External reference to display
 #define GET_I32_VALUE(item)     (int32_t)(item->Value | ((item->Value & (1 << (item->Attributes.BitSize-1))) ? ~((1 << item->Attributes.BitSize) - 1) : 0))
 #define JOY_GPIO_INIT(io)       gpio_init(io); gpio_set_dir(io, GPIO_IN); gpio_pull_up(io);
 
-static std::map<int, uint8_t*> device;
+static std::set<int> device;   // USB HID interfaces in use (mouse half of a combo device: addr + 128)
 static UserInterface* ui_ = nullptr;
 static int kb_count = 0;
 static int mouse_count = 0;
 static int joy_count = 0;  // HID joysticks (not Xbox)
 static std::set<uint8_t> gc_counted_devices;  // Track GameCube devices already counted
 
-// Path counters (file-level static, accessed via getters)
-static uint32_t g_gpio_path_count = 0;
-static uint32_t g_usb_path_count = 0;
-static uint32_t g_hid_joy_success = 0;
-static uint32_t g_ps4_success = 0;
-static uint32_t g_xbox_success = 0;
-static uint32_t g_switch_success = 0;
-
 // Llamatron (dual-stick) mode state
 static bool g_llamatron_mode = false;
 static bool g_llamatron_active = false;
@@ -134,7 +125,20 @@ static bool g_llama_paused = false;  // Track pause state to toggle between P an
 
 static std::deque<uint8_t> wheel_pulses;
 static std::bitset<128> wheel_prev_mask;
-static volatile uint8_t wheel_hold_frames[128] = {0};
+static uint8_t wheel_hold_frames[128] = {0};
+// Keys held by gamepad buttons (pad_keymap.h). Kept apart from key_states,
+// which the BT keyboard peek rebuilds every tick.
+static uint8_t pad_key_down[128] = {0};
+
+// What Core 1 sees, written by publish_input() (core_channel.h). Without the
+// input queue the key bitmap, buttons and joystick go out as one state block.
+#if !ENABLE_INPUT_QUEUE
+static cc_seq_t st_input_seq;
+static uint32_t st_input_keys[4];
+static uint32_t st_input_mouse;
+static uint32_t st_input_joy;
+#endif
+static uint32_t st_input_mouse_en;
 
 static void enqueue_wheel_pulses(int delta) {
     if (delta == 0) {
@@ -155,7 +159,7 @@ static void enqueue_wheel_pulses(int delta) {
         wheel_pulses.push_back(key);
     }
 
-    // Core 1 reads keydown() while Core 0 rebuilds key_states (BT keyboard peek).
+    // Held apart from key_states, which the BT keyboard peek rebuilds
     wheel_hold_frames[key] = WHEEL_HOLD_TICKS;
 }
 
@@ -176,14 +180,6 @@ bool xinput_check_menu_or_start_button(void);
 // Xbox controller counter (extern, modified by main.cpp xinput callbacks)
 int xinput_joy_count = 0;
 
-// Getters for path counters
-uint32_t get_gpio_path_count() { return g_gpio_path_count; }
-uint32_t get_usb_path_count() { return g_usb_path_count; }
-uint32_t get_hid_joy_success() { return g_hid_joy_success; }
-uint32_t get_ps4_success() { return g_ps4_success; }
-uint32_t get_xbox_success() { return g_xbox_success; }
-uint32_t get_switch_success() { return g_switch_success; }
-
 #if ENABLE_BLUEPAD32
 extern "C" {
     int bluepad32_get_connected_count(void);
@@ -249,6 +245,9 @@ extern "C" {
     bool bluepad32_get_keyboard(int idx, void* out_keyboard);
     bool bluepad32_peek_keyboard(int idx, void* out_keyboard);
     bool bluepad32_get_mouse(int idx, void* out_mouse);
+    bool bluepad32_mouse_connected(int idx);
+    bool bluepad32_right_stick(int8_t* x, int8_t* y);
+    bool bluepad32_pad_buttons(uint32_t* buttons);
     int bluepad32_get_keyboard_count(void);
     int bluepad32_get_mouse_count(void);
 }
@@ -353,6 +352,39 @@ static bool collect_llamatron_sample(uint8_t& joy1_axis, uint8_t& joy1_fire,
     return false;
 }
 
+// Right stick of the first connected pad, normalised to -128..127
+static bool collect_right_stick(int8_t& x, int8_t& y) {
+    if (ps4_right_stick(&x, &y)) return true;
+    if (ps5_right_stick(&x, &y)) return true;
+    if (horipad_right_stick(&x, &y)) return true;
+    if (ps3_right_stick(&x, &y)) return true;
+    if (switch_right_stick(&x, &y)) return true;
+    if (stadia_right_stick(&x, &y)) return true;
+    if (xinput_right_stick(&x, &y)) return true;
+    if (gc_right_stick(&x, &y)) return true;
+#if ENABLE_BLUEPAD32
+    if (bt_runtime_is_enabled() && bluepad32_right_stick(&x, &y)) return true;
+#endif
+    return false;
+}
+
+// Buttons of the first connected pad as a PAD_BTN_* mask
+static bool collect_pad_buttons(uint32_t& buttons) {
+    if (ps4_pad_buttons(&buttons)) return true;
+    if (ps5_pad_buttons(&buttons)) return true;
+    if (psc_pad_buttons(&buttons)) return true;
+    if (horipad_pad_buttons(&buttons)) return true;
+    if (ps3_pad_buttons(&buttons)) return true;
+    if (switch_pad_buttons(&buttons)) return true;
+    if (stadia_pad_buttons(&buttons)) return true;
+    if (xinput_pad_buttons(&buttons)) return true;
+    if (gc_pad_buttons(&buttons)) return true;
+#if ENABLE_BLUEPAD32
+    if (bt_runtime_is_enabled() && bluepad32_pad_buttons(&buttons)) return true;
+#endif
+    return false;
+}
+
 // Check for menu/options/start button press across all controller types
 // Returns true if button is currently pressed
 static bool check_llamatron_pause_button() {
@@ -468,9 +500,9 @@ void tuh_hid_mounted_cb(uint8_t dev_addr) {
     
     if (tp == HID_KEYBOARD) {
         // For keyboards, check if already registered (prevent multi-interface conflict)
-        if (device.find(actual_addr) == device.end()) {
-            device[actual_addr] = new uint8_t[sizeof(hid_keyboard_report_t)];
-            hid_app_request_report(actual_addr, device[actual_addr]);
+        if (!device.count(actual_addr)) {
+            device.insert(actual_addr);
+            hid_app_request_report(actual_addr);
             ++kb_count;
             usb_map_set_keyboard("USB Keyboard");
         }
@@ -478,18 +510,18 @@ void tuh_hid_mounted_cb(uint8_t dev_addr) {
     else if (tp == HID_MOUSE) {
         // For mice, always use actual address (same as keyboard on Logitech Unifying)
         // If keyboard already registered, skip - we'll handle mouse separately
-        if (device.find(actual_addr) == device.end()) {
-            device[actual_addr] = new uint8_t[tuh_hid_get_report_size(actual_addr)];
-            hid_app_request_report(actual_addr, device[actual_addr]);
+        if (!device.count(actual_addr)) {
+            device.insert(actual_addr);
+            hid_app_request_report(actual_addr);
             ++mouse_count;
             usb_map_set_mouse("USB Mouse");
         } else {
             // Address already used - this is a multi-interface device
             // Add mouse with offset address
             int mouse_key = actual_addr + 128;
-            device[mouse_key] = new uint8_t[tuh_hid_get_report_size(actual_addr)];
+            device.insert(mouse_key);
             // Use mouse_key here so find_device() finds the MOUSE device, not keyboard
-            hid_app_request_report(mouse_key, device[mouse_key]);
+            hid_app_request_report(mouse_key);
             ++mouse_count;
             usb_map_set_mouse("USB Mouse");
         }
@@ -504,9 +536,9 @@ void tuh_hid_mounted_cb(uint8_t dev_addr) {
         
         // Check if already registered (prevent multi-interface duplicate counting)
         // Also skip if it's a GameCube adapter (counted separately)
-        if (!is_gamecube && device.find(actual_addr) == device.end()) {
-            device[actual_addr] = new uint8_t[tuh_hid_get_report_size(actual_addr)];
-            hid_app_request_report(actual_addr, device[actual_addr]);
+        if (!is_gamecube && !device.count(actual_addr)) {
+            device.insert(actual_addr);
+            hid_app_request_report(actual_addr);
             ++joy_count;
             if (!usb_map_gamepad_registered(actual_addr)) {
                 usb_map_register_gamepad(actual_addr, "USB Gamepad");
@@ -525,6 +557,9 @@ void tuh_hid_mounted_cb(uint8_t dev_addr) {
 
 void tuh_hid_unmounted_cb(uint8_t dev_addr) {
     HID_TYPE tp = tuh_hid_get_type(dev_addr);
+    // Release held buttons, including the mouse half of a keyboard/mouse combo
+    mouse_merge_remove(dev_addr);
+    mouse_merge_remove(dev_addr + 128);
     if (tp == HID_KEYBOARD) {
         // printf("A keyboard device (address %d) is unmounted\r\n", dev_addr);
         --kb_count;
@@ -546,20 +581,10 @@ void tuh_hid_unmounted_cb(uint8_t dev_addr) {
         --joy_count;
         usb_map_unregister_gamepad(dev_addr);
     }
-    auto it = device.find(dev_addr);
-    if (it != device.end()) {
-        delete[] it->second;
-        device.erase(it);
-    }
+    device.erase(dev_addr);
     notify_ui_device_counts();
 }
 
-// invoked ISR context
-void tuh_hid_isr(uint8_t dev_addr, xfer_result_t event) {
-    (void) dev_addr;
-    (void) event;
-}
-
 }
 
 HidInput::HidInput() {
@@ -608,12 +633,13 @@ void HidInput::handle_keyboard() {
 
     bool keyboard_handled = false;
 
-    for (auto it : device) {
-        if (tuh_hid_get_type(it.first) != HID_KEYBOARD) {
+    for (int key : device) {
+        if (tuh_hid_get_type(key) != HID_KEYBOARD) {
             continue;
         }
-        if (tuh_hid_is_mounted(it.first) && !tuh_hid_is_busy(it.first)) {
-            hid_keyboard_report_t* kb = (hid_keyboard_report_t*)it.second;
+        if (tuh_hid_is_mounted(key) && !tuh_hid_is_busy(key)) {
+            const hid_keyboard_report_t* kb = (const hid_keyboard_report_t*)hid_app_get_report(key);
+            const uint32_t report_us = hid_app_get_report_time(key);
 
             // Check for Ctrl+F12 to toggle mouse mode
             static bool last_toggle_state = false;
@@ -660,7 +686,7 @@ void HidInput::handle_keyboard() {
             }
             if (alt_pressed && plus_pressed) {
                 if (!last_plus_state) {
-                    set_sys_clock_khz(270000, false);
+                    tunable_set(tunable_find("cpu_khz"), 270000);
                     last_plus_state = true;
                 }
             } else {
@@ -678,7 +704,7 @@ void HidInput::handle_keyboard() {
             }
             if (alt_pressed && minus_pressed) {
                 if (!last_minus_state) {
-                    set_sys_clock_khz(150000, false);
+                    tunable_set(tunable_find("cpu_khz"), 150000);
                     last_minus_state = true;
                 }
             } else {
@@ -707,15 +733,15 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // First disable joystick reporting (0x1A = disable joystick)
-                    hd6301_receive_byte(0x1A);
-                    hd6301_receive_byte(0x00);  // Disable both joysticks
+                    core1_queue_rx_byte(0x1A);
+                    core1_queue_rx_byte(0x00);  // Disable both joysticks
                     
                     // Enable mouse reporting (0x92 0x00 = enable mouse)
-                    hd6301_receive_byte(0x92);
-                    hd6301_receive_byte(0x00);  // Enable mouse
+                    core1_queue_rx_byte(0x92);
+                    core1_queue_rx_byte(0x00);  // Enable mouse
                     
                     // Then send 0x08 (SET RELATIVE MOUSE MODE) to HD6301
-                    hd6301_receive_byte(0x08);
+                    core1_queue_rx_byte(0x08);
                     
 #if ENABLE_OLED_DISPLAY
                     // Small delay so user can see the message
@@ -750,21 +776,21 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // First disable joystick reporting (0x1A = disable joystick)
-                    hd6301_receive_byte(0x1A);
-                    hd6301_receive_byte(0x00);  // Disable both joysticks
+                    core1_queue_rx_byte(0x1A);
+                    core1_queue_rx_byte(0x00);  // Disable both joysticks
                     
                     // Enable mouse reporting (0x92 0x00 = enable mouse)
-                    hd6301_receive_byte(0x92);
-                    hd6301_receive_byte(0x00);  // Enable mouse
+                    core1_queue_rx_byte(0x92);
+                    core1_queue_rx_byte(0x00);  // Enable mouse
                     
                     // Then send 0x09 (SET ABSOLUTE MOUSE MODE) to HD6301
                     // Format: 0x09 Xmax_MSB Xmax_LSB Ymax_MSB Ymax_LSB
                     // Using standard ST high-res: 640x400
-                    hd6301_receive_byte(0x09);
-                    hd6301_receive_byte(0x02);  // Xmax MSB (640 = 0x0280)
-                    hd6301_receive_byte(0x80);  // Xmax LSB
-                    hd6301_receive_byte(0x01);  // Ymax MSB (400 = 0x0190)
-                    hd6301_receive_byte(0x90);  // Ymax LSB
+                    core1_queue_rx_byte(0x09);
+                    core1_queue_rx_byte(0x02);  // Xmax MSB (640 = 0x0280)
+                    core1_queue_rx_byte(0x80);  // Xmax LSB
+                    core1_queue_rx_byte(0x01);  // Ymax MSB (400 = 0x0190)
+                    core1_queue_rx_byte(0x90);  // Ymax LSB
                     
 #if ENABLE_OLED_DISPLAY
                     // Small delay so user can see the message
@@ -799,19 +825,19 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // First disable joystick reporting (0x1A = disable joystick)
-                    hd6301_receive_byte(0x1A);
-                    hd6301_receive_byte(0x00);  // Disable both joysticks
+                    core1_queue_rx_byte(0x1A);
+                    core1_queue_rx_byte(0x00);  // Disable both joysticks
                     
                     // Enable mouse reporting (0x92 0x00 = enable mouse)
-                    hd6301_receive_byte(0x92);
-                    hd6301_receive_byte(0x00);  // Enable mouse
+                    core1_queue_rx_byte(0x92);
+                    core1_queue_rx_byte(0x00);  // Enable mouse
                     
                     // Then send 0x0A (SET MOUSE KEYCODE MODE) to HD6301
                     // Format: 0x0A deltaX deltaY
                     // Using 1,1 as reasonable defaults (1 pixel per keypress)
-                    hd6301_receive_byte(0x0A);
-                    hd6301_receive_byte(0x01);  // deltaX = 1
-                    hd6301_receive_byte(0x01);  // deltaY = 1
+                    core1_queue_rx_byte(0x0A);
+                    core1_queue_rx_byte(0x01);  // deltaX = 1
+                    core1_queue_rx_byte(0x01);  // deltaY = 1
                     
 #if ENABLE_OLED_DISPLAY
                     // Small delay so user can see the message
@@ -846,7 +872,7 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // Send 0x14 (SET JOYSTICK EVENT REPORTING) to HD6301
-                    hd6301_receive_byte(0x14);
+                    core1_queue_rx_byte(0x14);
                     
 #if ENABLE_OLED_DISPLAY
                     // Small delay so user can see the message
@@ -883,7 +909,7 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // Trigger the reset
-                    hd6301_trigger_reset();
+                    core1_request_reset();
                     last_reset_state = true;
                 }
             } else {
@@ -1028,7 +1054,7 @@ void HidInput::handle_keyboard() {
                 // Try idx 0 first (standard), then 1, 2 for wireless receivers
                 bool led_sent = false;
                 for (uint8_t idx = 0; idx < 3 && !led_sent; idx++) {
-                    if (tuh_hid_set_report(it.first, idx, 0, HID_REPORT_TYPE_OUTPUT, &led_report, sizeof(led_report))) {
+                    if (tuh_hid_set_report(key, idx, 0, HID_REPORT_TYPE_OUTPUT, &led_report, sizeof(led_report))) {
                         led_sent = true;
                     }
                 }
@@ -1118,8 +1144,9 @@ void HidInput::handle_keyboard() {
             key_states[ATARI_ALT] = ((kb->modifier & KEYBOARD_MODIFIER_LEFTALT) ||
                                       (kb->modifier & KEYBOARD_MODIFIER_RIGHTALT)) ? 1 : 0;
             // Trigger the next report
-            hid_app_request_report(it.first, it.second);
+            hid_app_request_report(key);
             keyboard_handled = true;
+            publish_input(report_us);
         }
     }
 
@@ -1167,20 +1194,14 @@ void HidInput::handle_keyboard() {
         
         if (bt_kb_count > 0) {
             bool has_data = bluepad32_get_keyboard(0, &bt_kb);
-#if ENABLE_SERIAL_LOGGING
             if (has_data) {
-                hid_bt_kb_get++;
+                tm_inc(TM_HID_BT_KB_GET);
             } else if (bluepad32_peek_keyboard(0, &bt_kb)) {
                 has_data = true;
-                hid_bt_kb_peek++;
+                tm_inc(TM_HID_BT_KB_PEEK);
             } else {
-                hid_bt_kb_none++;
+                tm_inc(TM_HID_BT_KB_NONE);
             }
-#else
-            if (!has_data) {
-                has_data = bluepad32_peek_keyboard(0, &bt_kb);
-            }
-#endif
             
             if (has_data) {
                 // Convert Bluepad32 keyboard format to TinyUSB format
@@ -1269,15 +1290,15 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // First disable joystick reporting (0x1A = disable joystick)
-                    hd6301_receive_byte(0x1A);
-                    hd6301_receive_byte(0x00);  // Disable both joysticks
+                    core1_queue_rx_byte(0x1A);
+                    core1_queue_rx_byte(0x00);  // Disable both joysticks
                     
                     // Enable mouse reporting (0x92 0x00 = enable mouse)
-                    hd6301_receive_byte(0x92);
-                    hd6301_receive_byte(0x00);  // Enable mouse
+                    core1_queue_rx_byte(0x92);
+                    core1_queue_rx_byte(0x00);  // Enable mouse
                     
                     // Then send 0x08 (SET RELATIVE MOUSE MODE) to HD6301
-                    hd6301_receive_byte(0x08);
+                    core1_queue_rx_byte(0x08);
                     
 #if ENABLE_OLED_DISPLAY
                     // Small delay so user can see the message
@@ -1305,21 +1326,21 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // First disable joystick reporting (0x1A = disable joystick)
-                    hd6301_receive_byte(0x1A);
-                    hd6301_receive_byte(0x00);  // Disable both joysticks
+                    core1_queue_rx_byte(0x1A);
+                    core1_queue_rx_byte(0x00);  // Disable both joysticks
                     
                     // Enable mouse reporting (0x92 0x00 = enable mouse)
-                    hd6301_receive_byte(0x92);
-                    hd6301_receive_byte(0x00);  // Enable mouse
+                    core1_queue_rx_byte(0x92);
+                    core1_queue_rx_byte(0x00);  // Enable mouse
                     
                     // Then send 0x09 (SET ABSOLUTE MOUSE MODE) to HD6301
                     // Format: 0x09 Xmax_MSB Xmax_LSB Ymax_MSB Ymax_LSB
                     // Using standard ST high-res: 640x400
-                    hd6301_receive_byte(0x09);
-                    hd6301_receive_byte(0x02);  // Xmax MSB (640 = 0x0280)
-                    hd6301_receive_byte(0x80);  // Xmax LSB
-                    hd6301_receive_byte(0x01);  // Ymax MSB (400 = 0x0190)
-                    hd6301_receive_byte(0x90);  // Ymax LSB
+                    core1_queue_rx_byte(0x09);
+                    core1_queue_rx_byte(0x02);  // Xmax MSB (640 = 0x0280)
+                    core1_queue_rx_byte(0x80);  // Xmax LSB
+                    core1_queue_rx_byte(0x01);  // Ymax MSB (400 = 0x0190)
+                    core1_queue_rx_byte(0x90);  // Ymax LSB
                     
 #if ENABLE_OLED_DISPLAY
                     // Small delay so user can see the message
@@ -1347,19 +1368,19 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // First disable joystick reporting (0x1A = disable joystick)
-                    hd6301_receive_byte(0x1A);
-                    hd6301_receive_byte(0x00);  // Disable both joysticks
+                    core1_queue_rx_byte(0x1A);
+                    core1_queue_rx_byte(0x00);  // Disable both joysticks
                     
                     // Enable mouse reporting (0x92 0x00 = enable mouse)
-                    hd6301_receive_byte(0x92);
-                    hd6301_receive_byte(0x00);  // Enable mouse
+                    core1_queue_rx_byte(0x92);
+                    core1_queue_rx_byte(0x00);  // Enable mouse
                     
                     // Then send 0x0A (SET MOUSE KEYCODE MODE) to HD6301
                     // Format: 0x0A deltaX deltaY
                     // Using 1,1 as reasonable defaults (1 pixel per keypress)
-                    hd6301_receive_byte(0x0A);
-                    hd6301_receive_byte(0x01);  // deltaX = 1
-                    hd6301_receive_byte(0x01);  // deltaY = 1
+                    core1_queue_rx_byte(0x0A);
+                    core1_queue_rx_byte(0x01);  // deltaX = 1
+                    core1_queue_rx_byte(0x01);  // deltaY = 1
                     
 #if ENABLE_OLED_DISPLAY
                     // Small delay so user can see the message
@@ -1388,7 +1409,7 @@ void HidInput::handle_keyboard() {
 #endif
                     
                     // Trigger the reset
-                    hd6301_trigger_reset();
+                    core1_request_reset();
                     last_bt_reset_state = true;
                 }
             } else {
@@ -1477,7 +1498,7 @@ void HidInput::handle_keyboard() {
             }
             if (alt_pressed && plus_pressed) {
                 if (!last_bt_plus_state) {
-                    set_sys_clock_khz(270000, false);
+                    tunable_set(tunable_find("cpu_khz"), 270000);
                     last_bt_plus_state = true;
                 }
             } else {
@@ -1495,7 +1516,7 @@ void HidInput::handle_keyboard() {
             }
             if (alt_pressed && minus_pressed) {
                 if (!last_bt_minus_state) {
-                    set_sys_clock_khz(150000, false);
+                    tunable_set(tunable_find("cpu_khz"), 150000);
                     last_bt_minus_state = true;
                 }
             } else {
@@ -1565,11 +1586,9 @@ void HidInput::handle_keyboard() {
                                           (kb_report.modifier & KEYBOARD_MODIFIER_RIGHTCTRL)) ? 1 : 0;
                 key_states[ATARI_ALT] = ((kb_report.modifier & KEYBOARD_MODIFIER_LEFTALT) ||
                                           (kb_report.modifier & KEYBOARD_MODIFIER_RIGHTALT)) ? 1 : 0;
-#if ENABLE_SERIAL_LOGGING
                 if (kb_report.modifier != 0 || key_count > 0) {
-                    hid_bt_kb_keys_sent++;
+                    tm_inc(TM_HID_BT_KB_KEYS);
                 }
-#endif
             }
         }
     }
@@ -1583,23 +1602,27 @@ void HidInput::handle_keyboard() {
     }
 
     decay_wheel_hold_frames();
+    publish_input(time_us_32());
 }
 
 namespace {
 
 constexpr int MOUSE_REPORT_DRAIN_MAX = 32;
+constexpr int64_t STICK_MOUSE_MAX_STEP_US = 50000;  // Cap after a stalled loop
+constexpr uint16_t STICK_MOUSE_ID = 0x200;
 
-// Mild extra gain when accumulated delta exceeds one HID report (fast flick).
+// Mild extra gain when accumulated delta exceeds one HID report (fast flick):
+// 1 + 0.0035 per count over 96, capped at 1.45x. Integer only, in 1/10000ths.
 static int scale_mouse_burst(int v) {
     const int av = v < 0 ? -v : v;
     if (av <= 96) {
         return v;
     }
-    double factor = 1.0 + 0.0035 * static_cast<double>(av - 96);
-    if (factor > 1.45) {
-        factor = 1.45;
+    int factor = 10000 + 35 * (av - 96);
+    if (factor > 14500) {
+        factor = 14500;
     }
-    return static_cast<int>(static_cast<double>(v) * factor);
+    return static_cast<int>(static_cast<int64_t>(v) * factor / 10000);
 }
 
 struct UsbMouseSample {
@@ -1608,12 +1631,16 @@ struct UsbMouseSample {
     int wheel_delta = 0;
     int8_t buttons = 0;
     bool have_buttons = false;
+    bool absolute = false;      // dx/dy are a position in [0, max_x] x [0, max_y]
+    bool in_range = true;       // Digitizer stylus/finger present
+    int32_t max_x = 0;
+    int32_t max_y = 0;
 };
 
-bool parse_usb_mouse_report(uint8_t dev_key, const uint8_t* js, hid_mouse_report_t* mouse,
+bool parse_usb_mouse_report(uint8_t dev_key, const uint8_t* js, const hid_mouse_report_t* mouse,
                             bool is_multi_interface_mouse, UsbMouseSample& out) {
     out = {};
-    HID_ReportInfo_t* info = tuh_hid_get_report_info(dev_key);
+    hid_layout_t* info = tuh_hid_get_report_info(dev_key);
 
     if (is_multi_interface_mouse) {
         out.buttons = js[0];
@@ -1645,10 +1672,25 @@ bool parse_usb_mouse_report(uint8_t dev_key, const uint8_t* js, hid_mouse_report
                        ((item->Attributes.Usage.Usage == USAGE_X) ||
                         (item->Attributes.Usage.Usage == USAGE_Y)) &&
                        (item->ItemType == HID_REPORT_ITEM_In)) {
+                const bool relative = (item->ItemFlags & HID_IOF_RELATIVE) != 0;
+                const int32_t value = relative ? GET_I32_VALUE(item) : (int32_t)item->Value;
+                if (!relative) {
+                    out.absolute = true;
+                }
                 if (item->Attributes.Usage.Usage == USAGE_X) {
-                    out.dx = GET_I32_VALUE(item);
+                    out.dx = value;
+                    out.max_x = (int32_t)item->Attributes.Logical.Maximum;
                 } else {
-                    out.dy = GET_I32_VALUE(item);
+                    out.dy = value;
+                    out.max_y = (int32_t)item->Attributes.Logical.Maximum;
+                }
+            } else if ((item->Attributes.Usage.Page == USAGE_PAGE_DIGITIZER) &&
+                       (item->ItemType == HID_REPORT_ITEM_In)) {
+                if (item->Attributes.Usage.Usage == USAGE_DIGITIZER_IN_RANGE) {
+                    out.in_range = item->Value != 0;
+                } else if (item->Attributes.Usage.Usage == USAGE_DIGITIZER_TIP_SWITCH) {
+                    out.buttons |= item->Value ? MOUSE_MERGE_LEFT : 0;
+                    out.have_buttons = true;
                 }
             } else if ((item->Attributes.Usage.Page == USAGE_PAGE_GENERIC_DCTRL) &&
                        (item->Attributes.Usage.Usage == 0x38) &&
@@ -1685,44 +1727,52 @@ void HidInput::handle_mouse(const int64_t cpu_cycles) {
     int32_t x = 0;
     int32_t y = 0;
 
+    mouse_merge_begin(time_us_32());
+
     if (usb_runtime_is_enabled()) {
         tuh_task();
 
-        for (auto it : device) {
-            if (tuh_hid_get_type(it.first) != HID_MOUSE) {
+        for (int key : device) {
+            if (tuh_hid_get_type(key) != HID_MOUSE) {
                 continue;
             }
 
-            const bool is_multi_interface_mouse = (it.first >= 128);
+            const bool is_multi_interface_mouse = (key >= 128);
             int drained = 0;
 
-            while (tuh_hid_is_mounted(it.first) && !tuh_hid_is_busy(it.first) &&
+            while (tuh_hid_is_mounted(key) && !tuh_hid_is_busy(key) &&
                    drained < MOUSE_REPORT_DRAIN_MAX) {
-                hid_mouse_report_t* mouse = (hid_mouse_report_t*)it.second;
-                const uint8_t* js = it.second;
+                const uint8_t* js = hid_app_get_report(key);
+                const uint32_t report_us = hid_app_get_report_time(key);
+                const hid_mouse_report_t* mouse = (const hid_mouse_report_t*)js;
                 UsbMouseSample sample;
 
-                if (!parse_usb_mouse_report(it.first, js, mouse, is_multi_interface_mouse, sample)) {
-                    break;
+                if (!parse_usb_mouse_report(key, js, mouse, is_multi_interface_mouse, sample)) {
+                    // Nothing usable in this one: hand the buffer back and
+                    // keep draining, or the pipe stalls with it checked out
+                    hid_app_request_report(key);
+                    drained++;
+                    tuh_task();
+                    continue;
                 }
 
-                x += sample.dx;
-                y += sample.dy;
-
-                if (sample.have_buttons) {
-                    if (is_multi_interface_mouse) {
-                        set_mouse_state_bits(0xfd, (sample.buttons & 0x01) ? 2 : 0);
-                        set_mouse_state_bits(0xfe, (sample.buttons & 0x02) ? 1 : 0);
-                    } else {
-                        set_mouse_state_bits(0xfd, (sample.buttons & MOUSE_BUTTON_LEFT) ? 2 : 0);
-                        set_mouse_state_bits(0xfe, (sample.buttons & MOUSE_BUTTON_RIGHT) ? 1 : 0);
-                    }
+                // Both report layouts put left in bit 0 and right in bit 1. A
+                // report without buttons (wheel, AC Pan) leaves held ones held.
+                const uint8_t sample_buttons = sample.have_buttons ?
+                    (uint8_t)(sample.buttons & (MOUSE_MERGE_LEFT | MOUSE_MERGE_RIGHT)) :
+                    MOUSE_MERGE_BUTTONS_KEEP;
+                if (sample.absolute) {
+                    mouse_merge_absolute(key, MOUSE_CLASS_USB, sample.dx, sample.dy,
+                                         sample.max_x, sample.max_y, sample.in_range, sample_buttons);
+                } else {
+                    mouse_merge_relative(key, MOUSE_CLASS_USB, sample.dx, sample.dy, sample_buttons);
                 }
                 if (sample.wheel_delta != 0) {
                     enqueue_wheel_pulses(sample.wheel_delta);
                 }
+                sync_mouse_buttons(report_us);
 
-                hid_app_request_report(it.first, it.second);
+                hid_app_request_report(key);
                 drained++;
                 tuh_task();
             }
@@ -1746,41 +1796,63 @@ void HidInput::handle_mouse(const int64_t cpu_cycles) {
 
         for (int mi = 0; mi < BT_MOUSE_SLOTS; ++mi) {
             if (!bluepad32_get_mouse(mi, &bt_mouse)) {
-#if ENABLE_SERIAL_LOGGING
                 if (mi == 0) {
-                    hid_bt_ms_miss++;
+                    tm_inc(TM_HID_BT_MS_MISS);
+                }
+                if (!bluepad32_mouse_connected(mi)) {
+                    mouse_merge_remove(MOUSE_MERGE_BT_ID(mi));
                 }
-#endif
                 continue;
             }
-#if ENABLE_SERIAL_LOGGING
-            hid_bt_ms_get++;
+            tm_inc(TM_HID_BT_MS_GET);
             if (bt_mouse.delta_x != 0 || bt_mouse.delta_y != 0) {
-                hid_bt_ms_move++;
+                tm_inc(TM_HID_BT_MS_MOVE);
             }
-#endif
-
-            x += bt_mouse.delta_x;
-            y += bt_mouse.delta_y;
 
-            bool left_down = (bt_mouse.buttons & 0x01) != 0;
-            bool right_down = (bt_mouse.buttons & 0x02) != 0;
-            set_mouse_state_bits(0xfd, left_down ? 2 : 0);
-            set_mouse_state_bits(0xfe, right_down ? 1 : 0);
+            mouse_merge_relative(MOUSE_MERGE_BT_ID(mi), MOUSE_CLASS_BT, bt_mouse.delta_x, bt_mouse.delta_y,
+                                 (uint8_t)(bt_mouse.buttons & (MOUSE_MERGE_LEFT | MOUSE_MERGE_RIGHT)));
 
             if (bt_mouse.scroll_wheel != 0) {
                 enqueue_wheel_pulses(bt_mouse.scroll_wheel);
             }
+            sync_mouse_buttons(time_us_32());
         }
     }
 #endif
+
+    // Right analog stick as a mouse. Llamatron owns the right stick while it is on.
+    static absolute_time_t stick_last = nil_time;
+    if (stick_mouse_enabled() && !g_llamatron_mode) {
+        absolute_time_t now = get_absolute_time();
+        int64_t elapsed = is_nil_time(stick_last) ? 0 : absolute_time_diff_us(stick_last, now);
+        int8_t sx = 0;
+        int8_t sy = 0;
+        stick_last = now;
+        if (elapsed > STICK_MOUSE_MAX_STEP_US) {
+            elapsed = STICK_MOUSE_MAX_STEP_US;
+        }
+        if (collect_right_stick(sx, sy)) {
+            int32_t sdx = 0;
+            int32_t sdy = 0;
+            stick_mouse_update(stick_mouse_curve(), sx, sy, (uint32_t)elapsed, &sdx, &sdy);
+            mouse_merge_relative(STICK_MOUSE_ID, MOUSE_CLASS_STICK, sdx, sdy, 0);
+        } else {
+            stick_mouse_reset();
+        }
+    } else if (!is_nil_time(stick_last)) {
+        stick_last = nil_time;
+        mouse_merge_remove(STICK_MOUSE_ID);
+    }
+
+    sync_mouse_buttons(time_us_32());
+    mouse_merge_end(&x, &y);
     
     // Handle the mouse acceleration/deceleration configured in the UI.
-    // Base multiplier of 1.0 with speed adjustment (0.0-9.0) adds 0.0-0.9
-    // This gives a range of 1.0x to 1.9x acceleration
-    double accel = 1.0 + ((double)ui_->get_mouse_speed() * 0.1);
-    x = scale_mouse_burst(static_cast<int>(static_cast<double>(x) * accel));
-    y = scale_mouse_burst(static_cast<int>(static_cast<double>(y) * accel));
+    // Base multiplier of 1.0 with speed adjustment (MOUSE_MIN..MOUSE_MAX)
+    // adding 0.1 per step, in tenths so Core 0 stays integer only
+    const int accel_tenths = 10 + ui_->get_mouse_speed();
+    x = scale_mouse_burst(x * accel_tenths / 10);
+    y = scale_mouse_burst(y * accel_tenths / 10);
     AtariSTMouse::instance().set_speed(x, y);
 }
 
@@ -1793,7 +1865,7 @@ bool HidInput::get_usb_joystick(int addr, uint8_t& axis, uint8_t& button) {
         extern bool stadia_is_controller(uint16_t, uint16_t);
         if (stadia_is_controller(vid, pid)) {
             if (tuh_hid_is_mounted(addr) && !tuh_hid_is_busy(addr)) {
-                const uint8_t* js = device[addr];
+                const uint8_t* js = hid_app_get_report(addr);
                 // Expected: 11 bytes: [0-1 header/buttons?][2-3 buttons?][4-5 LX/LY][6-7 RX/RY][8 LT][9 RT][10 pad]
                 if (js) {
                     // Reset outputs
@@ -1868,7 +1940,7 @@ bool HidInput::get_usb_joystick(int addr, uint8_t& axis, uint8_t& button) {
                     #endif
                     
                     // Queue next report
-                    hid_app_request_report(addr, device[addr]);
+                    hid_app_request_report(addr);
                     return true;
                 }
             }
@@ -1876,8 +1948,8 @@ bool HidInput::get_usb_joystick(int addr, uint8_t& axis, uint8_t& button) {
     }
 
     if (tuh_hid_is_mounted(addr) && !tuh_hid_is_busy(addr)) {
-        const uint8_t* js = device[addr];
-        HID_ReportInfo_t* info = tuh_hid_get_report_info(addr);
+        const uint8_t* js = hid_app_get_report(addr);
+        hid_layout_t* info = tuh_hid_get_report_info(addr);
         if (info) {
             for (uint8_t i = 0; i < info->TotalReportItems; ++i) {
                 HID_ReportItem_t* item = &info->ReportItems[i];
@@ -1921,7 +1993,7 @@ bool HidInput::get_usb_joystick(int addr, uint8_t& axis, uint8_t& button) {
             }
         }
         // Trigger the next report
-        hid_app_request_report(addr, device[addr]);
+        hid_app_request_report(addr);
         return true;
     }
     return false;
@@ -2157,6 +2229,12 @@ void HidInput::handle_joystick() {
         g_llama_fire_joy0 = 0;
     }
 
+    // Keyboard joystick, from the key matrix handle_keyboard() just built
+    uint8_t key_axis = 0;
+    uint8_t key_fire = 0;
+    const bool key_joy = key_joy_update(key_states.data(), &key_axis, &key_fire);
+    const int key_joy_port = key_joy_get_port();
+
     // See if the joysticks are GPIO or USB
     for (int joystick = 1; joystick >= 0; --joystick) {
         // Initialize axis and button for each joystick separately to prevent state bleed
@@ -2166,7 +2244,8 @@ void HidInput::handle_joystick() {
         uint8_t joy_setting = ui_->get_joystick();
         if (joy_setting & (1 << joystick)) {
             // GPIO path
-            g_gpio_path_count++;
+            tm_inc(TM_JOY_GPIO_PATH);
+            joy_arb_clear(joystick);
             if (joystick == 1) {
                 set_mouse_state_bits(0xfe, gpio_get(JOY1_FIRE) ? 0 : 1);
                 axis |= (gpio_get(JOY1_UP)) ? 0 : 1;
@@ -2186,96 +2265,71 @@ void HidInput::handle_joystick() {
         }
         else {
             // USB path
-            g_usb_path_count++;
-            
-            // Try all sources: USB HID joystick, then PS4, then Xbox
-            bool got_input = false;
+            tm_inc(TM_JOY_USB_PATH);
 
+            // Every source publishes its state for this port (only changes
+            // count) and the port's policy picks the result (joy_arbiter.h)
             if (g_llamatron_active) {
-                if (joystick == 1) {
-                    axis = g_llama_axis_joy1;
-                    button = g_llama_fire_joy1;
-                    got_input = true;
-                } else if (joystick == 0) {
-                    axis = g_llama_axis_joy0;
-                    button = g_llama_fire_joy0;
-                    got_input = true;
-                }
-            }
-            
-            // Check USB controllers if USB is enabled at runtime
-            // (Works even when Bluetooth is compiled in)
-            if (usb_runtime_is_enabled()) {
-                // USB mode: Check USB HID joystick and USB-specific controllers
-                // First priority: USB HID joystick
-                if (!got_input && next_joystick < joystick_addr.size()) {
-                    if (get_usb_joystick(joystick_addr[next_joystick], axis, button)) {
-                        got_input = true;
-                        g_hid_joy_success++;  // Track HID success
-                    }
+                joy_arb_clear(joystick);
+            }
+            else {
+                uint8_t src_axis = 0;
+                uint8_t src_fire = 0;
+
+                // Check USB controllers if USB is enabled at runtime
+                // (Works even when Bluetooth is compiled in)
+                const bool usb = usb_runtime_is_enabled();
+                bool hid = false;
+                bool hid_report = false;
+                if (usb && next_joystick < joystick_addr.size()) {
+                    const int addr = joystick_addr[next_joystick];
                     ++next_joystick;
+                    // Present while mounted; a tick without a new report
+                    // keeps what the last one said
+                    hid = tuh_hid_is_mounted(addr);
+                    hid_report = get_usb_joystick(addr, src_axis, src_fire);
+                    if (hid_report) {
+                        tm_inc(TM_JOY_HID_OK);
+                    }
                 }
-                
-                // Second priority: PS4 controller (always check, even if HID exists)
-                // FIX: PS4 and Xbox were being skipped if ANY HID entry existed, even disconnected ones
-                if (!got_input && get_ps4_joystick(joystick, axis, button)) {
-                    got_input = true;
-                    g_ps4_success++;  // Track PS4 success
-                }
-                
-                // PS5 DualSense (check after PS4)
-                if (!got_input && get_ps5_joystick(joystick, axis, button)) {
-                    got_input = true;
-                }
-                
-                // PlayStation Classic (check after PS5)
-                if (!got_input && get_psc_joystick(joystick, axis, button)) {
-                    got_input = true;
-                }
-                
-                // PS3 controller (check after PSC)
-                if (!got_input && get_ps3_joystick(joystick, axis, button)) {
-                    got_input = true;
-                }
-                
-                // GameCube adapter (check after PS3)
-                if (!got_input && get_gamecube_joystick(joystick, axis, button)) {
-                    got_input = true;
-                }
-                
-                // Third priority: Switch controller
-                if (!got_input && get_switch_joystick(joystick, axis, button)) {
-                    got_input = true;
-                    g_switch_success++;  // Track Switch success
-                }
-                
-                // HORI HORIPAD (Switch) - check after Switch
-                if (!got_input && get_horipad_joystick(joystick, axis, button)) {
-                    got_input = true;
-                }
-                
-                // Fourth priority: Stadia controller - NOW USES GENERIC HID PATH
-                // (Stadia is detected as standard HID joystick, handled above)
-                
-                // Fifth priority: Xbox controller (always check as final fallback)
-                // FIX: This ensures Xbox is checked even if stale HID entries exist
-                if (!got_input && get_xbox_joystick(joystick, axis, button)) {
-                    got_input = true;
-                    g_xbox_success++;  // Track Xbox success
-                }
-            }
-            
+                publish_source(joystick, JOY_SRC_HID, hid, src_axis, src_fire, hid_report);
+
+                bool ok = usb && get_ps4_joystick(joystick, src_axis, src_fire);
+                if (ok) {
+                    tm_inc(TM_JOY_PS4_OK);
+                }
+                publish_source(joystick, JOY_SRC_PS4, ok, src_axis, src_fire);
+                ok = usb && get_ps5_joystick(joystick, src_axis, src_fire);
+                publish_source(joystick, JOY_SRC_PS5, ok, src_axis, src_fire);
+                ok = usb && get_psc_joystick(joystick, src_axis, src_fire);
+                publish_source(joystick, JOY_SRC_PSC, ok, src_axis, src_fire);
+                ok = usb && get_ps3_joystick(joystick, src_axis, src_fire);
+                publish_source(joystick, JOY_SRC_PS3, ok, src_axis, src_fire);
+                ok = usb && get_gamecube_joystick(joystick, src_axis, src_fire);
+                publish_source(joystick, JOY_SRC_GAMECUBE, ok, src_axis, src_fire);
+                ok = usb && get_switch_joystick(joystick, src_axis, src_fire);
+                if (ok) {
+                    tm_inc(TM_JOY_SWITCH_OK);
+                }
+                publish_source(joystick, JOY_SRC_SWITCH, ok, src_axis, src_fire);
+                ok = usb && get_horipad_joystick(joystick, src_axis, src_fire);
+                publish_source(joystick, JOY_SRC_HORIPAD, ok, src_axis, src_fire);
+                // Stadia is detected as a standard HID joystick, handled above
+                ok = usb && get_xbox_joystick(joystick, src_axis, src_fire);
+                if (ok) {
+                    tm_inc(TM_JOY_XBOX_OK);
+                }
+                publish_source(joystick, JOY_SRC_XBOX, ok, src_axis, src_fire);
+
+                ok = false;
+                bool bt_report = false;
 #if ENABLE_BLUEPAD32
-            // Check Bluetooth controllers if Bluetooth is enabled at runtime
-            // Match USB behavior: assign to joystick 1 first, then joystick 0
-            // This allows mouse to work with joystick 1 (joystick 0 conflicts with mouse)
-            if (!got_input && bt_runtime_is_enabled()) {
-                int bt_count = bluepad32_get_connected_count();
-                if (bt_count > 0) {
-                    // Map joystick number: joystick 1 -> bt_index 0, joystick 0 -> bt_index 1
-                    // This matches USB behavior where first USB joystick goes to joystick 1
+                // Match USB behavior: the first BT pad drives joystick 1, the
+                // second joystick 0, so the mouse keeps working with one pad
+                if (bt_runtime_is_enabled()) {
                     int bt_index = (joystick == 1) ? 0 : 1;
-                    if (bt_index < bt_count) {
+                    if (bt_index < bluepad32_get_connected_count()) {
+                        ok = true;
                         // Local struct with layout matching uni_gamepad_t exactly.
                         // See bluepad32's uni_gamepad_t definition.
                         struct {
@@ -2291,24 +2345,31 @@ void HidInput::handle_joystick() {
                             int32_t  gyro[3];
                             int32_t  accel[3];
                         } bt_gamepad;
-                        
+
+                        // Only returns true when the pad sent an update
                         if (bluepad32_get_gamepad(bt_index, &bt_gamepad)) {
-#if ENABLE_SERIAL_LOGGING
-                            hid_bt_joy_get++;
-#endif
-                            uint8_t bt_axis = 0;
-                            uint8_t bt_button = 0;
-                            if (bluepad32_to_atari_joystick(&bt_gamepad, &bt_axis, &bt_button)) {
-                                axis = bt_axis;
-                                button = bt_button;
-                                got_input = true;
-                            }
+                            tm_inc(TM_HID_BT_JOY_GET);
+                            bt_report = bluepad32_to_atari_joystick(&bt_gamepad, &src_axis, &src_fire);
                         }
                     }
                 }
-            }
 #endif
-            
+                publish_source(joystick, JOY_SRC_BLUETOOTH, ok, src_axis, src_fire, bt_report);
+
+                publish_source(joystick, JOY_SRC_KEYBOARD, key_joy && joystick == key_joy_port,
+                               key_axis, key_fire);
+            }
+
+            bool got_input;
+            if (g_llamatron_active) {
+                axis = joystick ? g_llama_axis_joy1 : g_llama_axis_joy0;
+                button = joystick ? g_llama_fire_joy1 : g_llama_fire_joy0;
+                got_input = true;
+            }
+            else {
+                got_input = joy_arb_resolve(joystick, &axis, &button);
+            }
+
             // Update joystick state if we got input from either source
             if (got_input) {
                 if (joystick == 0) {
@@ -2330,13 +2391,69 @@ void HidInput::handle_joystick() {
             }
         }
     }
+
+    // Gamepad buttons bound to ST keys. Llamatron already uses every button.
+    uint32_t pad_buttons = 0;
+    if (!g_llamatron_active) {
+        collect_pad_buttons(pad_buttons);
+    }
+    pad_key_edge_t edges[PAD_KEYMAP_MAX_EDGES];
+    int edge_count = pad_keymap_update(pad_buttons, edges);
+    for (int i = 0; i < edge_count; ++i) {
+        pad_key_down[edges[i].key] = edges[i].down ? 1 : 0;
+    }
+    tm_add(TM_JOY_PAD_KEYS, (uint32_t)edge_count);
+
+    publish_input(time_us_32());
 }
 
 void HidInput::reset() {
      std::fill(key_states.begin(), key_states.end(), 0);
-     memset((void*)wheel_hold_frames, 0, sizeof(wheel_hold_frames));
+     memset(wheel_hold_frames, 0, sizeof(wheel_hold_frames));
+     memset(pad_key_down, 0, sizeof(pad_key_down));
+     pad_keymap_reset();
      mouse_state.store(0, std::memory_order_relaxed);
      joystick_state.store(0, std::memory_order_relaxed);
+     publish_input(time_us_32());
+}
+
+// Merged mouse buttons, applied per report so a click shorter than one tick
+// still reaches the queue. Only touches the bits on a change: joystick fire
+// shares them.
+void HidInput::sync_mouse_buttons(uint32_t t_us) {
+    uint8_t buttons;
+    if (mouse_merge_take_buttons(&buttons)) {
+        set_mouse_state_bits(0xfd, (buttons & MOUSE_MERGE_LEFT) ? 2 : 0);
+        set_mouse_state_bits(0xfe, (buttons & MOUSE_MERGE_RIGHT) ? 1 : 0);
+        publish_input(t_us);
+    }
+}
+
+// Hand the Core 0 input state to Core 1: queue the keys and buttons that
+// changed since the 6301 was last sent them, stamped t_us (when the report
+// behind the change arrived), or republish the state block without the queue
+void HidInput::publish_input(uint32_t t_us) {
+    uint32_t keys[4] = {0};
+    for (int code = 0; code < 128; ++code) {
+        if (keydown((unsigned char)code)) {
+            keys[code >> 5] |= 1u << (code & 31);
+        }
+    }
+#if ENABLE_INPUT_QUEUE
+    iq_set_keys(keys, t_us);
+    iq_set_mouse_buttons((uint8_t)mouse_state.load(std::memory_order_relaxed), t_us);
+    iq_set_joystick(joystick_state.load(std::memory_order_relaxed), t_us);
+#else
+    (void)t_us;
+    cc_seq_write_begin(&st_input_seq);
+    for (int i = 0; i < 4; ++i) {
+        cc_seq_put(&st_input_keys[i], keys[i]);
+    }
+    cc_seq_put(&st_input_mouse, (uint32_t)mouse_state.load(std::memory_order_relaxed));
+    cc_seq_put(&st_input_joy, joystick_state.load(std::memory_order_relaxed));
+    cc_seq_write_end(&st_input_seq);
+#endif
+    cc_put(&st_input_mouse_en, (ui_ && ui_->get_mouse_enabled()) ? 1 : 0);
 }
 
 void HidInput::set_mouse_state_bits(int clear_mask, int set_bits) {
@@ -2356,11 +2473,29 @@ void HidInput::set_joystick_high_nibble(uint8_t axis) {
     joystick_state.store(next, std::memory_order_relaxed);
 }
 
+// Hand one source's read to the arbiter, then zero the outputs for the next
+// source (a getter that fails can leave them half written). present follows
+// the device being mounted or connected; fresh is false when it sent nothing
+// new this tick, and its last published state stands.
+void HidInput::publish_source(int joystick, joy_src_t src, bool present, uint8_t& axis, uint8_t& button,
+                              bool fresh) {
+    if (!present) {
+        joy_arb_withdraw(joystick, src);
+    } else if (fresh) {
+        joy_arb_publish(joystick, src, axis, button);
+    }
+    axis = 0;
+    button = 0;
+}
+
 unsigned char HidInput::keydown(const unsigned char code) const {
     if (code < 128) {
-        if (wheel_hold_frames[code] > 0) {
+        if (wheel_hold_frames[code] > 0 || pad_key_down[code]) {
             return 1;
         }
+        if (key_joy_consumes(code)) {
+            return 0;
+        }
         return key_states[code];
     }
     return 0;
@@ -2379,19 +2514,46 @@ bool HidInput::mouse_enabled() const {
 }
 
 unsigned char st_keydown(const unsigned char code){
-    return HidInput::instance().keydown(code);
+#if ENABLE_INPUT_QUEUE
+    return iq_keydown(code);
+#else
+    uint32_t seq, word;
+    do {
+        seq = cc_seq_read_begin(&st_input_seq);
+        word = cc_seq_get(&st_input_keys[(code >> 5) & 3]);
+    } while (cc_seq_read_retry(&st_input_seq, seq));
+    return (word >> (code & 31)) & 1;
+#endif
 }
 
 int st_mouse_buttons() {
-    return HidInput::instance().mouse_buttons();
+#if ENABLE_INPUT_QUEUE
+    return iq_mouse_buttons();
+#else
+    uint32_t seq, buttons;
+    do {
+        seq = cc_seq_read_begin(&st_input_seq);
+        buttons = cc_seq_get(&st_input_mouse);
+    } while (cc_seq_read_retry(&st_input_seq, seq));
+    return (int)buttons;
+#endif
 }
 
 unsigned char st_joystick() {
-    return HidInput::instance().joystick();
+#if ENABLE_INPUT_QUEUE
+    return iq_joystick();
+#else
+    uint32_t seq, joy;
+    do {
+        seq = cc_seq_read_begin(&st_input_seq);
+        joy = cc_seq_get(&st_input_joy);
+    } while (cc_seq_read_retry(&st_input_seq, seq));
+    return (unsigned char)joy;
+#endif
 }
 
 int st_mouse_enabled() {
-    return HidInput::instance().mouse_enabled() ? 1 : 0;
+    return (int)cc_get(&st_input_mouse_en);
 }
 
 void update_joystick_state() {
@@ -2411,27 +2573,8 @@ extern "C" void hid_diag_log_snapshot(void) {
     int joy_state = HidInput::instance().joystick();
     int mouse_btn = HidInput::instance().mouse_buttons();
 
-    printf("[DIAG] HidInput/5s: kb_get=%lu kb_peek=%lu kb_none=%lu kb_keys=%lu "
-           "ms_get=%lu ms_miss=%lu ms_move=%lu joy_get=%lu "
-           "mouse_en=%d joy=0x%02x mouse_btn=0x%02x\n",
-           (unsigned long)hid_bt_kb_get,
-           (unsigned long)hid_bt_kb_peek,
-           (unsigned long)hid_bt_kb_none,
-           (unsigned long)hid_bt_kb_keys_sent,
-           (unsigned long)hid_bt_ms_get,
-           (unsigned long)hid_bt_ms_miss,
-           (unsigned long)hid_bt_ms_move,
-           (unsigned long)hid_bt_joy_get,
+    printf("[DIAG] HidInput: mouse_en=%d joy=0x%02x mouse_btn=0x%02x\n",
            mouse_en, joy_state & 0xff, mouse_btn & 0xff);
-
-    hid_bt_kb_get = 0;
-    hid_bt_kb_peek = 0;
-    hid_bt_kb_none = 0;
-    hid_bt_kb_keys_sent = 0;
-    hid_bt_ms_get = 0;
-    hid_bt_ms_miss = 0;
-    hid_bt_ms_move = 0;
-    hid_bt_joy_get = 0;
 }
 #endif
 
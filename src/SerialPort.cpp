@@ -21,11 +21,15 @@
 #include "hardware/uart.h"
 #include "hardware/irq.h"
 #include "config.h"
+#include "telemetry.h"
+#include "core_channel.h"
+#include "st_link.h"
 
 #define UART_ID uart1
 #define UART_IRQ UART1_IRQ
-// The HD6301 in the ST communicates at 7812 baud
-#define BAUD_RATE 7812
+// The HD6301 in the ST communicates at 7812 baud; faster hosts can ask for more
+static const uint32_t link_rates[] = { ST_LINK_RATES };
+static uint32_t link_baud = IKBD_BAUD_DEFAULT;
 #define DATA_BITS 8
 #define STOP_BITS 1
 #define PARITY    UART_PARITY_NONE
@@ -36,24 +40,30 @@ static volatile uint8_t rx_buffer[RX_BUFFER_SIZE];
 static volatile uint16_t rx_head = 0;
 static volatile uint16_t rx_tail = 0;
 
-// Non-critical path TX buffer for UI monitoring (outside critical path)
+// Non-critical path TX buffer for UI monitoring (outside critical path).
+// Core 1 (6301 TX) produces, the Core 0 main loop drains.
 #define TX_LOG_BUFFER_SIZE 64
-static volatile uint8_t tx_log_buffer[TX_LOG_BUFFER_SIZE];
-static volatile uint16_t tx_log_head = 0;
-static volatile uint16_t tx_log_tail = 0;
+static uint8_t tx_log_buffer[TX_LOG_BUFFER_SIZE];
+static cc_spsc_t tx_log_chan;
 
 // Cached UART hardware pointer - set at initialization, used in critical path
 // This avoids calling uart_get_hw() which might access flash
 static uart_hw_t* g_uart_hw = nullptr;
 
+// Set by the ISR when a break is received, picked up by poll_link()
+static volatile bool rx_break_seen = false;
+// Characters the ISR has read, of any kind: tells poll_link() the line moved
+static volatile uint32_t rx_char_count = 0;
+
 // Put byte into ring buffer (called from ISR)
 static inline void rx_buffer_put(uint8_t data) {
     uint16_t next_head = (rx_head + 1) & 0xFF;
     if (next_head != rx_tail) {  // Buffer not full
         rx_buffer[rx_head] = data;
         rx_head = next_head;
+    } else {
+        tm_inc(TM_UART_RX_FULL);  // Byte dropped
     }
-    // If buffer is full, byte is silently dropped (matches logronoid's behavior)
 }
 
 // Get byte from ring buffer (called from main loop)
@@ -73,21 +83,20 @@ static uint16_t rx_buffer_available(void) {
 
 // Put byte into TX log buffer (non-critical path, called from critical path)
 static inline void tx_log_buffer_put(uint8_t data) {
-    uint16_t next_head = (tx_log_head + 1) & (TX_LOG_BUFFER_SIZE - 1);
-    if (next_head != tx_log_tail) {  // Buffer not full
-        tx_log_buffer[tx_log_head] = data;
-        tx_log_head = next_head;
+    if (cc_spsc_space(&tx_log_chan, TX_LOG_BUFFER_SIZE) != 0) {
+        tx_log_buffer[cc_spsc_head(&tx_log_chan) & (TX_LOG_BUFFER_SIZE - 1)] = data;
+        cc_spsc_push(&tx_log_chan);
     }
     // If buffer is full, byte is silently dropped (non-critical)
 }
 
 // Get byte from TX log buffer (called from main loop)
 static bool tx_log_buffer_get(uint8_t* data) {
-    if (tx_log_head == tx_log_tail) {
+    if (cc_spsc_count(&tx_log_chan) == 0) {
         return false;  // Buffer empty
     }
-    *data = tx_log_buffer[tx_log_tail];
-    tx_log_tail = (tx_log_tail + 1) & (TX_LOG_BUFFER_SIZE - 1);
+    *data = tx_log_buffer[cc_spsc_tail(&tx_log_chan) & (TX_LOG_BUFFER_SIZE - 1)];
+    cc_spsc_pop(&tx_log_chan);
     return true;
 }
 
@@ -98,10 +107,22 @@ static void on_uart_irq(void) {
         // Clear RX interrupt
         g_uart_hw->icr = UART_UARTICR_RXIC_BITS;
         
-        // Read all available data from UART and put into ring buffer
-        while (uart_is_readable(UART_ID)) {
-            uint8_t ch = uart_getc(UART_ID);
-            rx_buffer_put(ch);
+        // Read all available data from UART and put into ring buffer.
+        // The error flags come with each character in DR: only clean bytes
+        // reach the 6301, so line noise cannot inject IKBD commands.
+        while (!(g_uart_hw->fr & UART_UARTFR_RXFE_BITS)) {
+            uint32_t dr = g_uart_hw->dr;
+            st_link_rx_t kind = st_link_decode(dr);
+
+            rx_char_count++;
+            if (kind == ST_LINK_RX_BYTE) {
+                rx_buffer_put((uint8_t)dr);
+                continue;
+            }
+            if (kind == ST_LINK_RX_BREAK) {
+                rx_break_seen = true;
+            }
+            g_uart_hw->rsr = 0;             // Clear the latched error status
         }
     }
 }
@@ -117,7 +138,7 @@ SerialPort& SerialPort::instance() {
 
 void SerialPort::open() {
     // Initialize UART
-    uart_init(UART_DEVICE, BAUD_RATE);
+    uart_init(UART_DEVICE, link_baud);
     gpio_set_function(UART_TX, GPIO_FUNC_UART);
     gpio_set_function(UART_RX, GPIO_FUNC_UART);
     
@@ -128,8 +149,8 @@ void SerialPort::open() {
     // Set drive strength for TX
     gpio_set_drive_strength(UART_TX, GPIO_DRIVE_STRENGTH_12MA);
     
-    int actual = uart_set_baudrate(UART_ID, BAUD_RATE);
-    printf("Serial port opened at %d baud (target: %d)\n", actual, BAUD_RATE);
+    int actual = uart_set_baudrate(UART_ID, link_baud);
+    printf("Serial port opened at %d baud (target: %lu)\n", actual, (unsigned long)link_baud);
 
     // No hardware flow control
     uart_set_hw_flow(UART_ID, false, false);
@@ -209,6 +230,40 @@ bool SerialPort::recv(unsigned char& data) const {
 void SerialPort::configure() {
 }
 
+void SerialPort::reclock() {
+    if (!g_uart_hw) {
+        return;     // Not open yet: open() sets the divider
+    }
+    uart_set_baudrate(UART_ID, link_baud);
+}
+
+bool SerialPort::baud_supported(uint32_t baud) {
+    for (uint32_t rate : link_rates) {
+        if (rate == baud) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SerialPort::set_baud(uint32_t baud) {
+    if (!baud_supported(baud)) {
+        return false;
+    }
+    // Let the byte on the wire finish at the old rate (1.28 ms at most)
+    while (g_uart_hw && (g_uart_hw->fr & UART_UARTFR_BUSY_BITS)) {
+        tight_loop_contents();
+    }
+    link_baud = baud;
+    int actual = uart_set_baudrate(UART_ID, link_baud);
+    printf("Serial port now %d baud (target: %lu)\n", actual, (unsigned long)link_baud);
+    return true;
+}
+
+uint32_t SerialPort::get_baud() const {
+    return link_baud;
+}
+
 bool SerialPort::send_buf_empty() const {
     return uart_is_writable(UART_ID);
 }
@@ -217,6 +272,21 @@ uint16_t SerialPort::rx_available() const {
     return rx_buffer_available();
 }
 
+bool SerialPort::poll_link() {
+    const bool break_seen = rx_break_seen;
+    if (break_seen) {
+        rx_break_seen = false;
+    }
+
+    if (st_link_poll(&link, !gpio_get(UART_RX), rx_char_count, break_seen, time_us_32())) {
+        irq_set_enabled(UART_IRQ, false);
+        rx_tail = rx_head;          // Bytes around a break are suspect
+        irq_set_enabled(UART_IRQ, true);
+        return true;
+    }
+    return false;
+}
+
 void SerialPort::drain_tx_log() {
     // Process buffered TX data for UI display (non-critical path)
     uint8_t data;
@@ -232,18 +302,6 @@ void SerialPort::drain_tx_log() {
 // Using direct hardware register access for maximum speed
 extern "C" {
 
-#if ENABLE_SERIAL_LOGGING
-static volatile uint32_t g_diag_uart_tx_wait_spins = 0;
-#endif
-
-uint32_t diag_uart_tx_wait_spins(void) {
-#if ENABLE_SERIAL_LOGGING
-    return g_diag_uart_tx_wait_spins;
-#else
-    return 0;
-#endif
-}
-
 void __not_in_flash_func(serial_send)(unsigned char data) {
     // Direct hardware register access - CRITICAL: bypasses all SDK functions in flash
     // Use cached hardware pointer to avoid any flash access
@@ -266,9 +324,7 @@ void __not_in_flash_func(serial_send)(unsigned char data) {
     // TXFF bit is 1 when FIFO is full, 0 when there's space
     // BUSY bit is 1 when UART is transmitting, but we can still write to FIFO
     while (g_uart_hw->fr & UART_UARTFR_TXFF_BITS) {
-#if ENABLE_SERIAL_LOGGING
-        g_diag_uart_tx_wait_spins++;
-#endif
+        tm_inc(TM_UART_TX_WAIT_SPINS);
         // FIFO full, wait (should be rare with 32-byte FIFO)
         // This is a tight loop in RAM, so it's fast
     }
@@ -27,19 +27,12 @@
 #include "bluepad32_platform.h"  // For bluepad32_delete_pairing_keys()
 #endif
 #include "usb_device_map.h"
+#include "telemetry.h"
+#include "oled_text.h"
 
-// Forward declare Xbox debug counters (defined in main.cpp and xinput_atari.cpp)
+// Forward declare controller debug hooks (defined in xinput_atari.cpp and switch_controller.c)
 extern "C" {
-    uint32_t get_xbox_report_count();
-    uint32_t get_xbox_data_read_count();
-    uint32_t get_xbox_lookup_calls();
     void get_xbox_debug_flags(uint8_t* addr, uint8_t* connected, uint8_t* new_data);
-    uint32_t get_gpio_path_count();
-    uint32_t get_usb_path_count();
-    uint32_t get_hid_joy_success();
-    uint32_t get_ps4_success();
-    uint32_t get_xbox_success();
-    uint32_t get_switch_success();
     void switch_get_debug_values(uint16_t* buttons, uint8_t* dpad, int16_t* lx, int16_t* ly,
                                   uint8_t* atari_dir, uint8_t* atari_fire);
     uint32_t switch_get_report_count(void);
@@ -51,6 +44,9 @@ extern "C" {
 }
 
 #define DEBOUNCE_COUNT 10
+#define TELEMETRY_LINES 6   // Metrics per telemetry page screen
+
+static_assert(UserInterface::PAGE_PRO_INIT + 1 == UI_REDRAW_PAGES, "ui_redraw.c must cover every page");
 
 enum BUTTONS {
     BUTTON_LEFT,
@@ -59,6 +55,7 @@ enum BUTTONS {
 };
 
 UserInterface::UserInterface() {
+    ui_redraw_init(&redraw);
 }
 
 ssd1306_t   disp;
@@ -94,15 +91,14 @@ void UserInterface::init() {
         mouse_speed = MOUSE_MAX;
         settings.get_settings().mouse_speed = mouse_speed;
     }
-
-    serial_tm = get_absolute_time();
 }
 
 void UserInterface::device_connect_state(int usb_kb_in, int usb_mouse_in, int usb_joy_in,
                                          int bt_kb_in, int bt_mouse_in, int bt_joy_in) {
     if ((usb_kb != usb_kb_in) || (usb_mouse != usb_mouse_in) || (usb_joy != usb_joy_in) ||
         (bt_kb != bt_kb_in) || (bt_mouse != bt_mouse_in) || (bt_joy != bt_joy_in)) {
-        dirty = true;
+        // Counts on the devices page; BT names on the mapping page
+        invalidate(page_bit(PAGE_DEVICES) | page_bit(PAGE_MAPPING));
     }
     usb_kb = usb_kb_in;
     usb_mouse = usb_mouse_in;
@@ -131,53 +127,56 @@ uint8_t UserInterface::get_mouse_enabled() {
 void UserInterface::set_mouse_enabled(uint8_t en) {
     settings.get_settings().mouse_enabled = en;
     settings.write();
-    dirty = true;
+    invalidate();
 }
 
 
-void UserInterface::update_serial() {
-    uint8_t y = 0;
-    ssd1306_clear(&disp);
-    for (auto it : serial_lines) {
-        ssd1306_draw_string(&disp, 0, y, 1, (char*)it.c_str());
-        y += 9;
+bool UserInterface::update_serial() {
+    char buf[20];
+    oled_text_begin(&disp);
+    for (int i = 0; i < serial_count; ++i) {
+        int slot = (serial_head + SERIAL_LINES - serial_count + i) % SERIAL_LINES;
+        snprintf(buf, sizeof(buf), "%s%02X", serial_sent[slot] ? "              " : "", serial_data[slot]);
+        oled_text_draw(0, (uint8_t)(i * 9), buf);
     }
-    ssd1306_draw_string(&disp, 24, 27, 1, (char*)"ST <-> Kbd");
+    oled_text_draw(24, 27, "ST <-> Kbd");
 
-	ssd1306_draw_string(&disp, 34, 0, 1, (char*)"V " PROJECT_VERSION_STRING);	    
+	oled_text_draw(34, 0, "V " PROJECT_VERSION_STRING);
+    return oled_text_end();
 }
 
-void UserInterface::update_devices() {
+bool UserInterface::update_devices() {
     char buf[32];
-    ssd1306_clear(&disp);
-    ssd1306_draw_string(&disp, 0, 0, 1, (char*)"Devices");
+    oled_text_begin(&disp);
+    oled_text_draw(0, 0, "Devices");
 
 #if ENABLE_BLUEPAD32
     sprintf(buf, "Keybd   U %d BT %d", usb_kb, bt_kb);
-    ssd1306_draw_string(&disp, 0, 9, 1, buf);
+    oled_text_draw(0, 9, buf);
     sprintf(buf, "Mouse   U %d BT %d", usb_mouse, bt_mouse);
-    ssd1306_draw_string(&disp, 0, 18, 1, buf);
+    oled_text_draw(0, 18, buf);
     sprintf(buf, "Game    U %d BT %d", usb_joy, bt_joy);
-    ssd1306_draw_string(&disp, 0, 27, 1, buf);
+    oled_text_draw(0, 27, buf);
 #else
     sprintf(buf, "Keybd   U %d", usb_kb);
-    ssd1306_draw_string(&disp, 0, 9, 1, buf);
+    oled_text_draw(0, 9, buf);
     sprintf(buf, "Mouse   U %d", usb_mouse);
-    ssd1306_draw_string(&disp, 0, 18, 1, buf);
+    oled_text_draw(0, 18, buf);
     sprintf(buf, "Game    U %d", usb_joy);
-    ssd1306_draw_string(&disp, 0, 27, 1, buf);
+    oled_text_draw(0, 27, buf);
 #endif
 
-    ssd1306_draw_string(&disp, 0, 36, 1, get_translation("Mouse speed"));
+    oled_text_draw(0, 36, get_translation("Mouse speed"));
     sprintf(buf, "[==============]");
     buf[settings.get_settings().mouse_speed - MOUSE_MIN] = '*';
-    ssd1306_draw_string(&disp, 0, 45, 1, buf);
+    oled_text_draw(0, 45, buf);
+    return oled_text_end();
 }
 
-void UserInterface::update_mapping() {
+bool UserInterface::update_mapping() {
     char buf[64];
-    ssd1306_clear(&disp);
-    ssd1306_draw_string(&disp, 0, 0, 1, (char*)"Map Devices");
+    oled_text_begin(&disp);
+    oled_text_draw(0, 0, "Map Devices");
 
     auto draw_joy_line = [&](int y, const char* label, int dsub_bit, int bt_idx, int usb_slot) {
         if (settings.get_settings().joy_device & (1 << dsub_bit)) {
@@ -196,7 +195,7 @@ void UserInterface::update_mapping() {
                 snprintf(buf, sizeof(buf), "%s: --", label);
             }
         }
-        ssd1306_draw_string(&disp, 0, y, 1, buf);
+        oled_text_draw(0, y, buf);
     };
 
     // J2 = first gamepad slot; J1 = second (matches routing: joy1 then joy0)
@@ -212,9 +211,9 @@ void UserInterface::update_mapping() {
     }
     if (kname) {
         snprintf(buf, sizeof(buf), "K1:%.20s", kname);
-        ssd1306_draw_string(&disp, 0, 27, 1, buf);
+        oled_text_draw(0, 27, buf);
     } else {
-        ssd1306_draw_string(&disp, 0, 27, 1, (char*)"K1: --");
+        oled_text_draw(0, 27, "K1: --");
     }
 
     const char* mname = NULL;
@@ -226,13 +225,16 @@ void UserInterface::update_mapping() {
     }
     if (mname) {
         snprintf(buf, sizeof(buf), "M1:%.20s", mname);
-        ssd1306_draw_string(&disp, 0, 36, 1, buf);
+        oled_text_draw(0, 36, buf);
     } else {
-        ssd1306_draw_string(&disp, 0, 36, 1, (char*)"M1: --");
+        oled_text_draw(0, 36, "M1: --");
     }
+    return oled_text_end();
 }
 
 void UserInterface::update_splash() {
+    // Scale-2 title: drawn directly, not through the text grid
+    oled_text_invalidate();
     ssd1306_clear(&disp);
     
     // ATARI text (centered)
@@ -275,9 +277,9 @@ void UserInterface::update_splash() {
 #endif
 }
 
-void UserInterface::update_pro_init() {
+bool UserInterface::update_pro_init() {
     char buf[32];
-    ssd1306_clear(&disp);
+    oled_text_begin(&disp);
     
     // Get Pro Controller init status
     bool init_attempted, init_complete;
@@ -289,64 +291,84 @@ void UserInterface::update_pro_init() {
     bool scheduled = switch_get_pro_init_scheduled();
     uint32_t report_count = switch_get_report_count();
     
-    ssd1306_draw_string(&disp, 0, 0, 1, (char*)"Pro Init Status");
+    oled_text_draw(0, 0, "Pro Init Status");
     
     if (!init_attempted) {
         // Not attempted yet - show diagnostic info
         sprintf(buf, "Elapsed: %lu ms", elapsed_ms);
-        ssd1306_draw_string(&disp, 0, 15, 1, buf);
+        oled_text_draw(0, 15, buf);
         
         sprintf(buf, "Scheduled: %s", scheduled ? "YES" : "NO");
-        ssd1306_draw_string(&disp, 0, 27, 1, buf);
+        oled_text_draw(0, 27, buf);
         
         sprintf(buf, "Reports: %lu", report_count);
-        ssd1306_draw_string(&disp, 0, 39, 1, buf);
+        oled_text_draw(0, 39, buf);
         
         if (elapsed_ms >= 1000 && scheduled) {
-            ssd1306_draw_string(&disp, 0, 52, 1, (char*)"Should init!");
+            oled_text_draw(0, 52, "Should init!");
         } else if (!scheduled) {
-            ssd1306_draw_string(&disp, 0, 52, 1, (char*)"Not scheduled?");
+            oled_text_draw(0, 52, "Not scheduled?");
         } else {
             sprintf(buf, "Wait %lu ms", 1000 - elapsed_ms);
-            ssd1306_draw_string(&disp, 0, 52, 1, buf);
+            oled_text_draw(0, 52, buf);
         }
     } else if (!init_complete) {
         // Attempted but not complete yet
-        ssd1306_draw_string(&disp, 0, 20, 1, (char*)"Init sent!");
-        ssd1306_draw_string(&disp, 0, 35, 1, (char*)"Waiting for");
-        ssd1306_draw_string(&disp, 0, 50, 1, (char*)"response...");
+        oled_text_draw(0, 20, "Init sent!");
+        oled_text_draw(0, 35, "Waiting for");
+        oled_text_draw(0, 50, "response...");
     } else {
         // Complete - show results
             sprintf(buf, "Before: %d bytes", len_before);
-            ssd1306_draw_string(&disp, 0, 15, 1, buf);
+            oled_text_draw(0, 15, buf);
             sprintf(buf, "After:  %d bytes", len_after);
-            ssd1306_draw_string(&disp, 0, 25, 1, buf);
+            oled_text_draw(0, 25, buf);
             
             // Show command success bitmask
             uint8_t cmd_mask = switch_get_init_cmd_success();
             sprintf(buf, "Cmds: 0x%02X/0x7F", cmd_mask);
-            ssd1306_draw_string(&disp, 0, 37, 1, buf);
+            oled_text_draw(0, 37, buf);
             
             if (len_after != len_before && len_before > 0) {
                 if (cmd_mask == 0x7F) {
-                    ssd1306_draw_string(&disp, 0, 52, 1, (char*)"All cmds OK!");
+                    oled_text_draw(0, 52, "All cmds OK!");
                 } else {
                     sprintf(buf, "Some failed:%02X", cmd_mask);
-                    ssd1306_draw_string(&disp, 0, 52, 1, buf);
+                    oled_text_draw(0, 52, buf);
                 }
             } else {
-                ssd1306_draw_string(&disp, 0, 52, 1, (char*)"NO CHANGE");
+                oled_text_draw(0, 52, "NO CHANGE");
             }
         }
+    return oled_text_end();
+}
+
+bool UserInterface::update_telemetry() {
+    char buf[32];
+    int total = telemetry_line_count();
+    oled_text_begin(&disp);
+
+    snprintf(buf, sizeof(buf), "Telemetry %d/%d",
+             total ? telemetry_first / TELEMETRY_LINES + 1 : 0,
+             (total + TELEMETRY_LINES - 1) / TELEMETRY_LINES);
+    oled_text_draw(0, 0, buf);
+
+    for (int i = 0; i < TELEMETRY_LINES; ++i) {
+        if (!telemetry_format_line(telemetry_first + i, buf, sizeof(buf))) {
+            break;
+        }
+        oled_text_draw(0, 9 + i * 9, buf);
     }
+    return oled_text_end();
+}
 
-void UserInterface::update_usb_debug() {
+bool UserInterface::update_usb_debug() {
     char buf[32];
-    ssd1306_clear(&disp);
+    oled_text_begin(&disp);
     
 #if ENABLE_CONTROLLER_DEBUG
     // Debug page with live controller diagnostics
-    uint32_t switch_count = get_switch_success();
+    uint32_t switch_count = telemetry_counter(TM_JOY_SWITCH_OK);
     
     // If Switch controller active, show live values
     if (switch_count > 0) {
@@ -357,7 +379,7 @@ void UserInterface::update_usb_debug() {
         
         uint32_t rpt_count = switch_get_report_count();
         sprintf(buf, "SW Rpt:%lu Len:%d", rpt_count, len_after);
-        ssd1306_draw_string(&disp, 0, 0, 1, buf);
+        oled_text_draw(0, 0, buf);
         
         // Get live Switch values
         uint16_t btns;
@@ -367,10 +389,10 @@ void UserInterface::update_usb_debug() {
         switch_get_debug_values(&btns, &dpad, &lx, &ly, &atari_dir, &atari_fire);
         
         sprintf(buf, "B:0x%04X DP:%d", btns, dpad);
-        ssd1306_draw_string(&disp, 0, 10, 1, buf);
+        oled_text_draw(0, 10, buf);
         
         sprintf(buf, "LX:%d LY:%d", lx, ly);
-        ssd1306_draw_string(&disp, 0, 20, 1, buf);
+        oled_text_draw(0, 20, buf);
         
         // Get raw bytes for mode 0x30 debugging
         uint8_t raw[9];
@@ -380,16 +402,16 @@ void UserInterface::update_usb_debug() {
         // Show raw button bytes (3-5) for mode 0x30
         if (raw_len >= 49) {
             sprintf(buf, "B3-5:%02X %02X %02X", raw[0], raw[1], raw[2]);
-            ssd1306_draw_string(&disp, 0, 30, 1, buf);
+            oled_text_draw(0, 30, buf);
             
             sprintf(buf, "LStk:%02X %02X %02X", raw[3], raw[4], raw[5]);
-            ssd1306_draw_string(&disp, 0, 40, 1, buf);
+            oled_text_draw(0, 40, buf);
         } else {
             sprintf(buf, "->D:0x%02X F:%d", atari_dir, atari_fire);
-            ssd1306_draw_string(&disp, 0, 30, 1, buf);
+            oled_text_draw(0, 30, buf);
             
             sprintf(buf, "UseCnt:%lu", switch_count);
-            ssd1306_draw_string(&disp, 0, 40, 1, buf);
+            oled_text_draw(0, 40, buf);
         }
         
         // Show if values are changing
@@ -406,52 +428,53 @@ void UserInterface::update_usb_debug() {
         } else {
             sprintf(buf, "STATIC");
         }
-        ssd1306_draw_string(&disp, 0, 50, 1, buf);
+        oled_text_draw(0, 50, buf);
     } else {
         // Standard debug page when no Switch active
         // Path counters at top
-        uint32_t gpio_count = get_gpio_path_count();
-        uint32_t usb_count = get_usb_path_count();
+        uint32_t gpio_count = telemetry_counter(TM_JOY_GPIO_PATH);
+        uint32_t usb_count = telemetry_counter(TM_JOY_USB_PATH);
         sprintf(buf, "GPIO:%lu USB:%lu", gpio_count, usb_count);
-        ssd1306_draw_string(&disp, 0, 0, 1, buf);
+        oled_text_draw(0, 0, buf);
         
         // Device counts
         sprintf(buf, "KB:%d M:%d J:%d", num_kb, num_mouse, num_joy);
-        ssd1306_draw_string(&disp, 0, 10, 1, buf);
+        oled_text_draw(0, 10, buf);
         
         // Controller source counters
-        uint32_t hid_count = get_hid_joy_success();
-        uint32_t ps4_count = get_ps4_success();
-        uint32_t xbox_count = get_xbox_success();
+        uint32_t hid_count = telemetry_counter(TM_JOY_HID_OK);
+        uint32_t ps4_count = telemetry_counter(TM_JOY_PS4_OK);
+        uint32_t xbox_count = telemetry_counter(TM_JOY_XBOX_OK);
         
         sprintf(buf, "HID:%lu PS4:%lu", hid_count, ps4_count);
-        ssd1306_draw_string(&disp, 0, 20, 1, buf);
+        oled_text_draw(0, 20, buf);
         
         sprintf(buf, "SW:%lu Xbox:%lu", switch_count, xbox_count);
-        ssd1306_draw_string(&disp, 0, 30, 1, buf);
+        oled_text_draw(0, 30, buf);
         
         // Xbox report reception
-        uint32_t rx_count = get_xbox_report_count();
+        uint32_t rx_count = telemetry_counter(TM_XBOX_REPORTS);
         sprintf(buf, "XRx:%lu", rx_count);
-        ssd1306_draw_string(&disp, 0, 40, 1, buf);
+        oled_text_draw(0, 40, buf);
     }
 #else
     // Simple USB status page (set ENABLE_CONTROLLER_DEBUG=0 in config.h)
-    ssd1306_draw_string(&disp, 0, 0, 1, (char*)"USB Debug Info");
+    oled_text_draw(0, 0, "USB Debug Info");
     
     // Device counts
     sprintf(buf, "KB:%d Mouse:%d Joy:%d", usb_kb, usb_mouse, usb_joy);
-    ssd1306_draw_string(&disp, 0, 12, 1, buf);
+    oled_text_draw(0, 12, buf);
     
     // Mount and report stats
     sprintf(buf, "Mounts:%lu Active:%lu", 
-        hid_debug_get_mount_calls(),
-        hid_debug_get_active_devices());
-    ssd1306_draw_string(&disp, 0, 24, 1, buf);
+        telemetry_counter(TM_USB_HID_MOUNTS),
+        telemetry_gauge(TM_USB_HID_ACTIVE));
+    oled_text_draw(0, 24, buf);
     
-    sprintf(buf, "Reports:%lu", hid_debug_get_report_calls());
-    ssd1306_draw_string(&disp, 0, 36, 1, buf);
+    sprintf(buf, "Reports:%lu", telemetry_counter(TM_USB_HID_REPORTS));
+    oled_text_draw(0, 36, buf);
 #endif
+    return oled_text_end();
 }
 
 void UserInterface::handle_buttons() {
@@ -477,7 +500,7 @@ void UserInterface::toggle_joystick_source(uint8_t joystick_num) {
     // Toggle the joystick device bit (D-SUB <-> USB)
     settings.get_settings().joy_device ^= (1 << joystick_num);
     settings.write();
-    dirty = true;
+    invalidate(page_bit(PAGE_MAPPING));
 }
 
 void UserInterface::on_button_down(int i) {
@@ -487,17 +510,23 @@ void UserInterface::on_button_down(int i) {
 #if ENABLE_SERIAL_LOGGING
     #if ENABLE_CONTROLLER_DEBUG
         // Debug mode (standard build): include all pages up to PRO_INIT
-        pg = ((pg + 1) % (PAGE_PRO_INIT + 1));
+        const int page_count = PAGE_PRO_INIT + 1;
     #else
         // Standard build without controller debug: cycle up to USB_DEBUG / SERIAL
-        pg = ((pg + 1) % (PAGE_USB_DEBUG));
+        const int page_count = PAGE_USB_DEBUG;
     #endif
 #else
-        // Production / speed builds (logging disabled): SPLASH, DEVICES, MAPPING
-        pg = ((pg + 1) % PAGE_SERIAL);
+        // Production / speed builds (logging disabled): SPLASH, DEVICES, MAPPING, TELEMETRY
+        const int page_count = PAGE_SERIAL;
+#endif
+        pg = ((pg + 1) % page_count);
+#if !ENABLE_TELEMETRY
+        if (pg == PAGE_TELEMETRY) {
+            pg = ((pg + 1) % page_count);
+        }
 #endif
         page = (PAGE)pg;
-        dirty = true;
+        redraw_now();
     }
     else if (i == BUTTON_LEFT) {
         if (page == PAGE_SPLASH) {
@@ -529,7 +558,7 @@ void UserInterface::on_button_down(int i) {
                 bt_runtime_enable();
                 printf("Toggled to USB + Bluetooth mode\n");
             }
-            dirty = true;
+            redraw_now();
 #else
             // No Bluetooth support - just toggle USB (though this shouldn't be useful)
             printf("Bluetooth not available in this build\n");
@@ -539,13 +568,19 @@ void UserInterface::on_button_down(int i) {
             if (settings.get_settings().mouse_speed > MOUSE_MIN) {
                 --settings.get_settings().mouse_speed;
                 settings.write();
-                dirty = true;
+                redraw_now();
             }
         }
         else if (page == PAGE_MAPPING) {
             settings.get_settings().joy_device ^= (1 << 1);  // J2 / Joy1 -> DSub
             settings.write();
-            dirty = true;
+            redraw_now();
+        }
+        else if (page == PAGE_TELEMETRY) {
+            if (telemetry_first >= TELEMETRY_LINES) {
+                telemetry_first -= TELEMETRY_LINES;
+                redraw_now();
+            }
         }
     }
     else if (i == BUTTON_RIGHT) {
@@ -558,7 +593,7 @@ void UserInterface::on_button_down(int i) {
             } else {
                 printf("Bluetooth not enabled\n");
             }
-            dirty = true;
+            redraw_now();
 #else
             printf("Bluetooth not available in this build\n");
 #endif
@@ -567,85 +602,85 @@ void UserInterface::on_button_down(int i) {
             if (settings.get_settings().mouse_speed < MOUSE_MAX) {
                 ++settings.get_settings().mouse_speed;
                 settings.write();
-                dirty = true;
+                redraw_now();
             }
         }
         else if (page == PAGE_MAPPING) {
             settings.get_settings().joy_device ^= (1 << 0);  // J1 / Joy0 -> DSub
             settings.write();
-            dirty = true;
+            redraw_now();
+        }
+        else if (page == PAGE_TELEMETRY) {
+            if (telemetry_first + TELEMETRY_LINES < telemetry_line_count()) {
+                telemetry_first += TELEMETRY_LINES;
+                redraw_now();
+            }
         }
     }
 }
 
+// Button feedback: redraw the page on screen at the next update, whatever the rate limit
+void UserInterface::redraw_now() {
+    ui_redraw_now(&redraw, page);
+}
+
 void UserInterface::update() {
     if (mount_splash_poll()) {
-        dirty = true;
+        // The splash drew over the framebuffer
+        oled_text_invalidate();
+        redraw_now();
     }
 
+    handle_buttons();
+
     if (mount_splash_is_active()) {
-        handle_buttons();
         return;
     }
 
-    handle_buttons();
-
-    if (dirty) {
-        dirty = false;
+    if (!ui_redraw_due(&redraw, page, get_absolute_time())) {
+        return;     // Notifications until then collapse into one redraw
+    }
+    tm_inc(TM_UI_REDRAWS);
 
-        if (page == PAGE_DEVICES) {
-            update_devices();
-        }
-        else if (page == PAGE_MAPPING) {
-            update_mapping();
-        }
-        else if (page == PAGE_SERIAL) {
+    bool changed = true;    // Text pages report whether any cell changed
+    if (page == PAGE_DEVICES) {
+        changed = update_devices();
+    }
+    else if (page == PAGE_MAPPING) {
+        changed = update_mapping();
+    }
+    else if (page == PAGE_TELEMETRY) {
+        changed = update_telemetry();
+    }
+    else if (page == PAGE_SERIAL) {
 #if ENABLE_SERIAL_LOGGING
-            absolute_time_t tm = get_absolute_time();
-            if (absolute_time_diff_us(serial_tm, tm) >= (500 * 1000)) {
-                serial_tm = tm;
-                update_serial();
-            }
-            else {
-                // Not time yet
-                dirty = true;
-            }
+        changed = update_serial();
 #endif
-        }
-        else if (page == PAGE_SPLASH) {
-            update_splash();
-        }
-        else if (page == PAGE_USB_DEBUG) {
+    }
+    else if (page == PAGE_SPLASH) {
+        update_splash();
+    }
+    else if (page == PAGE_USB_DEBUG) {
 #if ENABLE_CONTROLLER_DEBUG && ENABLE_SERIAL_LOGGING
-            update_usb_debug();
-            ssd1306_show(&disp);
-            // Keep refreshing debug page
-            dirty = true;
+        changed = update_usb_debug();
 #endif
-        }
-        else if (page == PAGE_PRO_INIT) {
+    }
+    else if (page == PAGE_PRO_INIT) {
 #if ENABLE_CONTROLLER_DEBUG && ENABLE_SERIAL_LOGGING
-            update_pro_init();
-            ssd1306_show(&disp);
-            // Keep refreshing to show latest status
-            dirty = true;
+        changed = update_pro_init();
 #endif
-        }
-        if (!dirty) {
-            ssd1306_show(&disp);
-        }
+    }
+    if (changed) {
+        ssd1306_show(&disp);
     }
 }
 
 void UserInterface::serial(bool send, uint8_t data) {
-    char buf[32];
-    sprintf(buf, "%s%02X", send ? "              " : "", data);
-
-    serial_lines.push_back(std::string(buf));
-    while (serial_lines.size() > 7) {
-        serial_lines.pop_front();
-    }
-    if (page == PAGE_SERIAL) {
-        dirty = true;
+    serial_data[serial_head] = data;
+    serial_sent[serial_head] = send;
+    serial_head = (serial_head + 1) % SERIAL_LINES;
+    if (serial_count < SERIAL_LINES) {
+        ++serial_count;
     }
+    ui_redraw_invalidate(&redraw, page_bit(PAGE_SERIAL));
 }
@@ -0,0 +1,121 @@
+/*
+ * Core 1 guard for Bluetooth gamepad enumeration
+ * See bluepad32_guard.h
+ */
+
+#if ENABLE_BLUEPAD32
+
+#include <stdio.h>
+#include <btstack.h>
+#include <pico/time.h>
+
+#include "config.h"
+#include "telemetry.h"
+#include "bluepad32_guard.h"
+#include "core1_link.h"
+
+static bool holding;                    // Core 1 paused by the guard
+static bool release_wanted;             // Enumeration over, waiting for flash to go quiet
+static uint32_t hold_start_ms;
+static volatile uint32_t flash_busy;    // flash_safe_execute() calls in progress
+static volatile uint32_t flash_done_ms; // When the last one returned
+static btstack_timer_source_t timer;
+
+static uint32_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+int __real_flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms);
+
+// Every flash_safe_execute() in the image (BTstack TLV bank, NVSettings) lands here
+int __wrap_flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms) {
+    flash_busy++;
+    core1_pause_for_bt_enumeration();
+    core1_wait_for_pause_active(BT_CORE1_PARK_TIMEOUT_MS);
+    int rc = __real_flash_safe_execute(func, param, enter_exit_timeout_ms);
+    core1_resume_after_bt_enumeration();
+    flash_done_ms = now_ms();
+    flash_busy--;
+    tm_inc(TM_BT_FLASH_WRITES);
+    return rc;
+}
+
+static void guard_check(btstack_timer_source_t* ts);
+
+static void arm(uint32_t ms) {
+    btstack_run_loop_remove_timer(&timer);
+    btstack_run_loop_set_timer_handler(&timer, guard_check);
+    btstack_run_loop_set_timer(&timer, ms);
+    btstack_run_loop_add_timer(&timer);
+}
+
+static void resume(uint32_t now, bool capped) {
+    uint32_t held = now - hold_start_ms;
+    holding = false;
+    release_wanted = false;
+    btstack_run_loop_remove_timer(&timer);
+    core1_resume_after_bt_enumeration();
+    tm_hist(TM_BT_PAUSE_MS, held);
+    if (capped) {
+        tm_inc(TM_BT_PAUSE_CAPPED);
+    }
+#if ENABLE_SERIAL_LOGGING
+    printf("[DIAG] Core1 enumeration hold released after %lu ms%s\n",
+           (unsigned long)held, capped ? " (cap)" : "");
+#endif
+}
+
+// Resume if enumeration is over and flash is quiet, otherwise re-arm for the
+// earlier of the quiet window ending and the hold cap
+static void guard_check(btstack_timer_source_t* ts) {
+    (void)ts;
+    if (!holding) {
+        return;
+    }
+    uint32_t now = now_ms();
+    uint32_t held = now - hold_start_ms;
+    if (held >= BT_ENUM_PAUSE_MAX_MS) {
+        resume(now, true);
+        return;
+    }
+    uint32_t wait = BT_ENUM_PAUSE_MAX_MS - held;
+    if (release_wanted) {
+        uint32_t quiet = now - flash_done_ms;
+        if (flash_busy == 0 && quiet >= BT_FLASH_QUIET_MS) {
+            resume(now, false);
+            return;
+        }
+        uint32_t left = flash_busy ? 1 : BT_FLASH_QUIET_MS - quiet;
+        if (left < wait) {
+            wait = left;
+        }
+    }
+    arm(wait);
+}
+
+void bluepad32_guard_hold(void) {
+    if (holding) {
+        release_wanted = false;
+        return;
+    }
+    holding = true;
+    release_wanted = false;
+    hold_start_ms = now_ms();
+    core1_pause_for_bt_enumeration();
+    tm_inc(TM_BT_ENUM_PAUSES);
+    arm(BT_ENUM_PAUSE_MAX_MS);
+}
+
+void bluepad32_guard_release(void) {
+    if (!holding) {
+        return;
+    }
+    release_wanted = true;
+    guard_check(NULL);
+}
+
+bool bluepad32_guard_active(void) {
+    return holding;
+}
+
+#endif // ENABLE_BLUEPAD32
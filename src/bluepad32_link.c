@@ -0,0 +1,223 @@
+/*
+ * Bluetooth link latency tuning for HID peers
+ * See bluepad32_link.h
+ */
+
+#if ENABLE_BLUEPAD32
+
+#include <stdio.h>
+#include <string.h>
+#include <btstack.h>
+
+#include "config.h"
+#include "telemetry.h"
+#include "bluepad32_link.h"
+
+#define MAX_BT_LINKS        MAX_NR_HCI_CONNECTIONS
+#define LINK_TYPE_ACL       0x01
+#define LINK_MODE_SNIFF     0x02
+
+typedef struct {
+    bool             used;
+    bool             le;
+    hci_con_handle_t handle;
+    uint16_t         interval;      // LE: 1.25 ms units, Classic sniff: 0.625 ms slots
+    uint16_t         latency;       // LE peripheral latency
+    uint8_t          mode;          // Classic: 0 active, 2 sniff
+    uint8_t          updates;       // LE parameter update requests sent
+    uint8_t          sniff_exits;   // Classic sniff exits requested
+} bt_link_t;
+
+static bt_link_t links[MAX_BT_LINKS];
+static bool low_latency = true;
+static btstack_packet_callback_registration_t hci_event_registration;
+
+static bt_link_t* find_link(hci_con_handle_t handle, bool create) {
+    bt_link_t* free_link = NULL;
+    for (int i = 0; i < MAX_BT_LINKS; i++) {
+        if (links[i].used && links[i].handle == handle) {
+            return &links[i];
+        }
+        if (!links[i].used && !free_link) {
+            free_link = &links[i];
+        }
+    }
+    if (create && free_link) {
+        memset(free_link, 0, sizeof(*free_link));
+        free_link->used = true;
+        free_link->handle = handle;
+    }
+    return create ? free_link : NULL;
+}
+
+static bool le_params_ok(const bt_link_t* link) {
+    return link->interval <= BT_LE_CONN_INTERVAL_MAX && link->latency == 0;
+}
+
+// Ask for our parameters again, a bounded number of times per link so a peer
+// that insists on its own values does not get flooded
+static void tune_le(bt_link_t* link) {
+    if (!low_latency || le_params_ok(link) || link->updates >= BT_LINK_MAX_REQUESTS) {
+        return;
+    }
+    link->updates++;
+    tm_inc(TM_BT_LE_UPDATES);
+    gap_update_connection_parameters(link->handle, BT_LE_CONN_INTERVAL_MIN, BT_LE_CONN_INTERVAL_MAX,
+                                     0, BT_LE_SUPERVISION_TIMEOUT);
+}
+
+static void tune_classic(bt_link_t* link) {
+    if (!low_latency || link->mode != LINK_MODE_SNIFF || link->sniff_exits >= BT_LINK_MAX_REQUESTS) {
+        return;
+    }
+    link->sniff_exits++;
+    tm_inc(TM_BT_SNIFF_EXITS);
+    gap_sniff_mode_exit(link->handle);
+}
+
+// Classic links take the default link policy when they are created
+static void apply_link_policy(void) {
+    uint16_t policy = LM_LINK_POLICY_ENABLE_ROLE_SWITCH;
+    if (!low_latency) {
+        policy |= LM_LINK_POLICY_ENABLE_SNIFF_MODE;
+    }
+    gap_set_default_link_policy_settings(policy);
+}
+
+static void hci_event_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet, uint16_t size) {
+    (void)channel;
+    (void)size;
+    bt_link_t* link;
+
+    if (packet_type != HCI_EVENT_PACKET) {
+        return;
+    }
+
+    switch (hci_event_packet_get_type(packet)) {
+        case HCI_EVENT_LE_META:
+            switch (hci_event_le_meta_get_subevent_code(packet)) {
+                case HCI_SUBEVENT_LE_CONNECTION_COMPLETE:
+                    if (hci_subevent_le_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS) {
+                        break;
+                    }
+                    link = find_link(hci_subevent_le_connection_complete_get_connection_handle(packet), true);
+                    if (link) {
+                        link->le = true;
+                        link->interval = hci_subevent_le_connection_complete_get_conn_interval(packet);
+                        link->latency = hci_subevent_le_connection_complete_get_conn_latency(packet);
+                        tune_le(link);
+                    }
+                    break;
+                case HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE:
+                    // A rejected update leaves the parameters as they were;
+                    // the fields of a failed event are not to be used
+                    if (hci_subevent_le_connection_update_complete_get_status(packet) != ERROR_CODE_SUCCESS) {
+                        break;
+                    }
+                    link = find_link(hci_subevent_le_connection_update_complete_get_connection_handle(packet), true);
+                    if (link) {
+                        link->le = true;
+                        link->interval = hci_subevent_le_connection_update_complete_get_conn_interval(packet);
+                        link->latency = hci_subevent_le_connection_update_complete_get_conn_latency(packet);
+                        tune_le(link);
+                    }
+                    break;
+                default:
+                    break;
+            }
+            break;
+
+        case HCI_EVENT_CONNECTION_COMPLETE:
+            if (hci_event_connection_complete_get_status(packet) != ERROR_CODE_SUCCESS ||
+                hci_event_connection_complete_get_link_type(packet) != LINK_TYPE_ACL) {
+                break;
+            }
+            link = find_link(hci_event_connection_complete_get_connection_handle(packet), true);
+            if (link) {
+                link->le = false;
+            }
+            break;
+
+        case HCI_EVENT_MODE_CHANGE:
+            if (hci_event_mode_change_get_status(packet) != ERROR_CODE_SUCCESS) {
+                break;
+            }
+            link = find_link(hci_event_mode_change_get_handle(packet), false);
+            if (link) {
+                link->mode = hci_event_mode_change_get_mode(packet);
+                link->interval = hci_event_mode_change_get_interval(packet);
+                tune_classic(link);
+            }
+            break;
+
+        case HCI_EVENT_DISCONNECTION_COMPLETE:
+            link = find_link(hci_event_disconnection_complete_get_connection_handle(packet), false);
+            if (link) {
+                link->used = false;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void bluepad32_link_init(void) {
+    hci_event_registration.callback = &hci_event_handler;
+    hci_add_event_handler(&hci_event_registration);
+
+    // Defaults for links we initiate; existing ones are updated from the events
+    gap_set_connection_parameters(BT_LE_SCAN_INTERVAL, BT_LE_SCAN_WINDOW,
+                                  BT_LE_CONN_INTERVAL_MIN, BT_LE_CONN_INTERVAL_MAX,
+                                  0, BT_LE_SUPERVISION_TIMEOUT, 0, 0);
+    apply_link_policy();
+}
+
+void bluepad32_link_set_low_latency(bool enabled) {
+    if (enabled == low_latency) {
+        return;
+    }
+    low_latency = enabled;
+    apply_link_policy();
+    for (int i = 0; i < MAX_BT_LINKS; i++) {
+        if (!links[i].used) {
+            continue;
+        }
+        // Fresh request budget each time the ST comes back
+        links[i].updates = 0;
+        links[i].sniff_exits = 0;
+        if (links[i].le) {
+            tune_le(&links[i]);
+        } else {
+            tune_classic(&links[i]);
+        }
+    }
+}
+
+void bluepad32_link_print(void) {
+    bool any = false;
+    printf("low latency %s\n", low_latency ? "on" : "off");
+    for (int i = 0; i < MAX_BT_LINKS; i++) {
+        const bt_link_t* link = &links[i];
+        if (!link->used) {
+            continue;
+        }
+        any = true;
+        if (link->le) {
+            // 1.25 ms units
+            printf("%04x LE      interval %u.%02u ms latency %u (%u requests)\n", link->handle,
+                   link->interval * 125 / 100, link->interval * 125 % 100, link->latency, link->updates);
+        } else if (link->mode == LINK_MODE_SNIFF) {
+            // 0.625 ms slots
+            printf("%04x Classic sniff %u.%03u ms (%u exits)\n", link->handle,
+                   link->interval * 625 / 1000, link->interval * 625 % 1000, link->sniff_exits);
+        } else {
+            printf("%04x Classic active (%u exits)\n", link->handle, link->sniff_exits);
+        }
+    }
+    if (!any) {
+        printf("no links\n");
+    }
+}
+
+#endif // ENABLE_BLUEPAD32
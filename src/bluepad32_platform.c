@@ -14,6 +14,11 @@
 #include "sdkconfig.h"
 #include "config.h"
 #include "version.h"
+#include "telemetry.h"
+#include "bluepad32_link.h"
+#include "bluepad32_guard.h"
+#include "pad_keymap.h"
+#include "core1_link.h"
 
 #if ENABLE_SERIAL_LOGGING
 #define DIAG_LOGI(...) logi(__VA_ARGS__)
@@ -31,50 +36,9 @@
 #define MAX_BT_KEYBOARDS 2
 #define MAX_BT_MICE 2
 
-// Forward declarations for Core 1 pause/resume functions
-extern void core1_pause_for_bt_enumeration(void);
-extern void core1_resume_after_bt_enumeration(void);
-extern void core1_wait_for_pause_active(uint32_t timeout_ms);
-extern uint32_t core1_get_pause_depth(void);
-
-// busy_wait_us is safe inside BT callbacks; sleep_ms/__wfe are not (timer/IRQ may stall).
-static void bt_callback_busy_wait_ms(uint32_t ms) {
-    busy_wait_us(ms * 1000u);
-}
-
-// Throttled BT input diagnostics (serial debug)
-static uint32_t bt_diag_kb_reports = 0;
-static uint32_t bt_diag_mouse_reports = 0;
-static uint32_t bt_diag_joy_reports = 0;
-static uint32_t bt_diag_kb_cb_drop = 0;
-static uint32_t bt_diag_mouse_cb_drop = 0;
-static uint32_t bt_diag_joy_cb_drop = 0;
-static uint32_t bt_diag_joy_cb_early = 0;
-static uint32_t bt_diag_kb_get_ok = 0;
-static uint32_t bt_diag_kb_get_noupd = 0;
-static uint32_t bt_diag_mouse_get_ok = 0;
-static uint32_t bt_diag_mouse_get_noupd = 0;
-static uint32_t bt_diag_joy_get_ok = 0;
-static uint32_t bt_diag_joy_get_noupd = 0;
-static absolute_time_t bt_diag_last_log = {0};
+// Throttled BT storage snapshot (serial debug); counters live in telemetry
 static absolute_time_t bt_diag_last_snapshot = {0};
 
-static void bt_diag_maybe_log(void) {
-    absolute_time_t now = get_absolute_time();
-    if (absolute_time_diff_us(bt_diag_last_log, now) < 5000000) {
-        return;
-    }
-    bt_diag_last_log = now;
-    DIAG_LOGI("[DIAG] BT reports/5s: kb=%lu mouse=%lu joy=%lu pause_depth=%lu\n",
-         (unsigned long)bt_diag_kb_reports,
-         (unsigned long)bt_diag_mouse_reports,
-         (unsigned long)bt_diag_joy_reports,
-         (unsigned long)core1_get_pause_depth());
-    bt_diag_kb_reports = 0;
-    bt_diag_mouse_reports = 0;
-    bt_diag_joy_reports = 0;
-}
-
 // Storage for Bluetooth gamepad data
 typedef struct {
     uni_gamepad_t gamepad;
@@ -239,38 +203,6 @@ void bluepad32_diag_log_snapshot(void) {
              bt_mice[i].name[0] ? bt_mice[i].name : "-");
     }
     DIAG_LOGI("\n");
-
-    DIAG_LOGI("[DIAG] BT callbacks/5s: kb_in=%lu ms_in=%lu joy_in=%lu kb_drop=%lu ms_drop=%lu joy_drop=%lu joy_early=%lu\n",
-         (unsigned long)bt_diag_kb_reports,
-         (unsigned long)bt_diag_mouse_reports,
-         (unsigned long)bt_diag_joy_reports,
-         (unsigned long)bt_diag_kb_cb_drop,
-         (unsigned long)bt_diag_mouse_cb_drop,
-         (unsigned long)bt_diag_joy_cb_drop,
-         (unsigned long)bt_diag_joy_cb_early);
-
-    DIAG_LOGI("[DIAG] BT getters/5s: kb_ok=%lu kb_noupd=%lu ms_ok=%lu ms_noupd=%lu joy_ok=%lu joy_noupd=%lu pause_depth=%lu\n",
-         (unsigned long)bt_diag_kb_get_ok,
-         (unsigned long)bt_diag_kb_get_noupd,
-         (unsigned long)bt_diag_mouse_get_ok,
-         (unsigned long)bt_diag_mouse_get_noupd,
-         (unsigned long)bt_diag_joy_get_ok,
-         (unsigned long)bt_diag_joy_get_noupd,
-         (unsigned long)core1_get_pause_depth());
-
-    bt_diag_kb_reports = 0;
-    bt_diag_mouse_reports = 0;
-    bt_diag_joy_reports = 0;
-    bt_diag_kb_cb_drop = 0;
-    bt_diag_mouse_cb_drop = 0;
-    bt_diag_joy_cb_drop = 0;
-    bt_diag_joy_cb_early = 0;
-    bt_diag_kb_get_ok = 0;
-    bt_diag_kb_get_noupd = 0;
-    bt_diag_mouse_get_ok = 0;
-    bt_diag_mouse_get_noupd = 0;
-    bt_diag_joy_get_ok = 0;
-    bt_diag_joy_get_noupd = 0;
 #endif
 }
 
@@ -293,6 +225,9 @@ static void my_platform_on_init_complete(void) {
     logi("Waiting for HCI to be ready...\n");
     sleep_ms(2000);  // Give HCI 2 seconds to initialize
 
+    // Short BLE intervals and no sniff for HID peers (after Bluepad32's own setup)
+    bluepad32_link_init();
+
     // Start scanning and autoconnect to supported controllers
     logi("Starting Bluetooth scanning and autoconnect...\n");
     uni_bt_start_scanning_and_autoconnect_unsafe();
@@ -324,10 +259,8 @@ static uni_error_t my_platform_on_device_discovered(bd_addr_t addr, const char*
     if (might_be_gamepad) {
         DIAG_LOGI("[DIAG] Pausing Core 1 for gamepad discovery (COD=0x%04X, name='%s')\n",
                   cod, name ? name : "(null)");
-        core1_pause_for_bt_enumeration();
-        core1_wait_for_pause_active(20);
-        bt_callback_busy_wait_ms(BT_GAMEPAD_DISCOVERY_SETTLE_MS);
-        DIAG_LOGI("[DIAG] Core1 pause_depth=%lu after discovery settle\n",
+        bluepad32_guard_hold();
+        DIAG_LOGI("[DIAG] Core1 pause_depth=%lu after discovery\n",
                   (unsigned long)core1_get_pause_depth());
     }
 
@@ -351,13 +284,12 @@ static void my_platform_on_device_connected(uni_hid_device_t* d) {
 static void my_platform_on_device_disconnected(uni_hid_device_t* d) {
     logi("bluepad32_platform: device disconnected: %p\n", d);
     
-    // Resume only if enumeration was interrupted (Core 1 still paused)
-    if (core1_get_pause_depth() > 0) {
-        DIAG_LOGI("[DIAG] disconnect during enumeration (depth=%lu), resuming Core 1\n",
-             (unsigned long)core1_get_pause_depth());
-        core1_resume_after_bt_enumeration();
-        DIAG_LOGI("[DIAG] Core1 pause_depth=%lu after disconnect resume\n",
+    // Enumeration interrupted: let Core 1 go once flash is quiet. Only the
+    // guard's own pause is dropped, not one held by ST idle.
+    if (bluepad32_guard_active()) {
+        DIAG_LOGI("[DIAG] disconnect during enumeration (depth=%lu), releasing Core 1\n",
              (unsigned long)core1_get_pause_depth());
+        bluepad32_guard_release();
     }
     
     // Clear storage for all device types (device might have been any type)
@@ -485,22 +417,9 @@ static uni_error_t my_platform_on_device_ready(uni_hid_device_t* d) {
          (device_name && device_name[0]) ? device_name : "(none)",
          (unsigned long)core1_get_pause_depth());
 
-    // Resume Core 1 after enumeration. Gamepad discovery pauses Core 1 while
-    // BTstack may write pairing data to flash — wait before resume so Core 1
-    // does not re-enter XIP emulator during flash_safe_execute (Heisenbug without
-    // debug logging: 10 ms was too short; extra logi delay masked the race).
-    if (core1_get_pause_depth() > 0) {
-#if ENABLE_SERIAL_LOGGING
-        DIAG_LOGI("[DIAG] Waiting %dms before resuming Core 1 after device ready\n",
-             BT_GAMEPAD_CORE1_RESUME_DELAY_MS);
-#endif
-        bt_callback_busy_wait_ms(BT_GAMEPAD_CORE1_RESUME_DELAY_MS);
-        core1_resume_after_bt_enumeration();
-#if ENABLE_SERIAL_LOGGING
-        DIAG_LOGI("[DIAG] Core1 pause_depth=%lu after device ready resume\n",
-             (unsigned long)core1_get_pause_depth());
-#endif
-    }
+    // Enumeration is over. The guard resumes Core 1 from a run-loop timer once
+    // BTstack has finished writing pairing data to flash.
+    bluepad32_guard_release();
     
     return UNI_ERROR_SUCCESS;
 }
@@ -510,23 +429,23 @@ static void my_platform_on_controller_data(uni_hid_device_t* d, uni_controller_t
         case UNI_CONTROLLER_CLASS_GAMEPAD: {
             bt_gamepad_storage_t* storage = get_gamepad_storage(d);
             if (!storage) {
-                bt_diag_joy_cb_drop++;
+                tm_inc(TM_BT_JOY_CB_DROP);
                 break;
             }
             if (!storage->connected) {
-                bt_diag_joy_cb_early++;
+                tm_inc(TM_BT_JOY_CB_EARLY);
                 break;
             }
             storage->gamepad = ctl->gamepad;
             storage->updated = true;
-            bt_diag_joy_reports++;
+            tm_inc(TM_BT_JOY_REPORTS);
             break;
         }
         
         case UNI_CONTROLLER_CLASS_KEYBOARD: {
             bt_keyboard_storage_t* storage = get_keyboard_storage(d);
             if (!storage) {
-                bt_diag_kb_cb_drop++;
+                tm_inc(TM_BT_KB_CB_DROP);
                 break;
             }
             if (!storage->connected) {
@@ -534,14 +453,14 @@ static void my_platform_on_controller_data(uni_hid_device_t* d, uni_controller_t
             }
             storage->keyboard = ctl->keyboard;
             storage->updated = true;
-            bt_diag_kb_reports++;
+            tm_inc(TM_BT_KB_REPORTS);
             break;
         }
         
         case UNI_CONTROLLER_CLASS_MOUSE: {
             bt_mouse_storage_t* storage = get_mouse_storage(d);
             if (!storage) {
-                bt_diag_mouse_cb_drop++;
+                tm_inc(TM_BT_MOUSE_CB_DROP);
                 break;
             }
             if (!storage->connected) {
@@ -549,7 +468,7 @@ static void my_platform_on_controller_data(uni_hid_device_t* d, uni_controller_t
             }
             storage->mouse = ctl->mouse;
             storage->updated = true;
-            bt_diag_mouse_reports++;
+            tm_inc(TM_BT_MOUSE_REPORTS);
             break;
         }
         
@@ -558,7 +477,6 @@ static void my_platform_on_controller_data(uni_hid_device_t* d, uni_controller_t
             logi("bluepad32_platform: unknown controller class: %d\n", ctl->klass);
             break;
     }
-    bt_diag_maybe_log();
 }
 
 static const uni_property_t* my_platform_get_property(uni_property_idx_t idx) {
@@ -608,16 +526,66 @@ bool bluepad32_get_gamepad(int idx, void* out_gamepad) {
         uni_gamepad_t* gp = (uni_gamepad_t*)out_gamepad;
         *gp = bt_gamepads[idx].gamepad;
         bt_gamepads[idx].updated = false;
-        bt_diag_joy_get_ok++;
+        tm_inc(TM_BT_JOY_GET_OK);
         return true;
     }
     if (bt_gamepads[idx].connected) {
-        bt_diag_joy_get_noupd++;
+        tm_inc(TM_BT_JOY_GET_NOUPD);
     }
     
     return false;
 }
 
+// Right stick of the first connected gamepad without consuming its update flag.
+// Bluepad32 reports -512..511; the 16-bit range some pads produce is detected
+// the first time it is seen (same split as the joystick deadzone heuristic).
+bool bluepad32_right_stick(int8_t* x, int8_t* y) {
+    static bool full_range = false;
+    for (int i = 0; i < MAX_BT_GAMEPADS; i++) {
+        if (bt_gamepads[i].connected) {
+            int32_t rx = bt_gamepads[i].gamepad.axis_rx;
+            int32_t ry = bt_gamepads[i].gamepad.axis_ry;
+            if (rx > 1000 || rx < -1000 || ry > 1000 || ry < -1000) {
+                full_range = true;
+            }
+            int shift = full_range ? 8 : 2;
+            rx >>= shift;
+            ry >>= shift;
+            *x = (int8_t)(rx < -128 ? -128 : (rx > 127 ? 127 : rx));
+            *y = (int8_t)(ry < -128 ? -128 : (ry > 127 ? 127 : ry));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Bluepad32 already names buttons by Xbox position; like bluepad32_right_stick()
+// this leaves the update flag alone
+bool bluepad32_pad_buttons(uint32_t* buttons) {
+    static const struct { uint16_t uni; uint16_t pad; } map[] = {
+        { BUTTON_A, PAD_BTN_SOUTH },          { BUTTON_B, PAD_BTN_EAST },
+        { BUTTON_X, PAD_BTN_WEST },           { BUTTON_Y, PAD_BTN_NORTH },
+        { BUTTON_SHOULDER_L, PAD_BTN_L1 },    { BUTTON_SHOULDER_R, PAD_BTN_R1 },
+        { BUTTON_TRIGGER_L, PAD_BTN_L2 },     { BUTTON_TRIGGER_R, PAD_BTN_R2 },
+        { BUTTON_THUMB_L, PAD_BTN_L3 },       { BUTTON_THUMB_R, PAD_BTN_R3 },
+    };
+    for (int i = 0; i < MAX_BT_GAMEPADS; i++) {
+        if (bt_gamepads[i].connected) {
+            const uni_gamepad_t* gp = &bt_gamepads[i].gamepad;
+            uint32_t mask = 0;
+            for (size_t b = 0; b < sizeof(map) / sizeof(map[0]); b++) {
+                if (gp->buttons & map[b].uni) mask |= map[b].pad;
+            }
+            if (gp->misc_buttons & MISC_BUTTON_SELECT) mask |= PAD_BTN_SELECT;
+            if (gp->misc_buttons & MISC_BUTTON_START) mask |= PAD_BTN_START;
+            if (gp->misc_buttons & MISC_BUTTON_SYSTEM) mask |= PAD_BTN_HOME;
+            *buttons = mask;
+            return true;
+        }
+    }
+    return false;
+}
+
 int bluepad32_get_connected_count(void) {
     int count = 0;
     for (int i = 0; i < MAX_BT_GAMEPADS; i++) {
@@ -639,11 +607,11 @@ bool bluepad32_get_keyboard(int idx, void* out_keyboard) {
         uni_keyboard_t* kb = (uni_keyboard_t*)out_keyboard;
         *kb = bt_keyboards[idx].keyboard;
         bt_keyboards[idx].updated = false;
-        bt_diag_kb_get_ok++;
+        tm_inc(TM_BT_KB_GET_OK);
         return true;
     }
     if (bt_keyboards[idx].connected) {
-        bt_diag_kb_get_noupd++;
+        tm_inc(TM_BT_KB_GET_NOUPD);
     }
     
     return false;
@@ -676,16 +644,21 @@ bool bluepad32_get_mouse(int idx, void* out_mouse) {
         uni_mouse_t* ms = (uni_mouse_t*)out_mouse;
         *ms = bt_mice[idx].mouse;
         bt_mice[idx].updated = false;
-        bt_diag_mouse_get_ok++;
+        tm_inc(TM_BT_MOUSE_GET_OK);
         return true;
     }
     if (bt_mice[idx].connected) {
-        bt_diag_mouse_get_noupd++;
+        tm_inc(TM_BT_MOUSE_GET_NOUPD);
     }
     
     return false;
 }
 
+// True while the mouse in slot idx is connected, whether or not it has new data
+bool bluepad32_mouse_connected(int idx) {
+    return idx >= 0 && idx < MAX_BT_MICE && bt_mice[idx].connected;
+}
+
 // Get count of connected Bluetooth keyboards
 int bluepad32_get_keyboard_count(void) {
     int count = 0;
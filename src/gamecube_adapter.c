@@ -8,9 +8,12 @@
 
 #include "gamecube_adapter.h"
 #include "usb_device_map.h"
+#include "pad_keymap.h"
+#include "mount_splash.h"
+#include "telemetry.h"
 #include "config.h"
 #include "tusb.h"
-#include "ssd1306.h"
+#include "pico/time.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -50,6 +53,8 @@ static gc_adapter_t* allocate_adapter(uint8_t dev_addr) {
     adapter->connected = true;
     adapter->deadzone = 35;  // Default from reference driver
     adapter->active_port = 0xFF;  // No active port yet
+    adapter->state = GC_STATE_WAIT_REPORT;
+    adapter->deadline_ms = to_ms_since_boot(get_absolute_time()) + GC_FIRST_REPORT_TIMEOUT_MS;
     
     return adapter;
 }
@@ -81,7 +86,6 @@ bool gc_is_adapter(uint16_t vid, uint16_t pid) {
 bool gc_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t len) {
     static bool first_report_ever = true;
     static uint32_t total_reports = 0;
-    extern ssd1306_t disp;
     
     total_reports++;
     
@@ -132,6 +136,15 @@ bool gc_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t len) {
 #endif
     }
     
+    // Only once bring-up is done: another interface of the adapter may
+    // still be between its mode switch and start command
+    if (adapter->state == GC_STATE_WAIT_REPORT) {
+        adapter->state = GC_STATE_STREAMING;
+#if ENABLE_CONTROLLER_DEBUG
+        mount_splash_show(MOUNT_SPLASH_DEFAULT_MS, "GC Streaming", "Reports OK", NULL);
+#endif
+    }
+    
     // Parse the report (copy to adapter structure)
     memcpy(&adapter->report, report, sizeof(gc_adapter_report_t) < len ? 
            sizeof(gc_adapter_report_t) : len);
@@ -341,6 +354,36 @@ bool gc_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
     return false;
 }
 
+bool gc_right_stick(int8_t* x, int8_t* y) {
+    for (uint8_t i = 0; i < adapter_count; i++) {
+        if (adapters[i].connected && adapters[i].active_port < 4) {
+            const gc_controller_input_t* ctrl = &adapters[i].report.port[adapters[i].active_port];
+            *x = (int8_t)(ctrl->c_stick_x - 127);
+            *y = (int8_t)(127 - ctrl->c_stick_y);  // Invert Y
+            return true;
+        }
+    }
+    return false;
+}
+
+bool gc_pad_buttons(uint32_t* buttons) {
+    for (uint8_t i = 0; i < adapter_count; i++) {
+        if (adapters[i].connected && adapters[i].active_port < 4) {
+            const gc_controller_input_t* ctrl = &adapters[i].report.port[adapters[i].active_port];
+            *buttons = ((ctrl->buttons1 & GC_BTN_A) ? PAD_BTN_SOUTH : 0) |
+                       ((ctrl->buttons1 & GC_BTN_B) ? PAD_BTN_EAST : 0) |
+                       ((ctrl->buttons1 & GC_BTN_X) ? PAD_BTN_WEST : 0) |
+                       ((ctrl->buttons1 & GC_BTN_Y) ? PAD_BTN_NORTH : 0) |
+                       ((ctrl->buttons2 & GC_BTN_Z) ? PAD_BTN_R1 : 0) |
+                       ((ctrl->buttons2 & GC_BTN_L) ? PAD_BTN_L2 : 0) |
+                       ((ctrl->buttons2 & GC_BTN_R) ? PAD_BTN_R2 : 0) |
+                       ((ctrl->buttons2 & GC_BTN_START) ? PAD_BTN_START : 0);
+            return true;
+        }
+    }
+    return false;
+}
+
 void gc_set_deadzone(uint8_t dev_addr, int16_t deadzone) {
     gc_adapter_t* adapter = find_adapter_by_addr(dev_addr);
     if (adapter) {
@@ -351,94 +394,150 @@ void gc_set_deadzone(uint8_t dev_addr, int16_t deadzone) {
     }
 }
 
-// Send initialization command to a specific instance
-void gc_send_init(uint8_t dev_addr, uint8_t instance) {
-#if ENABLE_SERIAL_LOGGING
-    printf("GC: Sending init to addr=%d, inst=%d\n", dev_addr, instance);
-#endif
-    
-    // GameCube adapter initialization command
-    // Based on gc-x and Dolphin: send 0x13 to start adapter
-    // This is NOT the rumble command (rumble is 0x11)
-    static const uint8_t gc_init_command[] = {
-        0x13  // Enable adapter / start sending reports
+//--------------------------------------------------------------------
+// Bring-up State Machine
+//--------------------------------------------------------------------
+
+static uint32_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static void enter_state(gc_adapter_t* adapter, gc_state_t state, uint32_t timeout_ms) {
+    adapter->state = state;
+    adapter->deadline_ms = now_ms() + timeout_ms;
+}
+
+static void mode_switch_done(tuh_xfer_t* xfer);
+
+// PC mode: class request 11, value 1 on the interface. Third-party adapters
+// need it; the official one may STALL it, which is harmless.
+static void mode_switch(gc_adapter_t* adapter) {
+    tusb_control_request_t const request = {
+        .bmRequestType_bit = {
+            .recipient = TUSB_REQ_RCPT_INTERFACE,
+            .type = TUSB_REQ_TYPE_CLASS,
+            .direction = TUSB_DIR_OUT
+        },
+        .bRequest = 11,
+        .wValue = 1,
+        .wIndex = adapter->itf,
+        .wLength = 0
     };
-    
-    // Send as output report to activate the adapter
-    bool result = tuh_hid_set_report(dev_addr, instance,
-                                      0,            // report_id (0 for single byte)
-                                      HID_REPORT_TYPE_OUTPUT,
-                                      (uint8_t*)gc_init_command, 
-                                      sizeof(gc_init_command));
-    
+    tuh_xfer_t xfer = {
+        .daddr = adapter->dev_addr,
+        .ep_addr = 0,
+        .setup = &request,
+        .buffer = NULL,
+        .complete_cb = mode_switch_done,
+        .user_data = adapter->itf
+    };
+
+    enter_state(adapter, GC_STATE_MODE_SWITCH, GC_MODE_SWITCH_TIMEOUT_MS);
+    if (!tuh_control_xfer(&xfer)) {
+        // Control pipe busy: go straight on, gc_task() queues the start command
+        adapter->state = GC_STATE_START;
+    }
+}
+
+// Queue 0x13 on the interrupt OUT pipe and arm the first IN transfer.
+// Returns false if the OUT pipe is busy; gc_task() tries again.
+static bool send_start(gc_adapter_t* adapter) {
+    static const uint8_t gc_start = 0x13;
+
+    if (!tuh_hid_send_report(adapter->dev_addr, adapter->itf, 0, &gc_start, 1)) {
+        return false;
+    }
+    tuh_hid_receive_report(adapter->dev_addr, adapter->itf);
 #if ENABLE_SERIAL_LOGGING
-    if (result) {
-        printf("GC: Init 0x13 sent to instance %d OK\n", instance);
+    printf("GC: Start 0x13 queued (addr=%d, inst=%d)\n", adapter->dev_addr, adapter->itf);
+#endif
+
+    if (adapter->itf_pending) {
+        // Next interface of the same adapter
+        adapter->itf = (uint8_t)__builtin_ctz(adapter->itf_pending);
+        adapter->itf_pending &= (uint8_t)(adapter->itf_pending - 1);
+        mode_switch(adapter);
     } else {
-        printf("GC: WARNING - Init 0x13 to instance %d failed!\n", instance);
+        enter_state(adapter, GC_STATE_WAIT_REPORT, GC_FIRST_REPORT_TIMEOUT_MS);
     }
-#endif
+    return true;
 }
 
-void gc_mount_cb(uint8_t dev_addr) {
-    extern ssd1306_t disp;
-    
+static void mode_switch_done(tuh_xfer_t* xfer) {
+    gc_adapter_t* adapter = find_adapter_by_addr(xfer->daddr);
+    if (!adapter || adapter->state != GC_STATE_MODE_SWITCH || adapter->itf != xfer->user_data) {
+        return;  // Timed out or unplugged meanwhile
+    }
 #if ENABLE_SERIAL_LOGGING
-    printf("\n");
-    printf("═══════════════════════════════════════════════════════\n");
-    printf("  🎮 GAMECUBE CONTROLLER ADAPTER DETECTED!\n");
-    printf("  Device Address: %d\n", dev_addr);
-    printf("  \n");
-    printf("  Supports up to 4 GameCube controllers\n");
-    printf("  Will use first connected controller\n");
-    printf("  \n");
-    printf("  Make sure adapter is in PC MODE!\n");
-    printf("  \n");
-    printf("═══════════════════════════════════════════════════════\n");
-    printf("\n");
+    printf("GC: PC mode request result %d (inst=%d)\n", xfer->result, adapter->itf);
 #endif
-    
-#if ENABLE_CONTROLLER_DEBUG
-    // Show on OLED - match other controller style (debug mode only)
-    ssd1306_clear(&disp);
-    ssd1306_draw_string(&disp, 10, 10, 2, (char*)"GCube");
-    ssd1306_draw_string(&disp, 5, 35, 1, (char*)"USB Adapter");
-    ssd1306_show(&disp);
-    sleep_ms(2000);
-#endif
-    
-    gc_adapter_t* adapter = allocate_adapter(dev_addr);
+    adapter->state = GC_STATE_START;
+    send_start(adapter);
+}
+
+bool gc_attach(uint8_t dev_addr, uint8_t instance) {
+    gc_adapter_t* adapter = find_adapter_by_addr(dev_addr);
     if (adapter) {
-        usb_map_register_gamepad(dev_addr, "GameCube");
+        if (adapter->state == GC_STATE_STREAMING) {
+            adapter->itf = instance;
+            mode_switch(adapter);
+        } else if (instance != adapter->itf && instance < 8) {
+            // Brought up after the current interface
+            adapter->itf_pending |= (uint8_t)(1u << instance);
+        }
+        return true;
+    }
+
+    adapter = allocate_adapter(dev_addr);
+    if (!adapter) {
+        return false;
+    }
 #if ENABLE_SERIAL_LOGGING
-        printf("GC: Adapter registered!\n");
-        printf("GC: Sending initialization command to instance 0...\n");
+    printf("GC: Adapter at address %d, bringing up instance %d\n", dev_addr, instance);
 #endif
-        
-        // Send init to instance 0
-        gc_send_init(dev_addr, 0);
-        
+    usb_map_register_gamepad(dev_addr, "GameCube");
+    adapter->itf = instance;
+    mode_switch(adapter);
+    return true;
+}
+
+void gc_task(void) {
+    uint32_t now = now_ms();
+
+    for (uint8_t i = 0; i < adapter_count; i++) {
+        gc_adapter_t* adapter = &adapters[i];
+
+        switch (adapter->state) {
+            case GC_STATE_MODE_SWITCH:
+                if ((int32_t)(now - adapter->deadline_ms) >= 0) {
 #if ENABLE_SERIAL_LOGGING
-        printf("GC: Adapter address: %d\n", dev_addr);
-        printf("GC: Waiting for first report...\n");
+                    printf("GC: PC mode request timed out (inst=%d)\n", adapter->itf);
 #endif
-        
+                    adapter->state = GC_STATE_START;
+                    send_start(adapter);
+                }
+                break;
+
+            case GC_STATE_START:
+                send_start(adapter);
+                break;
+
+            case GC_STATE_WAIT_REPORT:
+                if ((int32_t)(now - adapter->deadline_ms) >= 0 && adapter->retries < GC_START_RETRIES) {
+                    // No report yet: the start command may have been lost
+                    adapter->retries++;
+                    tm_inc(TM_GC_START_RETRY);
+                    adapter->state = GC_STATE_START;
 #if ENABLE_CONTROLLER_DEBUG
-        // Show diagnostic info on OLED (debug mode only)
-        ssd1306_clear(&disp);
-        ssd1306_draw_string(&disp, 0, 0, 1, (char*)"GC Init Sent");
-        
-        char line[32];
-        snprintf(line, sizeof(line), "Addr:%d", dev_addr);
-        ssd1306_draw_string(&disp, 0, 12, 1, line);
-        
-        ssd1306_draw_string(&disp, 0, 24, 1, (char*)"PC mode?");
-        ssd1306_draw_string(&disp, 0, 36, 1, (char*)"Ctrl plugged?");
-        ssd1306_draw_string(&disp, 0, 48, 1, (char*)"Waiting...");
-        
-        ssd1306_show(&disp);
-        sleep_ms(5000);  // Wait 5 seconds to see this message
+                    mount_splash_show(MOUNT_SPLASH_DEFAULT_MS, "GC Init 0x13", "No report yet", "PC mode?");
 #endif
+                    send_start(adapter);
+                }
+                break;
+
+            default:
+                break;
+        }
     }
 }
 
@@ -4,6 +4,7 @@
  */
 
 #include "tusb.h"
+#include "pico/time.h"
 #include "hid_app_host.h"
 #include "version.h"  // Project version number
 // xinput.h removed - using official xinput_host.h driver now
@@ -17,6 +18,9 @@
 #include "stadia_controller.h"
 #include "mount_splash.h"
 #include "ssd1306.h"
+#include "telemetry.h"
+#include "hid_desc_cache.h"
+#include "hid_report_pool.h"
 #include <string.h>
 
 // Structure to track HID devices
@@ -26,35 +30,25 @@ typedef struct {
   HID_TYPE              hid_type;
   bool                  mounted;
   bool                  has_report_info;
-  HID_ReportInfo_t      report_info;
+  hid_layout_t*         report_info;  // From hid_report_pool, generic HID only
   uint16_t              report_size;
-  uint8_t               report_buffer[64];
-  void*                 report_dest;  // Where to copy report when it arrives
-  bool                  report_pending;
+  const uint8_t*        report;       // TinyUSB's IN buffer, lent to the app until it asks for the next one
+  bool                  report_pending;  // App is waiting for a report
+  uint32_t              report_us;    // time_us_32() when report arrived
 } hidh_device_t;
 
 // Size array for HID interfaces, not just devices (devices can have multiple interfaces)
 static hidh_device_t hid_devices[CFG_TUH_HID];
+
 static HID_TYPE filter_type = HID_UNDEFINED;
 
-// Debug counters (can be read externally)
-static uint32_t debug_mount_calls = 0;
-static uint32_t debug_report_calls = 0;
-static uint32_t debug_report_copied = 0;
-static uint32_t debug_unmount_calls = 0;
+// Last mounted interface (mount/report counts live in telemetry)
 static uint8_t debug_last_dev_addr = 0;
 static uint8_t debug_last_instance = 0;
-static uint8_t debug_active_devices = 0;
 
 // Track whether we've already notified the app layer for Stadia on first report
 static bool stadia_notified[CFG_TUSB_HOST_DEVICE_MAX] = {0};
 
-// Accessor functions for debug counters
-uint32_t hid_debug_get_mount_calls(void) { return debug_mount_calls; }
-uint32_t hid_debug_get_report_calls(void) { return debug_report_calls; }
-uint32_t hid_debug_get_report_copied(void) { return debug_report_copied; }
-uint32_t hid_debug_get_unmount_calls(void) { return debug_unmount_calls; }
-uint32_t hid_debug_get_active_devices(void) { return debug_active_devices; }
 uint32_t hid_debug_get_last_addr_inst(void) { return (debug_last_dev_addr << 8) | debug_last_instance; }
 
 // Forward declaration
@@ -99,11 +93,17 @@ static hidh_device_t* find_device_by_inst(uint8_t dev_addr, uint8_t instance) {
   return NULL;
 }
 
+// Return a slot's report layout to the pool and clear the slot
+static void release_device(hidh_device_t* dev) {
+  hid_report_pool_free(dev->report_info);
+  memset(dev, 0, sizeof(hidh_device_t));
+}
+
 // Allocate a new device slot
 static hidh_device_t* alloc_device(uint8_t dev_addr, uint8_t instance) {
   for (int i = 0; i < CFG_TUH_HID; i++) {
     if (!hid_devices[i].mounted) {
-      memset(&hid_devices[i], 0, sizeof(hidh_device_t));
+      release_device(&hid_devices[i]);
       hid_devices[i].dev_addr = dev_addr;
       hid_devices[i].instance = instance;
       hid_devices[i].mounted = true;
@@ -117,12 +117,16 @@ static hidh_device_t* alloc_device(uint8_t dev_addr, uint8_t instance) {
 static void free_device(uint8_t dev_addr) {
   for (int i = 0; i < CFG_TUH_HID; i++) {
     if (hid_devices[i].dev_addr == dev_addr) {
-      memset(&hid_devices[i], 0, sizeof(hidh_device_t));
+      release_device(&hid_devices[i]);
       return;
     }
   }
 }
 
+// Parser output. Only the items and collections a mounted interface uses are
+// kept, in hid_report_pool; this is reused for every descriptor.
+static HID_ReportInfo_t parse_scratch;
+
 // HID parser filter callback
 bool CALLBACK_HIDParser_FilterHIDReportItem(HID_ReportItem_t* const item)
 {
@@ -154,6 +158,9 @@ bool CALLBACK_HIDParser_FilterHIDReportItem(HID_ReportItem_t* const item)
     }
   }
   
+  if (filter_type == HID_MOUSE && item->Attributes.Usage.Page == USAGE_PAGE_DIGITIZER) {
+    return true;  // Tablet in-range / tip switch for absolute pointers
+  }
   if (filter_type == HID_JOYSTICK || filter_type == HID_MOUSE) {
     return ((item->Attributes.Usage.Page == USAGE_PAGE_BUTTON) ||
             (item->Attributes.Usage.Page == USAGE_PAGE_GENERIC_DCTRL));
@@ -161,6 +168,43 @@ bool CALLBACK_HIDParser_FilterHIDReportItem(HID_ReportItem_t* const item)
   return false;
 }
 
+// Parse a report descriptor, or reuse the layout from the last time this
+// device enumerated. Leaves filter_type as the parser would. A successful
+// parse leaves dev owning a copy of the layout from hid_report_pool;
+// pool_full is set when the pool had no room for it.
+static bool process_report_desc(uint16_t vid, uint16_t pid, uint8_t const* desc, uint16_t len,
+                                hidh_device_t* dev, bool* pool_full) {
+  *pool_full = false;
+
+  uint32_t hash = hid_desc_hash(desc, len);
+  const hid_layout_t* layout = NULL;
+  hid_layout_t parsed;
+  uint8_t result;
+  uint8_t type;
+  if (hid_desc_cache_lookup(vid, pid, hash, len, &layout, &result, &type)) {
+    filter_type = (HID_TYPE)type;
+  } else {
+    filter_type = HID_UNDEFINED;
+    result = USB_ProcessHIDReport(desc, len, &parse_scratch);
+    if (result == HID_PARSE_Successful) {
+      hid_layout_of(&parse_scratch, &parsed);
+      layout = &parsed;
+    }
+    hid_desc_cache_store(vid, pid, hash, len, layout, result, (uint8_t)filter_type);
+  }
+  if (result != HID_PARSE_Successful || !layout) {
+    return false;
+  }
+
+  dev->report_info = hid_report_pool_alloc(layout);
+  if (!dev->report_info) {
+    *pool_full = true;
+    filter_type = HID_UNDEFINED;
+    return false;
+  }
+  return true;
+}
+
 //--------------------------------------------------------------------+
 // Public API Implementation
 //--------------------------------------------------------------------+
@@ -178,29 +222,41 @@ HID_TYPE tuh_hid_get_type(uint8_t dev_addr) {
 bool tuh_hid_is_busy(uint8_t dev_addr) {
   hidh_device_t* dev = find_device(dev_addr);
   if (!dev) return false;
-  return dev->report_pending;
+  return !dev->report;   // Nothing lent to parse yet
 }
 
-bool hid_app_request_report(uint8_t dev_addr, void * p_report) {
+bool hid_app_request_report(uint8_t dev_addr) {
   hidh_device_t* dev = find_device(dev_addr);
   if (!dev) return false;
   
-  // In TinyUSB, reports are automatically received via callbacks
-  // Just store the destination buffer and mark as pending
-  dev->report_dest = p_report;
   dev->report_pending = true;
-  
+  if (dev->report) {
+    // Hand the IN buffer back to TinyUSB: the app is done parsing it
+    dev->report = NULL;
+    tuh_hid_receive_report(dev->dev_addr, dev->instance);
+  }
+  // Otherwise a transfer is already queued (from mount, or after an unclaimed report)
   return true;
 }
 
+const uint8_t* hid_app_get_report(uint8_t dev_addr) {
+  hidh_device_t* dev = find_device(dev_addr);
+  return dev ? dev->report : NULL;
+}
+
+uint32_t hid_app_get_report_time(uint8_t dev_addr) {
+  hidh_device_t* dev = find_device(dev_addr);
+  return dev ? dev->report_us : time_us_32();
+}
+
 uint16_t tuh_hid_get_report_size(uint8_t dev_addr) {
   hidh_device_t* dev = find_device(dev_addr);
   return dev ? dev->report_size : 0;
 }
 
-HID_ReportInfo_t* tuh_hid_get_report_info(uint8_t dev_addr) {
+hid_layout_t* tuh_hid_get_report_info(uint8_t dev_addr) {
   hidh_device_t* dev = find_device(dev_addr);
-  return dev ? &dev->report_info : NULL;
+  return dev ? dev->report_info : NULL;
 }
 
 //--------------------------------------------------------------------+
@@ -209,7 +265,7 @@ HID_ReportInfo_t* tuh_hid_get_report_info(uint8_t dev_addr) {
 
 // Invoked when device with HID interface is mounted
 void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report_desc, uint16_t desc_len) {
-  debug_mount_calls++;
+  tm_inc(TM_USB_HID_MOUNTS);
   debug_last_dev_addr = dev_addr;
   debug_last_instance = instance;
   
@@ -231,20 +287,11 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report_
   // Show on OLED for debugging - only in debug builds
   // Only show Nintendo VID devices to avoid spam from other devices
   if (vid == 0x057E) {  // Nintendo VID
-    extern ssd1306_t disp;
-    ssd1306_clear(&disp);
-    ssd1306_draw_string(&disp, 0, 0, 1, (char*)"GC VID Check");
-    char line[32];
-    snprintf(line, sizeof(line), "v%s", PROJECT_VERSION_STRING);
-    ssd1306_draw_string(&disp, 0, 10, 1, line);
-    snprintf(line, sizeof(line), "V:%04X P:%04X", vid, pid);
-    ssd1306_draw_string(&disp, 0, 24, 1, line);
-    snprintf(line, sizeof(line), "Match:%d Inst:%d", is_gamecube, instance);
-    ssd1306_draw_string(&disp, 0, 36, 1, line);
-    snprintf(line, sizeof(line), "Addr:%d Prot:%d", dev_addr, protocol);
-    ssd1306_draw_string(&disp, 0, 48, 1, line);
-    ssd1306_show(&disp);
-    sleep_ms(2000);  // Reduced to 2 seconds
+    char ids[32];
+    char match[24];
+    snprintf(ids, sizeof(ids), "V:%04X P:%04X", vid, pid);
+    snprintf(match, sizeof(match), "Match:%d Inst:%d", is_gamecube, instance);
+    mount_splash_show(MOUNT_SPLASH_DEFAULT_MS, "GC VID Check", ids, match);
   }
 #endif
   
@@ -257,20 +304,6 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report_
     // v11.1.3: HID Hijacking approach - let HID claim it, we handle the non-standard protocol
     // The adapter uses raw 37-byte reports with 0x21 signal byte
     
-    extern ssd1306_t disp;
-    char dbg[32];
-    
-#if ENABLE_CONTROLLER_DEBUG
-    // Show protocol info (debug mode only)
-    ssd1306_clear(&disp);
-    ssd1306_draw_string(&disp, 0, 0, 1, (char*)"GC HID Mount");
-    snprintf(dbg, sizeof(dbg), "Inst:%d Prot:%d", instance, protocol);
-    ssd1306_draw_string(&disp, 0, 12, 1, dbg);
-    ssd1306_draw_string(&disp, 0, 24, 1, (char*)"Initializing...");
-    ssd1306_show(&disp);
-    sleep_ms(1500);
-#endif
-    
     // Allocate device slot
     hidh_device_t* dev = alloc_device(dev_addr, instance);
     if (!dev) {
@@ -285,191 +318,20 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report_
     dev->report_size = 64;  // Buffer size (reports are 37 bytes)
     dev->has_report_info = false;  // We'll parse manually
     
-    // Only show splash and send init on instance 0
-    if (instance == 0) {
-#if ENABLE_CONTROLLER_DEBUG
-      // Show splash (debug mode only)
-      ssd1306_clear(&disp);
-      ssd1306_draw_string(&disp, 10, 10, 2, (char*)"GCube");
-      ssd1306_draw_string(&disp, 5, 35, 1, (char*)"USB Adapter");
-      ssd1306_show(&disp);
-      sleep_ms(2000);
-#endif
-      
-      // STEP 1: Control transfer for third-party adapter compatibility
-      // Windows driver shows this is required: bmRequestType=0x21, bRequest=11, wValue=1, wIndex=0
-#if ENABLE_SERIAL_LOGGING
-      printf("GC: Sending control transfer (request 11, value 1)...\n");
-#endif
-      tusb_control_request_t ctrl_req = {
-        .bmRequestType_bit = {
-          .recipient = TUSB_REQ_RCPT_INTERFACE,
-          .type = TUSB_REQ_TYPE_CLASS,
-          .direction = TUSB_DIR_OUT
-        },
-        .bRequest = 11,
-        .wValue = 1,
-        .wIndex = 0,
-        .wLength = 0
-      };
-      
-      uint8_t ctrl_result = XFER_RESULT_INVALID;
-      
-      tuh_xfer_t ctrl_xfer = {
-        .daddr = dev_addr,
-        .ep_addr = 0,
-        .setup = &ctrl_req,
-        .buffer = NULL,
-        .complete_cb = NULL,  // Synchronous - blocks until complete
-        .user_data = (uintptr_t)&ctrl_result
-      };
-      
-      bool ctrl_ok = tuh_control_xfer(&ctrl_xfer);
-#if ENABLE_SERIAL_LOGGING
-      printf("GC: Control transfer queued: %d\n", ctrl_ok);
-#endif
-      
-      // Small delay for control transfer to complete
-      sleep_ms(200);
-#if ENABLE_SERIAL_LOGGING
-      printf("GC: Control transfer result: %d\n", ctrl_result);
-#endif
-      
-#if ENABLE_CONTROLLER_DEBUG
-      ssd1306_clear(&disp);
-      ssd1306_draw_string(&disp, 0, 0, 1, (char*)"CTRL XFER");
-      snprintf(dbg, sizeof(dbg), "Req:11 Val:1");
-      ssd1306_draw_string(&disp, 0, 12, 1, dbg);
-      snprintf(dbg, sizeof(dbg), "Result:%d", ctrl_result);
-      ssd1306_draw_string(&disp, 0, 24, 1, dbg);
-      ssd1306_show(&disp);
-      sleep_ms(1500);
-#endif
-      
-      // STEP 2: Send 0x13 init command via interrupt OUT endpoint
-      // All reference drivers do this after control transfer
-#if ENABLE_SERIAL_LOGGING
-      printf("GC: Sending 0x13 init to interrupt OUT endpoint...\n");
-#endif
-      static const uint8_t gc_init = 0x13;
-      
-      // Use tuh_hid_send_report() to send to interrupt OUT endpoint 0x02
-      bool send_ok = tuh_hid_send_report(dev_addr, instance, 0, &gc_init, 1);
-      
-#if ENABLE_SERIAL_LOGGING
-      if (send_ok) {
-        printf("GC: Init 0x13 queued to endpoint 0x02\n");
-      } else {
-        printf("GC: WARNING - Init 0x13 queue failed!\n");
-      }
-#endif
-      
-#if ENABLE_CONTROLLER_DEBUG
-      // Show status (debug mode only)
-      ssd1306_clear(&disp);
-      ssd1306_draw_string(&disp, 0, 0, 1, (char*)"GC Init 0x13");
-      snprintf(dbg, sizeof(dbg), "Addr:%d Inst:%d", dev_addr, instance);
-      ssd1306_draw_string(&disp, 0, 12, 1, dbg);
-      ssd1306_draw_string(&disp, 0, 24, 1, (char*)"PC mode?");
-      ssd1306_draw_string(&disp, 0, 36, 1, (char*)"Ctrl plugged?");
-      ssd1306_draw_string(&disp, 0, 48, 1, (char*)"Waiting...");
-      ssd1306_show(&disp);
-      sleep_ms(3000);
-#endif
-      
-      // Notify application layer
-      extern void gc_notify_mount(uint8_t dev_addr);
-      gc_notify_mount(dev_addr);
-      
-      // Call mounted callback
-      tuh_hid_mounted_cb(dev_addr);
-    } else {
-#if ENABLE_SERIAL_LOGGING
-      printf("GC: Additional interface %d registered\n", instance);
-      
-      // Send init to additional instances too (might be needed for PC mode)
-      printf("GC: Sending control transfer to instance %d...\n", instance);
-#endif
-      tusb_control_request_t ctrl_req = {
-        .bmRequestType_bit = {
-          .recipient = TUSB_REQ_RCPT_INTERFACE,
-          .type = TUSB_REQ_TYPE_CLASS,
-          .direction = TUSB_DIR_OUT
-        },
-        .bRequest = 11,
-        .wValue = 1,
-        .wIndex = instance,  // Use instance number for wIndex
-        .wLength = 0
-      };
-      
-      uint8_t ctrl_result = XFER_RESULT_INVALID;
-      tuh_xfer_t ctrl_xfer = {
-        .daddr = dev_addr,
-        .ep_addr = 0,
-        .setup = &ctrl_req,
-        .buffer = NULL,
-        .complete_cb = NULL,
-        .user_data = (uintptr_t)&ctrl_result
-      };
-      
-      tuh_control_xfer(&ctrl_xfer);
-      sleep_ms(50);
-      
-      // Send 0x13 to this instance too
-      static const uint8_t gc_init = 0x13;
-      tuh_hid_send_report(dev_addr, instance, 0, &gc_init, 1);
-      
-      // Also notify for additional instances (causes joystick counter++)
-      extern void gc_notify_mount(uint8_t dev_addr);
-      gc_notify_mount(dev_addr);
-    }
-    
-    // Start receiving reports
-#if ENABLE_SERIAL_LOGGING
-    printf("GC: Calling tuh_hid_receive_report(addr=%d, inst=%d)...\n", dev_addr, instance);
-#endif
+    // PC-mode request, 0x13 start and the first IN transfer run from
+    // transfer completions and gc_task(); nothing here waits on the device
+    gc_attach(dev_addr, instance);
     
-#if ENABLE_CONTROLLER_DEBUG
-    // Show we're starting report reception (debug mode only)
-    ssd1306_clear(&disp);
-    ssd1306_draw_string(&disp, 0, 0, 2, (char*)"RCV START");
-    snprintf(dbg, sizeof(dbg), "A:%d I:%d", dev_addr, instance);
-    ssd1306_draw_string(&disp, 0, 20, 1, dbg);
-    ssd1306_draw_string(&disp, 0, 32, 1, (char*)"Queueing...");
-    ssd1306_show(&disp);
-    sleep_ms(1000);
-#endif
+    // Notify application layer (each instance counts as a joystick)
+    extern void gc_notify_mount(uint8_t dev_addr);
+    gc_notify_mount(dev_addr);
     
-    bool recv_ok = tuh_hid_receive_report(dev_addr, instance);
-#if ENABLE_SERIAL_LOGGING
-    printf("GC: tuh_hid_receive_report result: %d\n", recv_ok);
-#endif
-    
-#if ENABLE_CONTROLLER_DEBUG
-    // Show status (debug mode only)
-    ssd1306_clear(&disp);
-    if (recv_ok) {
-      ssd1306_draw_string(&disp, 0, 0, 2, (char*)"RCV OK!");
-      ssd1306_draw_string(&disp, 0, 20, 1, (char*)"Queued");
-      ssd1306_draw_string(&disp, 0, 32, 1, (char*)"Waiting for");
-      ssd1306_draw_string(&disp, 0, 44, 1, (char*)"controller...");
-    } else {
-      ssd1306_draw_string(&disp, 0, 0, 2, (char*)"RCV FAIL!");
-      snprintf(dbg, sizeof(dbg), "A:%d I:%d", dev_addr, instance);
-      ssd1306_draw_string(&disp, 0, 20, 1, dbg);
-      ssd1306_draw_string(&disp, 0, 32, 1, (char*)"Can't start");
-      ssd1306_draw_string(&disp, 0, 44, 1, (char*)"reports!");
-    }
-    ssd1306_show(&disp);
-    sleep_ms(recv_ok ? 2000 : 5000);
-#else
-  #if ENABLE_OLED_DISPLAY
     if (instance == 0) {
+      tuh_hid_mounted_cb(dev_addr);
+#if ENABLE_OLED_DISPLAY
       mount_splash_show(MOUNT_SPLASH_DEFAULT_MS, "GAMECUBE!", "USB Adapter", NULL);
-    }
-  #endif
 #endif
-    
+    }
     return;
   }
   
@@ -642,10 +504,11 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report_
   if (!dev) return;
   
   // Count active devices
-  debug_active_devices = 0;
+  uint32_t active = 0;
   for (int i = 0; i < CFG_TUH_HID; i++) {
-    if (hid_devices[i].mounted) debug_active_devices++;
+    if (hid_devices[i].mounted) active++;
   }
+  tm_set(TM_USB_HID_ACTIVE, active);
   
   // Check if it's a keyboard (boot protocol)
   if (protocol == HID_ITF_PROTOCOL_KEYBOARD) {
@@ -674,17 +537,26 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report_
   // Check if it's a mouse (boot protocol) - but mice need report parsing
   else if (protocol == HID_ITF_PROTOCOL_MOUSE) {
     // Even boot protocol mice need the report parser for proper handling
+    bool pool_full = false;
     if (report_desc && desc_len > 0 && desc_len < 512) {
-      filter_type = HID_UNDEFINED;
-      if (USB_ProcessHIDReport(report_desc, desc_len, &dev->report_info) == HID_PARSE_Successful) {
+      if (process_report_desc(vid, pid, report_desc, desc_len, dev, &pool_full)) {
         dev->has_report_info = true;
         dev->hid_type = HID_MOUSE;  // Force to MOUSE since we know the protocol
         dev->report_size = 64;
       }
     }
     
-    // Fallback if parsing fails
+    // Fallback if parsing fails, or no layout was free: read the boot
+    // layout (hid_mouse_report_t), switching the interface to boot
+    // protocol if enumeration left it in report protocol
     if (dev->hid_type == HID_UNDEFINED) {
+      if (pool_full) {
+        printf("HID: no free report layout for mouse %d/%d, using boot protocol\n",
+               dev_addr, instance);
+      }
+      if (tuh_hid_get_protocol(dev_addr, instance) != HID_PROTOCOL_BOOT) {
+        tuh_hid_set_protocol(dev_addr, instance, HID_PROTOCOL_BOOT);
+      }
       dev->hid_type = HID_MOUSE;
       dev->report_size = sizeof(hid_mouse_report_t);
     }
@@ -699,8 +571,18 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report_
   }
   // For other devices (joysticks, non-boot mice), try to parse descriptor
   else if (report_desc && desc_len > 0 && desc_len < 512) {
-    filter_type = HID_UNDEFINED;
-    bool parse_success = (USB_ProcessHIDReport(report_desc, desc_len, &dev->report_info) == HID_PARSE_Successful);
+    bool pool_full = false;
+    bool parse_success = process_report_desc(vid, pid, report_desc, desc_len, dev, &pool_full);
+    
+    // Without a layout there is no way to read a non-boot interface
+    if (pool_full && !is_stadia) {
+      printf("HID: ERROR - no room for report layout (%d of %d items taken), "
+             "interface %d/%d not mounted\n", hid_report_pool_items_used(), HID_LAYOUT_ITEMS,
+             dev_addr, instance);
+      release_device(dev);
+      tm_set(TM_USB_HID_ACTIVE, active - 1);
+      return;
+    }
     
     if (parse_success) {
       dev->has_report_info = true;
@@ -796,7 +678,7 @@ void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report_
 
 // Invoked when device with HID interface is unmounted
 void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance) {
-  debug_unmount_calls++;
+  tm_inc(TM_USB_HID_UNMOUNTS);
   
   hidh_device_t* dev = find_device_by_inst(dev_addr, instance);
   if (!dev) return;
@@ -821,8 +703,8 @@ void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance) {
     horipad_unmount_cb(dev_addr);
   }
   
-  // Clear report destination to prevent callbacks to freed memory
-  dev->report_dest = NULL;
+  // TinyUSB frees the interface and its IN buffer
+  dev->report = NULL;
   dev->report_pending = false;
   
   // Only call app unmount callback once per device (for first instance)
@@ -845,13 +727,26 @@ void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t instance) {
   xinput_notify_ui_unmount();
   
   // Clear this device slot
-  memset(dev, 0, sizeof(hidh_device_t));
+  release_device(dev);
+}
+
+// Invoked when a report sent with tuh_hid_send_report() has gone out
+void tuh_hid_report_sent_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report, uint16_t len) {
+  (void)instance;
+  (void)report;
+  (void)len;
+
+  uint16_t vid, pid;
+  tuh_vid_pid_get(dev_addr, &vid, &pid);
+  if (switch_is_controller(vid, pid)) {
+    switch_report_sent(dev_addr);
+  }
 }
 
 // Invoked when received report from device via interrupt endpoint
 // In TinyUSB 0.12+, this is called when reports arrive
 void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report, uint16_t len) {
-  debug_report_calls++;
+  tm_inc(TM_USB_HID_REPORTS);
   
   uint16_t vid, pid;
   tuh_vid_pid_get(dev_addr, &vid, &pid);
@@ -1011,26 +906,21 @@ void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t cons
   // Xbox controllers now handled by official xinput_host driver
   // Reports go directly to tuh_xinput_report_received_cb()
   
-  // Always store the latest report in our buffer
-  uint16_t copy_len = (len < 64) ? len : 64;
-  memcpy(dev->report_buffer, report, copy_len);
-  
-  // If application has provided a destination buffer, copy the report there
-  if (dev->report_dest && dev->report_pending) {
-    debug_report_copied++;
-    
-    memcpy(dev->report_dest, report, copy_len);
+  // Lend the report to the app in place. report points at TinyUSB's IN
+  // buffer for this interface, which stays untouched until the next
+  // transfer is queued, so that only happens in hid_app_request_report()
+  // once the app has parsed it. The device NAKs in between and keeps
+  // accumulating (mouse motion is not lost).
+  if (dev->report_pending) {
+    tm_inc(TM_USB_HID_LENT);
+    dev->report = report;
+    dev->report_us = time_us_32();
     dev->report_pending = false;
-    
-    // Call the application's ISR callback
-    extern void tuh_hid_isr(uint8_t dev_addr, xfer_result_t event);
-    tuh_hid_isr(dev_addr, XFER_RESULT_SUCCESS);
-    
-    // Clear the dest pointer after processing
-    dev->report_dest = NULL;
+    return;
   }
   
-  // Queue next report - CRITICAL for continuous operation in TinyUSB 0.12+
+  // Nobody asked for it: drop it and queue the next one - CRITICAL for
+  // continuous operation in TinyUSB 0.12+
   tuh_hid_receive_report(dev_addr, instance);
 }
 
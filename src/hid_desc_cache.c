@@ -0,0 +1,137 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "hid_desc_cache.h"
+#include "telemetry.h"
+#include <string.h>
+
+typedef struct {
+    bool          used;
+    uint8_t       result;
+    uint8_t       type;
+    uint16_t      vid;
+    uint16_t      pid;
+    uint16_t      len;
+    uint32_t      hash;
+    uint32_t      stamp;     // Last use, for eviction
+    hid_layout_t* layout;    // NULL for a failed parse
+} desc_entry_t;
+
+#if HID_DESC_CACHE_ENTRIES > 0
+static desc_entry_t entries[HID_DESC_CACHE_ENTRIES];
+static uint32_t use_stamp;
+
+static hid_layout_t cache_layouts[HID_DESC_CACHE_ENTRIES];
+static HID_ReportItem_t cache_items[HID_DESC_CACHE_ITEMS];
+static HID_CollectionPath_t cache_collections[HID_DESC_CACHE_COLLECTIONS];
+static hid_layout_store_t store = {
+    cache_layouts, cache_items, cache_collections,
+    HID_DESC_CACHE_ENTRIES, HID_DESC_CACHE_ITEMS, HID_DESC_CACHE_COLLECTIONS, 0, 0,
+};
+
+static void evict(desc_entry_t* e) {
+    hid_layout_store_remove(&store, e->layout);
+    e->layout = NULL;
+    e->used = false;
+}
+
+// Least recently used entry, of those holding a layout if with_layout
+static desc_entry_t* oldest(bool with_layout) {
+    desc_entry_t* victim = NULL;
+    for (int i = 0; i < HID_DESC_CACHE_ENTRIES; ++i) {
+        desc_entry_t* e = &entries[i];
+        if (e->used && (e->layout || !with_layout) && (!victim || e->stamp < victim->stamp)) {
+            victim = e;
+        }
+    }
+    return victim;
+}
+
+// A free entry, or else the least recently used one, emptied
+static desc_entry_t* take_entry(void) {
+    for (int i = 0; i < HID_DESC_CACHE_ENTRIES; ++i) {
+        if (!entries[i].used) {
+            return &entries[i];
+        }
+    }
+    desc_entry_t* e = oldest(false);
+    evict(e);
+    return e;
+}
+#endif
+
+uint32_t hid_desc_hash(const uint8_t* desc, uint16_t len) {
+    uint32_t h = 2166136261u;
+    for (uint16_t i = 0; i < len; ++i) {
+        h ^= desc[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool hid_desc_cache_lookup(uint16_t vid, uint16_t pid, uint32_t hash, uint16_t len,
+                           const hid_layout_t** layout, uint8_t* result, uint8_t* type) {
+#if HID_DESC_CACHE_ENTRIES > 0
+    for (int i = 0; i < HID_DESC_CACHE_ENTRIES; ++i) {
+        desc_entry_t* e = &entries[i];
+        if (e->used && e->hash == hash && e->len == len && e->vid == vid && e->pid == pid) {
+            *layout = e->layout;
+            *result = e->result;
+            *type = e->type;
+            e->stamp = ++use_stamp;
+            tm_inc(TM_USB_DESC_HIT);
+            return true;
+        }
+    }
+#endif
+    tm_inc(TM_USB_DESC_MISS);
+    return false;
+}
+
+void hid_desc_cache_store(uint16_t vid, uint16_t pid, uint32_t hash, uint16_t len,
+                          const hid_layout_t* layout, uint8_t result, uint8_t type) {
+#if HID_DESC_CACHE_ENTRIES > 0
+    if (layout && (layout->TotalReportItems > HID_DESC_CACHE_ITEMS ||
+                   layout->TotalCollections > HID_DESC_CACHE_COLLECTIONS)) {
+        return;     // Would not fit in the whole cache
+    }
+    desc_entry_t* e = take_entry();
+    hid_layout_t* copy = NULL;
+    if (layout) {
+        // Make room from the least recently used end
+        while ((copy = hid_layout_store_add(&store, layout)) == NULL) {
+            desc_entry_t* victim = oldest(true);
+            if (!victim) {
+                return;
+            }
+            evict(victim);
+        }
+    }
+    e->used = true;
+    e->result = result;
+    e->type = type;
+    e->vid = vid;
+    e->pid = pid;
+    e->len = len;
+    e->hash = hash;
+    e->stamp = ++use_stamp;
+    e->layout = copy;
+#else
+    (void)vid; (void)pid; (void)hash; (void)len; (void)layout; (void)result; (void)type;
+#endif
+}
@@ -0,0 +1,158 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "hid_report_pool.h"
+#include "telemetry.h"
+#include <stddef.h>
+
+static hid_layout_t pool_layouts[HID_REPORT_INFO_POOL];
+static HID_ReportItem_t pool_items[HID_LAYOUT_ITEMS];
+static HID_CollectionPath_t pool_collections[HID_LAYOUT_COLLECTIONS];
+static hid_layout_store_t pool = {
+    pool_layouts, pool_items, pool_collections,
+    HID_REPORT_INFO_POOL, HID_LAYOUT_ITEMS, HID_LAYOUT_COLLECTIONS, 0, 0,
+};
+
+void hid_layout_of(HID_ReportInfo_t* info, hid_layout_t* layout) {
+    // Children come after their parent in CollectionPaths, but walk the
+    // parents anyway rather than rely on it
+    int collections = 0;
+    for (int i = 0; i < info->TotalReportItems; ++i) {
+        for (const HID_CollectionPath_t* p = info->ReportItems[i].CollectionPath; p; p = p->Parent) {
+            int n = (int)(p - info->CollectionPaths) + 1;
+            if (n > collections) {
+                collections = n;
+            }
+        }
+    }
+    layout->TotalReportItems = info->TotalReportItems;
+    layout->TotalCollections = (uint8_t)collections;
+    layout->ReportItems = info->ReportItems;
+    layout->CollectionPaths = info->CollectionPaths;
+}
+
+// Copy src's items and collections to items/colls and point dst at them.
+// Items and collections link to collections by pointer, so those move with
+// them. The destination may overlap the source if it is lower down: each
+// entry is read before anything at or above it is written.
+static void place(hid_layout_t* dst, const hid_layout_t* src,
+                  HID_ReportItem_t* items, HID_CollectionPath_t* colls) {
+    const HID_ReportItem_t* src_items = src->ReportItems;
+    const HID_CollectionPath_t* src_colls = src->CollectionPaths;
+    uint8_t n_items = src->TotalReportItems;
+    uint8_t n_colls = src->TotalCollections;
+
+    for (int i = 0; i < n_colls; ++i) {
+        HID_CollectionPath_t c = src_colls[i];
+        if (c.Parent) {
+            c.Parent = colls + (c.Parent - src_colls);
+        }
+        colls[i] = c;
+    }
+    for (int i = 0; i < n_items; ++i) {
+        HID_ReportItem_t item = src_items[i];
+        if (item.CollectionPath) {
+            item.CollectionPath = colls + (item.CollectionPath - src_colls);
+        }
+        items[i] = item;
+    }
+    dst->TotalReportItems = n_items;
+    dst->TotalCollections = n_colls;
+    dst->ReportItems = items;
+    dst->CollectionPaths = colls;
+}
+
+hid_layout_t* hid_layout_store_add(hid_layout_store_t* store, const hid_layout_t* src) {
+    if (src->TotalReportItems == 0 ||
+        src->TotalReportItems > store->max_items - store->items_used ||
+        src->TotalCollections > store->max_collections - store->collections_used) {
+        return NULL;
+    }
+    for (int i = 0; i < store->max_layouts; ++i) {
+        hid_layout_t* layout = &store->layouts[i];
+        if (!layout->ReportItems) {
+            place(layout, src, store->items + store->items_used,
+                  store->collections + store->collections_used);
+            store->items_used += src->TotalReportItems;
+            store->collections_used += src->TotalCollections;
+            return layout;
+        }
+    }
+    return NULL;
+}
+
+// The stored layout whose items start lowest at or above from
+static hid_layout_t* next_stored(hid_layout_store_t* store, const HID_ReportItem_t* from) {
+    hid_layout_t* next = NULL;
+    for (int i = 0; i < store->max_layouts; ++i) {
+        hid_layout_t* layout = &store->layouts[i];
+        if (layout->ReportItems && layout->ReportItems >= from &&
+            (!next || layout->ReportItems < next->ReportItems)) {
+            next = layout;
+        }
+    }
+    return next;
+}
+
+void hid_layout_store_remove(hid_layout_store_t* store, hid_layout_t* layout) {
+    if (!layout || layout < store->layouts || layout >= store->layouts + store->max_layouts ||
+        !layout->ReportItems) {
+        return;
+    }
+    // Layouts sit in the order they were added, in both arrays. Slide every
+    // one above the gap down into it, lowest first.
+    HID_ReportItem_t* items = layout->ReportItems;
+    HID_CollectionPath_t* colls = layout->CollectionPaths;
+    layout->ReportItems = NULL;
+    layout->CollectionPaths = NULL;
+    layout->TotalReportItems = 0;
+    layout->TotalCollections = 0;
+
+    hid_layout_t* next;
+    while ((next = next_stored(store, items)) != NULL) {
+        place(next, next, items, colls);
+        items += next->TotalReportItems;
+        colls += next->TotalCollections;
+    }
+    store->items_used = (uint8_t)(items - store->items);
+    store->collections_used = (uint8_t)(colls - store->collections);
+}
+
+hid_layout_t* hid_report_pool_alloc(const hid_layout_t* src) {
+    hid_layout_t* layout = hid_layout_store_add(&pool, src);
+    if (!layout) {
+        tm_inc(TM_USB_RI_FULL);
+    }
+    return layout;
+}
+
+void hid_report_pool_free(hid_layout_t* layout) {
+    hid_layout_store_remove(&pool, layout);
+}
+
+int hid_report_pool_used(void) {
+    int n = 0;
+    for (int i = 0; i < HID_REPORT_INFO_POOL; i++) {
+        n += pool_layouts[i].ReportItems ? 1 : 0;
+    }
+    return n;
+}
+
+int hid_report_pool_items_used(void) {
+    return pool.items_used;
+}
@@ -11,6 +11,7 @@
 #include "horipad_controller.h"
 #include "mount_splash.h"
 #include "usb_device_map.h"
+#include "pad_keymap.h"
 #include "config.h"
 #include "tusb.h"
 #include "ssd1306.h"
@@ -58,7 +59,8 @@ bool horipad_is_controller(uint16_t vid, uint16_t pid) {
     return (vid == HORIPAD_VENDOR_ID && pid == HORIPAD_PID);
 }
 
-// Report layout: 3 bytes buttons+dpad, 4 bytes axes (x,y,z,rz)
+// Report layout: 3 bytes buttons+dpad, 4 bytes axes (x,y,z,rz).
+// Button bytes follow the Switch layout: Y B A X L R ZL ZR, then - + LS RS Home.
 void horipad_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t len) {
     if (!report || len < 7) return;
     if (len >= 8 && (report[0] == 0x00 || report[0] == 0x01)) {
@@ -73,7 +75,7 @@ void horipad_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t le
         if (!ctrl) return;
     }
 
-    uint8_t b0 = report[0], b2 = report[2];
+    uint8_t b0 = report[0], b1 = report[1], b2 = report[2];
     ctrl->y  = (b0 >> 0) & 1;
     ctrl->b  = (b0 >> 1) & 1;
     ctrl->a  = (b0 >> 2) & 1;
@@ -82,6 +84,11 @@ void horipad_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t le
     ctrl->r1 = (b0 >> 5) & 1;
     ctrl->l2 = (b0 >> 6) & 1;
     ctrl->r2 = (b0 >> 7) & 1;
+    ctrl->minus = (b1 >> 0) & 1;
+    ctrl->plus  = (b1 >> 1) & 1;
+    ctrl->l3    = (b1 >> 2) & 1;
+    ctrl->r3    = (b1 >> 3) & 1;
+    ctrl->home  = (b1 >> 4) & 1;
     ctrl->dpad = b2 & 0x0F;
     ctrl->axis_x  = report[3];
     ctrl->axis_y  = report[4];
@@ -148,6 +155,34 @@ uint8_t horipad_connected_count(void) {
     return n;
 }
 
+bool horipad_right_stick(int8_t* x, int8_t* y) {
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            *x = (int8_t)(controllers[i].axis_z - 128);
+            *y = (int8_t)(controllers[i].axis_rz - 128);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool horipad_pad_buttons(uint32_t* buttons) {
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            const horipad_controller_t* c = &controllers[i];
+            *buttons = (c->b ? PAD_BTN_SOUTH : 0) | (c->a ? PAD_BTN_EAST : 0) |
+                       (c->y ? PAD_BTN_WEST : 0) | (c->x ? PAD_BTN_NORTH : 0) |
+                       (c->l1 ? PAD_BTN_L1 : 0) | (c->r1 ? PAD_BTN_R1 : 0) |
+                       (c->l2 ? PAD_BTN_L2 : 0) | (c->r2 ? PAD_BTN_R2 : 0) |
+                       (c->minus ? PAD_BTN_SELECT : 0) | (c->plus ? PAD_BTN_START : 0) |
+                       (c->l3 ? PAD_BTN_L3 : 0) | (c->r3 ? PAD_BTN_R3 : 0) |
+                       (c->home ? PAD_BTN_HOME : 0);
+            return true;
+        }
+    }
+    return false;
+}
+
 bool horipad_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                             uint8_t* joy0_axis, uint8_t* joy0_fire) {
     for (uint8_t i = 0; i < controller_count; i++) {
@@ -0,0 +1,159 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "input_queue.h"
+#include "telemetry.h"
+#include "pico/stdlib.h"
+#include "pico/platform.h"
+#include "core_channel.h"
+
+#define IQ_CYCLES_PER_US    1       // 6301 runs at 1 MHz
+
+static iq_event_t ring[IQ_SIZE];
+static cc_spsc_t chan;              // Core 0 produces, Core 1 consumes
+
+// Core 0: what has been queued so far
+static uint32_t pub_keys[4];
+static uint8_t pub_mouse;
+static uint8_t pub_joy;
+
+// Core 1: what the 6301 sees
+static uint8_t cur_keys[16];
+static uint8_t cur_mouse;
+static uint8_t cur_joy;
+
+int64_t iq_due = IQ_NEVER;
+static bool     anchored;
+static uint32_t anchor_t_us;
+static int64_t  anchor_cycles;
+static int64_t  last_applied = INT64_MIN / 2;
+
+static bool push(uint8_t kind, uint8_t index, uint8_t value, uint32_t t_us) {
+    if (cc_spsc_space(&chan, IQ_SIZE) == 0) {
+        tm_inc(TM_IQ_OVERFLOW);
+        return false;
+    }
+    iq_event_t* e = &ring[cc_spsc_head(&chan) & (IQ_SIZE - 1)];
+    e->t_us = t_us;
+    e->kind = kind;
+    e->index = index;
+    e->value = value;
+    cc_spsc_push(&chan);
+    tm_inc(TM_IQ_EVENTS);
+    return true;
+}
+
+void iq_set_keys(const uint32_t keys[4], uint32_t t_us) {
+    for (int w = 0; w < 4; ++w) {
+        uint32_t changed = keys[w] ^ pub_keys[w];
+        while (changed) {
+            int b = __builtin_ctz(changed);
+            uint32_t bit = 1u << b;
+            changed &= changed - 1;
+            if (!push(IQ_KEY, (uint8_t)(w * 32 + b), (keys[w] & bit) ? 1 : 0, t_us)) {
+                return;     // Full: the rest go out on a later publish
+            }
+            pub_keys[w] ^= bit;
+        }
+    }
+}
+
+void iq_set_mouse_buttons(uint8_t buttons, uint32_t t_us) {
+    if (buttons != pub_mouse && push(IQ_MOUSE_BUTTONS, 0, buttons, t_us)) {
+        pub_mouse = buttons;
+    }
+}
+
+void iq_set_joystick(uint8_t joystick, uint32_t t_us) {
+    if (joystick != pub_joy && push(IQ_JOYSTICK, 0, joystick, t_us)) {
+        pub_joy = joystick;
+    }
+}
+
+void __not_in_flash_func(iq_reset)(void) {
+    anchored = false;
+    last_applied = INT64_MIN / 2;
+    iq_due = IQ_NEVER;
+}
+
+// Emulated time at which the event at the tail is due
+static int64_t __not_in_flash_func(schedule)(const iq_event_t* e, int64_t ncycles) {
+    if (!anchored || (int32_t)(time_us_32() - e->t_us) > IQ_MAX_AGE_US) {
+        if (anchored) {
+            tm_inc(TM_IQ_REANCHOR);
+        }
+        anchored = true;
+        anchor_t_us = e->t_us;
+        anchor_cycles = ncycles + IQ_LATENCY_CYCLES;
+    }
+    int64_t due = anchor_cycles + (int64_t)(int32_t)(e->t_us - anchor_t_us) * IQ_CYCLES_PER_US;
+    if (due < last_applied + IQ_MIN_GAP_CYCLES) {
+        due = last_applied + IQ_MIN_GAP_CYCLES;
+    }
+    return due;
+}
+
+void __not_in_flash_func(iq_poll)(int64_t ncycles) {
+    if (iq_due == IQ_NEVER && cc_spsc_count(&chan) > 0) {
+        iq_due = schedule(&ring[cc_spsc_tail(&chan) & (IQ_SIZE - 1)], ncycles);
+    }
+}
+
+void __not_in_flash_func(iq_service)(int64_t ncycles) {
+    while (iq_due <= ncycles) {
+        const iq_event_t* e = &ring[cc_spsc_tail(&chan) & (IQ_SIZE - 1)];
+
+        switch (e->kind) {
+        case IQ_KEY:
+            if (e->value) {
+                cur_keys[(e->index >> 3) & 15] |= (uint8_t)(1u << (e->index & 7));
+            } else {
+                cur_keys[(e->index >> 3) & 15] &= (uint8_t)~(1u << (e->index & 7));
+            }
+            break;
+        case IQ_MOUSE_BUTTONS:
+            cur_mouse = e->value;
+            break;
+        case IQ_JOYSTICK:
+            cur_joy = e->value;
+            break;
+        }
+        last_applied = ncycles;
+        tm_inc(TM_IQ_APPLIED);
+
+        cc_spsc_pop(&chan);
+        if (cc_spsc_count(&chan) == 0) {
+            anchored = false;   // Next burst starts a new mapping
+            iq_due = IQ_NEVER;
+        } else {
+            iq_due = schedule(&ring[cc_spsc_tail(&chan) & (IQ_SIZE - 1)], ncycles);
+        }
+    }
+}
+
+bool __not_in_flash_func(iq_keydown)(uint8_t code) {
+    return (cur_keys[(code >> 3) & 15] >> (code & 7)) & 1;
+}
+
+uint8_t __not_in_flash_func(iq_mouse_buttons)(void) {
+    return cur_mouse;
+}
+
+uint8_t __not_in_flash_func(iq_joystick)(void) {
+    return cur_joy;
+}
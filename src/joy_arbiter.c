@@ -0,0 +1,127 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "joy_arbiter.h"
+#include "config.h"
+#include "telemetry.h"
+
+#define FIRE_BIT    0x80    // Packed next to the direction nibble in state[]
+
+typedef struct {
+    uint16_t present;                   // Bit per source with a device on the port
+    uint8_t  state[JOY_SRC_COUNT];      // Direction nibble | FIRE_BIT
+    uint32_t stamp[JOY_SRC_COUNT];      // change_count when the state last changed
+    uint8_t  policy;
+    bool     stale;                     // A source changed since the last resolve
+    uint8_t  out;                       // Resolved state
+} joy_port_t;
+
+static joy_port_t ports[JOY_ARB_PORTS] = {
+    { .policy = JOY_ARB_DEFAULT_POLICY },
+    { .policy = JOY_ARB_DEFAULT_POLICY },
+};
+static uint32_t change_count;
+
+static const char* const policy_names[JOY_ARB_POLICY_COUNT] = {
+    "priority", "recent", "merge",
+};
+
+void joy_arb_set_policy(int port, int policy) {
+    if (port >= 0 && port < JOY_ARB_PORTS && policy >= 0 && policy < JOY_ARB_POLICY_COUNT) {
+        ports[port].policy = (uint8_t)policy;
+        ports[port].stale = true;
+    }
+}
+
+int joy_arb_get_policy(int port) {
+    return (port >= 0 && port < JOY_ARB_PORTS) ? ports[port].policy : JOY_ARB_PRIORITY;
+}
+
+const char* joy_arb_policy_name(int policy) {
+    return (policy >= 0 && policy < JOY_ARB_POLICY_COUNT) ? policy_names[policy] : "?";
+}
+
+void joy_arb_publish(int port, joy_src_t src, uint8_t axis, uint8_t fire) {
+    joy_port_t* p = &ports[port];
+    uint16_t bit = (uint16_t)(1u << src);
+    uint8_t value = (uint8_t)((axis & 0x0F) | (fire ? FIRE_BIT : 0));
+    if ((p->present & bit) && p->state[src] == value) {
+        return;
+    }
+    p->present |= bit;
+    p->state[src] = value;
+    p->stamp[src] = ++change_count;
+    p->stale = true;
+}
+
+void joy_arb_withdraw(int port, joy_src_t src) {
+    joy_port_t* p = &ports[port];
+    uint16_t bit = (uint16_t)(1u << src);
+    if (p->present & bit) {
+        p->present &= (uint16_t)~bit;
+        p->stale = true;
+    }
+}
+
+void joy_arb_clear(int port) {
+    joy_port_t* p = &ports[port];
+    if (p->present) {
+        p->present = 0;
+        p->stale = true;
+    }
+}
+
+static uint8_t resolve(const joy_port_t* p) {
+    uint8_t out = 0;
+    uint32_t newest = 0;
+    for (int s = 0; s < JOY_SRC_COUNT; ++s) {
+        if (!(p->present & (1u << s))) {
+            continue;
+        }
+        uint8_t v = p->state[s];
+        switch (p->policy) {
+        case JOY_ARB_MERGE:
+            out |= v;
+            break;
+        case JOY_ARB_RECENT:
+            if (v && p->stamp[s] > newest) {
+                newest = p->stamp[s];
+                out = v;
+            }
+            break;
+        default:
+            if (v) {
+                return v;
+            }
+            break;
+        }
+    }
+    return out;
+}
+
+bool joy_arb_resolve(int port, uint8_t* axis, uint8_t* fire) {
+    joy_port_t* p = &ports[port];
+    if (p->stale) {
+        p->stale = false;
+        p->out = resolve(p);
+        tm_inc(TM_JOY_ARB_RESOLVE);
+    }
+    *axis = p->out & 0x0F;
+    *fire = (p->out & FIRE_BIT) ? 1 : 0;
+    return p->present != 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "key_joystick.h"
+#include "config.h"
+#include <string.h>
+
+typedef struct {
+    uint8_t key;            // ST scancode
+    uint8_t bits;           // KEY_JOY_* directions and/or fire
+} key_joy_binding_t;
+
+#define UP      KEY_JOY_UP
+#define DOWN    KEY_JOY_DOWN
+#define LEFT    KEY_JOY_LEFT
+#define RIGHT   KEY_JOY_RIGHT
+#define FIRE    KEY_JOY_FIRE
+
+static const key_joy_binding_t cursor_keys[] = {
+    { 0x48, UP }, { 0x50, DOWN }, { 0x4B, LEFT }, { 0x4D, RIGHT }, { 0x39, FIRE },
+};
+
+static const key_joy_binding_t numpad_keys[] = {
+    { 0x68, UP },        { 0x6E, DOWN },       { 0x6A, LEFT },      { 0x6C, RIGHT },
+    { 0x67, UP | LEFT }, { 0x69, UP | RIGHT }, { 0x6D, DOWN | LEFT }, { 0x6F, DOWN | RIGHT },
+    { 0x70, FIRE },      { 0x6B, FIRE },
+};
+
+static const key_joy_binding_t wasd_keys[] = {
+    { 0x11, UP }, { 0x1F, DOWN }, { 0x1E, LEFT }, { 0x20, RIGHT }, { 0x39, FIRE },
+};
+
+static const struct {
+    const char* name;
+    const key_joy_binding_t* keys;
+    uint8_t count;
+} profiles[KEY_JOY_PROFILE_COUNT] = {
+    { "off",    NULL,        0 },
+    { "cursor", cursor_keys, sizeof(cursor_keys) / sizeof(cursor_keys[0]) },
+    { "numpad", numpad_keys, sizeof(numpad_keys) / sizeof(numpad_keys[0]) },
+    { "wasd",   wasd_keys,   sizeof(wasd_keys) / sizeof(wasd_keys[0]) },
+};
+
+static int profile = KEY_JOY_DEFAULT_PROFILE;
+static int port = KEY_JOY_DEFAULT_PORT;
+static bool passthrough;
+static bool table_stale = true;             // Profile or pass-through changed since the last update
+
+static uint8_t consumed[128 / 8];           // Keys held back from the ST keyboard
+static bool held[KEY_JOY_MAX_KEYS];
+static uint32_t stamp[KEY_JOY_MAX_KEYS];    // Update count when each key went down
+static uint32_t update_count;
+
+static void rebuild(void) {
+    memset(consumed, 0, sizeof(consumed));
+    memset(held, 0, sizeof(held));
+    if (passthrough) {
+        return;
+    }
+    for (int i = 0; i < profiles[profile].count; ++i) {
+        uint8_t key = profiles[profile].keys[i].key;
+        consumed[key >> 3] |= (uint8_t)(1u << (key & 7));
+    }
+}
+
+void key_joy_set_profile(int p) {
+    if (p >= 0 && p < KEY_JOY_PROFILE_COUNT) {
+        profile = p;
+        table_stale = true;
+    }
+}
+
+int key_joy_get_profile(void) {
+    return profile;
+}
+
+const char* key_joy_profile_name(int p) {
+    return (p >= 0 && p < KEY_JOY_PROFILE_COUNT) ? profiles[p].name : "?";
+}
+
+void key_joy_set_port(int p) {
+    port = p ? 1 : 0;
+}
+
+int key_joy_get_port(void) {
+    return port;
+}
+
+void key_joy_set_passthrough(bool on) {
+    passthrough = on;
+    table_stale = true;
+}
+
+bool key_joy_get_passthrough(void) {
+    return passthrough;
+}
+
+// Of two opposing directions, the one pressed later; neither if pressed together
+static uint8_t resolve_pair(uint8_t a, uint8_t b, const uint32_t last[4], uint8_t down) {
+    int ia = __builtin_ctz(a);
+    int ib = __builtin_ctz(b);
+    if ((down & a) && (down & b)) {
+        if (last[ia] == last[ib]) {
+            return 0;
+        }
+        return last[ia] > last[ib] ? a : b;
+    }
+    return down & (a | b);
+}
+
+bool key_joy_update(const uint8_t* keys, uint8_t* axis, uint8_t* fire) {
+    *axis = 0;
+    *fire = 0;
+    if (table_stale) {
+        table_stale = false;
+        rebuild();
+    }
+    if (profile == KEY_JOY_OFF) {
+        return false;
+    }
+
+    const key_joy_binding_t* b = profiles[profile].keys;
+    uint32_t last[4] = { 0, 0, 0, 0 };     // Latest press stamp per direction bit
+    uint8_t down = 0;
+
+    ++update_count;
+    for (int i = 0; i < profiles[profile].count; ++i) {
+        bool now = keys[b[i].key] != 0;
+        if (now && !held[i]) {
+            stamp[i] = update_count;
+        }
+        held[i] = now;
+        if (!now) {
+            continue;
+        }
+        if (b[i].bits & FIRE) {
+            *fire = 1;
+        }
+        for (int d = 0; d < 4; ++d) {
+            if ((b[i].bits & (1u << d)) && stamp[i] > last[d]) {
+                last[d] = stamp[i];
+            }
+        }
+        down |= b[i].bits & (UP | DOWN | LEFT | RIGHT);
+    }
+
+    *axis = resolve_pair(UP, DOWN, last, down) | resolve_pair(LEFT, RIGHT, last, down);
+    return true;
+}
+
+bool key_joy_consumes(uint8_t code) {
+    return profile != KEY_JOY_OFF && code < 128 && (consumed[code >> 3] & (1u << (code & 7)));
+}
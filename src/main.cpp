@@ -42,10 +42,18 @@
 #include "gamecube_adapter.h"  // GameCube adapter support
 #include "mount_splash.h"
 #include "usb_device_map.h"
+#include "telemetry.h"
+#include "tunables.h"
+#include "Console.h"
+#include "st_power.h"
+#include "core_channel.h"
+#include "core1_link.h"
+#include "sys_clock.h"
 
 #if ENABLE_BLUEPAD32
 // Use separate initialization file to avoid HID type conflicts between TinyUSB and btstack
 #include "bluepad32_init.h"
+#include "bluepad32_link.h"
 #endif
 
 #include "runtime_toggle.h"  // Runtime USB/Bluetooth toggle control
@@ -59,7 +67,6 @@ extern "C" {
     int bluepad32_get_connected_count(void);
     void bluepad32_diag_log_snapshot(void);
 #endif
-    uint32_t diag_uart_tx_wait_spins(void);
 }
 
 #define ROMBASE     256
@@ -69,86 +76,94 @@ extern unsigned int rom_HD6301V1ST_img_len;
 
 
 /**
- * Software receive queue to buffer bytes when 6301 RDR is busy
- * Prevents byte loss during timing-critical periods
+ * Bytes from the ST (and injected IKBD commands) on their way to the 6301.
+ * Core 0 pushes, Core 1 feeds RDR from the tail once the ROM has read the
+ * previous byte, so the SCI is only ever touched by the core running it.
  */
 #define RX_QUEUE_SIZE 32  // Buffer up to 32 bytes (matches UART FIFO size)
 static unsigned char rx_queue[RX_QUEUE_SIZE];
-static volatile int rx_queue_head = 0;
-static volatile int rx_queue_tail = 0;
-static volatile int rx_queue_count = 0;
+static cc_spsc_t rx_chan;
 
-/**
- * Clear the receive queue (called on reset to prevent stale data)
- */
-static void clear_rx_queue() {
-    rx_queue_head = 0;
-    rx_queue_tail = 0;
-    rx_queue_count = 0;
+// Reset requests from Core 0: Core 1 drops queued bytes up to flush_to first
+static uint32_t rx_reset_req = 0;
+static uint32_t rx_reset_flush_to = 0;
+
+extern "C" bool core1_queue_rx_byte(uint8_t data) {
+    if (cc_spsc_space(&rx_chan, RX_QUEUE_SIZE) == 0) {
+        return false;
+    }
+    rx_queue[cc_spsc_head(&rx_chan) & (RX_QUEUE_SIZE - 1)] = data;
+    cc_spsc_push(&rx_chan);
+    return true;
+}
+
+extern "C" uint32_t core1_rx_queued(void) {
+    return cc_spsc_count(&rx_chan);
+}
+
+extern "C" void core1_request_reset(void) {
+    cc_put(&rx_reset_flush_to, cc_spsc_head(&rx_chan));
+    cc_put_release(&rx_reset_req, cc_get(&rx_reset_req) + 1);
 }
 
 /**
- * Read bytes from the physical serial port and pass them to the HD6301
- * Uses software queue to buffer bytes when 6301 RDR is busy
+ * Read bytes from the physical serial port and queue them for the HD6301
  */
 static void __not_in_flash_func(handle_rx_from_st)() {
     unsigned char data;
-    static int bytes_deferred_count = 0;
     static int queue_full_count = 0;
-    
-    // First, try to drain the software queue (feed buffered bytes to 6301)
-    while (rx_queue_count > 0 && !hd6301_sci_busy()) {
-        unsigned char queued_byte = rx_queue[rx_queue_tail];
-        hd6301_receive_byte(queued_byte);
-        rx_queue_tail = (rx_queue_tail + 1) % RX_QUEUE_SIZE;
-        rx_queue_count--;
-    }
-    
-    // Now read new bytes from UART and queue them if 6301 is busy
+
     while (SerialPort::instance().recv(data)) {
-        if (!hd6301_sci_busy()) {
-            // 6301 RDR is available - send directly
-            hd6301_receive_byte(data);
-        } else {
-            // 6301 RDR is busy - queue the byte
-            if (rx_queue_count < RX_QUEUE_SIZE) {
-                // Add to queue
-                rx_queue[rx_queue_head] = data;
-                rx_queue_head = (rx_queue_head + 1) % RX_QUEUE_SIZE;
-                rx_queue_count++;
-            } else {
-                // Queue is full - this is very bad!
-                queue_full_count++;
-                if ((queue_full_count % 100) == 1) {
-                    printf("CRITICAL: RX queue FULL! Byte 0x%02X LOST! (count: %d)\n", 
-                           data, queue_full_count);
-                }
-                // Byte is lost - but at least we logged it
-            }
-            bytes_deferred_count++;
-            if ((bytes_deferred_count % 1000) == 1) {
-                printf("WARNING: 6301 RDR busy (deferred %d times, queue: %d/%d)\n", 
-                       bytes_deferred_count, rx_queue_count, RX_QUEUE_SIZE);
+        if (!core1_queue_rx_byte(data)) {
+            // Queue is full - this is very bad!
+            tm_inc(TM_UART_RX_DROPPED);
+            queue_full_count++;
+            if ((queue_full_count % 100) == 1) {
+                printf("CRITICAL: RX queue FULL! Byte 0x%02X LOST! (count: %d)\n",
+                       data, queue_full_count);
             }
+            continue;
         }
+        tm_sample(TM_UART_RX_QUEUE, core1_rx_queued());
     }
-    
-    // Check for serial overrun errors (byte arrived while RDR was still full)
-    // This would indicate the ROM firmware isn't reading bytes fast enough
+}
+
+/**
+ * Core 1, between run_clocks batches: apply a pending reset, then move the
+ * next queued byte into RDR if the ROM has read the last one. Returns false
+ * if the 6301 was reset and should not run this iteration.
+ */
+static bool __not_in_flash_func(service_rx_to_6301)() {
+    static uint32_t reset_seen = 0;
+    static uint32_t deferred_at = ~0u;
+
+    uint32_t req = cc_get_acquire(&rx_reset_req);
+    if (req != reset_seen) {
+        reset_seen = req;
+        cc_spsc_pop_to(&rx_chan, cc_get(&rx_reset_flush_to));
+        hd6301_reset(1);  // Cold reset
+        return false;
+    }
+
+    if (cc_spsc_count(&rx_chan) > 0) {
+        uint32_t tail = cc_spsc_tail(&rx_chan);
+        if (!hd6301_sci_busy()) {
+            hd6301_receive_byte(rx_queue[tail & (RX_QUEUE_SIZE - 1)]);
+            cc_spsc_pop(&rx_chan);
+        } else if (tail != deferred_at) {
+            deferred_at = tail;     // Count each held byte once
+            tm_inc(TM_UART_RX_DEFERRED);
+        }
+    }
+
+    // Serial overrun (byte arrived while RDR was still full): the ROM is not
+    // reading fast enough. Counted only; Core 1 does not printf.
     extern u_char iram[];  // Defined in ireg.c
     if (iram[0x11] & 0x40) {  // TRCSR register, ORFE bit (Overrun/Framing Error)
-        static int overrun_count = 0;
-        if ((++overrun_count % 100) == 1) {  // Don't spam, report every 100th
-            printf("WARNING: Serial overrun detected! ROM reading too slow. Count: %d\n", overrun_count);
-            printf("  TRCSR=0x%02X (RDRF=%d ORFE=%d)\n", 
-                   iram[0x11], 
-                   (iram[0x11] & 0x80) ? 1 : 0,  // RDRF
-                   (iram[0x11] & 0x40) ? 1 : 0); // ORFE
-        }
-        // Clear overrun flag to prevent continuous triggering
-        // Note: ROM should also clear this when reading RDR
-        iram[0x11] &= ~0x40;  // Clear ORFE bit
+        tm_inc(TM_SCI_OVERRUN);
+        iram[0x11] &= ~0x40;  // Clear ORFE bit to prevent continuous triggering
     }
+    return true;
 }
 
 /**
@@ -166,12 +181,11 @@ void __not_in_flash_func(setup_hd6301)() {
     memcpy(pram + ROMBASE, rom_HD6301V1ST_img, rom_HD6301V1ST_img_len);
 }
 
-// Global flag to track Core 1 activity (updated by Core 1, read by Core 0)
-static volatile uint32_t g_core1_heartbeat_counter = 0;
-static volatile uint32_t g_core1_cycle_count = 0;
-static volatile uint32_t g_core1_loop_counter = 0;  // Simple loop counter to detect if Core 1 is running
-static volatile bool g_core1_paused = false;  // True while pause depth > 0
-static volatile uint32_t g_core1_pause_depth = 0;
+// Core 1 pause control (loop, cycle and heartbeat counts live in telemetry).
+// The depth is Core 0's own; Core 1 only sees the paused word.
+static uint32_t g_core1_paused = 0;  // Non-zero while pause depth > 0
+static uint32_t g_core1_pause_depth = 0;
+static bool g_core1_launched = false;   // Core 0 only
 
 // Core 1 location breadcrumbs for freeze diagnosis (read by Core 0 heartbeat)
 enum : uint32_t {
@@ -181,11 +195,15 @@ enum : uint32_t {
     CORE1_PHASE_RUN_CLOCKS = 3,
     CORE1_PHASE_LOOP_DONE = 4,
 };
-static volatile uint32_t g_core1_phase = CORE1_PHASE_LOOP_TOP;
-static volatile uint32_t g_core1_pc_at_run = 0;
-static volatile uint32_t g_core1_run_enter = 0;
-static volatile uint32_t g_core1_run_exit = 0;
-static volatile uint32_t g_core1_pause_spins = 0;
+static uint32_t g_core1_phase = CORE1_PHASE_LOOP_TOP;
+static uint32_t g_core1_pc_at_run = 0;
+static uint32_t g_core1_pause_spins = 0;
+
+// Emulated cycles per Core 1 loop iteration (console tunable "cycles_per_loop")
+static uint32_t g_cycles_per_loop = CYCLES_PER_LOOP;
+
+extern "C" void core1_set_cycles_per_loop(uint32_t cycles) { cc_put(&g_cycles_per_loop, cycles); }
+extern "C" uint32_t core1_get_cycles_per_loop(void) { return cc_get(&g_cycles_per_loop); }
 
 static const char* core1_phase_name(uint32_t phase) {
     switch (phase) {
@@ -197,29 +215,27 @@ static const char* core1_phase_name(uint32_t phase) {
     }
 }
 
-extern "C" uint32_t core1_get_diag_phase(void) { return g_core1_phase; }
-extern "C" uint32_t core1_get_diag_pc(void) { return g_core1_pc_at_run; }
-extern "C" uint32_t core1_get_run_enter(void) { return g_core1_run_enter; }
-extern "C" uint32_t core1_get_run_exit(void) { return g_core1_run_exit; }
-extern "C" uint32_t core1_get_pause_spins(void) { return g_core1_pause_spins; }
+extern "C" uint32_t core1_get_diag_phase(void) { return cc_get(&g_core1_phase); }
+extern "C" uint32_t core1_get_diag_pc(void) { return cc_get(&g_core1_pc_at_run); }
+extern "C" uint32_t core1_get_pause_spins(void) { return cc_get(&g_core1_pause_spins); }
 
 // Functions to pause/resume Core 1 (called from BT callbacks)
 extern "C" void core1_pause_for_bt_enumeration(void) {
     uint32_t depth = ++g_core1_pause_depth;
-    __dmb();
-    g_core1_paused = true;
-    __dmb();
+    cc_put(&g_core1_paused, 1);
 #if ENABLE_SERIAL_LOGGING
     printf("[DIAG] Core1 PAUSE depth=%lu\n", (unsigned long)depth);
 #endif
 }
 
-// Poll until Core 1 has entered the pause loop. Uses busy_wait only — safe inside
-// BT callbacks where sleep_ms/__wfe may not advance (IRQs constrained).
+// Poll until Core 1 is in the pause loop. Uses busy_wait only, as it runs on
+// the flash_safe_execute path (bluepad32_guard.c). pause_spins is a running
+// total, so only the phase says where Core 1 is now.
 extern "C" void core1_wait_for_pause_active(uint32_t timeout_ms) {
     uint32_t limit = timeout_ms * 100u;  // 10 us steps
     for (uint32_t i = 0; i < limit; i++) {
-        if (g_core1_pause_spins > 0 || g_core1_phase == CORE1_PHASE_PAUSED) {
+        // Acquire: once parked, Core 1 has finished its last batch
+        if (cc_get_acquire(&g_core1_phase) == CORE1_PHASE_PAUSED) {
             return;
         }
         busy_wait_us(10);
@@ -234,12 +250,10 @@ extern "C" void core1_resume_after_bt_enumeration(void) {
         return;
     }
     uint32_t depth = --g_core1_pause_depth;
-    __dmb();
-    g_core1_paused = (g_core1_pause_depth != 0);
-    __dmb();
+    cc_put(&g_core1_paused, depth != 0);
 #if ENABLE_SERIAL_LOGGING
     printf("[DIAG] Core1 RESUME depth=%lu paused=%d\n",
-           (unsigned long)depth, g_core1_paused ? 1 : 0);
+           (unsigned long)depth, depth != 0 ? 1 : 0);
 #endif
 }
 
@@ -248,7 +262,43 @@ extern "C" uint32_t core1_get_pause_depth(void) {
 }
 
 extern "C" int core1_is_paused(void) {
-    return g_core1_paused ? 1 : 0;
+    return g_core1_pause_depth != 0 ? 1 : 0;
+}
+
+extern "C" bool core1_launched(void) {
+    return g_core1_launched;
+}
+
+// Without a sense pin only a connected, switched-off ST is seen: RX has a
+// pull-up, so an unplugged cable looks like an idle line (config.h)
+static bool st_present() {
+#if ST_SENSE_GPIO >= 0
+    return gpio_get(ST_SENSE_GPIO) == ST_SENSE_ACTIVE;
+#else
+    return !SerialPort::instance().link_is_down();
+#endif
+}
+
+// ST gone: park Core 1 in its WFE pause loop, then drop the system clock
+static void st_idle_enter() {
+    core1_pause_for_bt_enumeration();
+    core1_wait_for_pause_active(10);
+#if ENABLE_BLUEPAD32
+    bluepad32_link_set_low_latency(false);  // Let BT peers sniff / stretch intervals
+#endif
+    sys_clock_enter_idle(ST_IDLE_CPU_KHZ);
+    printf("ST absent: idle at %lu MHz\n", (unsigned long)(ST_IDLE_CPU_KHZ / 1000));
+}
+
+// ST back: full clock first, so Core 1 resumes at full speed
+static void st_idle_exit() {
+    sys_clock_exit_idle();
+#if ENABLE_BLUEPAD32
+    bluepad32_link_set_low_latency(true);
+#endif
+    core1_resume_after_bt_enumeration();
+    __sev();    // Wake Core 1 out of WFE now rather than on the next event
+    printf("ST present: running at %lu MHz\n", (unsigned long)(sys_clock_get_khz() / 1000));
 }
 
 void __not_in_flash_func(core1_entry)() {
@@ -267,13 +317,10 @@ void __not_in_flash_func(core1_entry)() {
     setup_hd6301();
     
     hd6301_reset(1);
-    // Note: RX queue is cleared at startup (automatically zero-initialized)
     unsigned long count = 0;
     
     // CRITICAL: Don't use printf here - it can block if UART0 is locked by Bluetooth
-    // Instead, set a flag that Core 0 can check
-    g_core1_heartbeat_counter = 0xFFFFFFFF;  // Magic value to indicate Core 1 started
-    
+    // Core 0 sees Core 1 running through the c1.* telemetry counters instead
     // Pure tight loop - NO DELAYS (matching logronoid's implementation)
     // This makes Core 1 completely independent of timer system and Core 0's USB/Bluetooth operations
     // Core 1 runs at maximum speed, only limited by CPU clock
@@ -281,29 +328,34 @@ void __not_in_flash_func(core1_entry)() {
     uint32_t last_heartbeat_loop = 0;
     
     while (true) {
-        g_core1_loop_counter++;
-        g_core1_phase = CORE1_PHASE_LOOP_TOP;
+        tm_inc(TM_CORE1_LOOPS);
+        cc_put(&g_core1_phase, CORE1_PHASE_LOOP_TOP);
 
-        if (g_core1_paused) {
-            g_core1_phase = CORE1_PHASE_PAUSED;
-            g_core1_pause_spins++;
+        if (cc_get(&g_core1_paused)) {
+            cc_put_release(&g_core1_phase, CORE1_PHASE_PAUSED);
+            cc_put(&g_core1_pause_spins, cc_get(&g_core1_pause_spins) + 1);
             // Yield so multicore lockout FIFO IRQ (flash_safe_execute) can preempt Core 1
             __wfe();
             continue;
         }
 
-        count += CYCLES_PER_LOOP;
-        g_core1_cycle_count = count;
+        if (!service_rx_to_6301()) {
+            continue;   // Reset this iteration, don't run cycles
+        }
 
-        g_core1_phase = CORE1_PHASE_TX_EMPTY;
+        uint32_t cycles = cc_get(&g_cycles_per_loop);
+        count += cycles;
+        tm_set(TM_CORE1_CYCLES, count);
+
+        cc_put(&g_core1_phase, CORE1_PHASE_TX_EMPTY);
         hd6301_tx_empty(serial_send_buf_empty());
 
-        g_core1_run_enter++;
-        g_core1_pc_at_run = hd6301_get_pc();
-        g_core1_phase = CORE1_PHASE_RUN_CLOCKS;
-        hd6301_run_clocks(CYCLES_PER_LOOP);
-        g_core1_run_exit++;
-        g_core1_phase = CORE1_PHASE_LOOP_DONE;
+        tm_inc(TM_CORE1_RUN_ENTER);
+        cc_put(&g_core1_pc_at_run, hd6301_get_pc());
+        cc_put(&g_core1_phase, CORE1_PHASE_RUN_CLOCKS);
+        hd6301_run_clocks(cycles);
+        tm_inc(TM_CORE1_RUN_EXIT);
+        cc_put(&g_core1_phase, CORE1_PHASE_LOOP_DONE);
 
         loop_count++;
         
@@ -311,7 +363,7 @@ void __not_in_flash_func(core1_entry)() {
         // Use loop counter instead of absolute_time to avoid Bluetooth blocking
         if (loop_count - last_heartbeat_loop >= 50000) {
             last_heartbeat_loop = loop_count;
-            g_core1_heartbeat_counter++;  // Increment counter (non-blocking atomic operation)
+            tm_inc(TM_CORE1_HEARTBEAT);
         }
 
         // NO DELAY - pure tight loop (matching logronoid's approach)
@@ -333,6 +385,8 @@ int main() {
     uart_puts(uart0, "UART0 console ready (115200 8N1)\r\n");
     printf("Firmware version: %s\n", PROJECT_VERSION_DISPLAY);
 
+    telemetry_init();
+
     // Note: stdio_init_all() not called as it may interfere with SerialPort UART setup
     // Initialize TinyUSB for USB HID device support (concurrent with Bluetooth)
     if (!tusb_init()) {
@@ -351,13 +405,15 @@ int main() {
     // CYW43 chip has issues at very high clock speeds (270MHz causes STALL timeouts)
     // 225MHz provides good balance between performance and stability
     #if ENABLE_BLUEPAD32
-    uint32_t clock_khz = 225000;  // 225 MHz for Bluetooth builds (matching logronoid)
+    uint32_t clock_khz = BT_CPU_CLOCK_KHZ;  // 225 MHz for Bluetooth builds (matching logronoid)
     printf("Bluetooth build: Using 225 MHz (matching logronoid's config)\n");
     #else
     uint32_t clock_khz = DEFAULT_CPU_CLOCK_KHZ;
     #endif
     
-    if (!set_sys_clock_khz(clock_khz, false))
+    // Through sys_clock so the idle path and the cpu_khz tunable start from
+    // the clock actually set here
+    if (!sys_clock_set_khz(clock_khz))
       printf("system clock %d MHz failed\n", clock_khz / 1000);
     else
       printf("system clock now %d MHz\n", clock_khz / 1000);
@@ -391,7 +447,17 @@ int main() {
     HidInput::instance().set_ui(ui);
 #endif
 
+    // Saved console tunables (clock, cycles per loop...) before Core 1 starts
+    tunables_init();
+
+#if ST_SENSE_GPIO >= 0
+    gpio_init(ST_SENSE_GPIO);
+    gpio_set_dir(ST_SENSE_GPIO, GPIO_IN);
+    gpio_pull_down(ST_SENSE_GPIO);
+#endif
+
     // The second CPU core is dedicated to the HD6301 emulation.
+    g_core1_launched = true;
     multicore_launch_core1(core1_entry);
 
     // Force mouse enabled at startup
@@ -419,20 +485,33 @@ int main() {
     absolute_time_t heartbeat_ms = get_absolute_time();
 #if ENABLE_BLUEPAD32
     absolute_time_t bt_poll_ms = get_absolute_time();  // For Bluetooth polling (1ms interval)
-    static uint32_t bt_poll_count = 0;
 #endif
-    static uint32_t loop_count = 0;
     
-    printf("Main loop: Starting...\n");
-    printf("[DIAG] heartbeat every 10s: Core1 phase/pc, BT storage, HidInput consume, CYCLES_FROZEN\n");
+    printf("Main loop: Starting... (console: type 'help')\n");
+    printf("[DIAG] heartbeat every 10s: Core1 phase/pc, BT storage, telemetry, CYCLES_FROZEN\n");
     
     while (true) {
         absolute_time_t tm = get_absolute_time();
-        loop_count++;
+        tm_inc(TM_MAIN_LOOPS);
 
         // HIGH PRIORITY: Check for serial data from ST every loop iteration
-        // At 7812 baud, bytes arrive every ~1.28ms - must not miss them!
+        // At 7812 baud, bytes arrive every ~1.28ms (160us at ikbd_baud 62500) - must not miss them!
         handle_rx_from_st();
+        if (SerialPort::instance().poll_link()) {
+            // ST reset or powered back up: drop queued bytes and start the 6301 clean
+            core1_request_reset();
+            printf("ST link break: 6301 re-synced\n");
+        }
+
+        switch (st_power_update(st_present(), time_us_32())) {
+            case ST_POWER_ENTER_IDLE: st_idle_enter(); break;
+            case ST_POWER_EXIT_IDLE:  st_idle_exit();  break;
+            default: break;
+        }
+        const bool idle = st_power_idle();
+
+        // UART0 command shell (non-blocking, one command per pass at most)
+        Console::instance().poll();
         
         // Drain TX log buffer for UI display (non-critical path)
         SerialPort::instance().drain_tx_log();
@@ -440,12 +519,13 @@ int main() {
         AtariSTMouse::instance().update();
 
         // 10ms: USB stack, HID, and UI — handle_mouse() drains/accumulates deltas per tick
-        if (absolute_time_diff_us(ten_ms, tm) >= 10000) {
+        if (absolute_time_diff_us(ten_ms, tm) >= (idle ? ST_IDLE_TICK_US : 10000)) {
             ten_ms = tm;
 
             if (usb_runtime_is_enabled()) {
                 tuh_task();
                 switch_check_delayed_init();
+                gc_task();
 #if ENABLE_OLED_DISPLAY
                 mount_splash_service();
 #endif
@@ -482,15 +562,16 @@ int main() {
 #if ENABLE_OLED_DISPLAY
             ui.update();
 #endif
+            tm_hist(TM_MAIN_TICK_US, (uint32_t)absolute_time_diff_us(tm, get_absolute_time()));
         }
         
 #if ENABLE_BLUEPAD32
         // Poll Bluetooth frequently (every 1ms) for responsive controller input
         // Matching logronoid's approach of frequent Bluetooth polling
         // Only poll if Bluetooth is enabled at runtime
-        if (bt_runtime_is_enabled() && bluepad32_is_enabled() && absolute_time_diff_us(bt_poll_ms, tm) >= 1000) {
+        if (bt_runtime_is_enabled() && bluepad32_is_enabled() && absolute_time_diff_us(bt_poll_ms, tm) >= (idle ? ST_IDLE_BT_POLL_US : 1000)) {
             bt_poll_ms = tm;
-            bt_poll_count++;
+            tm_inc(TM_MAIN_BT_POLLS);
             bluepad32_poll();  // Process Bluetooth events
             // Immediately poll USB after Bluetooth to prevent USB starvation (if USB enabled)
             if (usb_runtime_is_enabled()) {
@@ -507,9 +588,8 @@ int main() {
 #if ENABLE_SERIAL_LOGGING
         if (absolute_time_diff_us(heartbeat_ms, tm) >= 10000000) {
             heartbeat_ms = tm;
-            uint32_t core1_heartbeat = g_core1_heartbeat_counter;
-            uint32_t core1_cycles = g_core1_cycle_count;
-            uint32_t core1_loops = g_core1_loop_counter;
+            uint32_t core1_cycles = telemetry_gauge(TM_CORE1_CYCLES);
+            uint32_t core1_loops = telemetry_counter(TM_CORE1_LOOPS);
             static uint32_t last_core1_cycles = 0;
             static uint32_t last_core1_loops = 0;
             bool core1_frozen = (core1_cycles == last_core1_cycles && core1_cycles > 0);
@@ -517,14 +597,11 @@ int main() {
             last_core1_cycles = core1_cycles;
             last_core1_loops = core1_loops;
 #if ENABLE_BLUEPAD32
-            printf("Main loop: HEARTBEAT - loops=%lu, BT polls=%lu, Core1: hb=%lu cycles=%lu loops=%lu phase=%s pc=%04lX run_in=%lu run_out=%lu pause_spins=%lu pause_depth=%lu paused=%d sci_busy=%d rx_q=%d uart_tx_spin=%lu BT(kb=%d mouse=%d joy=%d)%s%s\n",
-                   loop_count, bt_poll_count, core1_heartbeat, core1_cycles, core1_loops,
-                   core1_phase_name(g_core1_phase), (unsigned long)g_core1_pc_at_run,
-                   (unsigned long)g_core1_run_enter, (unsigned long)g_core1_run_exit,
-                   (unsigned long)g_core1_pause_spins,
+            printf("Main loop: HEARTBEAT - Core1: phase=%s pc=%04lX pause_spins=%lu pause_depth=%lu paused=%d rx_q=%lu BT(kb=%d mouse=%d joy=%d)%s%s\n",
+                   core1_phase_name(core1_get_diag_phase()), (unsigned long)core1_get_diag_pc(),
+                   (unsigned long)core1_get_pause_spins(),
                    (unsigned long)core1_get_pause_depth(), core1_is_paused(),
-                   hd6301_sci_busy(), rx_queue_count,
-                   (unsigned long)diag_uart_tx_wait_spins(),
+                   (unsigned long)core1_rx_queued(),
                    bluepad32_get_keyboard_count(), bluepad32_get_mouse_count(),
                    bluepad32_get_connected_count(),
                    core1_frozen ? " [CYCLES_FROZEN!]" : "",
@@ -532,13 +609,19 @@ int main() {
             bluepad32_diag_log_snapshot();
             hid_diag_log_snapshot();
 #else
-            printf("Main loop: HEARTBEAT - loops=%lu, Core1: hb=%lu cycles=%lu loops=%lu%s%s\n", 
-                   loop_count, core1_heartbeat, core1_cycles, core1_loops,
+            printf("Main loop: HEARTBEAT - Core1: phase=%s pc=%04lX%s%s\n",
+                   core1_phase_name(core1_get_diag_phase()), (unsigned long)core1_get_diag_pc(),
                    core1_frozen ? " [CYCLES_FROZEN!]" : "",
                    core1_loops_frozen ? " [LOOPS_FROZEN!]" : "");
 #endif
+            telemetry_print_changes();  // Full dump: "tm" on the console
         }
 #endif
+
+        if (idle) {
+            // Nothing urgent while the ST is off: sleep (WFE) instead of spinning
+            sleep_us(ST_IDLE_SLEEP_US);
+        }
     }
     return 0;
 }
@@ -568,12 +651,6 @@ extern "C" {
     void switch_check_delayed_init(void);
 }
 
-// Global Xbox report counter (accessible from UI)
-static uint32_t xbox_report_count = 0;
-extern "C" uint32_t get_xbox_report_count() {
-    return xbox_report_count;
-}
-
 // XInput mount callback - called when Xbox controller is connected
 void tuh_xinput_mount_cb(uint8_t dev_addr, uint8_t instance, const xinputh_interface_t *xinput_itf) {
     const char* type_str;
@@ -651,7 +728,7 @@ void tuh_xinput_umount_cb(uint8_t dev_addr, uint8_t instance) {
 void tuh_xinput_report_received_cb(uint8_t dev_addr, uint8_t instance, 
                                     xinputh_interface_t const* xid_itf, uint16_t len) {
     // Increment global counter for UI display
-    xbox_report_count++;
+    tm_inc(TM_XBOX_REPORTS);
     
     // Force new_pad_data flag to 1 (TinyUSB workaround)
     xinputh_interface_t* mutable_itf = (xinputh_interface_t*)xid_itf;
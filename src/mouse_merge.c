@@ -0,0 +1,325 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "mouse_merge.h"
+#include "config.h"
+#include <string.h>
+
+typedef struct {
+    bool     used;
+    bool     abs_valid;     // abs_x/abs_y hold a position to diff against
+    uint16_t id;
+    uint8_t  buttons;
+    uint8_t  cls;
+    int32_t  abs_x;
+    int32_t  abs_y;
+    int64_t  rem_x;         // Scaled remainder not yet emitted
+    int64_t  rem_y;
+
+    // Resolution calibration (relative USB/BT mice only)
+    bool     calibrated;
+    uint8_t  samples;                       // Moving samples in hist
+    uint16_t sample_reports;                // Current sample
+    int32_t  sample_counts;                 // |dx| + |dy| in the current sample
+    uint32_t sample_us;
+    uint32_t move_reports;                  // Reports in the moving samples
+    uint32_t move_us;                       // Duration of the moving samples
+    uint32_t median_cps;
+    uint8_t  hist[MOUSE_NORM_BUCKETS];      // Moving samples per speed bucket
+} merge_source_t;
+
+static merge_source_t sources[MOUSE_MERGE_SOURCES];
+static int32_t class_scale[MOUSE_CLASS_COUNT] = {
+    MOUSE_MERGE_SCALE_ONE, MOUSE_MERGE_SCALE_ONE, MOUSE_MERGE_SCALE_ONE
+};
+static int32_t acc_x;
+static int32_t acc_y;
+static uint8_t transient_buttons;   // Buttons from sources that found no free slot (this pass only)
+static uint8_t last_buttons;
+static bool    normalise = MOUSE_NORM_DEFAULT;
+static int32_t target_cps = MOUSE_NORM_TARGET_CPS;
+static bool    have_pass_start;
+static uint32_t pass_start_us;
+
+static merge_source_t* find_source(uint16_t id, bool create) {
+    merge_source_t* free_slot = NULL;
+    for (int i = 0; i < MOUSE_MERGE_SOURCES; ++i) {
+        if (sources[i].used && sources[i].id == id) {
+            return &sources[i];
+        }
+        if (!sources[i].used && !free_slot) {
+            free_slot = &sources[i];
+        }
+    }
+    if (create && free_slot) {
+        memset(free_slot, 0, sizeof(*free_slot));
+        free_slot->used = true;
+        free_slot->id = id;
+    }
+    return create ? free_slot : NULL;
+}
+
+// num/den, carrying the remainder to the next call so nothing is lost
+static int32_t divide_keep_remainder(int64_t num, int64_t den, int64_t* rem) {
+    int64_t total = num + *rem;
+    int64_t out = total / den;
+    *rem = total - out * den;
+    return (int32_t)out;
+}
+
+static int32_t scale_for(mouse_class_t cls) {
+    return (cls < MOUSE_CLASS_COUNT) ? class_scale[cls] : MOUSE_MERGE_SCALE_ONE;
+}
+
+static bool calibrates(mouse_class_t cls) {
+    return cls == MOUSE_CLASS_USB || cls == MOUSE_CLASS_BT;
+}
+
+// Speed buckets are quarter octaves: 4 per power of two, from 4 counts/s up
+static int cps_bucket(uint32_t cps) {
+    if (cps < 4) {
+        cps = 4;
+    }
+    int msb = 31 - __builtin_clz(cps);
+    int b = msb * 4 + (int)((cps >> (msb - 2)) & 3);
+    return (b < MOUSE_NORM_BUCKETS) ? b : MOUSE_NORM_BUCKETS - 1;
+}
+
+static uint32_t bucket_low(int b) {
+    return (uint32_t)(4 + (b & 3)) << (b / 4 - 2);
+}
+
+// Median of the histogram, interpolated inside its bucket
+static uint32_t hist_median(const merge_source_t* s) {
+    uint32_t half = (s->samples + 1u) / 2u;
+    uint32_t below = 0;
+    for (int b = 0; b < MOUSE_NORM_BUCKETS; ++b) {
+        if (below + s->hist[b] >= half) {
+            uint32_t lo = bucket_low(b);
+            uint32_t hi = bucket_low(b + 1);
+            return lo + (hi - lo) * (2u * (half - below) - 1u) / (2u * s->hist[b]);
+        }
+        below += s->hist[b];
+    }
+    return 0;
+}
+
+static int32_t norm_for(const merge_source_t* s) {
+    if (!normalise || !s || s->median_cps == 0) {
+        return MOUSE_NORM_ONE;
+    }
+    int64_t norm = ((int64_t)target_cps * MOUSE_NORM_ONE + s->median_cps / 2) / s->median_cps;
+    if (norm < MOUSE_NORM_MIN) {
+        norm = MOUSE_NORM_MIN;
+    } else if (norm > MOUSE_NORM_MAX) {
+        norm = MOUSE_NORM_MAX;
+    }
+    return (int32_t)norm;
+}
+
+static void clear_sample(merge_source_t* s) {
+    s->sample_counts = 0;
+    s->sample_reports = 0;
+    s->sample_us = 0;
+}
+
+// Add the pass that just ended to the current sample of one source, and
+// record the sample once it is long enough
+static void calibrate_pass(merge_source_t* s, uint32_t pass_us) {
+    if (s->calibrated) {
+        clear_sample(s);
+        return;
+    }
+    if (pass_us > MOUSE_NORM_MAX_PASS_US) {
+        clear_sample(s);
+        return;
+    }
+    s->sample_us += pass_us;
+    if (s->sample_us < MOUSE_NORM_SAMPLE_US) {
+        return;
+    }
+    if (s->sample_counts > 0) {
+        uint32_t cps = (uint32_t)(((uint64_t)s->sample_counts * 1000000u) / s->sample_us);
+        s->hist[cps_bucket(cps)]++;
+        s->samples++;
+        s->move_reports += s->sample_reports;
+        s->move_us += s->sample_us;
+        if (s->samples >= MOUSE_NORM_MIN_SAMPLES) {
+            s->median_cps = hist_median(s);
+        }
+        if (s->samples >= MOUSE_NORM_WINDOW) {
+            s->calibrated = true;
+        }
+    }
+    clear_sample(s);
+}
+
+static void add_motion(merge_source_t* s, int32_t scale, int64_t dx_num, int64_t dy_num, int64_t den) {
+    int64_t dummy_x = 0;
+    int64_t dummy_y = 0;
+    acc_x += divide_keep_remainder(dx_num * scale, den, s ? &s->rem_x : &dummy_x);
+    acc_y += divide_keep_remainder(dy_num * scale, den, s ? &s->rem_y : &dummy_y);
+}
+
+static void set_buttons(merge_source_t* s, uint8_t buttons) {
+    if (buttons == MOUSE_MERGE_BUTTONS_KEEP) {
+        return;
+    }
+    if (s) {
+        s->buttons = buttons;
+    } else {
+        transient_buttons |= buttons;
+    }
+}
+
+void mouse_merge_begin(uint32_t now_us) {
+    if (have_pass_start) {
+        uint32_t pass_us = now_us - pass_start_us;
+        for (int i = 0; i < MOUSE_MERGE_SOURCES; ++i) {
+            if (sources[i].used) {
+                calibrate_pass(&sources[i], pass_us);
+            }
+        }
+    }
+    have_pass_start = true;
+    pass_start_us = now_us;
+
+    acc_x = 0;
+    acc_y = 0;
+    transient_buttons = 0;
+}
+
+void mouse_merge_relative(uint16_t id, mouse_class_t cls, int32_t dx, int32_t dy, uint8_t buttons) {
+    merge_source_t* s = find_source(id, true);
+    int32_t norm = MOUSE_NORM_ONE;
+    if (s && calibrates(cls)) {
+        s->cls = (uint8_t)cls;
+        s->sample_counts += (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+        s->sample_reports++;
+        norm = norm_for(s);
+    }
+    add_motion(s, scale_for(cls), (int64_t)dx * norm, (int64_t)dy * norm,
+               (int64_t)MOUSE_MERGE_SCALE_ONE * MOUSE_NORM_ONE);
+    set_buttons(s, buttons);
+}
+
+void mouse_merge_absolute(uint16_t id, mouse_class_t cls, int32_t x, int32_t y,
+                          int32_t max_x, int32_t max_y, bool in_range, uint8_t buttons) {
+    merge_source_t* s = find_source(id, true);
+
+    if (s) {
+        s->cls = (uint8_t)cls;
+    }
+    set_buttons(s, buttons);
+    if (!s) {
+        return;     // No history to diff against
+    }
+    if (!in_range || max_x <= 0 || max_y <= 0) {
+        s->abs_valid = false;
+        return;
+    }
+    if (s->abs_valid) {
+        // A full sweep of the device moves MOUSE_MERGE_ABS_SPAN counts at 1x
+        int64_t span = MOUSE_MERGE_ABS_SPAN;
+        int32_t scale = scale_for(cls);
+        acc_x += divide_keep_remainder((int64_t)(x - s->abs_x) * span * scale,
+                                       (int64_t)max_x * MOUSE_MERGE_SCALE_ONE, &s->rem_x);
+        acc_y += divide_keep_remainder((int64_t)(y - s->abs_y) * span * scale,
+                                       (int64_t)max_y * MOUSE_MERGE_SCALE_ONE, &s->rem_y);
+    }
+    s->abs_x = x;
+    s->abs_y = y;
+    s->abs_valid = true;
+}
+
+void mouse_merge_remove(uint16_t id) {
+    merge_source_t* s = find_source(id, false);
+    if (s) {
+        s->used = false;
+    }
+}
+
+bool mouse_merge_take_buttons(uint8_t* buttons) {
+    uint8_t merged = transient_buttons;
+    for (int i = 0; i < MOUSE_MERGE_SOURCES; ++i) {
+        if (sources[i].used) {
+            merged |= sources[i].buttons;
+        }
+    }
+    *buttons = merged;
+
+    bool changed = (merged != last_buttons);
+    last_buttons = merged;
+    return changed;
+}
+
+void mouse_merge_end(int32_t* dx, int32_t* dy) {
+    *dx = acc_x;
+    *dy = acc_y;
+}
+
+int mouse_merge_active(void) {
+    int n = 0;
+    for (int i = 0; i < MOUSE_MERGE_SOURCES; ++i) {
+        n += sources[i].used ? 1 : 0;
+    }
+    return n;
+}
+
+void mouse_merge_set_scale(mouse_class_t cls, int32_t percent) {
+    if (cls < MOUSE_CLASS_COUNT && percent > 0) {
+        class_scale[cls] = percent;
+    }
+}
+
+int32_t mouse_merge_get_scale(mouse_class_t cls) {
+    return scale_for(cls);
+}
+
+void mouse_merge_set_normalise(bool enabled) {
+    normalise = enabled;
+}
+
+bool mouse_merge_get_normalise(void) {
+    return normalise;
+}
+
+void mouse_merge_set_target_cps(int32_t cps) {
+    if (cps > 0) {
+        target_cps = cps;
+    }
+}
+
+int32_t mouse_merge_get_target_cps(void) {
+    return target_cps;
+}
+
+bool mouse_merge_source_info(int slot, mouse_merge_info_t* info) {
+    if (slot < 0 || slot >= MOUSE_MERGE_SOURCES || !sources[slot].used) {
+        return false;
+    }
+    const merge_source_t* s = &sources[slot];
+    info->id = s->id;
+    info->cls = s->cls;
+    info->calibrated = s->calibrated;
+    info->samples = s->samples;
+    info->median_cps = s->median_cps;
+    info->report_hz = s->move_us ? (uint32_t)(((uint64_t)s->move_reports * 1000000u) / s->move_us) : 0;
+    info->norm = norm_for(s);
+    return true;
+}
@@ -0,0 +1,138 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "oled_text.h"
+#include "mount_splash.h"
+#include <string.h>
+
+typedef struct {
+    uint8_t x;
+    uint8_t y;
+    uint8_t cols;                       // Cells on screen
+    char    cells[OLED_TEXT_COLS];      // 0 past the end of the string
+} text_line_t;
+
+typedef struct {
+    uint8_t     count;
+    text_line_t lines[OLED_TEXT_LINES];
+} text_frame_t;
+
+static ssd1306_t* disp_p;
+static text_frame_t shown;              // What the framebuffer holds
+static text_frame_t next;               // Page being composed
+static bool shown_valid;
+static uint32_t shown_clears;           // disp_p->clears when shown was drawn
+
+void oled_text_begin(ssd1306_t* p) {
+    disp_p = p;
+    next.count = 0;
+}
+
+void oled_text_draw(uint8_t x, uint8_t y, const char* s) {
+    if (next.count >= OLED_TEXT_LINES) {
+        return;
+    }
+    text_line_t* line = &next.lines[next.count++];
+    uint32_t cols = (x < disp_p->width) ? (disp_p->width - x + OLED_TEXT_CELL_W - 1) / OLED_TEXT_CELL_W : 0;
+
+    line->x = x;
+    line->y = y;
+    line->cols = (uint8_t)(cols < OLED_TEXT_COLS ? cols : OLED_TEXT_COLS);
+    memset(line->cells, 0, sizeof(line->cells));
+    for (int i = 0; i < line->cols && s[i]; ++i) {
+        line->cells[i] = s[i];
+    }
+}
+
+void oled_text_invalidate(void) {
+    shown_valid = false;
+}
+
+static bool same_layout(const text_frame_t* a, const text_frame_t* b) {
+    if (a->count != b->count) {
+        return false;
+    }
+    for (int i = 0; i < a->count; ++i) {
+        if (a->lines[i].x != b->lines[i].x || a->lines[i].y != b->lines[i].y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Clearing a cell of one line would wipe part of the other
+static bool lines_overlap(const text_frame_t* f) {
+    for (int i = 0; i < f->count; ++i) {
+        const text_line_t* a = &f->lines[i];
+        for (int j = i + 1; j < f->count; ++j) {
+            const text_line_t* b = &f->lines[j];
+            int dy = (int)a->y - (int)b->y;
+            if (dy <= -OLED_TEXT_CELL_H || dy >= OLED_TEXT_CELL_H) {
+                continue;
+            }
+            if (a->x < b->x + b->cols * OLED_TEXT_CELL_W && b->x < a->x + a->cols * OLED_TEXT_CELL_W) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void draw_cell(const text_line_t* line, int col) {
+    if (line->cells[col]) {
+        ssd1306_draw_char(disp_p, line->x + col * OLED_TEXT_CELL_W, line->y, 1, line->cells[col]);
+    }
+}
+
+bool oled_text_end(void) {
+    if (mount_splash_blocks_oled()) {
+        // Draws are being dropped, so the framebuffer will not match
+        shown_valid = false;
+        return false;
+    }
+
+    bool changed = false;
+    if (!shown_valid || disp_p->clears != shown_clears ||
+        !same_layout(&shown, &next) || lines_overlap(&next)) {
+        ssd1306_clear(disp_p);
+        for (int i = 0; i < next.count; ++i) {
+            for (int col = 0; col < next.lines[i].cols; ++col) {
+                draw_cell(&next.lines[i], col);
+            }
+        }
+        shown_clears = disp_p->clears;
+        changed = true;
+    } else {
+        for (int i = 0; i < next.count; ++i) {
+            const text_line_t* line = &next.lines[i];
+            for (int col = 0; col < line->cols; ++col) {
+                if (line->cells[col] == shown.lines[i].cells[col]) {
+                    continue;
+                }
+                ssd1306_clear_square(disp_p, line->x + col * OLED_TEXT_CELL_W, line->y,
+                                     OLED_TEXT_CELL_W, OLED_TEXT_CELL_H);
+                draw_cell(line, col);
+                changed = true;
+            }
+        }
+    }
+
+    shown = next;
+    shown_valid = true;
+    return changed;
+}
@@ -0,0 +1,266 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "pad_keymap.h"
+#include "config.h"
+#include <string.h>
+
+// Bit indices of the PAD_BTN_* flags
+enum {
+    BTN_SOUTH, BTN_EAST, BTN_WEST, BTN_NORTH, BTN_L1, BTN_R1, BTN_L2, BTN_R2,
+    BTN_SELECT, BTN_START, BTN_L3, BTN_R3, BTN_HOME
+};
+
+// ST scancodes used by the built-in profiles
+#define ST_KEY_ESC      0x01
+#define ST_KEY_Y        0x15
+#define ST_KEY_RETURN   0x1C
+#define ST_KEY_N        0x31
+#define ST_KEY_SPACE    0x39
+#define ST_KEY_F1       0x3B
+#define ST_KEY_F9       0x43
+#define ST_KEY_F10      0x44
+
+static const char* const button_names[PAD_BTN_COUNT] = {
+    "south", "east", "west", "north", "l1", "r1", "l2", "r2",
+    "select", "start", "l3", "r3", "home"
+};
+
+// South, east and R2 are fire on most pads, so the built-in profiles leave
+// them alone
+static const pad_keymap_binding_t menus_rows[] = {
+    { BTN_START,  ST_KEY_RETURN },
+    { BTN_SELECT, ST_KEY_ESC },
+    { BTN_NORTH,  ST_KEY_SPACE },
+    { BTN_L1,     ST_KEY_Y },
+    { BTN_R1,     ST_KEY_N },
+};
+
+static const pad_keymap_binding_t fkeys_rows[] = {
+    { BTN_L1,     ST_KEY_F1 },
+    { BTN_R1,     ST_KEY_F1 + 1 },
+    { BTN_L2,     ST_KEY_F1 + 2 },
+    { BTN_L3,     ST_KEY_F1 + 3 },
+    { BTN_R3,     ST_KEY_F1 + 4 },
+    { BTN_SELECT, ST_KEY_F9 },
+    { BTN_START,  ST_KEY_F10 },
+};
+
+static pad_keymap_binding_t custom_rows[PAD_KEYMAP_CUSTOM_MAX];
+static int custom_count;
+
+static const char* const profile_names[PAD_KEYMAP_PROFILE_COUNT] = {
+    "off", "menus", "fkeys", "custom"
+};
+
+// Flattened active profile: keys pressed by each button, in press order
+static uint8_t key_table[PAD_BTN_COUNT][PAD_KEYMAP_KEYS_PER_BUTTON];
+static uint8_t key_count[PAD_BTN_COUNT];
+static uint32_t bound_mask;
+
+static int profile = PAD_KEYMAP_DEFAULT_PROFILE;
+static bool table_stale = true;             // Profile selected or edited since the last update
+static uint32_t prev_buttons;
+static uint8_t key_refs[128];               // Held buttons per key
+
+static const pad_keymap_binding_t* profile_rows(int p, int* count) {
+    switch (p) {
+        case PAD_KEYMAP_MENUS:
+            *count = (int)(sizeof(menus_rows) / sizeof(menus_rows[0]));
+            return menus_rows;
+        case PAD_KEYMAP_FKEYS:
+            *count = (int)(sizeof(fkeys_rows) / sizeof(fkeys_rows[0]));
+            return fkeys_rows;
+        case PAD_KEYMAP_CUSTOM:
+            *count = custom_count;
+            return custom_rows;
+        default:
+            *count = 0;
+            return NULL;
+    }
+}
+
+static void build_table(void) {
+    int count;
+    const pad_keymap_binding_t* rows = profile_rows(profile, &count);
+
+    memset(key_count, 0, sizeof(key_count));
+    bound_mask = 0;
+    for (int i = 0; i < count; ++i) {
+        uint8_t b = rows[i].button;
+        if (b < PAD_BTN_COUNT && key_count[b] < PAD_KEYMAP_KEYS_PER_BUTTON) {
+            key_table[b][key_count[b]++] = rows[i].key;
+            bound_mask |= 1u << b;
+        }
+    }
+}
+
+static int release_all(pad_key_edge_t* edges) {
+    int n = 0;
+    for (int key = 0; key < 128; ++key) {
+        if (key_refs[key]) {
+            key_refs[key] = 0;
+            edges[n].key = (uint8_t)key;
+            edges[n].down = false;
+            ++n;
+        }
+    }
+    return n;
+}
+
+void pad_keymap_set_profile(int p) {
+    if (p >= 0 && p < PAD_KEYMAP_PROFILE_COUNT) {
+        profile = p;
+        table_stale = true;
+    }
+}
+
+int pad_keymap_get_profile(void) {
+    return profile;
+}
+
+const char* pad_keymap_profile_name(int p) {
+    return (p >= 0 && p < PAD_KEYMAP_PROFILE_COUNT) ? profile_names[p] : "?";
+}
+
+int pad_keymap_binding_count(int p) {
+    int count;
+    profile_rows(p, &count);
+    return count;
+}
+
+bool pad_keymap_binding(int p, int idx, pad_keymap_binding_t* binding) {
+    int count;
+    const pad_keymap_binding_t* rows = profile_rows(p, &count);
+    if (idx < 0 || idx >= count) {
+        return false;
+    }
+    *binding = rows[idx];
+    return true;
+}
+
+bool pad_keymap_custom_bind(uint8_t button, uint8_t key) {
+    if (button >= PAD_BTN_COUNT || key >= 128) {
+        return false;
+    }
+    if (key == 0) {
+        int out = 0;
+        for (int i = 0; i < custom_count; ++i) {
+            if (custom_rows[i].button != button) {
+                custom_rows[out++] = custom_rows[i];
+            }
+        }
+        custom_count = out;
+    } else {
+        int per_button = 0;
+        for (int i = 0; i < custom_count; ++i) {
+            per_button += (custom_rows[i].button == button) ? 1 : 0;
+        }
+        if (custom_count >= PAD_KEYMAP_CUSTOM_MAX || per_button >= PAD_KEYMAP_KEYS_PER_BUTTON) {
+            return false;
+        }
+        custom_rows[custom_count].button = button;
+        custom_rows[custom_count].key = key;
+        ++custom_count;
+    }
+    table_stale = true;
+    return true;
+}
+
+void pad_keymap_custom_clear(void) {
+    custom_count = 0;
+    table_stale = true;
+}
+
+void pad_keymap_custom_export(uint16_t rows[PAD_KEYMAP_CUSTOM_MAX]) {
+    for (int i = 0; i < PAD_KEYMAP_CUSTOM_MAX; ++i) {
+        rows[i] = (i < custom_count)
+            ? (uint16_t)((custom_rows[i].button << 8) | custom_rows[i].key) : 0;
+    }
+}
+
+void pad_keymap_custom_import(const uint16_t rows[PAD_KEYMAP_CUSTOM_MAX]) {
+    custom_count = 0;
+    for (int i = 0; i < PAD_KEYMAP_CUSTOM_MAX; ++i) {
+        if (rows[i] != 0) {
+            pad_keymap_custom_bind((uint8_t)(rows[i] >> 8), (uint8_t)(rows[i] & 0xFF));
+        }
+    }
+    table_stale = true;
+}
+
+const char* pad_keymap_button_name(int button) {
+    return (button >= 0 && button < PAD_BTN_COUNT) ? button_names[button] : "?";
+}
+
+int pad_keymap_button_find(const char* name) {
+    for (int i = 0; i < PAD_BTN_COUNT; ++i) {
+        if (strcmp(button_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int pad_keymap_update(uint32_t buttons, pad_key_edge_t* edges) {
+    int n = 0;
+
+    if (table_stale) {
+        // Release under the old table, then let held buttons press afresh
+        table_stale = false;
+        n = release_all(edges);
+        build_table();
+        prev_buttons = 0;
+    }
+
+    buttons &= bound_mask;
+    uint32_t changed = buttons ^ prev_buttons;
+    prev_buttons = buttons;
+
+    while (changed) {
+        int b = __builtin_ctz(changed);
+        changed &= changed - 1;
+
+        if (buttons & (1u << b)) {
+            // Modifier first
+            for (int i = 0; i < key_count[b]; ++i) {
+                uint8_t key = key_table[b][i];
+                if (key_refs[key]++ == 0) {
+                    edges[n].key = key;
+                    edges[n].down = true;
+                    ++n;
+                }
+            }
+        } else {
+            for (int i = key_count[b] - 1; i >= 0; --i) {
+                uint8_t key = key_table[b][i];
+                if (key_refs[key] && --key_refs[key] == 0) {
+                    edges[n].key = key;
+                    edges[n].down = false;
+                    ++n;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+void pad_keymap_reset(void) {
+    memset(key_refs, 0, sizeof(key_refs));
+    prev_buttons = 0;
+}
@@ -9,6 +9,7 @@
 #include "ps3_controller.h"
 #include "mount_splash.h"
 #include "usb_device_map.h"
+#include "pad_keymap.h"
 #include "config.h"
 #include "tusb.h"
 #include "ssd1306.h"
@@ -100,10 +101,6 @@ bool ps3_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t len) {
         }
     }
     
-    // Store raw report
-    ctrl->raw_len = len < sizeof(ctrl->raw_report) ? len : sizeof(ctrl->raw_report);
-    memcpy(ctrl->raw_report, report, ctrl->raw_len);
-    
     if (first_report_ever) {
         first_report_ever = false;
         printf("PS3: First report received (%d bytes)\n", len);
@@ -366,6 +363,39 @@ uint8_t ps3_connected_count(void) {
     return count;
 }
 
+bool ps3_right_stick(int8_t* x, int8_t* y) {
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            *x = (int8_t)(controllers[i].report.rx - 128);
+            *y = (int8_t)(controllers[i].report.ry - 128);
+            return true;
+        }
+    }
+    return false;
+}
+
+// buttons[0]: Select L3 R3 Start; buttons[2]: L2 R2 L1 R1 Triangle Circle X Square
+bool ps3_pad_buttons(uint32_t* buttons) {
+    static const uint16_t sys[4] = { PAD_BTN_SELECT, PAD_BTN_L3, PAD_BTN_R3, PAD_BTN_START };
+    static const uint16_t face[8] = { PAD_BTN_L2, PAD_BTN_R2, PAD_BTN_L1, PAD_BTN_R1,
+                                      PAD_BTN_NORTH, PAD_BTN_EAST, PAD_BTN_SOUTH, PAD_BTN_WEST };
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            const ps3_report_t* r = &controllers[i].report;
+            uint32_t mask = 0;
+            for (int b = 0; b < 4; b++) {
+                if (r->buttons[0] & (1 << b)) mask |= sys[b];
+            }
+            for (int b = 0; b < 8; b++) {
+                if (r->buttons[2] & (1 << b)) mask |= face[b];
+            }
+            *buttons = mask;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool ps3_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                         uint8_t* joy0_axis, uint8_t* joy0_fire) {
     for (uint8_t i = 0; i < controller_count; i++) {
@@ -9,6 +9,7 @@
 #include "ps4_controller.h"
 #include "mount_splash.h"
 #include "usb_device_map.h"
+#include "pad_keymap.h"
 #include "tusb.h"
 #include "ssd1306.h"
 #include <stdio.h>
@@ -291,6 +292,34 @@ uint8_t ps4_connected_count(void) {
     return count;
 }
 
+bool ps4_right_stick(int8_t* x, int8_t* y) {
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            *x = (int8_t)(controllers[i].report.z - 128);
+            *y = (int8_t)(controllers[i].report.rz - 128);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ps4_pad_buttons(uint32_t* buttons) {
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            const ps4_report_t* r = &controllers[i].report;
+            *buttons = (r->cross ? PAD_BTN_SOUTH : 0) | (r->circle ? PAD_BTN_EAST : 0) |
+                       (r->square ? PAD_BTN_WEST : 0) | (r->triangle ? PAD_BTN_NORTH : 0) |
+                       (r->l1 ? PAD_BTN_L1 : 0) | (r->r1 ? PAD_BTN_R1 : 0) |
+                       (r->l2 ? PAD_BTN_L2 : 0) | (r->r2 ? PAD_BTN_R2 : 0) |
+                       (r->share ? PAD_BTN_SELECT : 0) | (r->options ? PAD_BTN_START : 0) |
+                       (r->l3 ? PAD_BTN_L3 : 0) | (r->r3 ? PAD_BTN_R3 : 0) |
+                       (r->ps ? PAD_BTN_HOME : 0);
+            return true;
+        }
+    }
+    return false;
+}
+
 bool ps4_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                         uint8_t* joy0_axis, uint8_t* joy0_fire) {
     for (uint8_t i = 0; i < controller_count; i++) {
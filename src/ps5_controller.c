@@ -10,6 +10,7 @@
 #include "ps5_controller.h"
 #include "mount_splash.h"
 #include "usb_device_map.h"
+#include "pad_keymap.h"
 #include "config.h"
 #include "tusb.h"
 #include "ssd1306.h"
@@ -183,6 +184,39 @@ uint8_t ps5_connected_count(void) {
     return count;
 }
 
+bool ps5_right_stick(int8_t* x, int8_t* y) {
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            *x = (int8_t)(controllers[i].report.rx - 128);
+            *y = (int8_t)(controllers[i].report.ry - 128);
+            return true;
+        }
+    }
+    return false;
+}
+
+// buttons[0] high nibble: Square Cross Circle Triangle; buttons[1]: L1 R1 L2 R2 Share Options L3 R3
+bool ps5_pad_buttons(uint32_t* buttons) {
+    static const uint16_t face[4] = { PAD_BTN_WEST, PAD_BTN_SOUTH, PAD_BTN_EAST, PAD_BTN_NORTH };
+    static const uint16_t misc[8] = { PAD_BTN_L1, PAD_BTN_R1, PAD_BTN_L2, PAD_BTN_R2,
+                                      PAD_BTN_SELECT, PAD_BTN_START, PAD_BTN_L3, PAD_BTN_R3 };
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            const ps5_report_mini_t* r = &controllers[i].report;
+            uint32_t mask = 0;
+            for (int b = 0; b < 4; b++) {
+                if (r->buttons[0] & (0x10 << b)) mask |= face[b];
+            }
+            for (int b = 0; b < 8; b++) {
+                if (r->buttons[1] & (1 << b)) mask |= misc[b];
+            }
+            *buttons = mask;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool ps5_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                         uint8_t* joy0_axis, uint8_t* joy0_fire) {
     for (uint8_t i = 0; i < controller_count; i++) {
@@ -11,6 +11,7 @@
 #include "psc_controller.h"
 #include "mount_splash.h"
 #include "usb_device_map.h"
+#include "pad_keymap.h"
 #include "config.h"
 #include "tusb.h"
 #include "ssd1306.h"
@@ -116,6 +117,20 @@ uint8_t psc_connected_count(void) {
     return n;
 }
 
+bool psc_pad_buttons(uint32_t* buttons) {
+    for (uint8_t i = 0; i < controller_count; i++) {
+        if (controllers[i].connected) {
+            const psc_controller_t* c = &controllers[i];
+            *buttons = (c->cross ? PAD_BTN_SOUTH : 0) | (c->circle ? PAD_BTN_EAST : 0) |
+                       (c->square ? PAD_BTN_WEST : 0) | (c->triangle ? PAD_BTN_NORTH : 0) |
+                       (c->l1 ? PAD_BTN_L1 : 0) | (c->r1 ? PAD_BTN_R1 : 0) |
+                       (c->l2 ? PAD_BTN_L2 : 0) | (c->r2 ? PAD_BTN_R2 : 0);
+            return true;
+        }
+    }
+    return false;
+}
+
 void psc_mount_cb(uint8_t dev_addr) {
 #if ENABLE_SERIAL_LOGGING
     printf("PSC: PlayStation Classic controller detected (addr=%d)\n", dev_addr);
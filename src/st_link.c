@@ -0,0 +1,70 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "st_link.h"
+#include "hardware/regs/uart.h"
+#include "config.h"
+#include "telemetry.h"
+
+st_link_rx_t st_link_decode(uint32_t dr) {
+    if (dr & UART_UARTDR_OE_BITS) {
+        tm_inc(TM_UART_OVERRUN);    // A byte before this one was lost; this one is good
+    }
+    if (dr & UART_UARTDR_BE_BITS) {
+        tm_inc(TM_UART_BREAK);
+        return ST_LINK_RX_BREAK;
+    }
+    if (dr & UART_UARTDR_FE_BITS) {
+        tm_inc(TM_UART_FRAMING);
+        return ST_LINK_RX_ERROR;
+    }
+    if (dr & UART_UARTDR_PE_BITS) {
+        tm_inc(TM_UART_PARITY);
+        return ST_LINK_RX_ERROR;
+    }
+    return ST_LINK_RX_BYTE;
+}
+
+bool st_link_poll(st_link_t* link, bool rx_low, uint32_t rx_count, bool break_seen, uint32_t now_us) {
+    if (rx_count != link->rx_count) {
+        link->rx_count = rx_count;
+        link->line_low = false;     // The line went high since the last sample
+    }
+
+    if (!rx_low) {
+        link->line_low = false;
+    } else if (!link->line_low) {
+        link->line_low = true;
+        link->low_since = now_us;
+    } else if (!link->down && (now_us - link->low_since) >= ST_LINK_LOW_US) {
+        link->down = true;          // ST powered down or unplugged
+    }
+
+    if (break_seen) {
+        link->down = true;
+    }
+
+    // Re-sync once the line idles high again, so the 6301 starts clean when
+    // the ST is back rather than in the middle of whatever it was doing
+    if (link->down && !rx_low) {
+        link->down = false;
+        tm_inc(TM_ST_LINK_RESYNC);
+        return true;
+    }
+    return false;
+}
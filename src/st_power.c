@@ -0,0 +1,104 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "st_power.h"
+#include "config.h"
+#include "telemetry.h"
+
+static st_power_state_t state = ST_POWER_ON;
+static bool     enabled = ST_IDLE_DEFAULT;
+static bool     have_last;
+static uint32_t last_us;
+static uint32_t leaving_since;
+static uint64_t residency[ST_POWER_STATE_COUNT];
+static uint32_t idle_entries;
+
+st_power_action_t st_power_update(bool st_present, uint32_t now_us) {
+    if (have_last) {
+        residency[state] += (uint32_t)(now_us - last_us);
+    }
+    have_last = true;
+    last_us = now_us;
+
+    if (!enabled) {
+        st_present = true;      // Leave or never enter idle
+    }
+
+    switch (state) {
+    case ST_POWER_ON:
+        if (!st_present) {
+            state = ST_POWER_LEAVING;
+            leaving_since = now_us;
+        }
+        break;
+    case ST_POWER_LEAVING:
+        if (st_present) {
+            state = ST_POWER_ON;
+        } else if ((uint32_t)(now_us - leaving_since) >= ST_IDLE_DELAY_US) {
+            state = ST_POWER_IDLE;
+            idle_entries++;
+            tm_inc(TM_ST_IDLE_ENTER);
+            return ST_POWER_ENTER_IDLE;
+        }
+        break;
+    case ST_POWER_IDLE:
+        if (st_present) {
+            state = ST_POWER_ON;
+            return ST_POWER_EXIT_IDLE;
+        }
+        break;
+    default:
+        state = ST_POWER_ON;
+        break;
+    }
+    return ST_POWER_NONE;
+}
+
+st_power_state_t st_power_state(void) {
+    return state;
+}
+
+bool st_power_idle(void) {
+    return state == ST_POWER_IDLE;
+}
+
+void st_power_set_enabled(bool on) {
+    enabled = on;
+}
+
+bool st_power_enabled(void) {
+    return enabled;
+}
+
+uint64_t st_power_residency_us(st_power_state_t s) {
+    return (s < ST_POWER_STATE_COUNT) ? residency[s] : 0;
+}
+
+uint32_t st_power_idle_entries(void) {
+    return idle_entries;
+}
+
+uint32_t st_power_estimate_ua(void) {
+    uint64_t active = residency[ST_POWER_ON] + residency[ST_POWER_LEAVING];
+    uint64_t idle = residency[ST_POWER_IDLE];
+    uint64_t total = active + idle;
+    if (total == 0) {
+        return ST_POWER_ACTIVE_UA;
+    }
+    return (uint32_t)((active * ST_POWER_ACTIVE_UA + idle * ST_POWER_IDLE_UA) / total);
+}
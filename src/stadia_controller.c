@@ -8,6 +8,7 @@
 #include "stadia_controller.h"
 #include "mount_splash.h"
 #include "usb_device_map.h"
+#include "pad_keymap.h"
 #include "tusb.h"
 #include "ssd1306.h"
 #include "config.h"
@@ -269,6 +270,40 @@ uint8_t stadia_connected_count(void) {
     return count;
 }
 
+static int16_t clamp_axis(int16_t v) {
+    return v < -128 ? -128 : (v > 127 ? 127 : v);
+}
+
+bool stadia_right_stick(int8_t* x, int8_t* y) {
+    for (uint8_t i = 0; i < MAX_STADIA_CONTROLLERS; i++) {
+        if (controllers[i].connected) {
+            *x = (int8_t)clamp_axis(controllers[i].stick_right_x);
+            *y = (int8_t)clamp_axis(controllers[i].stick_right_y);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool stadia_pad_buttons(uint32_t* buttons) {
+    for (uint8_t i = 0; i < MAX_STADIA_CONTROLLERS; i++) {
+        if (controllers[i].connected) {
+            uint16_t b = controllers[i].buttons;
+            // Shoulders, triggers, Select/Start, stick clicks and Home share the PAD_BTN bits
+            uint32_t mask = b & (PAD_BTN_L1 | PAD_BTN_R1 | PAD_BTN_L2 | PAD_BTN_R2 |
+                                 PAD_BTN_SELECT | PAD_BTN_START | PAD_BTN_L3 | PAD_BTN_R3 |
+                                 PAD_BTN_HOME);
+            if (b & STADIA_BTN_A) mask |= PAD_BTN_SOUTH;
+            if (b & STADIA_BTN_B) mask |= PAD_BTN_EAST;
+            if (b & STADIA_BTN_X) mask |= PAD_BTN_WEST;
+            if (b & STADIA_BTN_Y) mask |= PAD_BTN_NORTH;
+            *buttons = mask;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool stadia_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
                            uint8_t* joy0_axis, uint8_t* joy0_fire) {
     for (uint8_t i = 0; i < MAX_STADIA_CONTROLLERS; i++) {
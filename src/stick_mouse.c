@@ -0,0 +1,87 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "stick_mouse.h"
+#include "config.h"
+
+static stick_curve_t live_curve = {
+    STICK_MOUSE_DEAD_ZONE, STICK_MOUSE_EXPONENT, STICK_MOUSE_MAX_SPEED
+};
+static bool enabled;
+
+// Counts not yet emitted, Q16 times microseconds so no step truncates
+#define ACC_ONE ((int64_t)STICK_MOUSE_Q16_ONE * 1000000)
+static int64_t acc_x;
+static int64_t acc_y;
+
+stick_curve_t* stick_mouse_curve(void) {
+    return &live_curve;
+}
+
+bool stick_mouse_enabled(void) {
+    return enabled;
+}
+
+void stick_mouse_set_enabled(bool on) {
+    enabled = on;
+    stick_mouse_reset();
+}
+
+int64_t stick_curve_eval(const stick_curve_t* curve, int32_t v) {
+    int32_t mag = v < 0 ? -v : v;
+    int32_t dz = curve->dead_zone;
+    int32_t exp = curve->exponent;
+
+    if (mag > STICK_MOUSE_AXIS_MAX) mag = STICK_MOUSE_AXIS_MAX;
+    if (dz < 0) dz = 0;
+    if (dz >= STICK_MOUSE_AXIS_MAX) dz = STICK_MOUSE_AXIS_MAX - 1;
+    if (exp < 1) exp = 1;
+    if (exp > STICK_MOUSE_EXP_MAX) exp = STICK_MOUSE_EXP_MAX;
+    if (mag <= dz) {
+        return 0;
+    }
+
+    // Normalised deflection past the dead zone, Q16 in (0, 1]
+    int64_t t = ((int64_t)(mag - dz) * STICK_MOUSE_Q16_ONE) / (STICK_MOUSE_AXIS_MAX - dz);
+    int64_t shaped = t;
+    for (int32_t i = 1; i < exp; ++i) {
+        shaped = (shaped * t) >> 16;
+    }
+    int64_t speed = shaped * curve->max_speed;
+    return v < 0 ? -speed : speed;
+}
+
+// Whole counts out of the accumulator, truncating toward zero
+static int32_t take_counts(int64_t* acc) {
+    int64_t whole = *acc / ACC_ONE;
+    *acc -= whole * ACC_ONE;
+    return (int32_t)whole;
+}
+
+void stick_mouse_update(const stick_curve_t* curve, int32_t x, int32_t y,
+                        uint32_t elapsed_us, int32_t* dx, int32_t* dy) {
+    acc_x += stick_curve_eval(curve, x) * elapsed_us;
+    acc_y += stick_curve_eval(curve, y) * elapsed_us;
+    *dx = take_counts(&acc_x);
+    *dy = take_counts(&acc_y);
+}
+
+void stick_mouse_reset(void) {
+    acc_x = 0;
+    acc_y = 0;
+}
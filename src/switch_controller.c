@@ -9,6 +9,8 @@
 #include "switch_controller.h"
 #include "mount_splash.h"
 #include "usb_device_map.h"
+#include "pad_keymap.h"
+#include "telemetry.h"
 #include "tusb.h"
 #include "ssd1306.h"
 #include "config.h"
@@ -39,7 +41,6 @@ static bool pro_needs_init = false;
 static uint8_t pro_dev_addr = 0;
 static uint32_t pro_mount_time = 0;
 static bool pro_init_attempted = false;
-static uint8_t global_count = 0; // Packet counter for subcommands
 static uint16_t pro_report_len_before = 0;
 static uint16_t pro_report_len_after = 0;
 static bool pro_init_complete = false;
@@ -49,6 +50,30 @@ static uint8_t init_cmd_success = 0;  // Bitmask: bits 0-6 for each of 7 command
 
 #define PRO_INIT_DELAY_MS 1000  // Wait 1 second after mount before initializing
 
+// Pro Controller USB handshake (BetterJoy sequence). 0x80 commands are
+// answered with 0x81 <cmd>, subcommands with a 0x21 report carrying the
+// subcommand ID in byte 14. 0x80 0x04 has no reply; the step completes when
+// the reply timeout expires after the OUT transfer.
+enum { HS_USB, HS_SUB };
+
+typedef struct {
+    uint8_t kind;           // HS_USB or HS_SUB
+    uint8_t id;             // 0x80 command or subcommand ID
+    uint8_t arg;            // Subcommand argument
+    bool    reply;          // A reply report is expected
+} hs_step_t;
+
+static const hs_step_t hs_script[] = {
+    { HS_USB, 0x02, 0x00, true  },  // Handshake
+    { HS_USB, 0x03, 0x00, true  },  // 3 Mbit baud rate
+    { HS_USB, 0x02, 0x00, true  },  // Handshake at the new baud rate
+    { HS_USB, 0x04, 0x00, false },  // USB only, prevent HID timeout
+    { HS_SUB, 0x40, 0x01, true  },  // Enable IMU
+    { HS_SUB, 0x48, 0x01, true  },  // Enable vibration
+    { HS_SUB, 0x03, 0x30, true  },  // Input report mode 0x30 (full)
+};
+#define HS_STEPS (sizeof(hs_script) / sizeof(hs_script[0]))
+
 void switch_get_debug_values(uint16_t* buttons, uint8_t* dpad, int16_t* lx, int16_t* ly,
                               uint8_t* atari_dir, uint8_t* atari_fire) {
     *buttons = last_buttons;
@@ -92,26 +117,6 @@ void switch_get_raw_bytes(uint8_t* bytes, uint16_t* len) {
     }
 }
 
-// Check and perform delayed Pro Controller initialization
-// This is called from the main loop, NOT from report processing
-void switch_check_delayed_init(void) {
-    if (!pro_needs_init || pro_init_attempted) {
-        return;  // Nothing to do
-    }
-    
-    uint32_t current_time = to_ms_since_boot(get_absolute_time());
-    uint32_t elapsed = current_time - pro_mount_time;
-    
-    if (elapsed >= PRO_INIT_DELAY_MS) {
-        pro_report_len_before = 7;  // Assume Simple HID mode (7 bytes)
-        pro_init_attempted = true;
-        pro_needs_init = false;  // Don't try again
-        
-        // Now send initialization commands
-        switch_init_pro_controller(pro_dev_addr);
-    }
-}
-
 // Allocate a controller slot
 static switch_controller_t* allocate_controller(uint8_t dev_addr) {
     for (int i = 0; i < MAX_SWITCH_CONTROLLERS; i++) {
@@ -173,6 +178,89 @@ switch_controller_t* switch_get_controller(uint8_t dev_addr) {
     return NULL;
 }
 
+static void handshake_next(switch_controller_t* ctrl, bool ok);
+
+// Queue the current handshake step. Leaves the state at SEND if the OUT
+// pipe is busy; switch_check_delayed_init() tries again on every pass until
+// hs_deadline_ms, then gives up on the step. A busy pipe is not a lost
+// reply, so it does not use up the step's retries.
+static void handshake_send(switch_controller_t* ctrl) {
+    const hs_step_t* step = &hs_script[ctrl->hs_step];
+    uint8_t buf[12];
+    uint16_t len;
+    
+    if (step->kind == HS_USB) {
+        buf[0] = 0x80;
+        buf[1] = step->id;
+        len = 2;
+    } else {
+        // [0x01][counter][rumble 8 bytes][subcommand][argument]
+        static const uint8_t neutral_rumble[8] = { 0x00, 0x01, 0x40, 0x40, 0x00, 0x01, 0x40, 0x40 };
+        buf[0] = 0x01;
+        buf[1] = ctrl->hs_counter;
+        memcpy(&buf[2], neutral_rumble, sizeof(neutral_rumble));
+        buf[10] = step->id;
+        buf[11] = step->arg;
+        len = 12;
+    }
+    
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    if (!tuh_hid_send_report(ctrl->dev_addr, ctrl->instance, 0, buf, len)) {
+        if ((int32_t)(now - ctrl->hs_deadline_ms) >= 0) {
+            tm_inc(TM_SWITCH_HS_BUSY);
+            handshake_next(ctrl, false);
+        }
+        return;
+    }
+    
+#if ENABLE_SWITCH_DEBUG
+    printf("Switch: Handshake step %d (%s 0x%02X) sent\n", ctrl->hs_step,
+           step->kind == HS_USB ? "cmd" : "subcmd", step->id);
+#endif
+    if (step->kind == HS_SUB) {
+        ctrl->hs_counter = (ctrl->hs_counter + 1) & 0x0F;
+    }
+    ctrl->hs_tries++;
+    ctrl->hs_state = SWITCH_HS_SENT;
+    ctrl->hs_deadline_ms = now + SWITCH_HS_REPLY_TIMEOUT_MS;
+}
+
+// (Re)send the current step, allowing the OUT pipe SWITCH_HS_REPLY_TIMEOUT_MS
+// to become free
+static void handshake_queue(switch_controller_t* ctrl) {
+    ctrl->hs_state = SWITCH_HS_SEND;
+    ctrl->hs_deadline_ms = to_ms_since_boot(get_absolute_time()) + SWITCH_HS_REPLY_TIMEOUT_MS;
+    handshake_send(ctrl);
+}
+
+// Current step answered (ok) or given up on; go on to the next one
+static void handshake_next(switch_controller_t* ctrl, bool ok) {
+    if (ok && ctrl->dev_addr == pro_dev_addr) {
+        init_cmd_success |= (uint8_t)(1u << ctrl->hs_step);
+    }
+    ctrl->hs_tries = 0;
+    if (++ctrl->hs_step >= HS_STEPS) {
+        ctrl->hs_state = SWITCH_HS_DONE;
+        // Keep this message - it's useful for users to know initialization completed
+        printf("Switch Pro Controller initialized (cmds: 0x%02X/0x7F)\n", init_cmd_success);
+        return;
+    }
+    handshake_queue(ctrl);
+}
+
+static void handshake_reply(switch_controller_t* ctrl, const uint8_t* report, uint16_t len) {
+    if (ctrl->hs_state != SWITCH_HS_SENT && ctrl->hs_state != SWITCH_HS_REPLY) {
+        return;
+    }
+    const hs_step_t* step = &hs_script[ctrl->hs_step];
+    bool match = (step->kind == HS_USB)
+        ? (len >= 2 && report[0] == 0x81 && report[1] == step->id)
+        : (len >= 15 && report[0] == 0x21 && report[14] == step->id);
+    if (match && step->reply) {
+        handshake_next(ctrl, true);
+    }
+}
+
 void switch_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t len) {
     if (!report || len == 0) return;
     
@@ -182,6 +270,13 @@ void switch_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t len
     // Increment global report counter
     global_report_count++;
     
+    if (ctrl->hs_state != SWITCH_HS_NONE) {
+        handshake_reply(ctrl, report, len);
+        if (report[0] == 0x81) {
+            return;  // 0x80 command reply, no input state
+        }
+    }
+    
     // Save report info for OLED display
     last_report_len = len;
     if (len >= 12) {
@@ -192,7 +287,8 @@ void switch_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t len
     }
     
     // Debug: Log report length after initialization completes
-    if (pro_init_attempted && !pro_init_complete) {
+    if (pro_init_attempted && !pro_init_complete &&
+        ctrl->hs_state == SWITCH_HS_DONE && ctrl->dev_addr == pro_dev_addr) {
         pro_report_len_after = len;
         pro_init_complete = true;
         
@@ -423,142 +519,81 @@ void switch_to_atari(const switch_controller_t* sw, uint8_t joystick_num,
     // Debug output removed - was causing performance issues with frequent logging
 }
 
-// USB handshake command structure (2 bytes sent as feature report)
-static bool send_usb_command(uint8_t dev_addr, uint8_t cmd) {
-    uint8_t buf[2] = {0x80, cmd};
-    
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Sending USB command 0x80 0x%02X...", cmd);
-#endif
-    
-    // Pump USB stack before sending to ensure previous transfer is complete
-    for (int i = 0; i < 10; i++) {
-        tuh_task();
-        sleep_ms(1);
+bool switch_init_pro_controller(uint8_t dev_addr) {
+    switch_controller_t* ctrl = switch_get_controller(dev_addr);
+    if (!ctrl) {
+        return false;
     }
     
-    // Send as an output report to endpoint 0
-    bool result = tuh_hid_send_report(dev_addr, 0, 0, buf, 2);
-    
 #if ENABLE_SWITCH_DEBUG
-    printf(" result=%d\n", result);
+    printf("Switch: Pro Controller USB handshake (addr=%d)\n", dev_addr);
 #endif
     
-    // Wait longer for controller to process and respond
-    // Pump USB stack while waiting
-    for (int i = 0; i < 150; i++) {
-        tuh_task();
-        sleep_ms(1);
+    if (dev_addr == pro_dev_addr) {
+        pro_needs_init = false;
+        pro_init_attempted = true;
+        pro_init_complete = false;
+        pro_report_len_before = 7;  // Assume Simple HID mode (7 bytes)
+        init_cmd_success = 0;
     }
-    return result;
+    
+    ctrl->hs_step = 0;
+    ctrl->hs_tries = 0;
+    ctrl->hs_counter = 0;
+    handshake_queue(ctrl);
+    return true;
 }
 
-// Send a subcommand to the Pro Controller
-// Format: [0x01][counter][rumble_data 8 bytes][subcommand][data...]
-static bool send_subcommand(uint8_t dev_addr, uint8_t subcmd, const uint8_t* data, uint8_t data_len) {
-    uint8_t buf[64] = {0};
-    
-    buf[0] = 0x01;           // Output report ID
-    buf[1] = global_count;   // Packet counter (0x00-0x0F)
-    
-    // Rumble data (8 bytes) - use neutral rumble
-    buf[2] = 0x00; buf[3] = 0x01; buf[4] = 0x40; buf[5] = 0x40;  // Left rumble
-    buf[6] = 0x00; buf[7] = 0x01; buf[8] = 0x40; buf[9] = 0x40;  // Right rumble
-    
-    buf[10] = subcmd;        // Subcommand ID
-    
-    // Copy subcommand data
-    if (data && data_len > 0) {
-        memcpy(&buf[11], data, data_len);
-    }
-    
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Sending subcommand 0x%02X (counter=%d, data_len=%d)...", subcmd, global_count, data_len);
-#endif
-    
-    // Increment counter (wraps at 0x0F)
-    global_count = (global_count + 1) & 0x0F;
-    
-    // Pump USB stack before sending to ensure previous transfer is complete
-    for (int i = 0; i < 10; i++) {
-        tuh_task();
-        sleep_ms(1);
-    }
-    
-    // Send as output report
-    bool result = tuh_hid_send_report(dev_addr, 0, 0, buf, 11 + data_len);
-    
-#if ENABLE_SWITCH_DEBUG
-    printf(" result=%d\n", result);
-#endif
-    
-    // Wait for controller to respond, pumping USB stack
-    for (int i = 0; i < 200; i++) {
-        tuh_task();
-        sleep_ms(1);
+void switch_report_sent(uint8_t dev_addr) {
+    switch_controller_t* ctrl = switch_get_controller(dev_addr);
+    if (ctrl && ctrl->hs_state == SWITCH_HS_SENT) {
+        // The reply timeout runs from here
+        ctrl->hs_state = SWITCH_HS_REPLY;
+        ctrl->hs_deadline_ms = to_ms_since_boot(get_absolute_time()) + SWITCH_HS_REPLY_TIMEOUT_MS;
     }
-    return result;
 }
 
-bool switch_init_pro_controller(uint8_t dev_addr) {
-#if ENABLE_SWITCH_DEBUG
-    printf("\n");
-    printf("═══════════════════════════════════════════════════════\n");
-    printf("  Switch Pro Controller USB Initialization (BetterJoy style)\n");
-    printf("═══════════════════════════════════════════════════════\n");
-#endif
-    
-    global_count = 0;
-    init_cmd_success = 0;  // Reset bitmask
-    
-    // Step 1: USB Handshaking sequence (BetterJoy EXACT sequence)
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Step 1 - USB Handshake 0x02\n");
-#endif
-    if (send_usb_command(dev_addr, 0x02)) init_cmd_success |= (1 << 0);
-    
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Step 2 - Set 3Mbit baud rate 0x03\n");
-#endif
-    if (send_usb_command(dev_addr, 0x03)) init_cmd_success |= (1 << 1);
-    
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Step 3 - Handshake at new baud rate 0x02\n");
-#endif
-    if (send_usb_command(dev_addr, 0x02)) init_cmd_success |= (1 << 2);
-    
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Step 4 - Prevent HID timeout 0x04\n");
-#endif
-    if (send_usb_command(dev_addr, 0x04)) init_cmd_success |= (1 << 3);
-    
-    sleep_ms(100);
-    
-    // Step 2: Enable IMU (subcommand 0x40)
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Step 5 - Enable IMU (subcommand 0x40)\n");
-#endif
-    uint8_t imu_enable = 0x01;
-    if (send_subcommand(dev_addr, 0x40, &imu_enable, 1)) init_cmd_success |= (1 << 4);
-    
-    // Step 3: Enable vibration (subcommand 0x48)
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Step 6 - Enable vibration (subcommand 0x48)\n");
-#endif
-    uint8_t vib_enable = 0x01;
-    if (send_subcommand(dev_addr, 0x48, &vib_enable, 1)) init_cmd_success |= (1 << 5);
-    
-    // Step 4: Set input report mode to 0x30 (FULL MODE - this is the critical one!)
-#if ENABLE_SWITCH_DEBUG
-    printf("Switch: Step 7 - Set input mode 0x30 (FULL MODE)\n");
-#endif
-    uint8_t input_mode = 0x30;
-    if (send_subcommand(dev_addr, 0x03, &input_mode, 1)) init_cmd_success |= (1 << 6);
-    
-    // Keep this message - it's useful for users to know initialization completed
-    printf("Switch Pro Controller initialized (cmds: 0x%02X/0x7F)\n", init_cmd_success);
+void switch_check_delayed_init(void) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
     
-    return true;
+    for (int i = 0; i < MAX_SWITCH_CONTROLLERS; i++) {
+        switch_controller_t* ctrl = &controllers[i];
+        if (!ctrl->connected) {
+            continue;
+        }
+        
+        switch (ctrl->hs_state) {
+            case SWITCH_HS_DELAY:
+                if ((int32_t)(now - ctrl->hs_deadline_ms) >= 0) {
+                    switch_init_pro_controller(ctrl->dev_addr);
+                }
+                break;
+            
+            case SWITCH_HS_SEND:
+                // OUT pipe was busy; hs_deadline_ms bounds the wait
+                handshake_send(ctrl);
+                break;
+            
+            case SWITCH_HS_SENT:
+            case SWITCH_HS_REPLY:
+                if ((int32_t)(now - ctrl->hs_deadline_ms) < 0) {
+                    break;
+                }
+                if (ctrl->hs_state == SWITCH_HS_REPLY && !hs_script[ctrl->hs_step].reply) {
+                    handshake_next(ctrl, true);
+                } else if (ctrl->hs_tries <= SWITCH_HS_RETRIES) {
+                    // Command or reply lost: send the step again
+                    tm_inc(TM_SWITCH_HS_RETRY);
+                    handshake_queue(ctrl);
+                } else {
+                    handshake_next(ctrl, false);
+                }
+                break;
+            
+            default:
+                break;
+        }
+    }
 }
 
 void switch_mount_cb(uint8_t dev_addr) {
@@ -604,7 +639,8 @@ void switch_mount_cb(uint8_t dev_addr) {
             pro_mount_time = to_ms_since_boot(get_absolute_time());
             pro_init_attempted = false;
             pro_init_complete = false;
-            global_count = 0;
+            ctrl->hs_state = SWITCH_HS_DELAY;
+            ctrl->hs_deadline_ms = pro_mount_time + PRO_INIT_DELAY_MS;
         }
     } else {
         printf("Switch: ERROR - Failed to allocate controller!\n");
@@ -655,6 +691,44 @@ bool switch_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
     return false;
 }
 
+static int16_t clamp_axis(int16_t v) {
+    return v < -128 ? -128 : (v > 127 ? 127 : v);
+}
+
+bool switch_right_stick(int8_t* x, int8_t* y) {
+    for (uint8_t i = 0; i < MAX_SWITCH_CONTROLLERS; i++) {
+        if (controllers[i].connected) {
+            *x = (int8_t)clamp_axis(controllers[i].stick_right_x);
+            *y = (int8_t)clamp_axis(controllers[i].stick_right_y);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool switch_pad_buttons(uint32_t* buttons) {
+    static const struct { uint16_t sw; uint16_t pad; } map[] = {
+        { SWITCH_BTN_B, PAD_BTN_SOUTH },  { SWITCH_BTN_A, PAD_BTN_EAST },
+        { SWITCH_BTN_Y, PAD_BTN_WEST },   { SWITCH_BTN_X, PAD_BTN_NORTH },
+        { SWITCH_BTN_L, PAD_BTN_L1 },     { SWITCH_BTN_R, PAD_BTN_R1 },
+        { SWITCH_BTN_ZL, PAD_BTN_L2 },    { SWITCH_BTN_ZR, PAD_BTN_R2 },
+        { SWITCH_BTN_MINUS, PAD_BTN_SELECT }, { SWITCH_BTN_PLUS, PAD_BTN_START },
+        { SWITCH_BTN_LSTICK, PAD_BTN_L3 }, { SWITCH_BTN_RSTICK, PAD_BTN_R3 },
+        { SWITCH_BTN_HOME, PAD_BTN_HOME },
+    };
+    for (uint8_t i = 0; i < MAX_SWITCH_CONTROLLERS; i++) {
+        if (controllers[i].connected) {
+            uint32_t mask = 0;
+            for (size_t b = 0; b < sizeof(map) / sizeof(map[0]); b++) {
+                if (controllers[i].buttons & map[b].sw) mask |= map[b].pad;
+            }
+            *buttons = mask;
+            return true;
+        }
+    }
+    return false;
+}
+
 void switch_set_deadzone(uint8_t dev_addr, int16_t deadzone) {
     switch_controller_t* ctrl = switch_get_controller(dev_addr);
     if (ctrl) {
@@ -0,0 +1,69 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "sys_clock.h"
+#include "SerialPort.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/uart.h"
+
+static uint32_t active_khz;     // 0 until first set: whatever main() booted with
+static bool     idle;
+
+// clk_peri follows clk_sys: recompute both UART dividers
+static void reclock_uarts() {
+    uart_set_baudrate(uart0, 115200);
+    SerialPort::instance().reclock();
+}
+
+static bool apply(uint32_t khz) {
+    if (!set_sys_clock_khz(khz, false)) {
+        return false;
+    }
+    reclock_uarts();
+    return true;
+}
+
+bool sys_clock_set_khz(uint32_t khz) {
+    uint vco, postdiv1, postdiv2;
+    if (!check_sys_clock_khz(khz, &vco, &postdiv1, &postdiv2)) {
+        return false;
+    }
+    if (!idle && !apply(khz)) {
+        return false;
+    }
+    active_khz = khz;
+    return true;
+}
+
+uint32_t sys_clock_get_khz(void) {
+    return active_khz ? active_khz : clock_get_hz(clk_sys) / 1000;
+}
+
+void sys_clock_enter_idle(uint32_t idle_khz) {
+    if (!active_khz) {
+        active_khz = clock_get_hz(clk_sys) / 1000;
+    }
+    idle = true;
+    apply(idle_khz);
+}
+
+void sys_clock_exit_idle(void) {
+    idle = false;
+    apply(active_khz);
+}
@@ -0,0 +1,328 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "telemetry.h"
+#include <stdio.h>
+#include <string.h>
+
+#if ENABLE_TELEMETRY
+
+#define TM_BINARY_VERSION 1
+
+tm_shard_t tm_shards[TELEMETRY_CORES];
+volatile uint32_t tm_gauges[TM_GAUGE_COUNT];
+
+// Values at the last telemetry_reset(), subtracted on read
+static uint32_t counter_base[TM_COUNTER_COUNT];
+static uint32_t hist_base[TM_HIST_COUNT][TELEMETRY_HIST_BUCKETS];
+
+#define TM_NAME(id, name) name,
+static const char* const counter_names[TM_COUNTER_COUNT] = { TELEMETRY_COUNTERS(TM_NAME) };
+static const char* const gauge_names[TM_GAUGE_COUNT] = { TELEMETRY_GAUGES(TM_NAME) };
+static const char* const minmax_names[TM_MINMAX_COUNT] = { TELEMETRY_MINMAX(TM_NAME) };
+static const char* const hist_names[TM_HIST_COUNT] = { TELEMETRY_HISTOGRAMS(TM_NAME) };
+#undef TM_NAME
+
+static void clear_ranges(void) {
+    for (int c = 0; c < TELEMETRY_CORES; c++) {
+        for (int i = 0; i < TM_MINMAX_COUNT; i++) {
+            tm_shards[c].range[i].min = UINT32_MAX;
+            tm_shards[c].range[i].max = 0;
+        }
+    }
+}
+
+static uint32_t raw_counter(int id) {
+    uint32_t sum = 0;
+    for (int c = 0; c < TELEMETRY_CORES; c++) {
+        sum += tm_shards[c].counter[id];
+    }
+    return sum;
+}
+
+static uint32_t raw_bucket(int id, int b) {
+    uint32_t sum = 0;
+    for (int c = 0; c < TELEMETRY_CORES; c++) {
+        sum += tm_shards[c].hist[id][b];
+    }
+    return sum;
+}
+
+void telemetry_init(void) {
+    memset(tm_shards, 0, sizeof(tm_shards));
+    memset(counter_base, 0, sizeof(counter_base));
+    memset(hist_base, 0, sizeof(hist_base));
+    clear_ranges();
+}
+
+uint32_t telemetry_counter(tm_counter_t id) {
+    return raw_counter(id) - counter_base[id];
+}
+
+uint32_t telemetry_gauge(tm_gauge_t id) {
+    return tm_gauges[id];
+}
+
+bool telemetry_range(tm_minmax_t id, uint32_t* min, uint32_t* max) {
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+    bool seen = false;
+    for (int c = 0; c < TELEMETRY_CORES; c++) {
+        tm_range_t r = { tm_shards[c].range[id].min, tm_shards[c].range[id].max };
+        if (r.min > r.max) {
+            continue;  // Nothing sampled on this core
+        }
+        seen = true;
+        if (r.min < lo) lo = r.min;
+        if (r.max > hi) hi = r.max;
+    }
+    *min = seen ? lo : 0;
+    *max = hi;
+    return seen;
+}
+
+void telemetry_histogram(tm_hist_t id, uint32_t buckets[TELEMETRY_HIST_BUCKETS]) {
+    for (int b = 0; b < TELEMETRY_HIST_BUCKETS; b++) {
+        buckets[b] = raw_bucket(id, b) - hist_base[id][b];
+    }
+}
+
+void telemetry_reset(void) {
+    for (int i = 0; i < TM_COUNTER_COUNT; i++) {
+        counter_base[i] = raw_counter(i);
+    }
+    for (int i = 0; i < TM_HIST_COUNT; i++) {
+        for (int b = 0; b < TELEMETRY_HIST_BUCKETS; b++) {
+            hist_base[i][b] = raw_bucket(i, b);
+        }
+    }
+    clear_ranges();
+}
+
+// Approximate percentile from log2 buckets: upper bound of the bucket holding it
+static uint32_t hist_percentile(const uint32_t* buckets, uint32_t total, uint32_t pct) {
+    uint32_t target = (total * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (int b = 0; b < TELEMETRY_HIST_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= target) {
+            return b ? (1u << b) - 1 : 0;
+        }
+    }
+    return UINT32_MAX;
+}
+
+int telemetry_line_count(void) {
+    return TM_COUNTER_COUNT + TM_GAUGE_COUNT + TM_MINMAX_COUNT + TM_HIST_COUNT;
+}
+
+bool telemetry_format_line(int idx, char* buf, size_t len) {
+    if (idx < 0) {
+        return false;
+    }
+    if (idx < TM_COUNTER_COUNT) {
+        snprintf(buf, len, "%-12s %lu", counter_names[idx],
+                 (unsigned long)telemetry_counter((tm_counter_t)idx));
+        return true;
+    }
+    idx -= TM_COUNTER_COUNT;
+    if (idx < TM_GAUGE_COUNT) {
+        snprintf(buf, len, "%-12s %lu", gauge_names[idx],
+                 (unsigned long)telemetry_gauge((tm_gauge_t)idx));
+        return true;
+    }
+    idx -= TM_GAUGE_COUNT;
+    if (idx < TM_MINMAX_COUNT) {
+        uint32_t lo, hi;
+        if (telemetry_range((tm_minmax_t)idx, &lo, &hi)) {
+            snprintf(buf, len, "%-12s %lu-%lu", minmax_names[idx],
+                     (unsigned long)lo, (unsigned long)hi);
+        } else {
+            snprintf(buf, len, "%-12s -", minmax_names[idx]);
+        }
+        return true;
+    }
+    idx -= TM_MINMAX_COUNT;
+    if (idx < TM_HIST_COUNT) {
+        uint32_t buckets[TELEMETRY_HIST_BUCKETS];
+        uint32_t total = 0;
+        telemetry_histogram((tm_hist_t)idx, buckets);
+        for (int b = 0; b < TELEMETRY_HIST_BUCKETS; b++) {
+            total += buckets[b];
+        }
+        if (total) {
+            snprintf(buf, len, "%-12s p99<%lu", hist_names[idx],
+                     (unsigned long)hist_percentile(buckets, total, 99));
+        } else {
+            snprintf(buf, len, "%-12s -", hist_names[idx]);
+        }
+        return true;
+    }
+    return false;
+}
+
+void telemetry_print_text(void) {
+    for (int i = 0; i < TM_COUNTER_COUNT; i++) {
+        printf("[TM] %-12s %lu\n", counter_names[i],
+               (unsigned long)telemetry_counter((tm_counter_t)i));
+    }
+    for (int i = 0; i < TM_GAUGE_COUNT; i++) {
+        printf("[TM] %-12s %lu\n", gauge_names[i],
+               (unsigned long)telemetry_gauge((tm_gauge_t)i));
+    }
+    for (int i = 0; i < TM_MINMAX_COUNT; i++) {
+        uint32_t lo, hi;
+        if (telemetry_range((tm_minmax_t)i, &lo, &hi)) {
+            printf("[TM] %-12s min=%lu max=%lu\n", minmax_names[i],
+                   (unsigned long)lo, (unsigned long)hi);
+        } else {
+            printf("[TM] %-12s (no samples)\n", minmax_names[i]);
+        }
+    }
+    for (int i = 0; i < TM_HIST_COUNT; i++) {
+        uint32_t buckets[TELEMETRY_HIST_BUCKETS];
+        telemetry_histogram((tm_hist_t)i, buckets);
+        printf("[TM] %-12s", hist_names[i]);
+        for (int b = 0; b < TELEMETRY_HIST_BUCKETS; b++) {
+            printf(" <%lu:%lu", b ? (1ul << b) : 1ul, (unsigned long)buckets[b]);
+        }
+        printf("\n");
+    }
+}
+
+void telemetry_print_changes(void) {
+    static uint32_t last_raw[TM_COUNTER_COUNT];
+    static uint32_t last_gauge[TM_GAUGE_COUNT];
+
+    for (int i = 0; i < TM_COUNTER_COUNT; i++) {
+        // The raw sums only ever go up, so the delta holds across a
+        // telemetry_reset(), which only moves the base
+        uint32_t raw = raw_counter(i);
+        uint32_t delta = raw - last_raw[i];
+        last_raw[i] = raw;
+        if (delta) {
+            printf("[TM] %-12s +%lu (%lu)\n", counter_names[i],
+                   (unsigned long)delta, (unsigned long)telemetry_counter((tm_counter_t)i));
+        }
+    }
+    for (int i = 0; i < TM_GAUGE_COUNT; i++) {
+        uint32_t now = telemetry_gauge((tm_gauge_t)i);
+        if (now != last_gauge[i]) {
+            last_gauge[i] = now;
+            printf("[TM] %-12s %lu\n", gauge_names[i], (unsigned long)now);
+        }
+    }
+}
+
+static void put_u32(void (*put)(uint8_t), uint8_t* sum, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        uint8_t b = (uint8_t)(v >> (8 * i));
+        *sum += b;
+        put(b);
+    }
+}
+
+void telemetry_write_binary(void (*put)(uint8_t byte)) {
+    uint16_t len = 4 * (TM_COUNTER_COUNT + TM_GAUGE_COUNT + 2 * TM_MINMAX_COUNT +
+                        TM_HIST_COUNT * TELEMETRY_HIST_BUCKETS);
+    uint8_t sum = 0;
+
+    put('T');
+    put('M');
+    sum += TM_BINARY_VERSION;
+    put(TM_BINARY_VERSION);
+    sum += (uint8_t)len;
+    put((uint8_t)len);
+    sum += (uint8_t)(len >> 8);
+    put((uint8_t)(len >> 8));
+
+    for (int i = 0; i < TM_COUNTER_COUNT; i++) {
+        put_u32(put, &sum, telemetry_counter((tm_counter_t)i));
+    }
+    for (int i = 0; i < TM_GAUGE_COUNT; i++) {
+        put_u32(put, &sum, telemetry_gauge((tm_gauge_t)i));
+    }
+    for (int i = 0; i < TM_MINMAX_COUNT; i++) {
+        uint32_t lo, hi;
+        telemetry_range((tm_minmax_t)i, &lo, &hi);
+        put_u32(put, &sum, lo);
+        put_u32(put, &sum, hi);
+    }
+    for (int i = 0; i < TM_HIST_COUNT; i++) {
+        uint32_t buckets[TELEMETRY_HIST_BUCKETS];
+        telemetry_histogram((tm_hist_t)i, buckets);
+        for (int b = 0; b < TELEMETRY_HIST_BUCKETS; b++) {
+            put_u32(put, &sum, buckets[b]);
+        }
+    }
+    put((uint8_t)(-sum));
+}
+
+#else /* !ENABLE_TELEMETRY */
+
+void telemetry_init(void) {
+}
+
+uint32_t telemetry_counter(tm_counter_t id) {
+    (void)id;
+    return 0;
+}
+
+uint32_t telemetry_gauge(tm_gauge_t id) {
+    (void)id;
+    return 0;
+}
+
+bool telemetry_range(tm_minmax_t id, uint32_t* min, uint32_t* max) {
+    (void)id;
+    *min = 0;
+    *max = 0;
+    return false;
+}
+
+void telemetry_histogram(tm_hist_t id, uint32_t buckets[TELEMETRY_HIST_BUCKETS]) {
+    (void)id;
+    memset(buckets, 0, TELEMETRY_HIST_BUCKETS * sizeof(uint32_t));
+}
+
+void telemetry_reset(void) {
+}
+
+int telemetry_line_count(void) {
+    return 0;
+}
+
+bool telemetry_format_line(int idx, char* buf, size_t len) {
+    (void)idx;
+    (void)buf;
+    (void)len;
+    return false;
+}
+
+void telemetry_print_text(void) {
+    printf("telemetry not built (ENABLE_TELEMETRY=0)\n");
+}
+
+void telemetry_print_changes(void) {
+}
+
+void telemetry_write_binary(void (*put)(uint8_t byte)) {
+    (void)put;
+}
+
+#endif /* ENABLE_TELEMETRY */
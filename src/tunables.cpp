@@ -0,0 +1,363 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "tunables.h"
+#include "config.h"
+#include "NVSettings.h"
+#include "UserInterface.h"
+#include "SerialPort.h"
+#include "6301.h"
+#include "mouse_merge.h"
+#include "stick_mouse.h"
+#include "st_power.h"
+#include "pad_keymap.h"
+#include "key_joystick.h"
+#include "joy_arbiter.h"
+#include "core1_link.h"
+#include "sys_clock.h"
+#include "pico/stdlib.h"
+#include <string.h>
+
+extern "C" {
+    void hid_request_ui_refresh(void);
+}
+
+#if ENABLE_BLUEPAD32
+#define CPU_CLOCK_DEFAULT_KHZ   BT_CPU_CLOCK_KHZ
+#else
+#define CPU_CLOCK_DEFAULT_KHZ   DEFAULT_CPU_CLOCK_KHZ
+#endif
+
+// Created by tunables_init(), not as a global: the constructor reads flash,
+// and on first boot writes it through flash_safe_execute(), which needs the
+// clocks and the Bluetooth flash guard up first
+static NVSettings* nv = nullptr;
+
+static int32_t get_cycles_per_loop() {
+    return (int32_t)core1_get_cycles_per_loop();
+}
+
+static bool set_cycles_per_loop(int32_t value) {
+    core1_set_cycles_per_loop((uint32_t)value);
+    return true;
+}
+
+static int32_t get_overclock() {
+    return hd6301_get_overclock();
+}
+
+static bool set_overclock(int32_t value) {
+    hd6301_set_overclock(value);
+    return true;
+}
+
+static int32_t get_cpu_khz() {
+    return (int32_t)sys_clock_get_khz();    // The active clock, also while idle
+}
+
+static bool set_cpu_khz(int32_t value) {
+    // While the ST is off this only changes the clock idle returns to
+    return sys_clock_set_khz((uint32_t)value);
+}
+
+static int32_t get_mouse_speed() {
+    return nv->get_settings().mouse_speed;
+}
+
+static bool set_mouse_speed(int32_t value) {
+    // Shared with the OLED Devices page, which persists it on its own
+    nv->get_settings().mouse_speed = (int8_t)value;
+    hid_request_ui_refresh();
+    return true;
+}
+
+static int32_t get_usb_mouse_pct() {
+    return mouse_merge_get_scale(MOUSE_CLASS_USB);
+}
+
+static bool set_usb_mouse_pct(int32_t value) {
+    mouse_merge_set_scale(MOUSE_CLASS_USB, value);
+    return true;
+}
+
+#if ENABLE_BLUEPAD32
+static int32_t get_bt_mouse_pct() {
+    return mouse_merge_get_scale(MOUSE_CLASS_BT);
+}
+
+static bool set_bt_mouse_pct(int32_t value) {
+    mouse_merge_set_scale(MOUSE_CLASS_BT, value);
+    return true;
+}
+#endif
+
+static int32_t get_mouse_norm() {
+    return mouse_merge_get_normalise() ? 1 : 0;
+}
+
+static bool set_mouse_norm(int32_t value) {
+    mouse_merge_set_normalise(value != 0);
+    return true;
+}
+
+static int32_t get_mouse_norm_cps() {
+    return mouse_merge_get_target_cps();
+}
+
+static bool set_mouse_norm_cps(int32_t value) {
+    mouse_merge_set_target_cps(value);
+    return true;
+}
+
+static int32_t get_st_idle() {
+    return st_power_enabled() ? 1 : 0;
+}
+
+static bool set_st_idle(int32_t value) {
+    st_power_set_enabled(value != 0);
+    return true;
+}
+
+static int32_t get_pad_keys() {
+    return pad_keymap_get_profile();
+}
+
+static bool set_pad_keys(int32_t value) {
+    pad_keymap_set_profile(value);
+    return true;
+}
+
+static int32_t get_key_joy() {
+    return key_joy_get_profile();
+}
+
+static bool set_key_joy(int32_t value) {
+    key_joy_set_profile(value);
+    return true;
+}
+
+static int32_t get_key_joy_port() {
+    return key_joy_get_port();
+}
+
+static bool set_key_joy_port(int32_t value) {
+    key_joy_set_port(value);
+    return true;
+}
+
+static int32_t get_key_joy_pass() {
+    return key_joy_get_passthrough() ? 1 : 0;
+}
+
+static bool set_key_joy_pass(int32_t value) {
+    key_joy_set_passthrough(value != 0);
+    return true;
+}
+
+static int32_t get_joy0_arb() {
+    return joy_arb_get_policy(0);
+}
+
+static bool set_joy0_arb(int32_t value) {
+    joy_arb_set_policy(0, value);
+    return true;
+}
+
+static int32_t get_joy1_arb() {
+    return joy_arb_get_policy(1);
+}
+
+static bool set_joy1_arb(int32_t value) {
+    joy_arb_set_policy(1, value);
+    return true;
+}
+
+static int32_t get_ikbd_baud() {
+    return (int32_t)SerialPort::instance().get_baud();
+}
+
+static bool set_ikbd_baud(int32_t value) {
+    if (!SerialPort::baud_supported((uint32_t)value)) {
+        return false;
+    }
+    // From tunables_init() Core 1 is not running yet: nothing to park
+    if (!core1_launched()) {
+        return SerialPort::instance().set_baud((uint32_t)value);
+    }
+    // Park Core 1 so the 6301 does not start a byte while the divider changes
+    core1_pause_for_bt_enumeration();
+    core1_wait_for_pause_active(10);
+    SerialPort::instance().set_baud((uint32_t)value);
+    core1_resume_after_bt_enumeration();
+    return true;
+}
+
+static int32_t get_stick_mouse() {
+    return stick_mouse_enabled() ? 1 : 0;
+}
+
+static bool set_stick_mouse(int32_t value) {
+    stick_mouse_set_enabled(value != 0);
+    return true;
+}
+
+static int32_t get_stick_dz() {
+    return stick_mouse_curve()->dead_zone;
+}
+
+static bool set_stick_dz(int32_t value) {
+    stick_mouse_curve()->dead_zone = value;
+    return true;
+}
+
+static int32_t get_stick_exp() {
+    return stick_mouse_curve()->exponent;
+}
+
+static bool set_stick_exp(int32_t value) {
+    stick_mouse_curve()->exponent = value;
+    return true;
+}
+
+static int32_t get_stick_speed() {
+    return stick_mouse_curve()->max_speed;
+}
+
+static bool set_stick_speed(int32_t value) {
+    stick_mouse_curve()->max_speed = value;
+    return true;
+}
+
+static const Tunable tunables[] = {
+    { "cycles_per_loop", "6301 cycles per Core 1 loop",
+      50, 5000, CYCLES_PER_LOOP, 0, get_cycles_per_loop, set_cycles_per_loop },
+    { "overclock", "6301 emulation speed multiplier",
+      1, 8, HD6301_OVERCLOCK_NUM, 1, get_overclock, set_overclock },
+    { "cpu_khz", "System clock in kHz",
+      125000, 270000, CPU_CLOCK_DEFAULT_KHZ, 2, get_cpu_khz, set_cpu_khz },
+    { "mouse_speed", "Mouse speed (0 = standard)",
+      MOUSE_MIN, MOUSE_MAX, 0, -1, get_mouse_speed, set_mouse_speed },
+    { "usb_mouse_pct", "USB mouse speed scale (%)",
+      25, 400, MOUSE_MERGE_SCALE_ONE, 3, get_usb_mouse_pct, set_usb_mouse_pct },
+#if ENABLE_BLUEPAD32
+    { "bt_mouse_pct", "Bluetooth mouse speed scale (%)",
+      25, 400, MOUSE_MERGE_SCALE_ONE, 4, get_bt_mouse_pct, set_bt_mouse_pct },
+#endif
+    { "stick_mouse", "Right stick drives the mouse (0/1)",
+      0, 1, 0, 5, get_stick_mouse, set_stick_mouse },
+    { "stick_dz", "Stick mouse dead zone (of 127)",
+      0, 100, STICK_MOUSE_DEAD_ZONE, 6, get_stick_dz, set_stick_dz },
+    { "stick_exp", "Stick mouse curve exponent",
+      1, STICK_MOUSE_EXP_MAX, STICK_MOUSE_EXPONENT, 7, get_stick_exp, set_stick_exp },
+    { "stick_speed", "Stick mouse speed (counts/s)",
+      50, 4000, STICK_MOUSE_MAX_SPEED, 8, get_stick_speed, set_stick_speed },
+    { "mouse_norm", "Normalise mouse resolution (0/1)",
+      0, 1, MOUSE_NORM_DEFAULT, 9, get_mouse_norm, set_mouse_norm },
+    { "mouse_norm_cps", "Typical mouse speed after normalising (counts/s)",
+      200, 8000, MOUSE_NORM_TARGET_CPS, 10, get_mouse_norm_cps, set_mouse_norm_cps },
+    { "st_idle", "Low-power idle while the ST is off (0/1)",
+      0, 1, ST_IDLE_DEFAULT, 11, get_st_idle, set_st_idle },
+    { "pad_keys", "Gamepad key profile (0 off, 1 menus, 2 fkeys, 3 custom)",
+      0, PAD_KEYMAP_PROFILE_COUNT - 1, PAD_KEYMAP_DEFAULT_PROFILE, 12, get_pad_keys, set_pad_keys },
+    { "key_joy", "Keyboard joystick (0 off, 1 cursor, 2 numpad, 3 wasd)",
+      0, KEY_JOY_PROFILE_COUNT - 1, KEY_JOY_DEFAULT_PROFILE, 13, get_key_joy, set_key_joy },
+    { "key_joy_port", "ST joystick port driven by the keyboard (0/1)",
+      0, 1, KEY_JOY_DEFAULT_PORT, 14, get_key_joy_port, set_key_joy_port },
+    { "key_joy_pass", "Keyboard joystick keys also reach the ST (0/1)",
+      0, 1, 0, 15, get_key_joy_pass, set_key_joy_pass },
+    { "joy0_arb", "Joystick 0 sources (0 priority, 1 recent, 2 merge)",
+      0, JOY_ARB_POLICY_COUNT - 1, JOY_ARB_DEFAULT_POLICY, 16, get_joy0_arb, set_joy0_arb },
+    { "joy1_arb", "Joystick 1 sources (0 priority, 1 recent, 2 merge)",
+      0, JOY_ARB_POLICY_COUNT - 1, JOY_ARB_DEFAULT_POLICY, 17, get_joy1_arb, set_joy1_arb },
+    { "ikbd_baud", "ST link baud (7812, 15625, 31250, 62500)",
+      7812, 62500, IKBD_BAUD_DEFAULT, 18, get_ikbd_baud, set_ikbd_baud },
+};
+
+#define TUNABLE_COUNT ((int)(sizeof(tunables) / sizeof(tunables[0])))
+
+static_assert(NV_PAD_KEY_ROWS == PAD_KEYMAP_CUSTOM_MAX, "custom pad key rows must fit NVSettings");
+
+int tunable_count() {
+    return TUNABLE_COUNT;
+}
+
+const Tunable* tunable_at(int idx) {
+    if (idx < 0 || idx >= TUNABLE_COUNT) {
+        return nullptr;
+    }
+    return &tunables[idx];
+}
+
+const Tunable* tunable_find(const char* name) {
+    for (int i = 0; i < TUNABLE_COUNT; ++i) {
+        if (strcmp(tunables[i].name, name) == 0) {
+            return &tunables[i];
+        }
+    }
+    return nullptr;
+}
+
+bool tunable_set(const Tunable* t, int32_t value) {
+    if (!t || value < t->min || value > t->max) {
+        return false;
+    }
+    return t->set(value);
+}
+
+void tunables_init() {
+    static NVSettings settings;
+    nv = &settings;
+    Settings& s = nv->get_settings();
+    bool saved = (s.tunable_magic == NV_TUNABLE_MAGIC);
+
+    if (saved) {
+        pad_keymap_custom_import(s.pad_keys);
+    }
+
+    for (int i = 0; i < TUNABLE_COUNT; ++i) {
+        const Tunable* t = &tunables[i];
+        if (t->nv_slot < 0) {
+            continue;
+        }
+        int32_t value = saved ? s.tunables[t->nv_slot] : t->def;
+        // Only touch the hardware when the saved value differs from what main() set up
+        if (value != t->get() && !tunable_set(t, value)) {
+            tunable_set(t, t->def);
+        }
+    }
+}
+
+void tunables_defaults() {
+    for (int i = 0; i < TUNABLE_COUNT; ++i) {
+        if (tunables[i].get() != tunables[i].def) {
+            tunable_set(&tunables[i], tunables[i].def);
+        }
+    }
+}
+
+void tunables_save() {
+    Settings& s = nv->get_settings();
+    for (int i = 0; i < TUNABLE_COUNT; ++i) {
+        if (tunables[i].nv_slot >= 0) {
+            s.tunables[tunables[i].nv_slot] = tunables[i].get();
+        }
+    }
+    pad_keymap_custom_export(s.pad_keys);
+    s.tunable_magic = NV_TUNABLE_MAGIC;
+    nv->write();
+}
@@ -0,0 +1,60 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "ui_redraw.h"
+#include "config.h"
+
+// Minimum time between redraws of each page
+static const struct {
+    uint16_t interval_ms;
+    bool     live;
+} page_refresh[UI_REDRAW_PAGES] = {
+    { UI_REDRAW_MIN_MS,   false },  // PAGE_SPLASH
+    { UI_REDRAW_MIN_MS,   false },  // PAGE_DEVICES
+    { UI_REDRAW_MIN_MS,   false },  // PAGE_MAPPING
+    { UI_LIVE_REFRESH_MS, true  },  // PAGE_TELEMETRY
+    { UI_LIVE_REFRESH_MS, false },  // PAGE_SERIAL: dirtied per byte, coalesced
+    { UI_REDRAW_MIN_MS,   true  },  // PAGE_USB_DEBUG
+    { UI_REDRAW_MIN_MS,   true  },  // PAGE_PRO_INIT
+};
+
+void ui_redraw_init(ui_redraw_t* r) {
+    r->dirty = ~0u;
+    r->last = nil_time;
+}
+
+void ui_redraw_now(ui_redraw_t* r, int page) {
+    r->dirty |= 1u << page;
+    r->last = nil_time;
+}
+
+bool ui_redraw_due(ui_redraw_t* r, int page, absolute_time_t now) {
+    const uint32_t bit = 1u << page;
+    if (absolute_time_diff_us(r->last, now) < page_refresh[page].interval_ms * 1000) {
+        return false;
+    }
+    if (page_refresh[page].live) {
+        r->dirty |= bit;
+    }
+    if (!(r->dirty & bit)) {
+        return false;
+    }
+    r->dirty &= ~bit;
+    r->last = now;
+    return true;
+}
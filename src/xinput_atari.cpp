@@ -7,6 +7,8 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include "telemetry.h"
+#include "pad_keymap.h"
 
 // Forward declare only what we need from xinput_host.h to avoid TinyUSB header issues
 extern "C" {
@@ -62,16 +64,6 @@ typedef struct {
 // Storage for Xbox controller state (indexed by dev_addr)
 static xinputh_interface_t const* xbox_controllers[8] = {0};
 
-// Debug counter for successful data reads (accessible from UI)
-static uint32_t xbox_data_read_count = 0;
-static uint32_t xbox_lookup_calls = 0;  // How many times lookup was called
-extern "C" uint32_t get_xbox_data_read_count() {
-    return xbox_data_read_count;
-}
-extern "C" uint32_t get_xbox_lookup_calls() {
-    return xbox_lookup_calls;
-}
-
 // Debug info: Last seen flags for UI display
 static uint8_t last_seen_addr = 0;
 static uint8_t last_seen_connected = 0;
@@ -170,7 +162,7 @@ bool xinput_to_atari_joystick(int joystick_num, uint8_t* axis, uint8_t* button)
     call_count++;
     
     // Increment lookup call counter for UI
-    xbox_lookup_calls++;
+    tm_inc(TM_XBOX_LOOKUPS);
     
     // Find first connected Xbox controller
     for (uint8_t dev_addr = 1; dev_addr < 8; dev_addr++) {
@@ -183,7 +175,7 @@ bool xinput_to_atari_joystick(int joystick_num, uint8_t* axis, uint8_t* button)
         
         // FIX: Increment counter IMMEDIATELY to prove we found something
         // This proves the lookup is working
-        xbox_data_read_count++;
+        tm_inc(TM_XBOX_READS);
         
         // Update debug flags for UI display
         last_seen_addr = dev_addr;
@@ -239,6 +231,40 @@ extern "C" bool xinput_llamatron_axes(uint8_t* joy1_axis, uint8_t* joy1_fire,
     return false;
 }
 
+extern "C" bool xinput_right_stick(int8_t* x, int8_t* y) {
+    for (uint8_t dev_addr = 1; dev_addr < 8; dev_addr++) {
+        const xinputh_interface_t* xbox = xbox_controllers[dev_addr];
+        if (xbox && xbox->connected) {
+            *x = (int8_t)(xbox->pad.sThumbRX >> 8);
+            *y = (int8_t)(-(xbox->pad.sThumbRY + 1) >> 8);  // Up is positive on XInput
+            return true;
+        }
+    }
+    return false;
+}
+
+extern "C" bool xinput_pad_buttons(uint32_t* buttons) {
+    // wButtons bits 4..15: Start Back LS RS LB RB Guide Share A B X Y
+    static const uint16_t map[12] = {
+        PAD_BTN_START, PAD_BTN_SELECT, PAD_BTN_L3, PAD_BTN_R3, PAD_BTN_L1, PAD_BTN_R1,
+        PAD_BTN_HOME, 0, PAD_BTN_SOUTH, PAD_BTN_EAST, PAD_BTN_WEST, PAD_BTN_NORTH
+    };
+    for (uint8_t dev_addr = 1; dev_addr < 8; dev_addr++) {
+        const xinputh_interface_t* xbox = xbox_controllers[dev_addr];
+        if (xbox && xbox->connected) {
+            uint32_t mask = 0;
+            for (int b = 0; b < 12; b++) {
+                if (xbox->pad.wButtons & (1u << (b + 4))) mask |= map[b];
+            }
+            if (xbox->pad.bLeftTrigger > 128) mask |= PAD_BTN_L2;
+            if (xbox->pad.bRightTrigger > 128) mask |= PAD_BTN_R2;
+            *buttons = mask;
+            return true;
+        }
+    }
+    return false;
+}
+
 // Get Xbox controller by device address (for pause button checking)
 extern "C" const xinputh_interface_t* xinput_get_controller(uint8_t dev_addr) {
     if (dev_addr >= 1 && dev_addr < 8) {
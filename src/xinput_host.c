@@ -8,6 +8,7 @@
 #include "host/usbh.h"
 #include "host/usbh_pvt.h"
 #include "xinput_host.h"
+#include "telemetry.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-const-variable"
@@ -68,10 +69,51 @@ static const uint8_t xboxog_rumble[] = {0x00, 0x06, 0x00, 0x00, 0x00, 0x00};
 
 #pragma GCC diagnostic pop
 
+//GIP (Xbox One / Series) session. Handshakes, acks and rumble are queued and
+//sent one at a time from the OUT transfer-complete callback, so nothing waits
+//on the endpoint. Acks go first; the init script runs when the queue is empty.
+#ifndef GIP_TXQ_DEPTH
+#define GIP_TXQ_DEPTH 4
+#endif
+#define GIP_TXQ_PACKET 16
+#define GIP_SCRIPT_MAX 5
+#define GIP_INPUT_MIN 18
+
+typedef enum
+{
+    GIP_STATE_OFF = 0, //Not a GIP interface
+    GIP_STATE_INIT,    //Init script still being sent
+    GIP_STATE_READY
+} gip_state_t;
+
+typedef enum
+{
+    GIP_TX_IDLE = 0,
+    GIP_TX_QUEUE,      //Queue head on the wire
+    GIP_TX_SCRIPT,     //Script step on the wire
+    GIP_TX_STALE       //Script step from before a restart; retires as a no-op
+} gip_tx_t;
+
+typedef struct
+{
+    uint8_t state;      //gip_state_t
+    uint8_t tx;         //gip_tx_t
+    uint8_t seq;        //Sequence number for packets we originate
+    uint8_t q_head;
+    uint8_t q_count;
+    uint8_t q_len[GIP_TXQ_DEPTH];
+    uint8_t q_buf[GIP_TXQ_DEPTH][GIP_TXQ_PACKET];
+    uint8_t script_step;
+    uint8_t script_count;
+    const uint8_t *script[GIP_SCRIPT_MAX];
+    uint8_t script_len[GIP_SCRIPT_MAX];
+} gip_session_t;
+
 typedef struct
 {
     uint8_t inst_count;
     xinputh_interface_t instances[CFG_TUH_XINPUT];
+    gip_session_t gip[CFG_TUH_XINPUT];
 } xinputh_device_t;
 
 static xinputh_device_t _xinputh_dev[CFG_TUH_DEVICE_MAX];
@@ -86,6 +128,11 @@ TU_ATTR_ALWAYS_INLINE static inline xinputh_interface_t *get_instance(uint8_t de
     return &_xinputh_dev[dev_addr - 1].instances[instance];
 }
 
+TU_ATTR_ALWAYS_INLINE static inline gip_session_t *get_gip(uint8_t dev_addr, uint8_t instance)
+{
+    return &_xinputh_dev[dev_addr - 1].gip[instance];
+}
+
 static uint8_t get_instance_id_by_epaddr(uint8_t dev_addr, uint8_t ep_addr)
 {
     for (uint8_t inst = 0; inst < CFG_TUH_XINPUT; inst++)
@@ -118,30 +165,163 @@ static void wait_for_tx_complete(uint8_t dev_addr, uint8_t ep_out)
         tuh_task();
 }
 
-static void xboxone_init( xinputh_interface_t *xid_itf, uint8_t dev_addr, uint8_t instance)
+//Send the next queued packet or script step if the OUT endpoint is free
+static void gip_pump(uint8_t dev_addr, uint8_t instance)
+{
+    xinputh_interface_t *xid_itf = get_instance(dev_addr, instance);
+    gip_session_t *gip = get_gip(dev_addr, instance);
+    const uint8_t *pkt;
+    uint8_t len;
+    uint8_t tx;
+
+    if (gip->state == GIP_STATE_OFF || gip->tx != GIP_TX_IDLE)
+        return;
+
+    if (gip->q_count)
+    {
+        pkt = gip->q_buf[gip->q_head];
+        len = gip->q_len[gip->q_head];
+        tx = GIP_TX_QUEUE;
+    }
+    else if (gip->script_step < gip->script_count)
+    {
+        pkt = gip->script[gip->script_step];
+        len = gip->script_len[gip->script_step];
+        tx = GIP_TX_SCRIPT;
+    }
+    else
+    {
+        gip->state = GIP_STATE_READY;
+        return;
+    }
+
+    if (len > xid_itf->epout_size || !usbh_edpt_claim(dev_addr, xid_itf->ep_out))
+        return; //Busy with someone else's transfer; its completion pumps again
+
+    memcpy(xid_itf->epout_buf, pkt, len);
+    if (tx == GIP_TX_SCRIPT)
+        xid_itf->epout_buf[2] = ++gip->seq;
+
+    if (!usbh_edpt_xfer(dev_addr, xid_itf->ep_out, xid_itf->epout_buf, len))
+    {
+        usbh_edpt_release(dev_addr, xid_itf->ep_out);
+        return;
+    }
+    gip->tx = tx;
+}
+
+//OUT transfer finished (or failed): retire what was on the wire
+static void gip_sent(uint8_t dev_addr, uint8_t instance)
+{
+    gip_session_t *gip = get_gip(dev_addr, instance);
+    if (gip->tx == GIP_TX_QUEUE)
+    {
+        gip->q_head = (gip->q_head + 1) % GIP_TXQ_DEPTH;
+        gip->q_count--;
+    }
+    else if (gip->tx == GIP_TX_SCRIPT)
+    {
+        gip->script_step++;
+    }
+    gip->tx = GIP_TX_IDLE;
+    gip_pump(dev_addr, instance);
+}
+
+static bool gip_queue(uint8_t dev_addr, uint8_t instance, const uint8_t *pkt, uint8_t len)
+{
+    gip_session_t *gip = get_gip(dev_addr, instance);
+    TU_VERIFY(len <= GIP_TXQ_PACKET && gip->q_count < GIP_TXQ_DEPTH);
+
+    uint8_t tail = (gip->q_head + gip->q_count) % GIP_TXQ_DEPTH;
+    memcpy(gip->q_buf[tail], pkt, len);
+    gip->q_len[tail] = len;
+    gip->q_count++;
+    gip_pump(dev_addr, instance);
+    return true;
+}
+
+//Ack a packet sent with GIP_OPT_ACK, echoing its command and sequence number
+//(same layout xpad uses for the Guide button report)
+static void gip_ack(uint8_t dev_addr, uint8_t instance, const uint8_t *rdata)
 {
+    uint8_t ack[] = {GIP_CMD_ACK, GIP_OPT_INTERNAL, rdata[2], GIP_PL_LEN(9),
+                     0x00, rdata[0], rdata[1] & GIP_OPT_INTERNAL, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    if (gip_queue(dev_addr, instance, ack, sizeof(ack)))
+        tm_inc(TM_XBOX_GIP_ACKS);
+}
+
+//(Re)start the power-on script: on set_config and whenever the pad announces
+static void gip_start(uint8_t dev_addr, uint8_t instance)
+{
+    gip_session_t *gip = get_gip(dev_addr, instance);
     uint16_t PID, VID;
     tuh_vid_pid_get(dev_addr, &VID, &PID);
 
-    tuh_xinput_send_report(dev_addr, instance, xboxone_power_on, sizeof(xboxone_power_on));
-    wait_for_tx_complete(dev_addr, xid_itf->ep_out);
-    tuh_xinput_send_report(dev_addr, instance, xboxone_s_init, sizeof(xboxone_s_init));
-    wait_for_tx_complete(dev_addr, xid_itf->ep_out);
-
+    gip->script_count = 0;
+    #define GIP_SCRIPT(p) do { gip->script[gip->script_count] = p; gip->script_len[gip->script_count++] = sizeof(p); } while (0)
+    GIP_SCRIPT(xboxone_power_on);
+    GIP_SCRIPT(xboxone_s_init);
     if (VID == 0x045e && (PID == 0x0b00))
     {
-        tuh_xinput_send_report(dev_addr, instance, extra_input_packet_init, sizeof(extra_input_packet_init));
-        wait_for_tx_complete(dev_addr, xid_itf->ep_out);
+        GIP_SCRIPT(extra_input_packet_init);
     }
-
     //Required for PDP aftermarket controllers
     if (VID == 0x0e6f)
     {
-        tuh_xinput_send_report(dev_addr, instance, xboxone_pdp_led_on, sizeof(xboxone_pdp_led_on));
-        wait_for_tx_complete(dev_addr, xid_itf->ep_out);
-        tuh_xinput_send_report(dev_addr, instance, xboxone_pdp_auth, sizeof(xboxone_pdp_auth));
-        wait_for_tx_complete(dev_addr, xid_itf->ep_out);
+        GIP_SCRIPT(xboxone_pdp_led_on);
+        GIP_SCRIPT(xboxone_pdp_auth);
     }
+    #undef GIP_SCRIPT
+
+    //A step of the old script still on the wire must not advance the new one
+    if (gip->tx == GIP_TX_SCRIPT)
+        gip->tx = GIP_TX_STALE;
+    gip->script_step = 0;
+    gip->state = GIP_STATE_INIT;
+    gip_pump(dev_addr, instance);
+}
+
+//GIP_CMD_INPUT, fixed layout: buttons in bytes 4-5, triggers (10 bit) in 6-9,
+//sticks in 10-17 and, on Series pads, Share in byte 22. Returns false if the
+//state is unchanged from the last packet.
+static const struct
+{
+    uint16_t gip;
+    uint16_t xinput;
+} gip_buttons[] = {
+    {1 << 2, XINPUT_GAMEPAD_START},      {1 << 3, XINPUT_GAMEPAD_BACK},
+    {1 << 4, XINPUT_GAMEPAD_A},          {1 << 5, XINPUT_GAMEPAD_B},
+    {1 << 6, XINPUT_GAMEPAD_X},          {1 << 7, XINPUT_GAMEPAD_Y},
+    {1 << 8, XINPUT_GAMEPAD_DPAD_UP},    {1 << 9, XINPUT_GAMEPAD_DPAD_DOWN},
+    {1 << 10, XINPUT_GAMEPAD_DPAD_LEFT}, {1 << 11, XINPUT_GAMEPAD_DPAD_RIGHT},
+    {1 << 12, XINPUT_GAMEPAD_LEFT_SHOULDER}, {1 << 13, XINPUT_GAMEPAD_RIGHT_SHOULDER},
+    {1 << 14, XINPUT_GAMEPAD_LEFT_THUMB},    {1 << 15, XINPUT_GAMEPAD_RIGHT_THUMB},
+};
+
+static bool gip_decode_input(const uint8_t *rdata, uint32_t len, xinput_gamepad_t *pad)
+{
+    xinput_gamepad_t in;
+    uint16_t wButtons = rdata[5] << 8 | rdata[4];
+
+    tu_memclr(&in, sizeof(in));
+    for (uint8_t i = 0; i < TU_ARRAY_SIZE(gip_buttons); i++)
+    {
+        if (wButtons & gip_buttons[i].gip) in.wButtons |= gip_buttons[i].xinput;
+    }
+    if (len > 22 && (rdata[22] & 0x01)) in.wButtons |= XINPUT_GAMEPAD_SHARE;
+    in.wButtons |= pad->wButtons & XINPUT_GAMEPAD_GUIDE; //Owned by GIP_CMD_VIRTUAL_KEY
+
+    in.bLeftTrigger = (rdata[7] << 8 | rdata[6]) >> 2;
+    in.bRightTrigger = (rdata[9] << 8 | rdata[8]) >> 2;
+    in.sThumbLX = rdata[11] << 8 | rdata[10];
+    in.sThumbLY = rdata[13] << 8 | rdata[12];
+    in.sThumbRX = rdata[15] << 8 | rdata[14];
+    in.sThumbRY = rdata[17] << 8 | rdata[16];
+
+    if (memcmp(&in, pad, sizeof(in)) == 0)
+        return false;
+    *pad = in;
+    return true;
 }
 
 bool tuh_xinput_receive_report(uint8_t dev_addr, uint8_t instance)
@@ -226,8 +406,10 @@ bool tuh_xinput_set_rumble(uint8_t dev_addr, uint8_t instance, uint8_t lValue, u
         memcpy(txbuf, xboxone_rumble, sizeof(xboxone_rumble));
         txbuf[8] = lValue / 2; // 0 - 128
         txbuf[9] = rValue / 2; // 0 - 128
-        len = sizeof(xboxone_rumble);
-        break;
+        //Queued behind any handshake in progress, so never blocks
+        txbuf[2] = ++get_gip(dev_addr, instance)->seq;
+        gip_queue(dev_addr, instance, txbuf, sizeof(xboxone_rumble));
+        return true;
     case XBOXOG:
         memcpy(txbuf, xboxog_rumble, sizeof(xboxog_rumble));
         txbuf[2] = lValue;
@@ -343,7 +525,7 @@ bool xinputh_set_config(uint8_t dev_addr, uint8_t itf_num)
     }
     else if (xid_itf->type == XBOXONE)
     {
-        xboxone_init(xid_itf, dev_addr, instance);
+        gip_start(dev_addr, instance);
     }
 
     if (tuh_xinput_mount_cb)
@@ -373,9 +555,13 @@ bool xinputh_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, ui
         {
             tuh_xinput_report_received_cb(dev_addr, instance, xid_itf, sizeof(xinputh_interface_t));
         }
-        else if (tuh_xinput_report_sent_cb)
+        else
         {
-            tuh_xinput_report_sent_cb(dev_addr, instance, xid_itf->epout_buf, xferred_bytes);
+            if (tuh_xinput_report_sent_cb)
+            {
+                tuh_xinput_report_sent_cb(dev_addr, instance, xid_itf->epout_buf, xferred_bytes);
+            }
+            gip_sent(dev_addr, instance);
         }
         return false;
     }
@@ -477,39 +663,17 @@ bool xinputh_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, ui
         }
         else if (xid_itf->type == XBOXONE)
         {
-            if (rdata[0] == GIP_CMD_INPUT)
+            if (xferred_bytes >= 4 && (rdata[1] & GIP_OPT_ACK))
             {
-                tu_memclr(pad, sizeof(xinput_gamepad_t));
-                uint16_t wButtons = rdata[5] << 8 | rdata[4];
-
-                //Map digital buttons
-                if (wButtons & (1 << 8)) pad->wButtons |= XINPUT_GAMEPAD_DPAD_UP;
-                if (wButtons & (1 << 9)) pad->wButtons |= XINPUT_GAMEPAD_DPAD_DOWN;
-                if (wButtons & (1 << 10)) pad->wButtons |= XINPUT_GAMEPAD_DPAD_LEFT;
-                if (wButtons & (1 << 11)) pad->wButtons |= XINPUT_GAMEPAD_DPAD_RIGHT;
-                if (wButtons & (1 << 2)) pad->wButtons |= XINPUT_GAMEPAD_START;
-                if (wButtons & (1 << 3)) pad->wButtons |= XINPUT_GAMEPAD_BACK;
-                if (wButtons & (1 << 14)) pad->wButtons |= XINPUT_GAMEPAD_LEFT_THUMB;
-                if (wButtons & (1 << 15)) pad->wButtons |= XINPUT_GAMEPAD_RIGHT_THUMB;
-                if (wButtons & (1 << 12)) pad->wButtons |= XINPUT_GAMEPAD_LEFT_SHOULDER;
-                if (wButtons & (1 << 13)) pad->wButtons |= XINPUT_GAMEPAD_RIGHT_SHOULDER;
-                if (wButtons & (1 << 4)) pad->wButtons |= XINPUT_GAMEPAD_A;
-                if (wButtons & (1 << 5)) pad->wButtons |= XINPUT_GAMEPAD_B;
-                if (wButtons & (1 << 6)) pad->wButtons |= XINPUT_GAMEPAD_X;
-                if (wButtons & (1 << 7)) pad->wButtons |= XINPUT_GAMEPAD_Y;
-                if (rdata[22] && 0x01) pad->wButtons   |= XINPUT_GAMEPAD_SHARE;
-
-                //Map the left and right triggers
-                pad->bLeftTrigger = (rdata[7] << 8 | rdata[6]) >> 2;
-                pad->bRightTrigger = (rdata[9] << 8 | rdata[8]) >> 2;
-
-                //Map analog sticks
-                pad->sThumbLX = rdata[11] << 8 | rdata[10];
-                pad->sThumbLY = rdata[13] << 8 | rdata[12];
-                pad->sThumbRX = rdata[15] << 8 | rdata[14];
-                pad->sThumbRY = rdata[17] << 8 | rdata[16];
+                gip_ack(dev_addr, instance, rdata);
+            }
 
-                xid_itf->new_pad_data = true;
+            if (rdata[0] == GIP_CMD_INPUT && xferred_bytes >= GIP_INPUT_MIN)
+            {
+                if (gip_decode_input(rdata, xferred_bytes, pad))
+                    xid_itf->new_pad_data = true;
+                else
+                    tm_inc(TM_XBOX_GIP_DUPS);
             }
             else if (rdata[0] == GIP_CMD_VIRTUAL_KEY)
             {
@@ -524,7 +688,7 @@ bool xinputh_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, ui
             }
             else if (rdata[0] == GIP_CMD_ANNOUNCE)
             {
-                xboxone_init(xid_itf, dev_addr, instance);
+                gip_start(dev_addr, instance);
             }
         }
         else if (xid_itf->type == XBOXOG)
@@ -578,6 +742,7 @@ bool xinputh_xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, ui
         {
             tuh_xinput_report_sent_cb(dev_addr, instance, xid_itf->epout_buf, xferred_bytes);
         }
+        gip_sent(dev_addr, instance);
     }
 
     return true;
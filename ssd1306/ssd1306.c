@@ -65,6 +65,7 @@ bool ssd1306_init(ssd1306_t *p, uint16_t width, uint16_t height, uint8_t address
     p->height=height;
     p->pages=height/8;
     p->address=address;
+    p->clears=0;
 
     p->i2c_i=i2c_instance;
 
@@ -139,6 +140,7 @@ inline void ssd1306_invert(ssd1306_t *p, uint8_t inv) {
 }
 
 inline void ssd1306_clear(ssd1306_t *p) {
+    ++p->clears;
 #if ENABLE_OLED_DISPLAY
     if (!ssd1306_oled_allowed()) {
         return;
@@ -190,16 +192,70 @@ void ssd13606_draw_empty_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t w
 	ssd1306_draw_line(p, x+width, y, x+width, y+height);
 }
 
-void ssd1306_draw_char_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, char c) {
-    if(c > '~')
+void ssd1306_clear_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+#if ENABLE_OLED_DISPLAY
+    if (!ssd1306_oled_allowed()) {
         return;
+    }
+#endif
+    if(x>=p->width || y>=p->height) return;
+    if(width>p->width-x) width=p->width-x;
+    if(height>p->height-y) height=p->height-y;
+
+    for(uint32_t page=y>>3; (page<<3)<y+height; ++page) {
+        uint32_t top=(page<<3)<y ? y-(page<<3) : 0;
+        uint32_t bottom=(page<<3)+8>y+height ? y+height-(page<<3) : 8;
+        uint8_t mask=(uint8_t)(((1u<<bottom)-1) & ~((1u<<top)-1));
+        uint8_t *dst=p->buffer+page*p->width+x;
+
+        for(uint32_t i=0; i<width; ++i)
+            dst[i]&=~mask;
+    }
+}
 
-    for(uint8_t i=0; i<font[1]; ++i) {
-        uint8_t line=(uint8_t)(font[(c-0x20)*font[1]+i+2]);
+void ssd1306_draw_char_with_font(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t scale, const uint8_t *font, char c) {
+    if(c < ' ' || c > '~')
+        return;
+#if ENABLE_OLED_DISPLAY
+    if (!ssd1306_oled_allowed()) {
+        return;
+    }
+#endif
+    if(x>=p->width || y>=p->height) return;
+
+    const uint8_t *glyph=font+(c-0x20)*font[1]+2;
+    uint32_t page=y>>3;
+    uint32_t shift=y&0x07;
+
+    if(scale==1 && font[0]==8) {
+        uint8_t *dst=p->buffer+page*p->width;
+        for(uint32_t i=0; i<font[1] && x+i<p->width; ++i) {
+            dst[x+i]|=(uint8_t)(glyph[i]<<shift);
+            if(shift && page+1<p->pages)
+                dst[x+i+p->width]|=(uint8_t)(glyph[i]>>(8-shift));
+        }
+        return;
+    }
 
-        for(int8_t j=0; j<font[0]; ++j, line>>=1) {
-            if(line & 1 ==1)
-                ssd1306_draw_square(p, x+i*scale, y+j*scale, scale, scale);
+    // Scaled: build each destination page byte of a column once, then
+    // repeat it across the scale columns
+    uint32_t bottom=y+font[0]*scale;
+    for(uint32_t i=0; i<font[1]; ++i) {
+        uint8_t line=glyph[i];
+        if(!line) continue;
+
+        for(uint32_t pg=page; pg<p->pages && (pg<<3)<bottom; ++pg) {
+            uint8_t bits=0;
+            for(uint32_t b=0; b<8; ++b) {
+                uint32_t row=(pg<<3)+b;
+                if(row>=y && row<bottom && ((line>>((row-y)/scale))&1))
+                    bits|=1<<b;
+            }
+            if(!bits) continue;
+
+            uint8_t *dst=p->buffer+pg*p->width;
+            for(uint32_t s=0; s<scale && x+i*scale+s<p->width; ++s)
+                dst[x+i*scale+s]|=bits;
         }
     }
 }
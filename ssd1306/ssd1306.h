@@ -72,6 +72,7 @@ typedef struct {
     bool external_vcc; 	/**< whether display uses external vcc */ 
     uint8_t *buffer;	/**< display buffer */
     size_t bufsize;		/**< buffer size */
+    uint32_t clears;	/**< bumped by every ssd1306_clear, so text layers can tell the buffer was redrawn */
 } ssd1306_t;
 
 /**
@@ -181,9 +182,23 @@ void ssd1306_draw_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, u
 */
 void ssd13606_draw_empty_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
 
+/**
+	@brief clear (set to off) a rectangle, a column byte at a time
+
+	@param[in] p : instance of display
+	@param[in] x : x position of starting point
+	@param[in] y : y position of starting point
+	@param[in] width : width of rectangle
+	@param[in] height : height of rectangle
+*/
+void ssd1306_clear_square(ssd1306_t *p, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
 /**
 	@brief draw char with given font
 
+	Glyph columns are ORed straight into the page-organised buffer: at scale 1
+	one byte per column, two when y is not a multiple of 8.
+
 	@param[in] p : instance of display
 	@param[in] x : x starting position of char
 	@param[in] y : y starting position of char
@@ -0,0 +1,149 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Host stand-in for btstack.h: the run-loop timer and GAP calls, which a
+// test defines, and the HCI event accessors, which read raw event packets
+// at the offsets btstack_event.h uses
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// As src/btstack_config.h, which needs the firmware's BLE/Classic flags
+#define MAX_NR_HCI_CONNECTIONS  4
+
+typedef struct btstack_timer_source {
+    void (*process)(struct btstack_timer_source* ts);
+    uint32_t timeout;
+    void* context;
+} btstack_timer_source_t;
+
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t* ts,
+                                        void (*process)(btstack_timer_source_t* ts));
+void btstack_run_loop_set_timer(btstack_timer_source_t* ts, uint32_t timeout_in_ms);
+void btstack_run_loop_add_timer(btstack_timer_source_t* ts);
+int btstack_run_loop_remove_timer(btstack_timer_source_t* ts);
+
+typedef uint16_t hci_con_handle_t;
+typedef void (*btstack_packet_handler_t)(uint8_t packet_type, uint16_t channel, uint8_t* packet, uint16_t size);
+
+typedef struct {
+    void* item;
+    btstack_packet_handler_t callback;
+} btstack_packet_callback_registration_t;
+
+#define HCI_EVENT_PACKET                            0x04
+#define ERROR_CODE_SUCCESS                          0x00
+
+#define HCI_EVENT_CONNECTION_COMPLETE               0x03
+#define HCI_EVENT_DISCONNECTION_COMPLETE            0x05
+#define HCI_EVENT_MODE_CHANGE                       0x14
+#define HCI_EVENT_LE_META                           0x3E
+#define HCI_SUBEVENT_LE_CONNECTION_COMPLETE         0x01
+#define HCI_SUBEVENT_LE_CONNECTION_UPDATE_COMPLETE  0x03
+
+#define LM_LINK_POLICY_ENABLE_ROLE_SWITCH           0x01
+#define LM_LINK_POLICY_ENABLE_SNIFF_MODE            0x04
+
+void hci_add_event_handler(btstack_packet_callback_registration_t* callback_handler);
+void gap_set_connection_parameters(uint16_t conn_scan_interval, uint16_t conn_scan_window,
+                                   uint16_t conn_interval_min, uint16_t conn_interval_max,
+                                   uint16_t conn_latency, uint16_t supervision_timeout,
+                                   uint16_t min_ce_length, uint16_t max_ce_length);
+int gap_update_connection_parameters(hci_con_handle_t con_handle, uint16_t conn_interval_min,
+                                     uint16_t conn_interval_max, uint16_t conn_latency,
+                                     uint16_t supervision_timeout);
+void gap_set_default_link_policy_settings(uint16_t default_link_policy_settings);
+uint8_t gap_sniff_mode_exit(hci_con_handle_t con_handle);
+
+static inline uint16_t little_endian_read_16(const uint8_t* buffer, int position) {
+    return (uint16_t)(buffer[position] | (buffer[position + 1] << 8));
+}
+
+static inline uint8_t hci_event_packet_get_type(const uint8_t* event) {
+    return event[0];
+}
+
+static inline uint8_t hci_event_le_meta_get_subevent_code(const uint8_t* event) {
+    return event[2];
+}
+
+static inline uint8_t hci_subevent_le_connection_complete_get_status(const uint8_t* event) {
+    return event[3];
+}
+
+static inline hci_con_handle_t hci_subevent_le_connection_complete_get_connection_handle(const uint8_t* event) {
+    return little_endian_read_16(event, 4);
+}
+
+static inline uint16_t hci_subevent_le_connection_complete_get_conn_interval(const uint8_t* event) {
+    return little_endian_read_16(event, 14);
+}
+
+static inline uint16_t hci_subevent_le_connection_complete_get_conn_latency(const uint8_t* event) {
+    return little_endian_read_16(event, 16);
+}
+
+static inline uint8_t hci_subevent_le_connection_update_complete_get_status(const uint8_t* event) {
+    return event[3];
+}
+
+static inline hci_con_handle_t hci_subevent_le_connection_update_complete_get_connection_handle(const uint8_t* event) {
+    return little_endian_read_16(event, 4);
+}
+
+static inline uint16_t hci_subevent_le_connection_update_complete_get_conn_interval(const uint8_t* event) {
+    return little_endian_read_16(event, 6);
+}
+
+static inline uint16_t hci_subevent_le_connection_update_complete_get_conn_latency(const uint8_t* event) {
+    return little_endian_read_16(event, 8);
+}
+
+static inline uint8_t hci_event_connection_complete_get_status(const uint8_t* event) {
+    return event[2];
+}
+
+static inline uint16_t hci_event_connection_complete_get_connection_handle(const uint8_t* event) {
+    return little_endian_read_16(event, 3);
+}
+
+static inline uint8_t hci_event_connection_complete_get_link_type(const uint8_t* event) {
+    return event[11];
+}
+
+static inline uint8_t hci_event_mode_change_get_status(const uint8_t* event) {
+    return event[2];
+}
+
+static inline hci_con_handle_t hci_event_mode_change_get_handle(const uint8_t* event) {
+    return little_endian_read_16(event, 3);
+}
+
+static inline uint8_t hci_event_mode_change_get_mode(const uint8_t* event) {
+    return event[5];
+}
+
+static inline uint16_t hci_event_mode_change_get_interval(const uint8_t* event) {
+    return little_endian_read_16(event, 6);
+}
+
+static inline uint16_t hci_event_disconnection_complete_get_connection_handle(const uint8_t* event) {
+    return little_endian_read_16(event, 3);
+}
@@ -0,0 +1,27 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Host stand-in for hardware/regs/uart.h: the UARTDR error flags
+#pragma once
+
+#define UART_UARTDR_OE_BITS     0x00000800
+#define UART_UARTDR_BE_BITS     0x00000400
+#define UART_UARTDR_PE_BITS     0x00000200
+#define UART_UARTDR_FE_BITS     0x00000100
+#define UART_UARTDR_DATA_BITS   0x000000ff
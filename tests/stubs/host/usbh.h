@@ -0,0 +1,95 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Host stand-in for TinyUSB's host/usbh.h: the common types and macros the
+// class drivers use, and the host stack calls, which a test defines
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "tusb_option.h"
+
+#define TU_ATTR_WEAK            __attribute__((weak))
+#define TU_ATTR_PACKED          __attribute__((packed))
+#define TU_ATTR_ALWAYS_INLINE   __attribute__((always_inline))
+#define TU_ARRAY_SIZE(a)        (sizeof(a) / sizeof((a)[0]))
+#define TU_LOG2(...)            do { } while (0)
+
+// TU_VERIFY(cond) / TU_VERIFY(cond, ret) and TU_ASSERT likewise: return
+// ret (default false) when cond does not hold
+#define TU_GET_3RD(a, b, c, ...)    c
+#define TU_VERIFY_1(cond)           do { if (!(cond)) return false; } while (0)
+#define TU_VERIFY_2(cond, ret)      do { if (!(cond)) return ret; } while (0)
+#define TU_VERIFY(...)  TU_GET_3RD(__VA_ARGS__, TU_VERIFY_2, TU_VERIFY_1, _)(__VA_ARGS__)
+#define TU_ASSERT(...)  TU_VERIFY(__VA_ARGS__)
+
+static inline void tu_memclr(void* p, size_t n) { memset(p, 0, n); }
+
+typedef enum {
+    XFER_RESULT_SUCCESS = 0,
+    XFER_RESULT_FAILED,
+    XFER_RESULT_STALLED,
+    XFER_RESULT_TIMEOUT,
+} xfer_result_t;
+
+typedef enum {
+    TUSB_DIR_OUT = 0,
+    TUSB_DIR_IN = 1,
+} tusb_dir_t;
+
+#define TUSB_DESC_INTERFACE     0x04
+#define TUSB_DESC_ENDPOINT      0x05
+
+typedef struct __attribute__((packed)) {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bInterfaceNumber;
+    uint8_t bAlternateSetting;
+    uint8_t bNumEndpoints;
+    uint8_t bInterfaceClass;
+    uint8_t bInterfaceSubClass;
+    uint8_t bInterfaceProtocol;
+    uint8_t iInterface;
+} tusb_desc_interface_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+    uint8_t  bEndpointAddress;
+    uint8_t  bmAttributes;
+    uint16_t wMaxPacketSize;
+    uint8_t  bInterval;
+} tusb_desc_endpoint_t;
+
+static inline uint8_t tu_desc_len(const void* desc) { return ((const uint8_t*)desc)[0]; }
+static inline uint8_t tu_desc_type(const void* desc) { return ((const uint8_t*)desc)[1]; }
+static inline const uint8_t* tu_desc_next(const void* desc) {
+    return (const uint8_t*)desc + tu_desc_len(desc);
+}
+static inline tusb_dir_t tu_edpt_dir(uint8_t addr) {
+    return (addr & 0x80) ? TUSB_DIR_IN : TUSB_DIR_OUT;
+}
+static inline uint16_t tu_edpt_packet_size(const tusb_desc_endpoint_t* ep) {
+    return ep->wMaxPacketSize & 0x7FF;
+}
+
+void tuh_task(void);
+bool tuh_vid_pid_get(uint8_t dev_addr, uint16_t* vid, uint16_t* pid);
+bool tuh_edpt_open(uint8_t dev_addr, const tusb_desc_endpoint_t* desc_ep);
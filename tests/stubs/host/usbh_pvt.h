@@ -0,0 +1,39 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Host stand-in for TinyUSB's host/usbh_pvt.h: the class driver table and
+// the endpoint calls a class driver makes, which a test defines
+#pragma once
+
+#include "host/usbh.h"
+
+typedef struct {
+    const char* name;
+    bool (*init)(void);
+    bool (*open)(uint8_t rhport, uint8_t dev_addr, const tusb_desc_interface_t* desc_itf, uint16_t max_len);
+    bool (*set_config)(uint8_t dev_addr, uint8_t itf_num);
+    bool (*xfer_cb)(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes);
+    void (*close)(uint8_t dev_addr);
+} usbh_class_driver_t;
+
+bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr);
+bool usbh_edpt_release(uint8_t dev_addr, uint8_t ep_addr);
+bool usbh_edpt_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes);
+bool usbh_edpt_busy(uint8_t dev_addr, uint8_t ep_addr);
+void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num);
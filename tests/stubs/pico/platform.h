@@ -0,0 +1,40 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Host stand-in for the Pico SDK's pico/platform.h: single core, code in
+ * RAM is just code.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __not_in_flash_func(f)  f
+#define __not_in_flash(group)
+#define __time_critical_func(f) f
+
+typedef unsigned int uint;
+
+static inline uint32_t get_core_num(void) {
+    return 0;
+}
+
+static inline void tight_loop_contents(void) {
+}
@@ -0,0 +1,85 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Host stand-in for pico/time.h. Time only moves when a test advances
+ * host_time_us, so timing behaviour is deterministic.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint64_t host_time_us;
+
+typedef uint64_t absolute_time_t;
+
+static const absolute_time_t nil_time = 0;
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)host_time_us;
+}
+
+static inline uint64_t time_us_64(void) {
+    return host_time_us;
+}
+
+static inline absolute_time_t get_absolute_time(void) {
+    return host_time_us;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+    return t + us;
+}
+
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) {
+    return t + (uint64_t)ms * 1000;
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return host_time_us + (uint64_t)ms * 1000;
+}
+
+static inline bool time_reached(absolute_time_t t) {
+    return host_time_us >= t;
+}
+
+static inline void busy_wait_us(uint32_t us) {
+    host_time_us += us;
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    host_time_us += (uint64_t)ms * 1000;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Host stand-in for TinyUSB's tusb.h: the host stack types plus the control
+// transfer and HID host calls, which a test defines
+#pragma once
+
+#include "host/usbh.h"
+
+#define TUSB_REQ_RCPT_DEVICE        0
+#define TUSB_REQ_RCPT_INTERFACE     1
+#define TUSB_REQ_TYPE_STANDARD      0
+#define TUSB_REQ_TYPE_CLASS         1
+#define TUSB_REQ_TYPE_VENDOR        2
+
+typedef struct __attribute__((packed)) {
+    union {
+        struct __attribute__((packed)) {
+            uint8_t recipient : 5;
+            uint8_t type : 2;
+            uint8_t direction : 1;
+        } bmRequestType_bit;
+        uint8_t bmRequestType;
+    };
+    uint8_t  bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} tusb_control_request_t;
+
+typedef struct tuh_xfer_s tuh_xfer_t;
+typedef void (*tuh_xfer_cb_t)(tuh_xfer_t* xfer);
+
+struct tuh_xfer_s {
+    uint8_t daddr;
+    uint8_t ep_addr;
+    xfer_result_t result;
+    uint32_t actual_len;
+    const tusb_control_request_t* setup;
+    uint8_t* buffer;
+    tuh_xfer_cb_t complete_cb;
+    uintptr_t user_data;
+};
+
+#define HID_ITF_PROTOCOL_NONE       0
+#define HID_ITF_PROTOCOL_KEYBOARD   1
+#define HID_ITF_PROTOCOL_MOUSE      2
+#define HID_PROTOCOL_BOOT           0
+#define HID_PROTOCOL_REPORT         1
+
+typedef struct __attribute__((packed)) {
+    uint8_t modifier;
+    uint8_t reserved;
+    uint8_t keycode[6];
+} hid_keyboard_report_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t buttons;
+    int8_t  x;
+    int8_t  y;
+    int8_t  wheel;
+    int8_t  pan;
+} hid_mouse_report_t;
+
+bool tuh_control_xfer(tuh_xfer_t* xfer);
+uint8_t tuh_hid_interface_protocol(uint8_t dev_addr, uint8_t idx);
+bool tuh_hid_mounted(uint8_t dev_addr, uint8_t idx);
+uint8_t tuh_hid_get_protocol(uint8_t dev_addr, uint8_t idx);
+bool tuh_hid_set_protocol(uint8_t dev_addr, uint8_t idx, uint8_t protocol);
+
+// Callbacks from the HID host driver, defined by hid_app_host.c
+void tuh_hid_mount_cb(uint8_t dev_addr, uint8_t idx, uint8_t const* report_desc, uint16_t desc_len);
+void tuh_hid_umount_cb(uint8_t dev_addr, uint8_t idx);
+void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t idx, uint8_t const* report, uint16_t len);
+bool tuh_hid_send_report(uint8_t dev_addr, uint8_t idx, uint8_t report_id, const void* report, uint16_t len);
+bool tuh_hid_receive_report(uint8_t dev_addr, uint8_t idx);
@@ -0,0 +1,33 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+// Host stand-in for TinyUSB's tusb_option.h: the firmware's own
+// tusb_config.h, built for a host-only RP2040
+#pragma once
+
+#define OPT_MCU_RP2040          1
+#define OPT_MODE_HOST           0x0001
+#define OPT_MODE_HIGH_SPEED     0x0400
+#define CFG_TUSB_MCU            OPT_MCU_RP2040
+#define CFG_TUSB_DEBUG          0
+#define CFG_TUH_LOG_LEVEL       2
+
+#include "tusb_config.h"
+
+#define TUSB_OPT_HOST_ENABLED   1
@@ -0,0 +1,109 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+/*
+ * mem_fetchb/mem_fetchw against the full mem_getb decode, over the whole
+ * address space, with and without an armed watchpoint page. Built with
+ * HD6301_WATCHPOINTS=1 so both fetch paths are compiled.
+ */
+#include <stdarg.h>
+#include <stdlib.h>
+#include "test.h"
+#include "defs.h"
+#include "chip.h"
+#include "ireg.h"
+#include "watch.h"
+#include "callstac.h"
+
+static int errors;
+
+void error(const char* fmt, ...) {
+    (void)fmt;
+    errors++;
+}
+
+#include "memory.h"
+
+u_int ram_start;
+u_int ram_end;
+u_char* ram;
+u_int ireg_start;
+u_char iram[NIREGS];
+u_char (*ireg_getb_func[NIREGS])(u_int offs);
+void (*ireg_putb_func[NIREGS])(u_int offs, u_char val);
+volatile u_char watch_page_armed[256];
+
+static int watch_reads;
+
+int callstack_peek_addr(void) {
+    return 0;
+}
+
+u_char watch_getb(u_int addr) {
+    watch_reads++;
+    return mem_getb_nowatch(addr);
+}
+
+void watch_putb(u_int addr, u_char value) {
+    mem_putb_nowatch(addr, value);
+}
+
+static void test_same_bytes(void) {
+    int differ = 0;
+    for (u_int addr = 0; addr <= 0xFFFF; addr++) {
+        differ += (mem_fetchb(addr) != mem_getb(addr));
+        differ += (mem_fetchw(addr) != mem_getw(addr));
+    }
+    CHECK_EQ(differ, 0);
+    CHECK_EQ(errors, 2);        // The word reads at FFFF both run off the end
+}
+
+static void test_watch_sees_fetches(void) {
+    watch_page_armed[0xF0] = 1;
+    watch_reads = 0;
+    CHECK_EQ(mem_fetchb(0xF010), mem_getb(0xF010));
+    CHECK_EQ(watch_reads, 2);
+    CHECK_EQ(mem_fetchb(0xF110), ram[0x110 + 256]);
+    CHECK_EQ(watch_reads, 2);
+    watch_page_armed[0xF0] = 0;
+}
+
+static void test_stores_seen_at_once(void) {
+    // An uploaded routine patching its own next operand
+    mem_putb(0x0091, 0xA5);
+    CHECK_EQ(mem_fetchb(0x0091), 0xA5);
+    mem_putw(0x0090, 0x1234);
+    CHECK_EQ(mem_fetchw(0x0090), 0x1234);
+}
+
+int main(void) {
+    ram = malloc(256 + 4096);
+    ram_start = 0;
+    ram_end = MEMSIZE - 1;
+    for (int i = 0; i < 256 + 4096; i++) {
+        ram[i] = (u_char)(i * 7 + 3);
+    }
+    for (int i = 0; i < NIREGS; i++) {
+        iram[i] = (u_char)(0x40 + i);
+    }
+    test_same_bytes();
+    test_watch_sees_fetches();
+    test_stores_seen_at_once();
+    free(ram);
+    return test_report("6301_fetch");
+}
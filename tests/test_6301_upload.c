@@ -0,0 +1,271 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Conformance of code the ST uploads into the 6301's internal RAM with
+ * memory load (0x20) and runs with controller execute (0x22). Each routine
+ * is run twice through the interpreter: once as the firmware runs it, with
+ * fetches from ROM and RAM read straight from ram[] (mem_fetchb), and once
+ * with every page armed for watchpoints, so that every fetch, read and write
+ * takes the full mem_getb/mem_putb decode. Registers, cycles, RAM and the
+ * internal registers must come out the same.
+ *
+ * The interpreter sources are included as 6301.c includes them, and built
+ * as the firmware builds them (no -Wall, implicit int and implicit
+ * declarations allowed).
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "6301.h"
+
+#pragma GCC diagnostic ignored "-Wimplicit-function-declaration"
+
+#define TRACE(...)
+#define ASSERT(x)
+#define error printf
+#define warning TRACE
+
+int crashed;
+
+#include "cpu.c"
+#include "symtab.c"
+#include "memory.c"
+#include "opfunc.c"
+#include "reg.c"
+#include "instr.c"
+#include "optab.c"
+#include "timer.c"
+#include "callstac.c"
+
+u_int ireg_start;
+u_char iram[NIREGS];
+u_char (*ireg_getb_func[NIREGS])(u_int offs);
+void (*ireg_putb_func[NIREGS])(u_int offs, u_char val);
+volatile u_char watch_page_armed[256];
+
+static int decoded;     // Accesses that took the full decode via watch_*
+
+u_char watch_getb(u_int addr) {
+    decoded++;
+    return mem_getb_nowatch(addr);
+}
+
+void watch_putb(u_int addr, u_char value) {
+    decoded++;
+    mem_putb_nowatch(addr, value);
+}
+
+// Stand-in for the ROM's side: set the stack, call the loaded routine the
+// way controller execute does, then spin
+#define ROM_DONE    0xF006
+static const u_char rom[] = {
+    0x8E, 0x00, 0xFF,       // LDS  #$00FF
+    0xBD, 0x00, 0x90,       // JSR  $0090
+    0x20, 0xFE,             // BRA  *
+};
+
+typedef struct {
+    struct regs regs;
+    COUNTER_VAR cycles;
+    int         instructions;
+    u_char      ram[256];
+    u_char      iram[NIREGS];
+} outcome_t;
+
+static void run(const u_char* routine, int len, bool reference, outcome_t* out) {
+    memset(ram, 0, 256 + 4096);
+    memset(iram, 0, NIREGS);
+    memset(&regs, 0, sizeof(regs));
+    memcpy(ram + 256, rom, sizeof(rom));
+    ram[256 + 0xFFE] = 0xF0;
+    ram[256 + 0xFFF] = 0x00;
+    memset((void*)watch_page_armed, reference, sizeof(watch_page_armed));
+
+    // Memory load stores each byte it is sent
+    for (int i = 0; i < len; i++) {
+        mem_putb(0x90 + i, routine[i]);
+    }
+    cpu_reset();
+    decoded = 0;
+    int n = 0;
+    while (reg_getpc() != ROM_DONE && n < 100000) {
+        instr_exec();
+        n++;
+    }
+    memset((void*)watch_page_armed, 0, sizeof(watch_page_armed));
+
+    memset(out, 0, sizeof(*out));
+    out->regs = regs;
+    out->cycles = cpu.ncycles;
+    out->instructions = n;
+    memcpy(out->ram, ram, 256);
+    memcpy(out->iram, iram, NIREGS);
+}
+
+// Run a routine both ways; the fast run's outcome is left in *fast
+static void conform(const char* name, const u_char* routine, int len, outcome_t* fast) {
+    int failures = test_failures;
+    outcome_t ref;
+    run(routine, len, true, &ref);
+    CHECK(decoded > 0);
+    run(routine, len, false, fast);
+    CHECK_EQ(decoded, 0);
+
+    CHECK_EQ(fast->regs.pc, ROM_DONE);
+    CHECK_EQ(fast->instructions, ref.instructions);
+    CHECK_EQ(fast->cycles, ref.cycles);
+    CHECK_EQ(fast->regs.accd.a, ref.regs.accd.a);
+    CHECK_EQ(fast->regs.accd.b, ref.regs.accd.b);
+    CHECK_EQ(fast->regs.ix, ref.regs.ix);
+    CHECK_EQ(fast->regs.sp, ref.regs.sp);
+    CHECK_EQ(fast->regs.ccr, ref.regs.ccr);
+    CHECK(memcmp(fast->ram, ref.ram, 256) == 0);
+    CHECK(memcmp(fast->iram, ref.iram, NIREGS) == 0);
+    if (test_failures != failures) {
+        fprintf(stderr, "  in %s\n", name);
+    }
+}
+
+static void test_patch_own_operand(void) {
+    static const u_char code[] = {
+        0x86, 0x2A,         // 90 LDAA #$2A
+        0x97, 0x95,         // 92 STAA $95      the operand below
+        0xC6, 0x00,         // 94 LDAB #$00     runs as #$2A
+        0xD7, 0xC0,         // 96 STAB $C0
+        0x39,               // 98 RTS
+    };
+    outcome_t out;
+    conform("patch own operand", code, sizeof(code), &out);
+    CHECK_EQ(out.regs.accd.b, 0x2A);
+    CHECK_EQ(out.ram[0xC0], 0x2A);
+}
+
+static void test_patch_next_opcode(void) {
+    static const u_char code[] = {
+        0x4F,               // 90 CLRA
+        0xC6, 0x01,         // 91 LDAB #$01     NOP
+        0xD7, 0x95,         // 93 STAB $95      the very next opcode
+        0x4C,               // 95 INCA         runs as NOP
+        0x4C,               // 96 INCA
+        0x97, 0xC1,         // 97 STAA $C1
+        0x39,               // 99 RTS
+    };
+    outcome_t out;
+    conform("patch next opcode", code, sizeof(code), &out);
+    CHECK_EQ(out.ram[0xC1], 1);
+}
+
+static void test_copy_and_jump(void) {
+    static const u_char code[] = {
+        0xCE, 0x00, 0xA0,   // 90 LDX  #$00A0
+        0xA6, 0x00,         // 93 LDAA 0,X
+        0xA7, 0x30,         // 95 STAA $30,X    to D0-D7
+        0x08,               // 97 INX
+        0x8C, 0x00, 0xA8,   // 98 CPX  #$00A8
+        0x26, 0xF6,         // 9B BNE  $93
+        0x7E, 0x00, 0xD0,   // 9D JMP  $00D0
+        0x86, 0x55,         // A0 LDAA #$55     copied, runs at D0
+        0x97, 0xC2,         //    STAA $C2
+        0x4C,               //    INCA
+        0x97, 0xC3,         //    STAA $C3
+        0x39,               //    RTS
+    };
+    outcome_t out;
+    conform("copy and jump", code, sizeof(code), &out);
+    CHECK_EQ(out.ram[0xC2], 0x55);
+    CHECK_EQ(out.ram[0xC3], 0x56);
+    CHECK(memcmp(out.ram + 0xD0, code + 0x10, 8) == 0);
+}
+
+static void test_patched_jump(void) {
+    static const u_char code[] = {
+        0x86, 0xA0,         // 90 LDAA #$A0
+        0x97, 0x98,         // 92 STAA $98      low byte of the JMP target
+        0x01, 0x01,         // 94 NOP NOP
+        0x7E, 0x00, 0x9A,   // 96 JMP  $009A    runs as JMP $00A0
+        0x39,               // 99 RTS
+        0x86, 0x11,         // 9A LDAA #$11
+        0x97, 0xC0,         //    STAA $C0
+        0x39,               //    RTS
+        0x01,               // 9F NOP
+        0x86, 0x22,         // A0 LDAA #$22
+        0x97, 0xC0,         //    STAA $C0
+        0x39,               //    RTS
+    };
+    outcome_t out;
+    conform("patched jump", code, sizeof(code), &out);
+    CHECK_EQ(out.ram[0xC0], 0x22);
+}
+
+static void test_delay_loop(void) {
+    static const u_char code[] = {
+        0xC6, 0x40,         // 90 LDAB #$40
+        0x5A,               // 92 DECB
+        0x26, 0xFD,         // 93 BNE  $92
+        0x39,               // 95 RTS
+    };
+    outcome_t out;
+    conform("delay loop", code, sizeof(code), &out);
+    CHECK_EQ(out.instructions, 2 + 1 + 2 * 0x40 + 1);     // LDS and JSR first
+}
+
+static void test_port_and_timer_poll(void) {
+    static const u_char code[] = {
+        0x96, P1,           // 90 LDAA $02      port 1
+        0x97, 0xC4,         // 92 STAA $C4
+        0xDC, FRC,          // 94 LDD  $09      free-running counter
+        0xDD, 0xC6,         // 96 STD  $C6
+        0x39,               // 98 RTS
+    };
+    outcome_t out;
+    conform("port and timer poll", code, sizeof(code), &out);
+    CHECK((out.ram[0xC6] << 8 | out.ram[0xC7]) != 0);
+}
+
+static void test_words_and_bit_ops(void) {
+    static const u_char code[] = {
+        0xCC, 0x12, 0x34,   // 90 LDD  #$1234
+        0xDD, 0xC8,         // 93 STD  $C8
+        0xCE, 0xBE, 0xEF,   // 95 LDX  #$BEEF
+        0xDF, 0xCA,         // 98 STX  $CA
+        0x71, 0x0F, 0xC8,   // 9A AIM  #$0F,$C8
+        0x72, 0x80, 0xC9,   // 9D OIM  #$80,$C9
+        0x39,               // A0 RTS
+    };
+    outcome_t out;
+    conform("words and bit ops", code, sizeof(code), &out);
+    CHECK_EQ(out.ram[0xC8], 0x02);
+    CHECK_EQ(out.ram[0xC9], 0xB4);
+    CHECK_EQ(out.ram[0xCA], 0xBE);
+    CHECK_EQ(out.ram[0xCB], 0xEF);
+}
+
+int main(void) {
+    mem_init();
+    test_patch_own_operand();
+    test_patch_next_opcode();
+    test_copy_and_jump();
+    test_patched_jump();
+    test_delay_loop();
+    test_port_and_timer_poll();
+    test_words_and_bit_ops();
+    free(ram);
+    return test_report("6301_upload");
+}
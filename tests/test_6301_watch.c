@@ -0,0 +1,168 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Watchpoint slots, value filters, page arming and the hit log, run over a
+ * flat 64K RAM so every access goes through the normal mem_getb/mem_putb
+ * decode. watch.c is included here the way 6301.c includes it, after
+ * 6301.h.
+ */
+#include <stdarg.h>
+#include <stdlib.h>
+#include "test.h"
+#include "defs.h"
+#include "chip.h"
+#include "6301.h"
+#include "cpu.h"
+#include "reg.h"
+#include "ireg.h"
+#include "watch.h"
+#include "callstac.h"
+
+void error(const char* fmt, ...) {
+    (void)fmt;
+}
+
+#include "memory.h"
+
+struct cpu cpu;
+struct regs regs;
+u_int ram_start;
+u_int ram_end;
+u_char* ram;
+u_int ireg_start;
+u_char iram[NIREGS];
+u_char (*ireg_getb_func[NIREGS])(u_int offs);
+void (*ireg_putb_func[NIREGS])(u_int offs, u_char val);
+
+int callstack_peek_addr(void) {
+    return 0;
+}
+
+#include "watch.c"
+
+// reg.h's inline stack helpers call into reg.c
+int reg_setsp(u_int value) {
+    regs.sp = value;
+    return 0;
+}
+
+static void setup(void) {
+    static u_char mem[0x10000];
+    ram = mem;
+    ram_start = 0x80;
+    ram_end = 0x10000;
+    ireg_start = 0;
+}
+
+static void test_set_and_clear(void) {
+    CHECK_EQ(hd6301_watch_set(0x90, 0, 0, 0), -1);     // Neither read nor write
+    int slot = hd6301_watch_set(0x90, HD6301_WATCH_WRITE, 0, 0);
+    CHECK_EQ(slot, 0);
+    CHECK(watch_page_armed[0x00]);
+    CHECK(!watch_page_armed[0x01]);
+
+    mem_putb(0x90, 1);
+    mem_putb(0x91, 1);              // Same page, other address
+    mem_getb(0x90);                 // Reads not watched
+    CHECK_EQ(hd6301_watch_hits(slot), 1);
+    CHECK_EQ(mem_getb(0x90), 1);    // The write still lands
+
+    CHECK_EQ(hd6301_watch_clear(slot), 0);
+    CHECK_EQ(hd6301_watch_clear(slot), -1);
+    CHECK(!watch_page_armed[0x00]);
+    mem_putb(0x90, 2);
+    CHECK_EQ(hd6301_watch_hits(slot), 1);
+}
+
+static void test_slots_fill(void) {
+    for (int i = 0; i < WATCH_MAX; i++) {
+        CHECK_EQ(hd6301_watch_set(0x100 * (i + 1), HD6301_WATCH_READ, 0, 0), i);
+    }
+    CHECK_EQ(hd6301_watch_set(0x9000, HD6301_WATCH_READ, 0, 0), -1);
+    CHECK_EQ(hd6301_watch_clear(3), 0);
+    CHECK_EQ(hd6301_watch_set(0x9000, HD6301_WATCH_READ, 0, 0), 3);
+    CHECK(!watch_page_armed[0x04]);
+    CHECK(watch_page_armed[0x90]);
+    hd6301_watch_clear_all();
+    int armed = 0;
+    for (int i = 0; i < 256; i++) {
+        armed += watch_page_armed[i];
+    }
+    CHECK_EQ(armed, 0);
+}
+
+static void test_value_filter(void) {
+    int slot = hd6301_watch_set(0xD5, HD6301_WATCH_WRITE | HD6301_WATCH_VALUE, 0x40, 0xF0);
+    mem_putb(0xD5, 0x4A);
+    mem_putb(0xD5, 0x3A);
+    mem_putb(0xD5, 0x41);
+    CHECK_EQ(hd6301_watch_hits(slot), 2);
+    hd6301_watch_clear_all();
+}
+
+static void test_hit_log(void) {
+    hd6301_watch_hit_t hit;
+    int counted = hd6301_watch_set(0xA0, HD6301_WATCH_READ, 0, 0);
+    int logged = hd6301_watch_set(0xA1, HD6301_WATCH_READ | HD6301_WATCH_WRITE | HD6301_WATCH_LOG, 0, 0);
+
+    mem_getb(0xA0);
+    CHECK(!hd6301_watch_pop_hit(&hit));                 // Count only
+
+    cpu.ncycles = 1234;
+    regs.pc = 0xF100;
+    mem_putb(0xA1, 0x5A);
+    CHECK(hd6301_watch_pop_hit(&hit));
+    CHECK_EQ(hit.slot, logged);
+    CHECK_EQ(hit.addr, 0xA1);
+    CHECK_EQ(hit.value, 0x5A);
+    CHECK_EQ(hit.access, HD6301_WATCH_WRITE);
+    CHECK_EQ(hit.pc, 0xF100);
+    CHECK_EQ((int)hit.cycles, 1234);
+    CHECK(!hd6301_watch_pop_hit(&hit));
+
+    // The ring keeps the oldest hits, the rest are only counted
+    for (int i = 0; i < WATCH_RING_SIZE + 5; i++) {
+        cpu.ncycles = i;
+        mem_getb(0xA1);
+    }
+    int popped = 0;
+    while (hd6301_watch_pop_hit(&hit)) {
+        CHECK_EQ((int)hit.cycles, popped);
+        CHECK_EQ(hit.access, HD6301_WATCH_READ);
+        popped++;
+    }
+    CHECK_EQ(popped, WATCH_RING_SIZE);
+    CHECK_EQ(hd6301_watch_hits(logged), WATCH_RING_SIZE + 6);
+    CHECK_EQ(hd6301_watch_hits(counted), 1);
+
+    // clear_all drops anything still queued
+    mem_getb(0xA1);
+    hd6301_watch_clear_all();
+    CHECK(!hd6301_watch_pop_hit(&hit));
+}
+
+int main(void) {
+    setup();
+    test_set_and_clear();
+    test_slots_fill();
+    test_value_filter();
+    test_hit_log();
+    return test_report("6301_watch");
+}
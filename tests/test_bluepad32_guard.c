@@ -0,0 +1,175 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "test.h"
+#include "bluepad32_guard.h"
+#include "config.h"
+#include "telemetry.h"
+#include <btstack.h>
+#include <pico/time.h>
+
+// Fake BTstack run loop with one timer slot, on the host clock
+static btstack_timer_source_t* armed;
+static uint64_t due_us;
+
+void btstack_run_loop_set_timer_handler(btstack_timer_source_t* ts,
+                                        void (*process)(btstack_timer_source_t* ts)) {
+    ts->process = process;
+}
+
+void btstack_run_loop_set_timer(btstack_timer_source_t* ts, uint32_t timeout_in_ms) {
+    ts->timeout = timeout_in_ms;
+}
+
+void btstack_run_loop_add_timer(btstack_timer_source_t* ts) {
+    armed = ts;
+    due_us = host_time_us + (uint64_t)ts->timeout * 1000;
+}
+
+int btstack_run_loop_remove_timer(btstack_timer_source_t* ts) {
+    if (armed != ts) {
+        return 0;
+    }
+    armed = NULL;
+    return 1;
+}
+
+// Advance the clock in 1 ms steps, firing the timer when due
+static void run_ms(uint32_t ms) {
+    while (ms--) {
+        host_time_us += 1000;
+        if (armed && host_time_us >= due_us) {
+            btstack_timer_source_t* ts = armed;
+            armed = NULL;
+            ts->process(ts);
+        }
+    }
+}
+
+// Core 1 pause depth as core1_link keeps it
+static int depth;
+
+void core1_pause_for_bt_enumeration(void) {
+    depth++;
+}
+
+void core1_resume_after_bt_enumeration(void) {
+    CHECK(depth > 0);
+    depth--;
+}
+
+void core1_wait_for_pause_active(uint32_t timeout_ms) {
+    (void)timeout_ms;
+}
+
+int __wrap_flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms);
+
+static uint32_t write_ms;
+
+int __real_flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    CHECK(depth > 0);               // Core 1 is parked for every write
+    func(param);
+    host_time_us += (uint64_t)write_ms * 1000;
+    return 0;
+}
+
+static int writes;
+
+static void write_flash(void* param) {
+    (void)param;
+    writes++;
+}
+
+static void flash_write(uint32_t ms) {
+    write_ms = ms;
+    CHECK_EQ(__wrap_flash_safe_execute(write_flash, NULL, 100), 0);
+}
+
+static void test_release_waits_for_quiet_flash(void) {
+    bluepad32_guard_hold();
+    bluepad32_guard_hold();         // Repeat calls do not nest
+    CHECK(bluepad32_guard_active());
+    CHECK_EQ(depth, 1);
+
+    run_ms(10);
+    flash_write(5);
+    CHECK_EQ(depth, 1);
+    bluepad32_guard_release();
+    CHECK(bluepad32_guard_active());
+
+    // A second write restarts the quiet window
+    run_ms(BT_FLASH_QUIET_MS / 2);
+    flash_write(5);
+    run_ms(BT_FLASH_QUIET_MS - 1);
+    CHECK(bluepad32_guard_active());
+    run_ms(1);
+    CHECK(!bluepad32_guard_active());
+    CHECK_EQ(depth, 0);
+    CHECK(armed == NULL);
+    CHECK_EQ(writes, 2);
+}
+
+static void test_release_when_already_quiet(void) {
+    run_ms(BT_FLASH_QUIET_MS);
+    bluepad32_guard_hold();
+    run_ms(3);
+    bluepad32_guard_release();
+    CHECK(!bluepad32_guard_active());
+    CHECK_EQ(depth, 0);
+    bluepad32_guard_release();      // Not holding: nothing to do
+    CHECK_EQ(depth, 0);
+}
+
+static void test_hold_is_capped(void) {
+    uint32_t capped = telemetry_counter(TM_BT_PAUSE_CAPPED);
+    bluepad32_guard_hold();
+    run_ms(BT_ENUM_PAUSE_MAX_MS - 1);
+    CHECK(bluepad32_guard_active());
+    run_ms(1);
+    CHECK(!bluepad32_guard_active());
+    CHECK_EQ(depth, 0);
+    CHECK_EQ(telemetry_counter(TM_BT_PAUSE_CAPPED), capped + 1);
+}
+
+static void test_hold_again_cancels_release(void) {
+    bluepad32_guard_hold();
+    flash_write(1);
+    bluepad32_guard_release();
+    bluepad32_guard_hold();         // Another pad started enumerating
+    run_ms(BT_FLASH_QUIET_MS * 4);
+    CHECK(bluepad32_guard_active());
+    bluepad32_guard_release();
+    CHECK(!bluepad32_guard_active());
+    CHECK_EQ(depth, 0);
+}
+
+static void test_write_without_hold(void) {
+    flash_write(2);
+    CHECK_EQ(depth, 0);
+    CHECK(!bluepad32_guard_active());
+}
+
+int main(void) {
+    test_release_waits_for_quiet_flash();
+    test_release_when_already_quiet();
+    test_hold_is_capped();
+    test_hold_again_cancels_release();
+    test_write_without_hold();
+    return test_report("bluepad32_guard");
+}
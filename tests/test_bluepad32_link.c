@@ -0,0 +1,202 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Replays HCI events, byte for byte as they appear in a btsnoop log of a
+ * BLE pad and a Classic pad, through bluepad32_link.c and checks the GAP
+ * requests it makes and what 'btlink' prints.
+ */
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "bluepad32_link.h"
+#include "config.h"
+#include <btstack.h>
+
+// Fake BTstack: records what the link tuning asks for
+static btstack_packet_handler_t handler;
+static int le_updates;
+static hci_con_handle_t le_update_handle;
+static uint16_t le_update_min, le_update_max, le_update_latency, le_update_timeout;
+static int sniff_exits;
+static hci_con_handle_t sniff_exit_handle;
+static uint16_t link_policy;
+
+void hci_add_event_handler(btstack_packet_callback_registration_t* callback_handler) {
+    handler = callback_handler->callback;
+}
+
+void gap_set_connection_parameters(uint16_t conn_scan_interval, uint16_t conn_scan_window,
+                                   uint16_t conn_interval_min, uint16_t conn_interval_max,
+                                   uint16_t conn_latency, uint16_t supervision_timeout,
+                                   uint16_t min_ce_length, uint16_t max_ce_length) {
+    (void)conn_scan_interval; (void)conn_scan_window; (void)min_ce_length; (void)max_ce_length;
+    CHECK_EQ(conn_interval_min, BT_LE_CONN_INTERVAL_MIN);
+    CHECK_EQ(conn_interval_max, BT_LE_CONN_INTERVAL_MAX);
+    CHECK_EQ(conn_latency, 0);
+    CHECK_EQ(supervision_timeout, BT_LE_SUPERVISION_TIMEOUT);
+}
+
+int gap_update_connection_parameters(hci_con_handle_t con_handle, uint16_t conn_interval_min,
+                                     uint16_t conn_interval_max, uint16_t conn_latency,
+                                     uint16_t supervision_timeout) {
+    le_updates++;
+    le_update_handle = con_handle;
+    le_update_min = conn_interval_min;
+    le_update_max = conn_interval_max;
+    le_update_latency = conn_latency;
+    le_update_timeout = supervision_timeout;
+    return 0;
+}
+
+void gap_set_default_link_policy_settings(uint16_t default_link_policy_settings) {
+    link_policy = default_link_policy_settings;
+}
+
+uint8_t gap_sniff_mode_exit(hci_con_handle_t con_handle) {
+    sniff_exits++;
+    sniff_exit_handle = con_handle;
+    return 0;
+}
+
+#define REPLAY(...) do { \
+        uint8_t ev_[] = { __VA_ARGS__ }; \
+        handler(HCI_EVENT_PACKET, 0, ev_, sizeof(ev_)); \
+    } while (0)
+
+#define PEER_ADDR   0x11, 0x22, 0x33, 0x44, 0x55, 0x66
+
+static char out[2048];
+
+// bluepad32_link_print() with stdout sent to a temporary file
+static const char* btlink(void) {
+    fflush(stdout);
+    int saved = dup(1);
+    FILE* tmp = tmpfile();
+    dup2(fileno(tmp), 1);
+    bluepad32_link_print();
+    fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+    rewind(tmp);
+    size_t n = fread(out, 1, sizeof(out) - 1, tmp);
+    out[n] = '\0';
+    fclose(tmp);
+    return out;
+}
+
+static void test_init(void) {
+    bluepad32_link_init();
+    CHECK(handler != NULL);
+    CHECK_EQ(link_policy, LM_LINK_POLICY_ENABLE_ROLE_SWITCH);     // No sniff
+    CHECK(strstr(btlink(), "no links") != NULL);
+}
+
+static void test_le_pad(void) {
+    // LE Connection Complete: handle 0x0040, 30 ms, peripheral latency 4
+    REPLAY(0x3E, 0x13, 0x01, 0x00, 0x40, 0x00, 0x01, 0x00, PEER_ADDR,
+           0x18, 0x00, 0x04, 0x00, 0xF4, 0x01, 0x00);
+    CHECK_EQ(le_updates, 1);
+    CHECK_EQ(le_update_handle, 0x0040);
+    CHECK_EQ(le_update_min, BT_LE_CONN_INTERVAL_MIN);
+    CHECK_EQ(le_update_max, BT_LE_CONN_INTERVAL_MAX);
+    CHECK_EQ(le_update_latency, 0);
+    CHECK_EQ(le_update_timeout, BT_LE_SUPERVISION_TIMEOUT);
+
+    // The peer rejects it (0x3B, unacceptable connection parameters). The
+    // other fields of a failed event carry nothing; the link is unchanged.
+    REPLAY(0x3E, 0x0A, 0x03, 0x3B, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+    CHECK_EQ(le_updates, 1);
+    CHECK(strstr(btlink(), "0040 LE      interval 30.00 ms latency 4 (1 requests)") != NULL);
+
+    // Accepted on a later attempt by the peer's own procedure: 7.5 ms
+    REPLAY(0x3E, 0x0A, 0x03, 0x00, 0x40, 0x00, 0x06, 0x00, 0x00, 0x00, 0xC8, 0x00);
+    CHECK_EQ(le_updates, 1);
+    CHECK(strstr(btlink(), "0040 LE      interval 7.50 ms latency 0") != NULL);
+
+    // The peer slows down again; asked back, within the request budget
+    for (int i = 0; i < BT_LINK_MAX_REQUESTS + 2; i++) {
+        REPLAY(0x3E, 0x0A, 0x03, 0x00, 0x40, 0x00, 0x28, 0x00, 0x00, 0x00, 0xC8, 0x00);
+    }
+    CHECK_EQ(le_updates, BT_LINK_MAX_REQUESTS);
+
+    // Disconnection Complete, reason 0x13 (remote user terminated)
+    REPLAY(0x05, 0x04, 0x00, 0x40, 0x00, 0x13);
+    CHECK(strstr(btlink(), "no links") != NULL);
+}
+
+static void test_failed_le_connection(void) {
+    int before = le_updates;
+    // Status 0x3E (connection failed to be established): no link
+    REPLAY(0x3E, 0x13, 0x01, 0x3E, 0x41, 0x00, 0x01, 0x00, PEER_ADDR,
+           0x18, 0x00, 0x04, 0x00, 0xF4, 0x01, 0x00);
+    CHECK_EQ(le_updates, before);
+    CHECK(strstr(btlink(), "no links") != NULL);
+}
+
+static void test_classic_pad(void) {
+    // Connection Complete: ACL link, handle 0x000B
+    REPLAY(0x03, 0x0B, 0x00, 0x0B, 0x00, PEER_ADDR, 0x01, 0x00);
+    CHECK(strstr(btlink(), "000b Classic active (0 exits)") != NULL);
+
+    // Mode Change to sniff, 800 slots (500 ms)
+    REPLAY(0x14, 0x06, 0x00, 0x0B, 0x00, 0x02, 0x20, 0x03);
+    CHECK_EQ(sniff_exits, 1);
+    CHECK_EQ(sniff_exit_handle, 0x000B);
+    CHECK(strstr(btlink(), "000b Classic sniff 500.000 ms (1 exits)") != NULL);
+
+    // A failed Mode Change (0x0C, command disallowed) changes nothing
+    REPLAY(0x14, 0x06, 0x0C, 0x0B, 0x00, 0x00, 0x00, 0x00);
+    CHECK_EQ(sniff_exits, 1);
+    CHECK(strstr(btlink(), "000b Classic sniff 500.000 ms") != NULL);
+
+    // Back to active
+    REPLAY(0x14, 0x06, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x00);
+    CHECK_EQ(sniff_exits, 1);
+    CHECK(strstr(btlink(), "000b Classic active (1 exits)") != NULL);
+
+    // ST off: peers may sniff, nothing is asked
+    bluepad32_link_set_low_latency(false);
+    CHECK_EQ(link_policy, LM_LINK_POLICY_ENABLE_ROLE_SWITCH | LM_LINK_POLICY_ENABLE_SNIFF_MODE);
+    REPLAY(0x14, 0x06, 0x00, 0x0B, 0x00, 0x02, 0x20, 0x03);
+    CHECK_EQ(sniff_exits, 1);
+
+    // ST back: the sniffing link is taken out straight away
+    bluepad32_link_set_low_latency(true);
+    CHECK_EQ(link_policy, LM_LINK_POLICY_ENABLE_ROLE_SWITCH);
+    CHECK_EQ(sniff_exits, 2);
+
+    REPLAY(0x05, 0x04, 0x00, 0x0B, 0x00, 0x13);
+    CHECK(strstr(btlink(), "no links") != NULL);
+}
+
+static void test_sco_ignored(void) {
+    // Connection Complete for a SCO link (type 0x00) is not tracked
+    REPLAY(0x03, 0x0B, 0x00, 0x0C, 0x00, PEER_ADDR, 0x00, 0x00);
+    CHECK(strstr(btlink(), "no links") != NULL);
+}
+
+int main(void) {
+    test_init();
+    test_le_pad();
+    test_failed_le_connection();
+    test_classic_pad();
+    test_sco_ignored();
+    return test_report("bluepad32_link");
+}
@@ -0,0 +1,83 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "test.h"
+#include "Console.h"
+#include <string.h>
+
+static void test_tokenize(void) {
+    char line[] = "  set\tcpu_khz   200000 ";
+    char* argv[CONSOLE_MAX_ARGS];
+    CHECK_EQ(Console::tokenize(line, argv, CONSOLE_MAX_ARGS), 3);
+    CHECK(strcmp(argv[0], "set") == 0);
+    CHECK(strcmp(argv[1], "cpu_khz") == 0);
+    CHECK(strcmp(argv[2], "200000") == 0);
+
+    char blank[] = " \t ";
+    CHECK_EQ(Console::tokenize(blank, argv, CONSOLE_MAX_ARGS), 0);
+}
+
+static void test_tokenize_max_args(void) {
+    char line[] = "a b c d";
+    char* argv[2];
+    // Stops at max_args; the rest of the line is left alone
+    CHECK_EQ(Console::tokenize(line, argv, 2), 2);
+    CHECK(strcmp(argv[0], "a") == 0);
+    CHECK(strcmp(argv[1], "b") == 0);
+}
+
+static void test_parse_int(void) {
+    int32_t v = 0;
+    CHECK(Console::parse_int("0", v));
+    CHECK_EQ(v, 0);
+    CHECK(Console::parse_int("-42", v));
+    CHECK_EQ(v, -42);
+    CHECK(Console::parse_int("$fa", v));
+    CHECK_EQ(v, 0xFA);
+    CHECK(Console::parse_int("0x7FFFFFFF", v));
+    CHECK_EQ(v, INT32_MAX);
+    CHECK(Console::parse_int("-2147483648", v));
+    CHECK_EQ(v, INT32_MIN);
+    CHECK(Console::parse_int("-$10", v));
+    CHECK_EQ(v, -16);
+}
+
+static void test_parse_int_rejects(void) {
+    int32_t v = 1234;
+    CHECK(!Console::parse_int("", v));
+    CHECK(!Console::parse_int("-", v));
+    CHECK(!Console::parse_int("$", v));
+    CHECK(!Console::parse_int("0x", v));
+    CHECK(!Console::parse_int("--1", v));
+    CHECK(!Console::parse_int("-+1", v));
+    CHECK(!Console::parse_int("12ab", v));
+    CHECK(!Console::parse_int("2147483648", v));
+    CHECK(!Console::parse_int("-2147483649", v));
+    CHECK(!Console::parse_int("0x100000000", v));
+    CHECK(!Console::parse_int("99999999999999999999", v));
+    CHECK_EQ(v, 1234);      // Untouched on failure
+}
+
+int main() {
+    test_tokenize();
+    test_tokenize_max_args();
+    test_parse_int();
+    test_parse_int_rejects();
+    return test_report("console");
+}
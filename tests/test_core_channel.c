@@ -0,0 +1,148 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <pthread.h>
+#include <sched.h>
+#include "test.h"
+#include "core_channel.h"
+
+#define RING        8
+#define MESSAGES    100000
+
+static void test_spsc_single(void) {
+    cc_spsc_t q = { 0, 0 };
+    uint32_t ring[RING];
+
+    CHECK_EQ(cc_spsc_space(&q, RING), RING);
+    CHECK_EQ(cc_spsc_count(&q), 0);
+    for (uint32_t i = 0; i < RING; i++) {
+        ring[cc_spsc_head(&q) & (RING - 1)] = i;
+        cc_spsc_push(&q);
+    }
+    CHECK_EQ(cc_spsc_space(&q, RING), 0);
+    CHECK_EQ(cc_spsc_count(&q), RING);
+    CHECK_EQ(ring[cc_spsc_tail(&q) & (RING - 1)], 0);
+    cc_spsc_pop(&q);
+    CHECK_EQ(cc_spsc_space(&q, RING), 1);
+
+    // pop_to skips ahead, never back
+    cc_spsc_pop_to(&q, 5);
+    CHECK_EQ(cc_spsc_count(&q), RING - 5);
+    cc_spsc_pop_to(&q, 2);
+    CHECK_EQ(cc_spsc_tail(&q), 5);
+    CHECK_EQ(ring[cc_spsc_tail(&q) & (RING - 1)], 5);
+}
+
+static void test_spsc_wraps(void) {
+    // Head and tail are free-running counters
+    cc_spsc_t q = { 0xFFFFFFFEu, 0xFFFFFFFEu };
+    for (int i = 0; i < 4; i++) {
+        cc_spsc_push(&q);
+    }
+    CHECK_EQ(q.head, 2);
+    CHECK_EQ(cc_spsc_count(&q), 4);
+    CHECK_EQ(cc_spsc_space(&q, RING), RING - 4);
+    cc_spsc_pop_to(&q, 1);
+    CHECK_EQ(cc_spsc_count(&q), 1);
+}
+
+static cc_spsc_t queue;
+static uint32_t ring[RING];
+
+static void* producer(void* arg) {
+    (void)arg;
+    for (uint32_t i = 1; i <= MESSAGES;) {
+        if (cc_spsc_space(&queue, RING)) {
+            ring[cc_spsc_head(&queue) & (RING - 1)] = i++;
+            cc_spsc_push(&queue);
+        } else {
+            sched_yield();      // The host may have fewer cores than threads
+        }
+    }
+    return NULL;
+}
+
+static void test_spsc_threads(void) {
+    pthread_t t;
+    uint32_t expect = 1;
+    int bad = 0;
+    pthread_create(&t, NULL, producer, NULL);
+    while (expect <= MESSAGES) {
+        if (cc_spsc_count(&queue)) {
+            bad += (ring[cc_spsc_tail(&queue) & (RING - 1)] != expect);
+            expect++;
+            cc_spsc_pop(&queue);
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(t, NULL);
+    CHECK_EQ(bad, 0);
+    CHECK_EQ(cc_spsc_count(&queue), 0);
+}
+
+// The writer keeps b == ~a; a reader must never see a mixed pair
+static cc_seq_t seq;
+static uint32_t field_a;
+static uint32_t field_b = ~0u;
+static uint32_t writer_done;
+
+static void* writer(void* arg) {
+    (void)arg;
+    for (uint32_t i = 1; i <= MESSAGES; i++) {
+        cc_seq_write_begin(&seq);
+        cc_seq_put(&field_a, i);
+        cc_seq_put(&field_b, ~i);
+        cc_seq_write_end(&seq);
+    }
+    cc_put_release(&writer_done, 1);
+    return NULL;
+}
+
+static void test_seq_threads(void) {
+    pthread_t t;
+    int torn = 0;
+    uint32_t last = 0;
+    int backwards = 0;
+    pthread_create(&t, NULL, writer, NULL);
+    while (!cc_get_acquire(&writer_done)) {
+        uint32_t s, a, b;
+        do {
+            s = cc_seq_read_begin(&seq);
+            a = cc_seq_get(&field_a);
+            b = cc_seq_get(&field_b);
+        } while (cc_seq_read_retry(&seq, s));
+        torn += (b != ~a);
+        backwards += (a < last);
+        last = a;
+        sched_yield();
+    }
+    pthread_join(t, NULL);
+    CHECK_EQ(torn, 0);
+    CHECK_EQ(backwards, 0);
+    CHECK_EQ(cc_seq_get(&field_a), MESSAGES);
+    CHECK_EQ(seq.seq, 2 * MESSAGES);
+}
+
+int main(void) {
+    test_spsc_single();
+    test_spsc_wraps();
+    test_spsc_threads();
+    test_seq_threads();
+    return test_report("core_channel");
+}
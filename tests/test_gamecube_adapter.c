@@ -0,0 +1,245 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <string.h>
+#include "test.h"
+#include "gamecube_adapter.h"
+#include "config.h"
+#include "telemetry.h"
+#include "tusb.h"
+#include "pico/time.h"
+
+#define DEV     2
+
+// Fake host stack: control requests complete when the test says so
+static bool ctrl_busy, out_busy;
+static tuh_xfer_t ctrl;
+static tusb_control_request_t ctrl_setup;
+static int ctrl_count;
+static int starts[8];
+static int receives;
+
+bool tuh_control_xfer(tuh_xfer_t* xfer) {
+    if (ctrl_busy) {
+        return false;
+    }
+    ctrl = *xfer;
+    ctrl_setup = *xfer->setup;
+    ctrl.setup = &ctrl_setup;
+    ctrl_count++;
+    return true;
+}
+
+bool tuh_hid_send_report(uint8_t dev_addr, uint8_t idx, uint8_t report_id, const void* report, uint16_t len) {
+    (void)dev_addr; (void)report_id;
+    if (out_busy) {
+        return false;
+    }
+    CHECK(len == 1 && *(const uint8_t*)report == 0x13);
+    starts[idx]++;
+    return true;
+}
+
+bool tuh_hid_receive_report(uint8_t dev_addr, uint8_t idx) {
+    (void)dev_addr; (void)idx;
+    receives++;
+    return true;
+}
+
+void usb_map_register_gamepad(uint8_t dev_addr, const char* name) {
+    (void)dev_addr; (void)name;
+}
+
+void usb_map_unregister_gamepad(uint8_t dev_addr) {
+    (void)dev_addr;
+}
+
+static void ctrl_done(void) {
+    ctrl.result = XFER_RESULT_STALLED;     // The official adapter may refuse PC mode
+    ctrl.complete_cb(&ctrl);
+}
+
+static void report(void) {
+    uint8_t r[37] = { 0x21 };
+    r[1 + 9] = 0x10;                       // Normal controller in port 2
+    CHECK(gc_process_report(DEV, r, sizeof(r)));
+}
+
+static uint8_t state(void) {
+    gc_adapter_t* a = gc_get_adapter(DEV);
+    CHECK(a != NULL);
+    return a ? a->state : 0xFF;
+}
+
+static void reset(void) {
+    gc_unmount_cb(DEV);
+    ctrl_busy = out_busy = false;
+    ctrl_count = receives = 0;
+    memset(starts, 0, sizeof(starts));
+}
+
+static void test_bring_up(void) {
+    reset();
+    CHECK(gc_attach(DEV, 0));
+    CHECK_EQ(state(), GC_STATE_MODE_SWITCH);
+    CHECK_EQ(ctrl_count, 1);
+    CHECK_EQ(ctrl_setup.bRequest, 11);
+    CHECK_EQ(ctrl_setup.wValue, 1);
+    CHECK_EQ(starts[0], 0);
+
+    ctrl_done();
+    CHECK_EQ(starts[0], 1);
+    CHECK_EQ(receives, 1);
+    CHECK_EQ(state(), GC_STATE_WAIT_REPORT);
+
+    report();
+    CHECK_EQ(state(), GC_STATE_STREAMING);
+    CHECK_EQ(gc_get_adapter(DEV)->active_port, 1);
+    CHECK_EQ(gc_connected_count(), 1);
+}
+
+static void test_mode_switch_timeout(void) {
+    reset();
+    gc_attach(DEV, 0);
+    host_time_us += (GC_MODE_SWITCH_TIMEOUT_MS - 1) * 1000ull;
+    gc_task();
+    CHECK_EQ(starts[0], 0);
+    host_time_us += 1000;
+    gc_task();
+    CHECK_EQ(starts[0], 1);
+    CHECK_EQ(state(), GC_STATE_WAIT_REPORT);
+
+    // The request completing late changes nothing
+    ctrl_done();
+    CHECK_EQ(starts[0], 1);
+}
+
+static void test_busy_pipes(void) {
+    reset();
+    ctrl_busy = true;
+    out_busy = true;
+    gc_attach(DEV, 0);
+    CHECK_EQ(state(), GC_STATE_START);     // Skipped the mode switch
+    gc_task();
+    gc_task();
+    CHECK_EQ(starts[0], 0);
+    CHECK_EQ(state(), GC_STATE_START);
+    out_busy = false;
+    gc_task();
+    CHECK_EQ(starts[0], 1);
+    CHECK_EQ(state(), GC_STATE_WAIT_REPORT);
+}
+
+static void test_start_retries(void) {
+    uint32_t retries = telemetry_counter(TM_GC_START_RETRY);
+    reset();
+    gc_attach(DEV, 0);
+    ctrl_done();
+    for (int i = 0; i < GC_START_RETRIES + 2; i++) {
+        host_time_us += GC_FIRST_REPORT_TIMEOUT_MS * 1000ull;
+        gc_task();
+    }
+    CHECK_EQ(starts[0], 1 + GC_START_RETRIES);
+    CHECK_EQ(telemetry_counter(TM_GC_START_RETRY), retries + GC_START_RETRIES);
+
+    // A report still brings it up
+    report();
+    CHECK_EQ(state(), GC_STATE_STREAMING);
+}
+
+static void test_second_interface(void) {
+    reset();
+    gc_attach(DEV, 0);
+    gc_attach(DEV, 1);                      // Mounted during bring-up of 0
+    CHECK_EQ(ctrl_count, 1);
+    ctrl_done();
+    CHECK_EQ(starts[0], 1);
+    CHECK_EQ(ctrl_count, 2);                // Then straight on to 1
+    CHECK_EQ(ctrl_setup.wIndex, 1);
+
+    // Interface 0 streams before 1 has finished its mode switch
+    report();
+    ctrl_done();
+    CHECK_EQ(starts[1], 1);
+    report();
+    CHECK_EQ(state(), GC_STATE_STREAMING);
+}
+
+static void test_attach_while_streaming(void) {
+    reset();
+    gc_attach(DEV, 0);
+    ctrl_done();
+    report();
+    gc_attach(DEV, 1);
+    CHECK_EQ(state(), GC_STATE_MODE_SWITCH);
+    ctrl_done();
+    CHECK_EQ(starts[1], 1);
+    report();
+    CHECK_EQ(state(), GC_STATE_STREAMING);
+
+    gc_unmount_cb(DEV);
+    CHECK(gc_get_adapter(DEV) == NULL);
+    CHECK_EQ(gc_connected_count(), 0);
+}
+
+// Nothing in bring-up may wait. The stubs' sleep_ms() and busy_wait_us()
+// advance host_time_us, so it must stand still across every entry point.
+static void test_never_blocks(void) {
+    reset();
+    const uint64_t t0 = host_time_us;
+    CHECK(gc_attach(DEV, 0));
+    CHECK_EQ(host_time_us, t0);
+    gc_attach(DEV, 1);
+    CHECK_EQ(host_time_us, t0);
+    gc_task();
+    CHECK_EQ(host_time_us, t0);
+
+    out_busy = true;
+    ctrl_done();                            // Start for 0 finds the pipe busy
+    CHECK_EQ(host_time_us, t0);
+    gc_task();
+    CHECK_EQ(host_time_us, t0);
+    out_busy = false;
+    gc_task();
+    CHECK_EQ(starts[0], 1);
+    CHECK_EQ(host_time_us, t0);
+
+    report();
+    CHECK_EQ(host_time_us, t0);
+    ctrl_done();
+    CHECK_EQ(starts[1], 1);
+    CHECK_EQ(host_time_us, t0);
+    report();
+    gc_task();
+    CHECK_EQ(state(), GC_STATE_STREAMING);
+    CHECK_EQ(host_time_us, t0);
+
+    gc_unmount_cb(DEV);
+    CHECK_EQ(host_time_us, t0);
+}
+
+int main(void) {
+    test_bring_up();
+    test_mode_switch_timeout();
+    test_busy_pipes();
+    test_start_retries();
+    test_second_interface();
+    test_attach_while_streaming();
+    test_never_blocks();
+    return test_report("gamecube_adapter");
+}
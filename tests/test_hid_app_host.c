@@ -0,0 +1,349 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <string.h>
+#include "test.h"
+#include "hid_app_host.h"
+#include "hid_report_pool.h"
+#include "gamecube_adapter.h"
+#include "ps3_controller.h"
+#include "ps4_controller.h"
+#include "ps5_controller.h"
+#include "psc_controller.h"
+#include "switch_controller.h"
+#include "horipad_controller.h"
+#include "stadia_controller.h"
+#include "mount_splash.h"
+#include "telemetry.h"
+
+// Enumeration through tuh_hid_mount_cb(): which interfaces take a report
+// layout, how much of the pool they use, and that the layouts still read
+// reports after others come and go.
+
+#define GC_VID      0x057E
+#define GC_PID      0x0337
+
+// Fake host stack: the VID/PID of each address and the protocol of each
+// interface, as the test plugs them in
+static uint16_t dev_vid[16], dev_pid[16];
+static uint8_t itf_protocol[16][4];
+static uint8_t boot_set[16];
+static int gc_attached;
+
+bool tuh_vid_pid_get(uint8_t dev_addr, uint16_t* vid, uint16_t* pid) {
+    *vid = dev_vid[dev_addr];
+    *pid = dev_pid[dev_addr];
+    return true;
+}
+uint8_t tuh_hid_interface_protocol(uint8_t dev_addr, uint8_t idx) { return itf_protocol[dev_addr][idx]; }
+bool tuh_hid_mounted(uint8_t dev_addr, uint8_t idx) { (void)dev_addr; (void)idx; return true; }
+uint8_t tuh_hid_get_protocol(uint8_t dev_addr, uint8_t idx) { (void)dev_addr; (void)idx; return HID_PROTOCOL_REPORT; }
+bool tuh_hid_set_protocol(uint8_t dev_addr, uint8_t idx, uint8_t protocol) {
+    (void)idx;
+    boot_set[dev_addr] = (protocol == HID_PROTOCOL_BOOT);
+    return true;
+}
+static int receives;     // IN transfers queued
+bool tuh_hid_receive_report(uint8_t dev_addr, uint8_t idx) { (void)dev_addr; (void)idx; receives++; return true; }
+
+// Controllers with their own drivers: only the GameCube adapter is plugged in
+bool gc_is_adapter(uint16_t vid, uint16_t pid) { return vid == GC_VID && pid == GC_PID; }
+bool gc_attach(uint8_t dev_addr, uint8_t instance) { (void)dev_addr; (void)instance; gc_attached++; return true; }
+bool gc_process_report(uint8_t dev_addr, const uint8_t* report, uint16_t len) { (void)dev_addr; (void)report; (void)len; return true; }
+void gc_unmount_cb(uint8_t dev_addr) { (void)dev_addr; }
+void gc_notify_mount(uint8_t dev_addr) { (void)dev_addr; }
+#define NOT_PLUGGED(is, mount, unmount, process, ret) \
+    bool is(uint16_t vid, uint16_t pid) { (void)vid; (void)pid; return false; } \
+    void mount(uint8_t dev_addr) { (void)dev_addr; } \
+    void unmount(uint8_t dev_addr) { (void)dev_addr; } \
+    ret process(uint8_t dev_addr, const uint8_t* report, uint16_t len) { (void)dev_addr; (void)report; (void)len; return (ret)0; }
+NOT_PLUGGED(ps3_is_dualshock3, ps3_mount_cb, ps3_unmount_cb, ps3_process_report, bool)
+NOT_PLUGGED(ps4_is_dualshock4, ps4_mount_cb, ps4_unmount_cb, ps4_process_report, bool)
+NOT_PLUGGED(ps5_is_dualsense, ps5_mount_cb, ps5_unmount_cb, ps5_process_report, bool)
+NOT_PLUGGED(psc_is_controller, psc_mount_cb, psc_unmount_cb, psc_process_report, void)
+NOT_PLUGGED(switch_is_controller, switch_mount_cb, switch_unmount_cb, switch_process_report, void)
+NOT_PLUGGED(horipad_is_controller, horipad_mount_cb, horipad_unmount_cb, horipad_process_report, void)
+bool stadia_is_controller(uint16_t vid, uint16_t pid) { (void)vid; (void)pid; return false; }
+void switch_report_sent(uint8_t dev_addr) { (void)dev_addr; }
+void mount_splash_show(uint32_t duration_ms, const char* title, const char* subtitle, const char* detail) {
+    (void)duration_ms; (void)title; (void)subtitle; (void)detail;
+}
+void xinput_notify_ui_unmount(void) { }
+void tuh_hid_mounted_cb(uint8_t dev_addr) { (void)dev_addr; }
+void tuh_hid_unmounted_cb(uint8_t dev_addr) { (void)dev_addr; }
+
+// Boot mouse: three buttons, X, Y and wheel (6 items)
+static const uint8_t mouse_desc[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05,
+    0x81, 0x01, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38,
+    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x03, 0x81, 0x06,
+    0xC0, 0xC0,
+};
+
+// Generic HID pad: X, Y, Z, Rz, a hat and 12 buttons (17 items).
+// Report: four axis bytes, hat in the low nibble, then the buttons.
+static const uint8_t pad_desc[] = {
+    0x05, 0x01, 0x09, 0x04, 0xA1, 0x01,
+    0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04,
+    0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x81, 0x02,
+    0x09, 0x39, 0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42,
+    0x81, 0x01,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x0C, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0C, 0x81, 0x02,
+    0x75, 0x04, 0x95, 0x01, 0x81, 0x01,
+    0xC0,
+};
+
+// Receiver mouse interface: report 2 with 16 buttons, 12-bit X and Y, a
+// wheel and AC Pan, which the filter drops (19 items)
+static const uint8_t receiver_mouse_desc[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x02, 0x09, 0x01, 0xA1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x10, 0x15, 0x00, 0x25, 0x01, 0x95, 0x10, 0x75, 0x01, 0x81, 0x02,
+    0x05, 0x01, 0x16, 0x01, 0xF8, 0x26, 0xFF, 0x07, 0x75, 0x0C, 0x95, 0x02, 0x09, 0x30, 0x09, 0x31, 0x81, 0x06,
+    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x01, 0x09, 0x38, 0x81, 0x06,
+    0x05, 0x0C, 0x0A, 0x38, 0x02, 0x95, 0x01, 0x81, 0x06,
+    0xC0, 0xC0,
+};
+
+// Receiver consumer control interface: nothing the filter keeps
+static const uint8_t receiver_consumer_desc[] = {
+    0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x03, 0x75, 0x10, 0x95, 0x02,
+    0x15, 0x01, 0x26, 0xFF, 0x02, 0x19, 0x01, 0x2A, 0xFF, 0x02, 0x81, 0x00, 0xC0,
+};
+
+static const uint8_t keyboard_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7,
+    0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x95, 0x01,
+    0x75, 0x08, 0x81, 0x01, 0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x65,
+    0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00, 0xC0,
+};
+
+static void plug(uint8_t addr, uint16_t vid, uint16_t pid) {
+    dev_vid[addr] = vid;
+    dev_pid[addr] = pid;
+}
+
+static void mount(uint8_t addr, uint8_t inst, uint8_t protocol, const uint8_t* desc, uint16_t len) {
+    itf_protocol[addr][inst] = protocol;
+    tuh_hid_mount_cb(addr, inst, desc, len);
+}
+
+static const HID_ReportItem_t* find_item(const hid_layout_t* layout, uint16_t page, uint16_t usage) {
+    for (int i = 0; i < layout->TotalReportItems; ++i) {
+        const HID_ReportItem_t* item = &layout->ReportItems[i];
+        if (item->Attributes.Usage.Page == page && item->Attributes.Usage.Usage == usage) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+// Read a pad report through its layout, as HidInput.cpp does
+static void check_pad_reads(uint8_t key) {
+    hid_layout_t* layout = tuh_hid_get_report_info(key);
+    CHECK(layout != NULL);
+    if (!layout) {
+        return;
+    }
+    CHECK_EQ(layout->TotalReportItems, 17);
+    static const uint8_t report[] = { 0x10, 0x80, 0x30, 0xF0, 0x03, 0x05, 0x0A };
+    int pressed = 0;
+    for (int i = 0; i < layout->TotalReportItems; ++i) {
+        HID_ReportItem_t* item = &layout->ReportItems[i];
+        CHECK(USB_GetHIDReportItemInfo(report, item));
+        CHECK_EQ(item->CollectionPath->Usage.Usage, USAGE_JOYSTICK);
+        if (item->Attributes.Usage.Page == USAGE_PAGE_BUTTON) {
+            pressed += item->Value ? 1 : 0;
+        }
+    }
+    CHECK_EQ(pressed, 4);
+    CHECK_EQ(find_item(layout, USAGE_PAGE_GENERIC_DCTRL, USAGE_X)->Value, 0x10);
+    CHECK_EQ(find_item(layout, USAGE_PAGE_GENERIC_DCTRL, USAGE_Y)->Value, 0x80);
+    CHECK_EQ(find_item(layout, USAGE_PAGE_GENERIC_DCTRL, 0x35)->Value, 0xF0);
+    CHECK_EQ(find_item(layout, USAGE_PAGE_GENERIC_DCTRL, 0x39)->Value, 3);
+}
+
+static void unplug(uint8_t addr, uint8_t interfaces) {
+    for (uint8_t inst = 0; inst < interfaces; ++inst) {
+        tuh_hid_umount_cb(addr, inst);
+    }
+}
+
+// Keyboard, mouse, two pads and a GameCube adapter on a hub
+static void test_hub(void) {
+    plug(1, 0x046D, 0xC31C);
+    mount(1, 0, HID_ITF_PROTOCOL_KEYBOARD, keyboard_desc, sizeof(keyboard_desc));
+    plug(2, 0x046D, 0xC077);
+    mount(2, 0, HID_ITF_PROTOCOL_MOUSE, mouse_desc, sizeof(mouse_desc));
+    plug(3, 0x0079, 0x0006);
+    mount(3, 0, HID_ITF_PROTOCOL_NONE, pad_desc, sizeof(pad_desc));
+    plug(4, 0x0079, 0x0006);
+    mount(4, 0, HID_ITF_PROTOCOL_NONE, pad_desc, sizeof(pad_desc));
+    plug(5, GC_VID, GC_PID);
+    mount(5, 0, HID_ITF_PROTOCOL_NONE, NULL, 0);
+
+    CHECK_EQ(tuh_hid_get_type(1), HID_KEYBOARD);
+    CHECK_EQ(tuh_hid_get_type(2 | 0x80), HID_MOUSE);
+    CHECK_EQ(tuh_hid_get_type(3), HID_JOYSTICK);
+    CHECK_EQ(tuh_hid_get_type(4), HID_JOYSTICK);
+    CHECK_EQ(tuh_hid_get_type(5), HID_JOYSTICK);
+    CHECK_EQ(gc_attached, 1);
+    CHECK(!boot_set[2]);
+
+    // Keyboard and adapter take no layout; the mouse and pads only their items
+    CHECK(tuh_hid_get_report_info(1) == NULL);
+    CHECK(tuh_hid_get_report_info(5) == NULL);
+    CHECK_EQ(tuh_hid_get_report_info(2 | 0x80)->TotalReportItems, 6);
+    CHECK_EQ(hid_report_pool_used(), 3);
+    CHECK_EQ(hid_report_pool_items_used(), 6 + 17 + 17);
+    check_pad_reads(3);
+    check_pad_reads(4);
+
+    // The mouse goes; the pads are packed down and still read the same
+    unplug(2, 1);
+    CHECK_EQ(hid_report_pool_items_used(), 17 + 17);
+    check_pad_reads(3);
+    check_pad_reads(4);
+
+    unplug(1, 1);
+    unplug(3, 1);
+    unplug(4, 1);
+    unplug(5, 1);
+    CHECK_EQ(hid_report_pool_used(), 0);
+    CHECK_EQ(hid_report_pool_items_used(), 0);
+}
+
+// A receiver with keyboard, mouse and consumer interfaces, plus two pads
+static void test_receiver_and_pads(void) {
+    uint32_t full = telemetry_counter(TM_USB_RI_FULL);
+
+    plug(6, 0x046D, 0xC52B);
+    mount(6, 0, HID_ITF_PROTOCOL_KEYBOARD, keyboard_desc, sizeof(keyboard_desc));
+    mount(6, 1, HID_ITF_PROTOCOL_MOUSE, receiver_mouse_desc, sizeof(receiver_mouse_desc));
+    mount(6, 2, HID_ITF_PROTOCOL_NONE, receiver_consumer_desc, sizeof(receiver_consumer_desc));
+    plug(7, 0x0079, 0x0006);
+    mount(7, 0, HID_ITF_PROTOCOL_NONE, pad_desc, sizeof(pad_desc));
+    plug(8, 0x0810, 0x0001);
+    mount(8, 0, HID_ITF_PROTOCOL_NONE, pad_desc, sizeof(pad_desc));
+
+    CHECK_EQ(tuh_hid_get_type(6), HID_KEYBOARD);
+    CHECK_EQ(tuh_hid_get_type(6 | 0x80), HID_MOUSE);
+    CHECK(!boot_set[6]);
+    hid_layout_t* mouse = tuh_hid_get_report_info(6 | 0x80);
+    CHECK(mouse != NULL);
+    CHECK_EQ(mouse->TotalReportItems, 19);
+    CHECK_EQ(mouse->ReportItems[0].ReportID, 2);
+    CHECK_EQ(hid_report_pool_used(), 3);
+    CHECK_EQ(hid_report_pool_items_used(), 19 + 17 + 17);
+    CHECK_EQ(telemetry_counter(TM_USB_RI_FULL), full);
+    check_pad_reads(7);
+    check_pad_reads(8);
+
+    // A third pad no longer fits: refused, counted, not mounted
+    plug(9, 0x0079, 0x0011);
+    mount(9, 0, HID_ITF_PROTOCOL_NONE, pad_desc, sizeof(pad_desc));
+    CHECK_EQ(telemetry_counter(TM_USB_RI_FULL), full + 1);
+    CHECK_EQ(tuh_hid_get_type(9), HID_UNDEFINED);
+    CHECK_EQ(hid_report_pool_used(), 3);
+
+    // A second receiver's mouse does not fit either, but still mounts in
+    // boot protocol; a plain mouse fits in what is left
+    plug(10, 0x046D, 0xC52B);
+    mount(10, 0, HID_ITF_PROTOCOL_MOUSE, receiver_mouse_desc, sizeof(receiver_mouse_desc));
+    CHECK_EQ(tuh_hid_get_type(10 | 0x80), HID_MOUSE);
+    CHECK(tuh_hid_get_report_info(10 | 0x80) == NULL);
+    CHECK(boot_set[10]);
+    plug(11, 0x046D, 0xC077);
+    mount(11, 0, HID_ITF_PROTOCOL_MOUSE, mouse_desc, sizeof(mouse_desc));
+    CHECK_EQ(tuh_hid_get_report_info(11 | 0x80)->TotalReportItems, 6);
+    CHECK(!boot_set[11]);
+    CHECK_EQ(telemetry_counter(TM_USB_RI_FULL), full + 2);
+
+    // Once the receiver goes the pad fits
+    unplug(6, 3);
+    mount(9, 0, HID_ITF_PROTOCOL_NONE, pad_desc, sizeof(pad_desc));
+    CHECK_EQ(tuh_hid_get_type(9), HID_JOYSTICK);
+    check_pad_reads(7);
+    check_pad_reads(8);
+    check_pad_reads(9);
+}
+
+// Reports reach the app in place: the pointer it parses is TinyUSB's IN
+// buffer, which is not re-armed until the app hands it back. Bytes copied
+// per consumed report used to be twice its length (the per-slot buffer,
+// then HidInput's heap copy).
+static int consume(uint8_t addr, uint8_t inst, uint8_t key, uint16_t len) {
+    static uint8_t in_buf[64];      // TinyUSB's IN buffer for the interface
+    memset(in_buf, 0x5A, len);
+    receives = 0;
+    CHECK(hid_app_request_report(key));
+    CHECK(tuh_hid_is_busy(key));
+    tuh_hid_report_received_cb(addr, inst, in_buf, len);
+    CHECK(!tuh_hid_is_busy(key));
+    const uint8_t* lent = hid_app_get_report(key);
+    CHECK(lent != NULL);
+    CHECK_EQ(receives, 0);          // Held while lent
+    int copied = (lent == in_buf) ? 0 : len;
+    CHECK(hid_app_request_report(key));
+    CHECK_EQ(receives, 1);
+    CHECK(hid_app_get_report(key) == NULL);
+    return copied;
+}
+
+static void test_reports_lent_in_place(void) {
+    for (uint8_t addr = 7; addr <= 11; ++addr) {
+        unplug(addr, 1);
+    }
+    plug(12, 0x046D, 0xC31C);
+    mount(12, 0, HID_ITF_PROTOCOL_KEYBOARD, keyboard_desc, sizeof(keyboard_desc));
+    plug(13, 0x046D, 0xC077);
+    mount(13, 0, HID_ITF_PROTOCOL_MOUSE, mouse_desc, sizeof(mouse_desc));
+    plug(14, 0x0079, 0x0006);
+    mount(14, 0, HID_ITF_PROTOCOL_NONE, pad_desc, sizeof(pad_desc));
+
+    // Unasked for: dropped and the next one queued, nothing lent
+    static const uint8_t stray[8];
+    receives = 0;
+    tuh_hid_report_received_cb(12, 0, stray, sizeof(stray));
+    CHECK_EQ(receives, 1);
+    CHECK(hid_app_get_report(12) == NULL);
+
+    uint32_t lent = telemetry_counter(TM_USB_HID_LENT);
+    int copied = 0;
+    for (int i = 0; i < 100; ++i) {
+        copied += consume(12, 0, 12, 8);
+        copied += consume(13, 0, 13 | 0x80, 4);
+        copied += consume(14, 0, 14, 7);
+    }
+    CHECK_EQ(copied, 0);
+    CHECK_EQ(telemetry_counter(TM_USB_HID_LENT), lent + 300);
+    printf("hid_app_host: 300 reports (8, 4 and 7 B) consumed, %d bytes copied (was %d)\n",
+           copied, 100 * 2 * (8 + 4 + 7));
+
+    unplug(12, 1);
+    unplug(13, 1);
+    unplug(14, 1);
+}
+
+int main(void) {
+    test_hub();
+    test_receiver_and_pads();
+    test_reports_lent_in_place();
+    return test_report("hid_app_host");
+}
@@ -0,0 +1,184 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <string.h>
+#include "test.h"
+#include "hid_desc_cache.h"
+#include "telemetry.h"
+
+bool CALLBACK_HIDParser_FilterHIDReportItem(HID_ReportItem_t* const CurrentItem) {
+    (void)CurrentItem;
+    return true;
+}
+
+// Three-button mouse with X, Y and wheel, as most boot mice describe themselves
+static const uint8_t mouse_desc[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05,
+    0x81, 0x01, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38,
+    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x03, 0x81, 0x06,
+    0xC0, 0xC0,
+};
+
+static HID_ReportInfo_t parsed;
+static hid_layout_t mouse;
+
+static void test_hit_rebases_pointers(void) {
+    const hid_layout_t* cached = NULL;
+    uint8_t result = 0xFF, type = 0;
+    uint32_t hash = hid_desc_hash(mouse_desc, sizeof(mouse_desc));
+    CHECK_EQ(USB_ProcessHIDReport(mouse_desc, sizeof(mouse_desc), &parsed), HID_PARSE_Successful);
+    hid_layout_of(&parsed, &mouse);
+    CHECK(!hid_desc_cache_lookup(0x046D, 0xC077, hash, sizeof(mouse_desc), &cached, &result, &type));
+
+    hid_desc_cache_store(0x046D, 0xC077, hash, sizeof(mouse_desc), &mouse, HID_PARSE_Successful, 2);
+    uint32_t hits = telemetry_counter(TM_USB_DESC_HIT);
+    CHECK(hid_desc_cache_lookup(0x046D, 0xC077, hash, sizeof(mouse_desc), &cached, &result, &type));
+    CHECK_EQ(result, HID_PARSE_Successful);
+    CHECK_EQ(type, 2);
+    CHECK_EQ(telemetry_counter(TM_USB_DESC_HIT), hits + 1);
+
+    // Only the items and collections in use, linked to the copy's own
+    CHECK(cached != NULL);
+    CHECK_EQ(cached->TotalReportItems, parsed.TotalReportItems);
+    CHECK_EQ(cached->TotalCollections, 2);
+    CHECK(cached->TotalReportItems > 0);
+    for (int i = 0; i < cached->TotalReportItems; i++) {
+        const HID_CollectionPath_t* p = cached->ReportItems[i].CollectionPath;
+        CHECK(p >= cached->CollectionPaths && p < cached->CollectionPaths + cached->TotalCollections);
+        CHECK_EQ(p - cached->CollectionPaths, parsed.ReportItems[i].CollectionPath - parsed.CollectionPaths);
+        CHECK_EQ(cached->ReportItems[i].BitOffset, parsed.ReportItems[i].BitOffset);
+        CHECK_EQ(cached->ReportItems[i].Attributes.Usage.Usage, parsed.ReportItems[i].Attributes.Usage.Usage);
+    }
+    const HID_CollectionPath_t* inner = cached->ReportItems[0].CollectionPath;
+    CHECK(inner->Parent >= cached->CollectionPaths && inner->Parent < cached->CollectionPaths + cached->TotalCollections);
+
+    // The parse it came from can go away
+    memset(&parsed, 0, sizeof(parsed));
+    CHECK_EQ(cached->ReportItems[0].CollectionPath->Parent->Usage.Usage, 0x02);
+}
+
+static void test_key(void) {
+    const hid_layout_t* layout;
+    uint8_t result, type;
+    uint32_t hash = hid_desc_hash(mouse_desc, sizeof(mouse_desc));
+    CHECK(!hid_desc_cache_lookup(0x046D, 0xC078, hash, sizeof(mouse_desc), &layout, &result, &type));
+    CHECK(!hid_desc_cache_lookup(0x046D, 0xC077, hash ^ 1, sizeof(mouse_desc), &layout, &result, &type));
+    CHECK(!hid_desc_cache_lookup(0x046D, 0xC077, hash, sizeof(mouse_desc) - 1, &layout, &result, &type));
+
+    // One changed byte changes the hash
+    uint8_t other[sizeof(mouse_desc)];
+    memcpy(other, mouse_desc, sizeof(other));
+    other[sizeof(other) - 5] ^= 0x01;
+    CHECK(hid_desc_hash(other, sizeof(other)) != hash);
+    CHECK_EQ(hid_desc_hash(NULL, 0), 2166136261u);
+}
+
+static void test_failed_parse_and_eviction(void) {
+    const hid_layout_t* layout;
+    uint8_t result, type;
+
+    // Failures are remembered as well, so a bad descriptor is not parsed again
+    hid_desc_cache_store(0x1234, 1, 0x11, 10, NULL, HID_PARSE_NoUnfilteredReportItems, 0);
+    CHECK(hid_desc_cache_lookup(0x1234, 1, 0x11, 10, &layout, &result, &type));
+    CHECK_EQ(result, HID_PARSE_NoUnfilteredReportItems);
+    CHECK(layout == NULL);
+
+    // Fill the entries, keep using the mouse, and the least recently used goes
+    for (int i = 2; i < HID_DESC_CACHE_ENTRIES; i++) {
+        hid_desc_cache_store(0x1234, (uint16_t)i, 0x11, 10, NULL, HID_PARSE_NoUnfilteredReportItems, 0);
+    }
+    uint32_t hash = hid_desc_hash(mouse_desc, sizeof(mouse_desc));
+    CHECK(hid_desc_cache_lookup(0x046D, 0xC077, hash, sizeof(mouse_desc), &layout, &result, &type));
+    hid_desc_cache_store(0x1234, 99, 0x11, 10, NULL, HID_PARSE_NoUnfilteredReportItems, 0);
+    CHECK(hid_desc_cache_lookup(0x046D, 0xC077, hash, sizeof(mouse_desc), &layout, &result, &type));
+    CHECK(hid_desc_cache_lookup(0x1234, 99, 0x11, 10, &layout, &result, &type));
+    CHECK(!hid_desc_cache_lookup(0x1234, 1, 0x11, 10, &layout, &result, &type));
+}
+
+// Joystick with X, Y, Z, Rz, a hat and 12 buttons: 17 items
+static const uint8_t pad_desc[] = {
+    0x05, 0x01, 0x09, 0x04, 0xA1, 0x01,
+    0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04,
+    0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x81, 0x02,
+    0x09, 0x39, 0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42,
+    0x81, 0x01,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x0C, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0C, 0x81, 0x02,
+    0x75, 0x04, 0x95, 0x01, 0x81, 0x01,
+    0xC0,
+};
+
+static void check_pad(const hid_layout_t* layout) {
+    CHECK(layout != NULL);
+    if (layout) {
+        CHECK_EQ(layout->TotalReportItems, 17);
+        CHECK_EQ(layout->ReportItems[16].Attributes.Usage.Usage, 12);
+        CHECK_EQ(layout->ReportItems[16].BitOffset, 51);
+        CHECK_EQ(layout->ReportItems[16].CollectionPath->Usage.Usage, 0x04);
+        CHECK(layout->ReportItems[16].CollectionPath == layout->CollectionPaths);
+    }
+}
+
+// Entries share HID_DESC_CACHE_ITEMS: when those run out the least recently
+// used layouts make room, and the ones left are still intact
+static void test_items_evict(void) {
+    static HID_ReportInfo_t pad_info;
+    hid_layout_t pad;
+    const hid_layout_t* layout;
+    uint8_t result, type;
+    CHECK_EQ(USB_ProcessHIDReport(pad_desc, sizeof(pad_desc), &pad_info), HID_PARSE_Successful);
+    hid_layout_of(&pad_info, &pad);
+    CHECK(3 * pad.TotalReportItems > HID_DESC_CACHE_ITEMS);
+    CHECK(3 < HID_DESC_CACHE_ENTRIES);
+
+    hid_desc_cache_store(0x2000, 1, 0x22, 60, &pad, HID_PARSE_Successful, 3);
+    hid_desc_cache_store(0x2000, 2, 0x22, 60, &pad, HID_PARSE_Successful, 3);
+    CHECK(hid_desc_cache_lookup(0x2000, 1, 0x22, 60, &layout, &result, &type));
+    hid_desc_cache_store(0x2000, 3, 0x22, 60, &pad, HID_PARSE_Successful, 3);
+    CHECK(!hid_desc_cache_lookup(0x2000, 2, 0x22, 60, &layout, &result, &type));
+    CHECK(hid_desc_cache_lookup(0x2000, 1, 0x22, 60, &layout, &result, &type));
+    check_pad(layout);
+    CHECK(hid_desc_cache_lookup(0x2000, 3, 0x22, 60, &layout, &result, &type));
+    check_pad(layout);
+    CHECK_EQ(type, 3);
+
+    // Failed parses take no items, so they are not evicted for room
+    hid_desc_cache_store(0x2000, 9, 0x22, 60, NULL, HID_PARSE_NoUnfilteredReportItems, 0);
+    hid_desc_cache_store(0x2000, 4, 0x22, 60, &pad, HID_PARSE_Successful, 3);
+    CHECK(hid_desc_cache_lookup(0x2000, 9, 0x22, 60, &layout, &result, &type));
+    CHECK(!hid_desc_cache_lookup(0x2000, 1, 0x22, 60, &layout, &result, &type));
+    CHECK(hid_desc_cache_lookup(0x2000, 4, 0x22, 60, &layout, &result, &type));
+    check_pad(layout);
+
+    // Bigger than the whole cache: not kept, and nothing else lost
+    hid_layout_t huge = pad;
+    huge.TotalReportItems = HID_DESC_CACHE_ITEMS + 1;
+    hid_desc_cache_store(0x3000, 1, 0x33, 10, &huge, HID_PARSE_Successful, 3);
+    CHECK(!hid_desc_cache_lookup(0x3000, 1, 0x33, 10, &layout, &result, &type));
+    CHECK(hid_desc_cache_lookup(0x2000, 3, 0x22, 60, &layout, &result, &type));
+    check_pad(layout);
+}
+
+int main(void) {
+    test_items_evict();
+    test_hit_rebases_pointers();
+    test_key();
+    test_failed_parse_and_eviction();
+    return test_report("hid_desc_cache");
+}
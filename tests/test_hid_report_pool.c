@@ -0,0 +1,157 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <string.h>
+#include "test.h"
+#include "hid_report_pool.h"
+#include "telemetry.h"
+
+bool CALLBACK_HIDParser_FilterHIDReportItem(HID_ReportItem_t* const CurrentItem) {
+    (void)CurrentItem;
+    return true;
+}
+
+// Three buttons, X, Y and wheel: 6 items in 2 collections
+static const uint8_t mouse_desc[] = {
+    0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05,
+    0x81, 0x01, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38,
+    0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x03, 0x81, 0x06,
+    0xC0, 0xC0,
+};
+
+// Joystick with X, Y, Z, Rz, a hat and 12 buttons: 17 items in 1 collection
+static const uint8_t pad_desc[] = {
+    0x05, 0x01, 0x09, 0x04, 0xA1, 0x01,
+    0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04,
+    0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x81, 0x02,
+    0x09, 0x39, 0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42,
+    0x81, 0x01,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x0C, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0C, 0x81, 0x02,
+    0x75, 0x04, 0x95, 0x01, 0x81, 0x01,
+    0xC0,
+};
+
+static HID_ReportInfo_t mouse_info, pad_info;
+static hid_layout_t mouse, pad;
+
+static void parse(void) {
+    CHECK_EQ(USB_ProcessHIDReport(mouse_desc, sizeof(mouse_desc), &mouse_info), HID_PARSE_Successful);
+    CHECK_EQ(USB_ProcessHIDReport(pad_desc, sizeof(pad_desc), &pad_info), HID_PARSE_Successful);
+    hid_layout_of(&mouse_info, &mouse);
+    hid_layout_of(&pad_info, &pad);
+}
+
+// Same items as the parse, linked to the layout's own collections
+static void check_copy(const hid_layout_t* copy, const HID_ReportInfo_t* info) {
+    CHECK_EQ(copy->TotalReportItems, info->TotalReportItems);
+    for (int i = 0; i < copy->TotalReportItems; ++i) {
+        const HID_ReportItem_t* a = &copy->ReportItems[i];
+        const HID_ReportItem_t* b = &info->ReportItems[i];
+        CHECK_EQ(a->BitOffset, b->BitOffset);
+        CHECK_EQ(a->Attributes.BitSize, b->Attributes.BitSize);
+        CHECK_EQ(a->Attributes.Usage.Page, b->Attributes.Usage.Page);
+        CHECK_EQ(a->Attributes.Usage.Usage, b->Attributes.Usage.Usage);
+        const HID_CollectionPath_t* p = a->CollectionPath;
+        const HID_CollectionPath_t* q = b->CollectionPath;
+        for (; p && q; p = p->Parent, q = q->Parent) {
+            CHECK(p >= copy->CollectionPaths && p < copy->CollectionPaths + copy->TotalCollections);
+            CHECK_EQ(p->Usage.Usage, q->Usage.Usage);
+        }
+        CHECK(!p && !q);
+    }
+}
+
+static void test_layout_of(void) {
+    CHECK_EQ(mouse.TotalReportItems, 6);
+    CHECK_EQ(mouse.TotalCollections, 2);
+    CHECK(mouse.ReportItems == mouse_info.ReportItems);
+    CHECK_EQ(pad.TotalReportItems, 17);
+    CHECK_EQ(pad.TotalCollections, 1);
+}
+
+static void test_sized_by_use(void) {
+    uint32_t full = telemetry_counter(TM_USB_RI_FULL);
+
+    // Mice and pads in turn until the items run out: more interfaces than
+    // four whole HID_ReportInfo_t held, and the one refused is counted
+    hid_layout_t* taken[HID_REPORT_INFO_POOL];
+    int n = 0;
+    int items = 0;
+    while (n < HID_REPORT_INFO_POOL) {
+        taken[n] = hid_report_pool_alloc(n & 1 ? &pad : &mouse);
+        if (!taken[n]) {
+            break;
+        }
+        items += taken[n]->TotalReportItems;
+        check_copy(taken[n], n & 1 ? &pad_info : &mouse_info);
+        n++;
+    }
+    CHECK(n > 4 && n < HID_REPORT_INFO_POOL);
+    CHECK(items + (n & 1 ? pad : mouse).TotalReportItems > HID_LAYOUT_ITEMS);
+    CHECK_EQ(telemetry_counter(TM_USB_RI_FULL), full + 1);
+    CHECK_EQ(hid_report_pool_used(), n);
+    CHECK_EQ(hid_report_pool_items_used(), items);
+
+    // An unplug in the middle packs the rest down; they still read the same
+    hid_report_pool_free(taken[1]);
+    CHECK_EQ(hid_report_pool_used(), n - 1);
+    CHECK_EQ(hid_report_pool_items_used(), items - pad.TotalReportItems);
+    CHECK(taken[2]->ReportItems == taken[0]->ReportItems + mouse.TotalReportItems);
+    for (int i = 0; i < n; ++i) {
+        if (i != 1) {
+            check_copy(taken[i], i & 1 ? &pad_info : &mouse_info);
+        }
+    }
+
+    // Room for a pad again, at the top
+    hid_layout_t* again = hid_report_pool_alloc(&pad);
+    CHECK(again != NULL);
+    check_copy(again, &pad_info);
+
+    hid_report_pool_free(again);
+    for (int i = 0; i < n; ++i) {
+        hid_report_pool_free(i == 1 ? NULL : taken[i]);
+    }
+    CHECK_EQ(hid_report_pool_used(), 0);
+    CHECK_EQ(hid_report_pool_items_used(), 0);
+}
+
+static void test_free_ignores_foreign(void) {
+    hid_layout_t other = mouse;
+    hid_layout_t* layout = hid_report_pool_alloc(&mouse);
+    hid_report_pool_free(NULL);
+    hid_report_pool_free(&other);
+    CHECK_EQ(hid_report_pool_used(), 1);
+    hid_report_pool_free(layout);
+    hid_report_pool_free(layout);     // A second free is harmless
+    CHECK_EQ(hid_report_pool_used(), 0);
+
+    // Nothing to keep, nothing taken
+    hid_layout_t empty = { 0, 0, NULL, NULL };
+    CHECK(hid_report_pool_alloc(&empty) == NULL);
+}
+
+int main(void) {
+    parse();
+    test_layout_of();
+    test_sized_by_use();
+    test_free_ignores_foreign();
+    return test_report("hid_report_pool");
+}
@@ -0,0 +1,245 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "test.h"
+#include "input_queue.h"
+#include "telemetry.h"
+#include "pico/time.h"
+
+static uint32_t keys[4];
+
+// Emulated time, advanced the way hd6301_run_clocks() does: a poll per
+// batch and a service check between instructions
+static int64_t ncycles;
+
+static void press(uint8_t code, bool down, uint32_t t_us) {
+    if (down) {
+        keys[code >> 5] |= 1u << (code & 31);
+    } else {
+        keys[code >> 5] &= ~(1u << (code & 31));
+    }
+    iq_set_keys(keys, t_us);
+}
+
+static void run(int64_t cycles) {
+    int64_t end = ncycles + cycles;
+    iq_poll(ncycles);
+    for (; ncycles < end; ncycles += 10) {
+        if (ncycles >= iq_due) {
+            iq_service(ncycles);
+        }
+    }
+}
+
+static void test_first_event_latency(void) {
+    host_time_us = 1000;
+    press(0x1E, true, 1000);
+    iq_poll(ncycles);
+    CHECK_EQ(iq_due, ncycles + IQ_LATENCY_CYCLES);
+    run(IQ_LATENCY_CYCLES);
+    CHECK(!iq_keydown(0x1E));
+    run(10);
+    CHECK(iq_keydown(0x1E));
+    CHECK_EQ(iq_due, IQ_NEVER);
+}
+
+static void test_spacing_follows_report_time(void) {
+    // Two reports 5 ms apart, published together later: the second is still
+    // due 5000 cycles after the first
+    host_time_us = 20000;
+    press(0x1E, false, 14000);
+    press(0x1F, true, 19000);
+    host_time_us = 20500;
+    run(100000);
+    CHECK(!iq_keydown(0x1E));
+    CHECK(iq_keydown(0x1F));
+
+    press(0x1F, false, 30000);
+    press(0x1E, true, 35000);
+    host_time_us = 35100;
+    iq_poll(ncycles);
+    int64_t first = iq_due;
+    iq_service(first);
+    CHECK_EQ(iq_due, first + 5000);
+    iq_service(iq_due);
+    CHECK(iq_keydown(0x1E));
+    ncycles = first + 5000;
+}
+
+static void test_min_gap(void) {
+    host_time_us = 40000;
+    press(0x1E, false, 40000);
+    press(0x20, true, 40010);
+    iq_poll(ncycles);
+    int64_t first = iq_due;
+    iq_service(first);
+    CHECK_EQ(iq_due, first + IQ_MIN_GAP_CYCLES);
+    iq_service(iq_due);
+    CHECK(iq_keydown(0x20));
+    ncycles = first + IQ_MIN_GAP_CYCLES;
+}
+
+static void test_only_changes_queued(void) {
+    uint32_t before = telemetry_counter(TM_IQ_EVENTS);
+    iq_set_keys(keys, host_time_us);
+    iq_set_mouse_buttons(0, host_time_us);
+    iq_set_joystick(0, host_time_us);
+    CHECK_EQ(telemetry_counter(TM_IQ_EVENTS), before);
+
+    // Three keys in different words change at once: three events
+    keys[0] |= 1u << 3;
+    keys[2] |= 1u << 31;
+    keys[3] |= 1u << 0;
+    iq_set_keys(keys, host_time_us);
+    CHECK_EQ(telemetry_counter(TM_IQ_EVENTS), before + 3);
+    run(10000);
+    CHECK(iq_keydown(3));
+    CHECK(iq_keydown(95));
+    CHECK(iq_keydown(96));
+}
+
+static void test_reset_mid_stream(void) {
+    // A long run leaves the last applied event at a large cycle count
+    host_time_us = 60000;
+    ncycles += 1000000;
+    press(0x21, true, 60000);
+    run(10000);
+    CHECK(iq_keydown(0x21));
+
+    // ncycles restarts from zero, as after hd6301_reset(); an event queued
+    // before the reset and one after both still apply promptly
+    press(0x21, false, 60100);
+    iq_poll(ncycles);
+    iq_reset();
+    CHECK_EQ(iq_due, IQ_NEVER);
+    ncycles = 0;
+    host_time_us = 61000;
+    press(0x22, true, 61000);
+    run(10000);
+    CHECK(!iq_keydown(0x21));
+    CHECK(iq_keydown(0x22));
+}
+
+static void test_overflow_keeps_final_state(void) {
+    host_time_us = 80000;
+    uint32_t overflow = telemetry_counter(TM_IQ_OVERFLOW);
+    // Toggle one key more times than the queue holds
+    for (int i = 0; i < IQ_SIZE + 7; ++i) {
+        press(0x23, (i & 1) == 0, 80000 + i);
+    }
+    CHECK(telemetry_counter(TM_IQ_OVERFLOW) > overflow);
+    CHECK((keys[1] >> 3) & 1);
+    // Drain, then publish again: the last state gets through
+    run((IQ_SIZE + 2) * IQ_MIN_GAP_CYCLES);
+    iq_set_keys(keys, host_time_us);
+    run(10000);
+    CHECK(iq_keydown(0x23));
+}
+
+static void test_old_event_reanchors(void) {
+    uint32_t reanchor = telemetry_counter(TM_IQ_REANCHOR);
+    host_time_us = 100000;
+    iq_set_joystick(0x01, 100000);
+    iq_set_joystick(0x02, 115000);
+    iq_poll(ncycles);
+    int64_t first = iq_due;
+    // Core 1 only gets round to it once the second event is stale, so that
+    // one starts a new mapping instead of waiting out its 15 ms spacing
+    host_time_us = 140000;
+    iq_service(first);
+    CHECK_EQ(iq_joystick(), 0x01);
+    CHECK_EQ(telemetry_counter(TM_IQ_REANCHOR), reanchor + 1);
+    CHECK_EQ(iq_due, first + IQ_MIN_GAP_CYCLES);
+    iq_service(iq_due);
+    CHECK_EQ(iq_joystick(), 0x02);
+}
+
+static void test_interleaved_kinds(void) {
+    // Key, button and joystick changes a few us apart, far closer than one
+    // scan: each is applied on its own, in the order it happened
+    static const struct { uint8_t kind, value; } steps[] = {
+        { IQ_KEY, 1 },            { IQ_MOUSE_BUTTONS, 0x02 }, { IQ_JOYSTICK, 0x01 },
+        { IQ_JOYSTICK, 0x81 },    { IQ_KEY, 0 },              { IQ_MOUSE_BUTTONS, 0x03 },
+        { IQ_KEY, 1 },            { IQ_JOYSTICK, 0x80 },      { IQ_MOUSE_BUTTONS, 0x00 },
+        { IQ_KEY, 0 },            { IQ_JOYSTICK, 0x00 },      { IQ_MOUSE_BUTTONS, 0x01 },
+    };
+    const int n = sizeof(steps) / sizeof(steps[0]);
+    uint32_t events = telemetry_counter(TM_IQ_EVENTS);
+    uint32_t overflow = telemetry_counter(TM_IQ_OVERFLOW);
+    bool key = iq_keydown(0x24);
+    uint8_t buttons = iq_mouse_buttons();
+    uint8_t joystick = iq_joystick();
+
+    host_time_us = 120000;
+    for (int i = 0; i < n; ++i) {
+        uint32_t t_us = 120000 + 3 * i;
+        switch (steps[i].kind) {
+        case IQ_KEY:
+            press(0x24, steps[i].value, t_us);
+            break;
+        case IQ_MOUSE_BUTTONS:
+            iq_set_mouse_buttons(steps[i].value, t_us);
+            break;
+        default:
+            iq_set_joystick(steps[i].value, t_us);
+            break;
+        }
+    }
+    CHECK_EQ(telemetry_counter(TM_IQ_EVENTS), events + n);
+    CHECK_EQ(telemetry_counter(TM_IQ_OVERFLOW), overflow);
+
+    // One event per service, each leaving exactly the state after that step
+    iq_poll(ncycles);
+    for (int i = 0; i < n; ++i) {
+        int64_t due = iq_due;
+        CHECK(due != IQ_NEVER);
+        if (i > 0) {
+            CHECK_EQ(due - ncycles, IQ_MIN_GAP_CYCLES);
+        }
+        ncycles = due;
+        iq_service(ncycles);
+        switch (steps[i].kind) {
+        case IQ_KEY:
+            key = steps[i].value;
+            break;
+        case IQ_MOUSE_BUTTONS:
+            buttons = steps[i].value;
+            break;
+        default:
+            joystick = steps[i].value;
+            break;
+        }
+        CHECK_EQ(iq_keydown(0x24), key);
+        CHECK_EQ(iq_mouse_buttons(), buttons);
+        CHECK_EQ(iq_joystick(), joystick);
+    }
+    CHECK_EQ(iq_due, IQ_NEVER);
+}
+
+int main(void) {
+    test_first_event_latency();
+    test_spacing_follows_report_time();
+    test_min_gap();
+    test_only_changes_queued();
+    test_reset_mid_stream();
+    test_overflow_keeps_final_state();
+    test_old_event_reanchors();
+    test_interleaved_kinds();
+    return test_report("input_queue");
+}
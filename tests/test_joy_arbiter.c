@@ -0,0 +1,129 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "test.h"
+#include "joy_arbiter.h"
+#include "key_joystick.h"
+#include "telemetry.h"
+
+#define UP      KEY_JOY_UP
+#define DOWN    KEY_JOY_DOWN
+#define LEFT    KEY_JOY_LEFT
+
+static uint8_t axis;
+static uint8_t fire;
+
+static void test_priority(void) {
+    joy_arb_clear(0);
+    joy_arb_set_policy(0, JOY_ARB_PRIORITY);
+    CHECK(!joy_arb_resolve(0, &axis, &fire));
+    CHECK_EQ(axis, 0);
+
+    // An idle pad present on the port never masks another one
+    joy_arb_publish(0, JOY_SRC_HID, 0, 0);
+    joy_arb_publish(0, JOY_SRC_XBOX, LEFT, 1);
+    CHECK(joy_arb_resolve(0, &axis, &fire));
+    CHECK_EQ(axis, LEFT);
+    CHECK_EQ(fire, 1);
+
+    // Both active: the first in joy_src_t order wins
+    joy_arb_publish(0, JOY_SRC_HID, UP, 0);
+    joy_arb_resolve(0, &axis, &fire);
+    CHECK_EQ(axis, UP);
+    CHECK_EQ(fire, 0);
+
+    joy_arb_withdraw(0, JOY_SRC_HID);
+    joy_arb_resolve(0, &axis, &fire);
+    CHECK_EQ(axis, LEFT);
+}
+
+static void test_recent(void) {
+    joy_arb_clear(1);
+    joy_arb_set_policy(1, JOY_ARB_RECENT);
+    joy_arb_publish(1, JOY_SRC_KEYBOARD, UP, 0);
+    joy_arb_publish(1, JOY_SRC_HID, DOWN, 0);
+    joy_arb_resolve(1, &axis, &fire);
+    CHECK_EQ(axis, DOWN);
+
+    // The keyboard still holds UP; republishing it unchanged is not a change
+    joy_arb_publish(1, JOY_SRC_KEYBOARD, UP, 0);
+    joy_arb_resolve(1, &axis, &fire);
+    CHECK_EQ(axis, DOWN);
+
+    // The pad goes idle: fall back to the next most recent active source
+    joy_arb_publish(1, JOY_SRC_HID, 0, 0);
+    joy_arb_resolve(1, &axis, &fire);
+    CHECK_EQ(axis, UP);
+
+    joy_arb_publish(1, JOY_SRC_HID, 0, 1);
+    joy_arb_resolve(1, &axis, &fire);
+    CHECK_EQ(axis, 0);
+    CHECK_EQ(fire, 1);
+    joy_arb_set_policy(1, JOY_ARB_DEFAULT_POLICY);
+}
+
+static void test_merge(void) {
+    joy_arb_clear(0);
+    joy_arb_set_policy(0, JOY_ARB_MERGE);
+    joy_arb_publish(0, JOY_SRC_PS4, UP, 0);
+    joy_arb_publish(0, JOY_SRC_BLUETOOTH, LEFT, 1);
+    joy_arb_resolve(0, &axis, &fire);
+    CHECK_EQ(axis, UP | LEFT);
+    CHECK_EQ(fire, 1);
+    joy_arb_clear(0);
+    CHECK(!joy_arb_resolve(0, &axis, &fire));
+    CHECK_EQ(axis, 0);
+    CHECK_EQ(fire, 0);
+}
+
+static void test_resolve_only_on_change(void) {
+    joy_arb_clear(0);
+    joy_arb_set_policy(0, JOY_ARB_PRIORITY);
+    joy_arb_publish(0, JOY_SRC_HID, UP, 0);
+    joy_arb_resolve(0, &axis, &fire);
+    uint32_t resolves = telemetry_counter(TM_JOY_ARB_RESOLVE);
+    for (int i = 0; i < 10; ++i) {
+        joy_arb_publish(0, JOY_SRC_HID, UP, 0);
+        joy_arb_resolve(0, &axis, &fire);
+    }
+    CHECK_EQ(telemetry_counter(TM_JOY_ARB_RESOLVE), resolves);
+    joy_arb_withdraw(0, JOY_SRC_PS3);     // Was never present
+    joy_arb_resolve(0, &axis, &fire);
+    CHECK_EQ(telemetry_counter(TM_JOY_ARB_RESOLVE), resolves);
+}
+
+static void test_policy_bounds(void) {
+    joy_arb_set_policy(0, JOY_ARB_MERGE);
+    joy_arb_set_policy(0, JOY_ARB_POLICY_COUNT);
+    joy_arb_set_policy(0, -1);
+    joy_arb_set_policy(JOY_ARB_PORTS, JOY_ARB_RECENT);
+    CHECK_EQ(joy_arb_get_policy(0), JOY_ARB_MERGE);
+    CHECK_EQ(joy_arb_get_policy(JOY_ARB_PORTS), JOY_ARB_PRIORITY);
+    CHECK(joy_arb_policy_name(JOY_ARB_POLICY_COUNT)[0] == '?');
+    joy_arb_set_policy(0, JOY_ARB_DEFAULT_POLICY);
+}
+
+int main(void) {
+    test_priority();
+    test_recent();
+    test_merge();
+    test_resolve_only_on_change();
+    test_policy_bounds();
+    return test_report("joy_arbiter");
+}
@@ -0,0 +1,294 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "defs.h"
+#include "chip.h"
+#include "6301.h"
+#include "cpu.h"
+#include "reg.h"
+#include "ireg.h"
+#include "key_joystick.h"
+#include "joy_arbiter.h"
+#include "input_queue.h"
+#include "pico/time.h"
+
+// ireg.c, included the way 6301.c includes it, so dr4_getb is the port read
+// the ROM sees. Around it, the Core 1 side as the firmware builds it with
+// ENABLE_INPUT_QUEUE: st_joystick() is the queue's applied copy.
+void error(const char* fmt, ...) {
+    (void)fmt;
+}
+
+struct cpu cpu;
+struct regs regs;
+u_int ram_start;
+u_int ram_end;
+u_char* ram;
+unsigned int mouse_x_counter;
+unsigned int mouse_y_counter;
+static bool mouse_enabled = true;
+
+int callstack_peek_addr(void) {
+    return 0;
+}
+
+unsigned char st_keydown(const unsigned char code) {
+    (void)code;
+    return 0;
+}
+
+int st_mouse_buttons(void) {
+    return 0;
+}
+
+unsigned char st_joystick(void) {
+    return iq_joystick();
+}
+
+int st_mouse_enabled(void) {
+    return mouse_enabled;
+}
+
+void mouse_tick(int64_t cpu_cycles, int* x_counter, int* y_counter) {
+    (void)cpu_cycles;
+    (void)x_counter;
+    (void)y_counter;
+}
+
+u_char tcsr_getb(u_int offs) { (void)offs; return 0; }
+void tcsr_putb(u_int offs, u_char value) { (void)offs; (void)value; }
+void ocr_putb(u_int offs, u_char value) { (void)offs; (void)value; }
+u_char trcsr_getb(u_int offs) { (void)offs; return 0; }
+void trcsr_putb(u_int offs, u_char value) { (void)offs; (void)value; }
+u_char rdr_getb(u_int offs) { (void)offs; return 0; }
+void tdr_putb(u_int offs, u_char value) { (void)offs; (void)value; }
+
+int reg_setsp(u_int value) {
+    regs.sp = value;
+    return 0;
+}
+
+#define TRACE(...)
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#pragma GCC diagnostic ignored "-Wpointer-sign"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#include "memory.h"
+#include "ireg.c"
+#pragma GCC diagnostic pop
+
+#define K_UP        0x48
+#define K_DOWN      0x50
+#define K_LEFT      0x4B
+#define K_RIGHT     0x4D
+#define K_SPACE     0x39
+#define K_NUM7      0x67
+#define K_NUM3      0x6F
+#define K_A         0x1E
+
+static uint8_t keys[128];
+static uint8_t axis, fire;
+
+static uint8_t update(void) {
+    CHECK(key_joy_update(keys, &axis, &fire));
+    return axis;
+}
+
+static void test_off(void) {
+    key_joy_set_profile(KEY_JOY_OFF);
+    keys[K_UP] = 1;
+    CHECK(!key_joy_update(keys, &axis, &fire));
+    CHECK_EQ(axis, 0);
+    CHECK(!key_joy_consumes(K_UP));
+    memset(keys, 0, sizeof(keys));
+}
+
+static void test_diagonal_and_fire(void) {
+    key_joy_set_profile(KEY_JOY_CURSOR);
+    keys[K_UP] = 1;
+    keys[K_RIGHT] = 1;
+    CHECK_EQ(update(), KEY_JOY_UP | KEY_JOY_RIGHT);
+    CHECK_EQ(fire, 0);
+    keys[K_SPACE] = 1;
+    update();
+    CHECK_EQ(fire, 1);
+    memset(keys, 0, sizeof(keys));
+    CHECK_EQ(update(), 0);
+    CHECK_EQ(fire, 0);
+}
+
+static void test_last_pressed_wins(void) {
+    key_joy_set_profile(KEY_JOY_CURSOR);
+    keys[K_LEFT] = 1;
+    CHECK_EQ(update(), KEY_JOY_LEFT);
+    keys[K_RIGHT] = 1;
+    CHECK_EQ(update(), KEY_JOY_RIGHT);
+    keys[K_RIGHT] = 0;                  // Back to the one still held
+    CHECK_EQ(update(), KEY_JOY_LEFT);
+    keys[K_LEFT] = 0;
+
+    // Together in one update they cancel out
+    keys[K_UP] = 1;
+    keys[K_DOWN] = 1;
+    CHECK_EQ(update(), 0);
+    memset(keys, 0, sizeof(keys));
+    update();
+}
+
+static void test_numpad_diagonals(void) {
+    key_joy_set_profile(KEY_JOY_NUMPAD);
+    keys[K_NUM7] = 1;
+    CHECK_EQ(update(), KEY_JOY_UP | KEY_JOY_LEFT);
+    keys[K_NUM3] = 1;
+    CHECK_EQ(update(), KEY_JOY_DOWN | KEY_JOY_RIGHT);
+    memset(keys, 0, sizeof(keys));
+    update();
+}
+
+static void test_consumes(void) {
+    key_joy_set_profile(KEY_JOY_WASD);
+    key_joy_set_passthrough(false);
+    update();
+    CHECK(key_joy_consumes(K_A));
+    CHECK(key_joy_consumes(K_SPACE));
+    CHECK(!key_joy_consumes(K_UP));
+    CHECK(!key_joy_consumes(200));
+
+    key_joy_set_passthrough(true);
+    update();
+    CHECK(!key_joy_consumes(K_A));
+    key_joy_set_passthrough(false);
+}
+
+static void test_settings(void) {
+    key_joy_set_port(5);
+    CHECK_EQ(key_joy_get_port(), 1);
+    key_joy_set_port(0);
+    CHECK_EQ(key_joy_get_port(), 0);
+    key_joy_set_profile(-1);
+    CHECK(key_joy_get_profile() >= 0);
+    CHECK(strcmp(key_joy_profile_name(KEY_JOY_NUMPAD), "numpad") == 0);
+    CHECK(strcmp(key_joy_profile_name(KEY_JOY_PROFILE_COUNT), "?") == 0);
+}
+
+// Core 0: the keyboard's part of HidInput::handle_joystick() on the USB
+// path, then publish_input()
+static uint8_t joystick_state;
+
+static void handle_joystick(uint32_t t_us) {
+    uint8_t key_axis = 0;
+    uint8_t key_fire = 0;
+    const bool key_joy = key_joy_update(keys, &key_axis, &key_fire);
+    const int key_joy_port = key_joy_get_port();
+    for (int joystick = 1; joystick >= 0; --joystick) {
+        if (key_joy && joystick == key_joy_port) {
+            joy_arb_publish(joystick, JOY_SRC_KEYBOARD, key_axis, key_fire);
+        } else {
+            joy_arb_withdraw(joystick, JOY_SRC_KEYBOARD);
+        }
+        uint8_t axis, button;
+        if (joy_arb_resolve(joystick, &axis, &button)) {
+            if (joystick == 0) {
+                if (!mouse_enabled) {
+                    joystick_state = (uint8_t)((joystick_state & 0xf0) | (axis & 0x0f));
+                }
+            } else {
+                joystick_state = (uint8_t)((joystick_state & 0x0f) | ((axis & 0x0f) << 4));
+            }
+        }
+    }
+    iq_set_joystick(joystick_state, t_us);
+}
+
+// Core 1: let emulated time reach the queued change, then read DR4 with the
+// 74LS244 selected (DDR4 all input, DR2 bit 0 set), as the ROM's joystick
+// scan does
+static int64_t ncycles;
+
+static uint8_t read_dr4(int64_t cycles) {
+    int64_t end = ncycles + cycles;
+    iq_poll(ncycles);
+    for (; ncycles < end; ncycles += 10) {
+        if (ncycles >= iq_due) {
+            iq_service(ncycles);
+        }
+    }
+    iram[DDR4] = 0x00;
+    iram[DDR2] = 0x01;
+    iram[P2] = 0x01;
+    return ireg_getb_func[P4](P4);
+}
+
+static void test_port_nibble(void) {
+    key_joy_set_profile(KEY_JOY_CURSOR);
+    key_joy_set_passthrough(false);
+    memset(keys, 0, sizeof(keys));
+
+    // Port 1 with the mouse on port 0: bits 4-7, active low
+    key_joy_set_port(1);
+    mouse_enabled = true;
+    host_time_us = 1000;
+    keys[K_UP] = 1;
+    keys[K_RIGHT] = 1;
+    handle_joystick(1000);
+    CHECK_EQ(read_dr4(100) & 0xf0, 0xf0);       // Not applied yet
+    CHECK_EQ(read_dr4(IQ_LATENCY_CYCLES) & 0xf0,
+             (uint8_t)~((KEY_JOY_UP | KEY_JOY_RIGHT) << 4) & 0xf0);
+    keys[K_UP] = 0;
+    handle_joystick(2000);
+    CHECK_EQ(read_dr4(IQ_MIN_GAP_CYCLES + 1000) & 0xf0, (uint8_t)~(KEY_JOY_RIGHT << 4) & 0xf0);
+    keys[K_RIGHT] = 0;
+    handle_joystick(5000);
+    CHECK_EQ(read_dr4(IQ_MIN_GAP_CYCLES + 3000) & 0xf0, 0xf0);
+
+    // Port 0 with the mouse off: bits 0-3, and port 1 stays neutral
+    key_joy_set_port(0);
+    mouse_enabled = false;
+    keys[K_DOWN] = 1;
+    keys[K_LEFT] = 1;
+    handle_joystick(30000);
+    CHECK_EQ(read_dr4(10000), (uint8_t)~(KEY_JOY_DOWN | KEY_JOY_LEFT));
+    memset(keys, 0, sizeof(keys));
+    handle_joystick(31000);
+    CHECK_EQ(read_dr4(10000), 0xff);
+
+    // Port 0 while the mouse owns it: the keys never reach the port
+    mouse_enabled = true;
+    keys[K_UP] = 1;
+    handle_joystick(50000);
+    CHECK_EQ(read_dr4(10000) & 0xf0, 0xf0);
+    CHECK_EQ(iq_joystick(), 0);
+    memset(keys, 0, sizeof(keys));
+    handle_joystick(51000);
+    key_joy_set_port(0);
+}
+
+int main(void) {
+    test_off();
+    test_diagonal_and_fire();
+    test_last_pressed_wins();
+    test_numpad_diagonals();
+    test_consumes();
+    test_settings();
+    test_port_nibble();
+    return test_report("key_joystick");
+}
@@ -0,0 +1,174 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Loopback of the ST link at every supported rate. A software UART sends
+ * frames at one rate and a 16x oversampling receiver, as in the PL011 and
+ * the ACIA, reads them at another; each character goes through
+ * st_link_decode() as the RX interrupt would see it.
+ *
+ * The RP2040 side runs at the rate uart_set_baudrate() can actually reach
+ * from clk_peri, which follows clk_sys through every clock the firmware
+ * uses. The ST side runs at its ACIA's rate, 500 kHz / 64 and multiples.
+ */
+#include <math.h>
+#include "test.h"
+#include "st_link.h"
+#include "hardware/regs/uart.h"
+#include "config.h"
+
+#define FRAME_BITS  10      // Start, 8 data, stop
+#define OVERSAMPLE  16
+
+static const uint32_t rates[] = { ST_LINK_RATES };
+static const uint32_t clocks_khz[] = {
+    DEFAULT_CPU_CLOCK_KHZ, BT_CPU_CLOCK_KHZ, 200000, 125000, 48000
+};
+
+// Rate programmed by uart_set_baudrate() from clk_peri
+static double rp2040_baud(uint32_t clk_hz, uint32_t baud) {
+    uint32_t div = (uint32_t)(8ull * clk_hz / baud);
+    uint32_t ibrd = div >> 7;
+    uint32_t fbrd;
+
+    if (ibrd == 0) {
+        ibrd = 1;
+        fbrd = 0;
+    } else if (ibrd >= 65535) {
+        ibrd = 65535;
+        fbrd = 0;
+    } else {
+        fbrd = ((div & 0x7f) + 1) / 2;
+    }
+    return 4.0 * clk_hz / (64 * ibrd + fbrd);
+}
+
+// ACIA rate for a link setting: 7812 stands for 500 kHz / 64
+static double st_baud(uint32_t rate) {
+    return 500000.0 / 64 * (rate / 7812);
+}
+
+// Line level at time t of n frames sent back to back from t = 0
+static int line_at(const uint8_t* bytes, int n, double baud, double t) {
+    long bit = (long)floor(t * baud);
+    if (t < 0 || bit >= (long)n * FRAME_BITS) {
+        return 1;
+    }
+    int pos = (int)(bit % FRAME_BITS);
+    if (pos == 0) {
+        return 0;
+    }
+    if (pos == FRAME_BITS - 1) {
+        return 1;
+    }
+    return (bytes[bit / FRAME_BITS] >> (pos - 1)) & 1;
+}
+
+typedef struct {
+    int    received;    // Clean characters
+    int    errors;      // Framing errors
+    int    wrong;       // Clean but not what was sent
+    double done_s;      // Time the last stop bit was sampled
+} loop_result_t;
+
+static loop_result_t loopback(const uint8_t* bytes, int n, double tx_baud, double rx_baud) {
+    loop_result_t r = {0};
+    const double tick = 1.0 / (rx_baud * OVERSAMPLE);
+    const double end = (n * FRAME_BITS + 2) / tx_baud;
+    double t = 0;
+
+    while (t < end) {
+        t += tick;
+        if (line_at(bytes, n, tx_baud, t)) {
+            continue;
+        }
+        // Start edge seen at t: sample the middle of each bit from here
+        uint32_t dr = 0;
+        for (int b = 1; b < FRAME_BITS - 1; b++) {
+            dr |= (uint32_t)line_at(bytes, n, tx_baud, t + (b + 0.5) / rx_baud - tick / 2) << (b - 1);
+        }
+        double stop_t = t + (FRAME_BITS - 0.5) / rx_baud - tick / 2;
+        if (!line_at(bytes, n, tx_baud, stop_t)) {
+            dr |= UART_UARTDR_FE_BITS;
+        }
+        if (st_link_decode(dr) == ST_LINK_RX_BYTE) {
+            r.wrong += (r.received >= n || (uint8_t)dr != bytes[r.received]);
+            r.received++;
+        } else {
+            r.errors++;
+        }
+        r.done_s = stop_t;
+        // The receiver looks for the next start bit from the stop bit on
+        t = stop_t;
+    }
+    return r;
+}
+
+static uint8_t all_bytes[256];
+
+static void check_direction(double tx_baud, double rx_baud, double nominal) {
+    loop_result_t r = loopback(all_bytes, 256, tx_baud, rx_baud);
+    CHECK_EQ(r.received, 256);
+    CHECK_EQ(r.errors, 0);
+    CHECK_EQ(r.wrong, 0);
+
+    // Back to back frames: a byte per ten bit times
+    double bytes_per_s = 256 / r.done_s;
+    CHECK(fabs(bytes_per_s - nominal / FRAME_BITS) < nominal / FRAME_BITS * 0.01);
+}
+
+static void test_every_rate_and_clock(void) {
+    for (unsigned c = 0; c < sizeof(clocks_khz) / sizeof(clocks_khz[0]); c++) {
+        for (unsigned i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+            double rp = rp2040_baud(clocks_khz[c] * 1000, rates[i]);
+            double st = st_baud(rates[i]);
+            check_direction(rp, st, st);    // 6301 to ST
+            check_direction(st, rp, st);    // ST to 6301
+        }
+    }
+}
+
+static void test_default_ceiling(void) {
+    loop_result_t r = loopback(all_bytes, 256, st_baud(IKBD_BAUD_DEFAULT),
+                               rp2040_baud(DEFAULT_CPU_CLOCK_KHZ * 1000, IKBD_BAUD_DEFAULT));
+    double bytes_per_s = 256 / r.done_s;
+    CHECK(bytes_per_s > 775 && bytes_per_s < 785);
+
+    // 8x the rate is 8x the bytes
+    r = loopback(all_bytes, 256, st_baud(62500), rp2040_baud(DEFAULT_CPU_CLOCK_KHZ * 1000, 62500));
+    CHECK(256 / r.done_s > bytes_per_s * 7.9);
+}
+
+static void test_mismatch_is_caught(void) {
+    // One side left at the old rate: the frames do not survive
+    loop_result_t r = loopback(all_bytes, 256, st_baud(62500), st_baud(7812));
+    CHECK(r.errors > 0 || r.wrong > 0);
+    r = loopback(all_bytes, 256, st_baud(7812), st_baud(15625));
+    CHECK(r.errors > 0 || r.wrong > 0);
+}
+
+int main(void) {
+    for (int i = 0; i < 256; i++) {
+        all_bytes[i] = (uint8_t)(i * 37 + 11);
+    }
+    test_every_rate_and_clock();
+    test_default_ceiling();
+    test_mismatch_is_caught();
+    return test_report("link_rate");
+}
@@ -0,0 +1,320 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "test.h"
+#include "mouse_merge.h"
+
+static uint32_t now;
+
+static void pass(int32_t* dx, int32_t* dy) {
+    mouse_merge_end(dx, dy);
+    mouse_merge_begin(now += 1000);
+}
+
+static void test_motion_and_buttons(void) {
+    int32_t dx, dy;
+    uint8_t b;
+    mouse_merge_begin(now);
+    mouse_merge_relative(1, MOUSE_CLASS_USB, 3, -2, MOUSE_MERGE_LEFT);
+    mouse_merge_relative(MOUSE_MERGE_BT_ID(0), MOUSE_CLASS_BT, 4, 1, MOUSE_MERGE_RIGHT);
+    mouse_merge_relative(1, MOUSE_CLASS_USB, 1, 0, MOUSE_MERGE_LEFT);
+    CHECK(mouse_merge_take_buttons(&b));
+    CHECK_EQ(b, MOUSE_MERGE_LEFT | MOUSE_MERGE_RIGHT);
+    pass(&dx, &dy);
+    CHECK_EQ(dx, 8);
+    CHECK_EQ(dy, -1);
+    CHECK_EQ(mouse_merge_active(), 2);
+
+    // A source that sends nothing keeps its buttons held
+    mouse_merge_relative(1, MOUSE_CLASS_USB, 0, 0, 0);
+    CHECK(mouse_merge_take_buttons(&b));
+    CHECK_EQ(b, MOUSE_MERGE_RIGHT);
+    CHECK(!mouse_merge_take_buttons(&b));
+    pass(&dx, &dy);
+    CHECK_EQ(dx, 0);
+
+    // Removing it releases them
+    mouse_merge_remove(MOUSE_MERGE_BT_ID(0));
+    CHECK(mouse_merge_take_buttons(&b));
+    CHECK_EQ(b, 0);
+    mouse_merge_remove(1);
+    CHECK_EQ(mouse_merge_active(), 0);
+}
+
+static void test_report_without_buttons(void) {
+    int32_t dx, dy;
+    uint8_t b;
+
+    // A GEM drag: left held while a report-ID mouse also sends wheel reports
+    mouse_merge_relative(2, MOUSE_CLASS_USB, 5, 0, MOUSE_MERGE_LEFT);
+    CHECK(mouse_merge_take_buttons(&b));
+    CHECK_EQ(b, MOUSE_MERGE_LEFT);
+    mouse_merge_relative(2, MOUSE_CLASS_USB, 0, 0, MOUSE_MERGE_BUTTONS_KEEP);
+    mouse_merge_absolute(3, MOUSE_CLASS_USB, 10, 10, 100, 100, true, MOUSE_MERGE_BUTTONS_KEEP);
+    CHECK(!mouse_merge_take_buttons(&b));
+    pass(&dx, &dy);
+    CHECK_EQ(dx, 5);
+
+    // Still held on the next pass, released by a report that has buttons
+    mouse_merge_relative(2, MOUSE_CLASS_USB, 1, 0, MOUSE_MERGE_BUTTONS_KEEP);
+    CHECK(!mouse_merge_take_buttons(&b));
+    mouse_merge_relative(2, MOUSE_CLASS_USB, 1, 0, 0);
+    CHECK(mouse_merge_take_buttons(&b));
+    CHECK_EQ(b, 0);
+    pass(&dx, &dy);
+    mouse_merge_remove(2);
+    mouse_merge_remove(3);
+    CHECK(!mouse_merge_take_buttons(&b));
+}
+
+static void test_scale_keeps_remainder(void) {
+    int32_t dx, dy, total = 0;
+    mouse_merge_set_scale(MOUSE_CLASS_USB, 50);
+    for (int i = 0; i < 9; i++) {
+        mouse_merge_relative(2, MOUSE_CLASS_USB, 1, 0, 0);
+        pass(&dx, &dy);
+        total += dx;
+    }
+    // Nine counts at half speed: four out, the odd half still owed
+    CHECK_EQ(total, 4);
+    mouse_merge_relative(2, MOUSE_CLASS_USB, 1, 0, 0);
+    pass(&dx, &dy);
+    CHECK_EQ(dx, 1);
+    mouse_merge_set_scale(MOUSE_CLASS_USB, 0);      // Ignored
+    CHECK_EQ(mouse_merge_get_scale(MOUSE_CLASS_USB), 50);
+    mouse_merge_set_scale(MOUSE_CLASS_USB, MOUSE_MERGE_SCALE_ONE);
+    mouse_merge_remove(2);
+}
+
+static void test_absolute(void) {
+    int32_t dx, dy;
+    // The first sample only sets the position
+    mouse_merge_absolute(3, MOUSE_CLASS_USB, 500, 500, 1000, 1000, true, 0);
+    pass(&dx, &dy);
+    CHECK_EQ(dx, 0);
+    CHECK_EQ(dy, 0);
+
+    // Half the range is half of MOUSE_MERGE_ABS_SPAN
+    mouse_merge_absolute(3, MOUSE_CLASS_USB, 1000, 250, 1000, 1000, true, 0);
+    pass(&dx, &dy);
+    CHECK_EQ(dx, MOUSE_MERGE_ABS_SPAN / 2);
+    CHECK_EQ(dy, -MOUSE_MERGE_ABS_SPAN / 4);
+
+    // Lifting and touching elsewhere does not move the pointer
+    mouse_merge_absolute(3, MOUSE_CLASS_USB, 1000, 250, 1000, 1000, false, 0);
+    mouse_merge_absolute(3, MOUSE_CLASS_USB, 0, 0, 1000, 1000, true, 0);
+    pass(&dx, &dy);
+    CHECK_EQ(dx, 0);
+    CHECK_EQ(dy, 0);
+    mouse_merge_remove(3);
+}
+
+static void test_full_table(void) {
+    int32_t dx, dy;
+    uint8_t b;
+    for (int i = 0; i < MOUSE_MERGE_SOURCES; i++) {
+        mouse_merge_relative((uint16_t)(10 + i), MOUSE_CLASS_USB, 0, 0, 0);
+    }
+    CHECK_EQ(mouse_merge_active(), MOUSE_MERGE_SOURCES);
+
+    // One source too many still moves and clicks, for this pass only
+    mouse_merge_relative(99, MOUSE_CLASS_USB, 5, 0, MOUSE_MERGE_LEFT);
+    CHECK(mouse_merge_take_buttons(&b));
+    CHECK_EQ(b, MOUSE_MERGE_LEFT);
+    pass(&dx, &dy);
+    CHECK_EQ(dx, 5);
+    CHECK(mouse_merge_take_buttons(&b));
+    CHECK_EQ(b, 0);
+    for (int i = 0; i < MOUSE_MERGE_SOURCES; i++) {
+        mouse_merge_remove((uint16_t)(10 + i));
+    }
+}
+
+static bool info_for(uint16_t id, mouse_merge_info_t* info) {
+    for (int i = 0; i < MOUSE_MERGE_SOURCES; i++) {
+        if (mouse_merge_source_info(i, info) && info->id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// One 10 ms pass of a 100 Hz mouse moving counts per report
+static int32_t mouse_pass(uint16_t id, int32_t counts) {
+    int32_t dx, dy;
+    mouse_merge_relative(id, MOUSE_CLASS_USB, counts, 0, 0);
+    mouse_merge_end(&dx, &dy);
+    mouse_merge_begin(now += 10000);
+    return dx;
+}
+
+static void test_normalise(void) {
+    mouse_merge_info_t info;
+    mouse_merge_set_normalise(true);
+    mouse_merge_begin(now);
+
+    // 32 counts per report at 100 Hz is 3200 counts/s, twice the target
+    int samples = 0;
+    while (samples < MOUSE_NORM_MIN_SAMPLES - 1) {
+        CHECK_EQ(mouse_pass(4, 32), 32);    // Not enough samples to scale yet
+        CHECK(info_for(4, &info));
+        samples = info.samples;
+    }
+    CHECK_EQ(info.median_cps, 0);
+    CHECK_EQ(info.norm, MOUSE_NORM_ONE);
+
+    for (int i = 0; i < 5; i++) {
+        mouse_pass(4, 32);
+    }
+    CHECK(info_for(4, &info));
+    CHECK_EQ(info.samples, MOUSE_NORM_MIN_SAMPLES);
+    CHECK(info.median_cps >= 3072 && info.median_cps < 3584);     // Its bucket
+    CHECK(info.norm > MOUSE_NORM_ONE * 9 / 20 && info.norm < MOUSE_NORM_ONE * 11 / 20);
+    CHECK_EQ(info.report_hz, 100);
+    CHECK(!info.calibrated);
+
+    // Stalls and still samples add nothing
+    mouse_merge_relative(4, MOUSE_CLASS_USB, 32, 0, 0);
+    mouse_merge_begin(now += MOUSE_NORM_MAX_PASS_US + 1);
+    for (int i = 0; i < 10; i++) {
+        mouse_pass(4, 0);
+    }
+    CHECK(info_for(4, &info));
+    CHECK_EQ(info.samples, MOUSE_NORM_MIN_SAMPLES);
+
+    // The factor freezes once the window is full
+    for (int i = 0; i < 5 * MOUSE_NORM_WINDOW; i++) {
+        mouse_pass(4, 32);
+    }
+    CHECK(info_for(4, &info));
+    CHECK(info.calibrated);
+    CHECK_EQ(info.samples, MOUSE_NORM_WINDOW);
+    int32_t frozen = info.norm;
+    for (int i = 0; i < 50; i++) {
+        mouse_pass(4, 400);
+    }
+    CHECK(info_for(4, &info));
+    CHECK_EQ(info.norm, frozen);
+
+    // Scaled motion over many reports matches the factor: only the
+    // remainder carried in from earlier reports can make a difference
+    int32_t total = 0;
+    for (int i = 0; i < 100; i++) {
+        total += mouse_pass(4, 32);
+    }
+    int32_t expect = (int32_t)((int64_t)3200 * frozen / MOUSE_NORM_ONE);
+    CHECK(total >= expect - 1 && total <= expect + 1);
+
+    // Off means off
+    mouse_merge_set_normalise(false);
+    CHECK_EQ(mouse_pass(4, 32), 32);
+    mouse_merge_remove(4);
+}
+
+static void test_norm_clamped(void) {
+    mouse_merge_info_t info;
+    mouse_merge_set_normalise(true);
+    mouse_merge_begin(now);
+    // One count per report is 100 counts/s: sped up at most MOUSE_NORM_MAX
+    for (int i = 0; i < 5 * MOUSE_NORM_MIN_SAMPLES; i++) {
+        mouse_pass(5, 1);
+    }
+    CHECK(info_for(5, &info));
+    CHECK_EQ(info.norm, MOUSE_NORM_MAX);
+    mouse_merge_remove(5);
+    mouse_merge_set_normalise(false);
+}
+
+// Hand speed at t ms, in inches per second: 1, 2, 3, 4 and 2 ips for 400 ms
+// each, then a 400 ms pause
+static int32_t hand_ips(uint32_t t_ms) {
+    static const int32_t profile[] = { 1, 2, 3, 4, 2, 0 };
+    return profile[(t_ms / 400) % 6];
+}
+
+// Move a mouse of dpi reporting at hz through the hand motion from t0_ms for
+// ms, in 1 ms passes. Returns the ST displacement.
+static int32_t dpi_trace(uint16_t id, int32_t dpi, int32_t hz, uint32_t t0_ms, uint32_t ms) {
+    static int64_t pos_uin;         // Hand position, micro-inches
+    static int64_t reported;        // Counts reported so far
+    int32_t period_ms = 1000 / hz;
+    int32_t total = 0;
+    if (t0_ms == 0) {
+        pos_uin = 0;
+        reported = 0;
+    }
+    for (uint32_t t = t0_ms; t < t0_ms + ms; t++) {
+        pos_uin += hand_ips(t) * 1000;
+        if (t % period_ms == 0) {
+            int64_t counts = pos_uin * dpi / 1000000;
+            mouse_merge_relative(id, MOUSE_CLASS_USB, (int32_t)(counts - reported), 0, 0);
+            reported = counts;
+        }
+        int32_t dx, dy;
+        mouse_merge_end(&dx, &dy);
+        mouse_merge_begin(now += 1000);
+        total += dx;
+    }
+    return total;
+}
+
+// A 400 DPI mouse at 125 Hz and a 16000 DPI mouse at 1000 Hz, moved the
+// same way: once calibrated, the ST sees the same displacement
+static void test_dpi_traces(void) {
+    mouse_merge_info_t slow, fast;
+    mouse_merge_set_normalise(true);
+    mouse_merge_begin(now);
+
+    dpi_trace(20, 400, 125, 0, 9600);
+    int32_t slow_total = dpi_trace(20, 400, 125, 9600, 4800);
+    CHECK(info_for(20, &slow));
+    mouse_merge_remove(20);
+
+    dpi_trace(21, 16000, 1000, 0, 9600);
+    int32_t fast_total = dpi_trace(21, 16000, 1000, 9600, 4800);
+    CHECK(info_for(21, &fast));
+    mouse_merge_remove(21);
+
+    CHECK(slow.calibrated);
+    CHECK(fast.calibrated);
+    CHECK_EQ(slow.report_hz, 125);
+    CHECK_EQ(fast.report_hz, 1000);
+    CHECK(slow.norm > MOUSE_NORM_ONE && slow.norm < MOUSE_NORM_MAX);
+    CHECK(fast.norm > MOUSE_NORM_MIN && fast.norm < MOUSE_NORM_ONE);
+
+    // 9.6 inches of hand travel either way; raw, the counts differ 40x. A
+    // 125 Hz mouse lands 6 or 7 reports in each 50 ms sample, so its speeds
+    // straddle the quarter-octave (19%) histogram buckets and its median is
+    // only good to about half a bucket
+    CHECK(slow_total > 0);
+    CHECK(fast_total > slow_total * 88 / 100 && fast_total < slow_total * 112 / 100);
+    mouse_merge_set_normalise(false);
+}
+
+int main(void) {
+    mouse_merge_set_normalise(false);
+    test_motion_and_buttons();
+    test_report_without_buttons();
+    test_scale_keeps_remainder();
+    test_absolute();
+    test_full_table();
+    test_normalise();
+    test_norm_clamped();
+    test_dpi_traces();
+    return test_report("mouse_merge");
+}
@@ -0,0 +1,235 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "test.h"
+#include "oled_text.h"
+
+extern const uint8_t font_8x5[];
+
+static bool splash_blocks;
+
+bool mount_splash_blocks_oled(void) {
+    return splash_blocks;
+}
+
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+    (void)i2c; (void)addr; (void)src; (void)nostop;
+    return (int)len;
+}
+
+typedef struct {
+    uint8_t x, y;
+    const char* s;
+} line_t;
+
+static ssd1306_t disp;      // Drawn by oled_text
+static ssd1306_t ref;       // The same page drawn from scratch
+
+static bool page(const line_t* lines, int count) {
+    oled_text_begin(&disp);
+    ssd1306_clear(&ref);
+    for (int i = 0; i < count; i++) {
+        oled_text_draw(lines[i].x, lines[i].y, lines[i].s);
+        for (int c = 0; lines[i].s[c] && lines[i].x + c * OLED_TEXT_CELL_W < 128; c++) {
+            ssd1306_draw_char(&ref, lines[i].x + c * OLED_TEXT_CELL_W, lines[i].y, 1, lines[i].s[c]);
+        }
+    }
+    return oled_text_end();
+}
+
+static bool matches(void) {
+    return memcmp(disp.buffer, ref.buffer, disp.bufsize) == 0;
+}
+
+static void test_diff_matches_full_redraw(void) {
+    const line_t a[] = { { 0, 0, "Telemetry" }, { 0, 16, "c1.loops  1234" }, { 8, 24, "ok" } };
+    const line_t b[] = { { 0, 0, "Telemetry" }, { 0, 16, "c1.loops  1299" }, { 8, 24, "" } };
+    const line_t c[] = { { 0, 0, "Telemetry" }, { 0, 16, "c1.loops    9" }, { 8, 24, "longer text" } };
+
+    CHECK(page(a, 3));
+    CHECK(matches());
+    uint32_t clears = disp.clears;
+
+    CHECK(!page(a, 3));                 // Nothing changed
+    CHECK(page(b, 3));
+    CHECK(matches());
+    CHECK(page(c, 3));
+    CHECK(matches());
+    CHECK_EQ(disp.clears, clears);      // All done cell by cell
+}
+
+static void test_full_redraws(void) {
+    const line_t a[] = { { 0, 0, "Page one" }, { 0, 8, "x" } };
+    const line_t moved[] = { { 0, 0, "Page one" }, { 0, 9, "x" } };
+    const line_t overlap[] = { { 0, 0, "ABCD" }, { 4, 4, "EF" } };
+
+    page(a, 2);
+    uint32_t clears = disp.clears;
+    CHECK(page(moved, 2));
+    CHECK(matches());
+    CHECK_EQ(disp.clears, clears + 1);
+
+    // Overlapping lines are drawn in full every time
+    page(overlap, 2);
+    clears = disp.clears;
+    page(overlap, 2);
+    CHECK_EQ(disp.clears, clears + 1);
+    CHECK(matches());
+
+    // Someone else cleared the framebuffer
+    page(a, 2);
+    ssd1306_clear(&disp);
+    CHECK(page(a, 2));
+    CHECK(matches());
+
+    oled_text_invalidate();
+    clears = disp.clears;
+    CHECK(page(a, 2));
+    CHECK_EQ(disp.clears, clears + 1);
+}
+
+static void test_splash(void) {
+    const line_t a[] = { { 0, 0, "Before" } };
+    const line_t b[] = { { 0, 0, "After" } };
+    page(a, 1);
+
+    // Nothing is drawn under the splash, and the page after it is drawn in full
+    splash_blocks = true;
+    ssd1306_draw_string(&disp, 0, 32, 1, "splash");
+    CHECK(!page(b, 1));
+    splash_blocks = false;
+    uint32_t clears = disp.clears;
+    CHECK(page(b, 1));
+    CHECK_EQ(disp.clears, clears + 1);
+    CHECK(matches());
+}
+
+static void test_right_edge(void) {
+    // Cells past the edge are dropped, and the last partial cell is kept
+    const line_t a[] = { { 100, 0, "abcdefgh" } };
+    const line_t b[] = { { 100, 0, "abcXefgh" } };
+    const line_t c[] = { { 100, 0, "abcXeZgh" } };
+    page(a, 1);
+    CHECK(page(b, 1));
+    CHECK(matches());
+    CHECK(!page(c, 1));
+}
+
+// The glyph path before column blitting: every lit pixel drawn as a
+// scale x scale square through ssd1306_draw_pixel()
+static void per_pixel_char(ssd1306_t* p, uint32_t x, uint32_t y, uint32_t scale, char c) {
+    const uint8_t* font = font_8x5;
+    if (c < ' ' || c > '~') {
+        return;
+    }
+    for (uint8_t i = 0; i < font[1]; ++i) {
+        uint8_t line = font[(c - 0x20) * font[1] + i + 2];
+        for (int8_t j = 0; j < font[0]; ++j, line >>= 1) {
+            if (line & 1) {
+                ssd1306_draw_square(p, x + i * scale, y + j * scale, scale, scale);
+            }
+        }
+    }
+}
+
+static void test_blit_matches_per_pixel(void) {
+    // Every glyph at scale 1-3, at random positions including every page
+    // offset and the right and bottom edges, three to a frame so the ORs
+    // into shared bytes are covered too
+    srand(91);
+    for (int round = 0; round < 20; round++) {
+        for (char c = ' '; c <= '~'; c++) {
+            ssd1306_clear(&disp);
+            ssd1306_clear(&ref);
+            for (int k = 0; k < 3; k++) {
+                uint32_t x = (uint32_t)(rand() % 128);
+                uint32_t y = (uint32_t)(rand() % 64);
+                uint32_t scale = 1 + (uint32_t)(rand() % 3);
+                char g = (char)(k == 0 ? c : ' ' + rand() % 95);
+                ssd1306_draw_char(&disp, x, y, scale, g);
+                per_pixel_char(&ref, x, y, scale, g);
+            }
+            if (!matches()) {
+                CHECK(matches());
+                return;
+            }
+        }
+    }
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// A six-line status page drawn the old way, blitted in full, and through
+// oled_text with one field changing. Host timings, for the before/after
+// ratio only; nothing is asserted on them.
+static void bench_page(void) {
+    const char* text[6] = {
+        "Atari ST IKBD", "Mouse  USB", "Joy 0  Gamecube", "Joy 1  XInput", "Ser    7812 bps", "CPU    1234",
+    };
+    const int n = 2000;
+    double t0 = now_us();
+    for (int r = 0; r < n; r++) {
+        ssd1306_clear(&ref);
+        for (int i = 0; i < 6; i++) {
+            for (int c = 0; text[i][c]; c++) {
+                per_pixel_char(&ref, c * OLED_TEXT_CELL_W, i * 10, 1, text[i][c]);
+            }
+        }
+    }
+    double t1 = now_us();
+    for (int r = 0; r < n; r++) {
+        ssd1306_clear(&disp);
+        for (int i = 0; i < 6; i++) {
+            ssd1306_draw_string(&disp, 0, i * 10, 1, text[i]);
+        }
+    }
+    CHECK(matches());
+    double t2 = now_us();
+    char cpu[16];
+    for (int r = 0; r < n; r++) {
+        snprintf(cpu, sizeof(cpu), "CPU    %04d", r);
+        oled_text_begin(&disp);
+        for (int i = 0; i < 5; i++) {
+            oled_text_draw(0, i * 10, text[i]);
+        }
+        oled_text_draw(0, 50, cpu);
+        oled_text_end();
+    }
+    double t3 = now_us();
+    printf("oled_text: six-line page per-pixel %.2f us, blitted %.2f us, diffed %.2f us\n",
+           (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / n);
+}
+
+int main(void) {
+    CHECK(ssd1306_init(&disp, 128, 64, 0x3C, NULL));
+    CHECK(ssd1306_init(&ref, 128, 64, 0x3C, NULL));
+    test_diff_matches_full_redraw();
+    test_full_redraws();
+    test_splash();
+    test_right_edge();
+    test_blit_matches_per_pixel();
+    bench_page();
+    return test_report("oled_text");
+}
@@ -0,0 +1,148 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "test.h"
+#include "pad_keymap.h"
+
+#define KEY_LALT    0x38
+#define KEY_X       0x2D
+
+static pad_key_edge_t edges[PAD_KEYMAP_MAX_EDGES];
+
+static int button(const char* name) {
+    int b = pad_keymap_button_find(name);
+    CHECK(b >= 0);
+    return b;
+}
+
+static void test_chord_and_release_order(void) {
+    int south = button("south");
+    pad_keymap_custom_clear();
+    CHECK(pad_keymap_custom_bind((uint8_t)south, KEY_LALT));
+    CHECK(pad_keymap_custom_bind((uint8_t)south, KEY_X));
+    CHECK(!pad_keymap_custom_bind((uint8_t)south, 0x10));     // Third key for one button
+    pad_keymap_set_profile(PAD_KEYMAP_CUSTOM);
+
+    // Modifier down first, up last
+    CHECK_EQ(pad_keymap_update(PAD_BTN_SOUTH, edges), 2);
+    CHECK(edges[0].key == KEY_LALT && edges[0].down);
+    CHECK(edges[1].key == KEY_X && edges[1].down);
+    CHECK_EQ(pad_keymap_update(PAD_BTN_SOUTH, edges), 0);
+    CHECK_EQ(pad_keymap_update(0, edges), 2);
+    CHECK(edges[0].key == KEY_X && !edges[0].down);
+    CHECK(edges[1].key == KEY_LALT && !edges[1].down);
+
+    // Unbound buttons do nothing
+    CHECK_EQ(pad_keymap_update(PAD_BTN_HOME | PAD_BTN_R2, edges), 0);
+    pad_keymap_update(0, edges);
+}
+
+static void test_shared_key_refcount(void) {
+    pad_keymap_custom_clear();
+    pad_keymap_custom_bind((uint8_t)button("l1"), KEY_X);
+    pad_keymap_custom_bind((uint8_t)button("r1"), KEY_X);
+    pad_keymap_set_profile(PAD_KEYMAP_CUSTOM);
+
+    CHECK_EQ(pad_keymap_update(PAD_BTN_L1, edges), 1);
+    CHECK_EQ(pad_keymap_update(PAD_BTN_L1 | PAD_BTN_R1, edges), 0);
+    CHECK_EQ(pad_keymap_update(PAD_BTN_R1, edges), 0);     // Still held by R1
+    CHECK_EQ(pad_keymap_update(0, edges), 1);
+    CHECK(edges[0].key == KEY_X && !edges[0].down);
+}
+
+static void test_profile_switch_while_held(void) {
+    pad_keymap_set_profile(PAD_KEYMAP_MENUS);
+    CHECK_EQ(pad_keymap_update(PAD_BTN_START, edges), 1);     // Return
+    uint8_t held = edges[0].key;
+
+    // The old key goes up and the held button presses the new one
+    pad_keymap_set_profile(PAD_KEYMAP_FKEYS);
+    CHECK_EQ(pad_keymap_update(PAD_BTN_START, edges), 2);
+    CHECK(edges[0].key == held && !edges[0].down);
+    CHECK(edges[1].key != held && edges[1].down);
+
+    pad_keymap_set_profile(PAD_KEYMAP_OFF);
+    CHECK_EQ(pad_keymap_update(PAD_BTN_START, edges), 1);
+    CHECK(!edges[0].down);
+    CHECK_EQ(pad_keymap_update(0, edges), 0);
+}
+
+static void test_reset(void) {
+    pad_keymap_set_profile(PAD_KEYMAP_MENUS);
+    pad_keymap_update(0, edges);
+    CHECK_EQ(pad_keymap_update(PAD_BTN_SELECT, edges), 1);
+    pad_keymap_reset();
+    // Still held: pressed again, with no release for the forgotten key
+    CHECK_EQ(pad_keymap_update(PAD_BTN_SELECT, edges), 1);
+    CHECK(edges[0].down);
+    pad_keymap_update(0, edges);
+}
+
+static void test_custom_edit_and_persist(void) {
+    uint16_t rows[PAD_KEYMAP_CUSTOM_MAX];
+    pad_keymap_custom_clear();
+    CHECK(!pad_keymap_custom_bind(PAD_BTN_COUNT, KEY_X));
+    CHECK(!pad_keymap_custom_bind(0, 0x80));
+    pad_keymap_custom_bind(0, KEY_X);
+    pad_keymap_custom_bind(3, KEY_LALT);
+    pad_keymap_custom_bind(3, KEY_X);
+    CHECK_EQ(pad_keymap_binding_count(PAD_KEYMAP_CUSTOM), 3);
+
+    // Key 0 removes every row for the button
+    pad_keymap_custom_bind(3, 0);
+    CHECK_EQ(pad_keymap_binding_count(PAD_KEYMAP_CUSTOM), 1);
+    pad_keymap_custom_bind(3, KEY_LALT);
+
+    pad_keymap_custom_export(rows);
+    CHECK_EQ(rows[0], KEY_X);
+    CHECK_EQ(rows[1], (3 << 8) | KEY_LALT);
+    CHECK_EQ(rows[2], 0);
+    pad_keymap_custom_clear();
+    pad_keymap_custom_import(rows);
+    pad_keymap_binding_t b;
+    CHECK_EQ(pad_keymap_binding_count(PAD_KEYMAP_CUSTOM), 2);
+    CHECK(pad_keymap_binding(PAD_KEYMAP_CUSTOM, 1, &b));
+    CHECK(b.button == 3 && b.key == KEY_LALT);
+    CHECK(!pad_keymap_binding(PAD_KEYMAP_CUSTOM, 2, &b));
+
+    // The custom profile fills up
+    pad_keymap_custom_clear();
+    for (int i = 0; i < PAD_KEYMAP_CUSTOM_MAX; i++) {
+        CHECK(pad_keymap_custom_bind((uint8_t)(i % PAD_BTN_COUNT), (uint8_t)(0x10 + i)));
+    }
+    CHECK(!pad_keymap_custom_bind(12, 0x70));
+}
+
+static void test_names(void) {
+    CHECK_EQ(pad_keymap_button_find("start"), 9);
+    CHECK_EQ(pad_keymap_button_find("nope"), -1);
+    CHECK(pad_keymap_button_name(PAD_BTN_COUNT)[0] == '?');
+    CHECK(pad_keymap_profile_name(PAD_KEYMAP_PROFILE_COUNT)[0] == '?');
+    pad_keymap_set_profile(PAD_KEYMAP_PROFILE_COUNT);     // Ignored
+    CHECK(pad_keymap_get_profile() < PAD_KEYMAP_PROFILE_COUNT);
+}
+
+int main(void) {
+    test_chord_and_release_order();
+    test_shared_key_refcount();
+    test_profile_switch_while_held();
+    test_reset();
+    test_custom_edit_and_persist();
+    test_names();
+    return test_report("pad_keymap");
+}
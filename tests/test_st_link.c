@@ -0,0 +1,102 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "test.h"
+#include "st_link.h"
+#include "hardware/regs/uart.h"
+#include "config.h"
+#include "telemetry.h"
+
+static void test_decode(void) {
+    telemetry_reset();
+    CHECK_EQ(st_link_decode(0x5A), ST_LINK_RX_BYTE);
+    // Overrun flags a lost earlier byte; the one it comes with is good
+    CHECK_EQ(st_link_decode(UART_UARTDR_OE_BITS | 0x80), ST_LINK_RX_BYTE);
+    CHECK_EQ(st_link_decode(UART_UARTDR_BE_BITS | UART_UARTDR_FE_BITS), ST_LINK_RX_BREAK);
+    CHECK_EQ(st_link_decode(UART_UARTDR_FE_BITS | 0x12), ST_LINK_RX_ERROR);
+    CHECK_EQ(st_link_decode(UART_UARTDR_PE_BITS | 0x13), ST_LINK_RX_ERROR);
+    CHECK_EQ(st_link_decode(UART_UARTDR_OE_BITS | UART_UARTDR_PE_BITS), ST_LINK_RX_ERROR);
+
+    CHECK_EQ(telemetry_counter(TM_UART_OVERRUN), 2);
+    CHECK_EQ(telemetry_counter(TM_UART_BREAK), 1);
+    CHECK_EQ(telemetry_counter(TM_UART_FRAMING), 1);   // Not for the break
+    CHECK_EQ(telemetry_counter(TM_UART_PARITY), 2);
+}
+
+static void test_long_low_goes_down(void) {
+    st_link_t link = {0};
+    uint32_t t = 1000;
+    CHECK(!st_link_poll(&link, false, 0, false, t));
+    CHECK(!st_link_poll(&link, true, 0, false, t += 100));
+    CHECK(!st_link_poll(&link, true, 0, false, t += ST_LINK_LOW_US - 1));
+    CHECK(!link.down);
+    CHECK(!st_link_poll(&link, true, 0, false, t += 1));
+    CHECK(link.down);
+    CHECK(!st_link_poll(&link, true, 0, false, t += 500000));
+    CHECK(st_link_poll(&link, false, 0, false, t += 10));     // Back: re-sync once
+    CHECK(!link.down);
+    CHECK(!st_link_poll(&link, false, 0, false, t += 10));
+}
+
+static void test_stall_during_traffic(void) {
+    st_link_t link = {0};
+    uint32_t t = 0;
+    uint32_t rx = 0;
+
+    // The main loop stalls 30 ms between polls while bytes keep arriving;
+    // each sample happens to land on a low bit of a different byte
+    for (int i = 0; i < 10; i++) {
+        rx += 40;
+        CHECK(!st_link_poll(&link, true, rx, false, t += 30000));
+        CHECK(!link.down);
+    }
+
+    // Received bytes counted with wrap
+    rx = 0xFFFFFFF0u;
+    CHECK(!st_link_poll(&link, true, rx, false, t += 30000));
+    rx += 0x20;
+    CHECK(!st_link_poll(&link, true, rx, false, t += 30000));
+    CHECK(!link.down);
+
+    // A real low line: nothing received while it stays low
+    CHECK(!st_link_poll(&link, true, rx, false, t += ST_LINK_LOW_US));
+    CHECK(link.down);
+}
+
+static void test_break(void) {
+    st_link_t link = {0};
+    uint32_t before = telemetry_counter(TM_ST_LINK_RESYNC);
+
+    // A break is a down link straight away; re-sync when the line is high
+    CHECK(!st_link_poll(&link, true, 1, true, 100));
+    CHECK(link.down);
+    CHECK(st_link_poll(&link, false, 1, false, 200));
+    CHECK_EQ(telemetry_counter(TM_ST_LINK_RESYNC), before + 1);
+
+    // Short break already over by the time the main loop looks
+    CHECK(st_link_poll(&link, false, 2, true, 300));
+    CHECK_EQ(telemetry_counter(TM_ST_LINK_RESYNC), before + 2);
+}
+
+int main(void) {
+    test_decode();
+    test_long_low_goes_down();
+    test_stall_during_traffic();
+    test_break();
+    return test_report("st_link");
+}
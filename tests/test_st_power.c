@@ -0,0 +1,83 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "test.h"
+#include "st_power.h"
+#include "config.h"
+
+static void test_enter_and_exit(void) {
+    uint32_t t = 0;
+    CHECK_EQ(st_power_update(true, t), ST_POWER_NONE);
+    CHECK_EQ(st_power_state(), ST_POWER_ON);
+
+    // Absent, but not for long enough
+    CHECK_EQ(st_power_update(false, t += 1000), ST_POWER_NONE);
+    CHECK_EQ(st_power_state(), ST_POWER_LEAVING);
+    CHECK_EQ(st_power_update(false, t += ST_IDLE_DELAY_US - 1), ST_POWER_NONE);
+    CHECK(!st_power_idle());
+
+    CHECK_EQ(st_power_update(false, t += 1), ST_POWER_ENTER_IDLE);
+    CHECK(st_power_idle());
+    CHECK_EQ(st_power_update(false, t += 5000000), ST_POWER_NONE);
+    CHECK_EQ(st_power_idle_entries(), 1);
+
+    CHECK_EQ(st_power_update(true, t += 10), ST_POWER_EXIT_IDLE);
+    CHECK_EQ(st_power_state(), ST_POWER_ON);
+    CHECK_EQ(st_power_residency_us(ST_POWER_IDLE), 5000010);
+}
+
+static void test_glitch_does_not_idle(void) {
+    uint32_t t = 100000000;
+    st_power_update(true, t);
+    st_power_update(false, t += 1000);
+    CHECK_EQ(st_power_update(true, t += 1000), ST_POWER_NONE);
+    CHECK_EQ(st_power_state(), ST_POWER_ON);
+    // The LEAVING timer starts again from the next absence
+    st_power_update(false, t += 1000);
+    CHECK_EQ(st_power_update(false, t += ST_IDLE_DELAY_US - 1), ST_POWER_NONE);
+}
+
+static void test_disable_while_idle(void) {
+    uint32_t t = 200000000;
+    st_power_update(true, t);
+    st_power_update(false, t += 1);
+    CHECK_EQ(st_power_update(false, t += ST_IDLE_DELAY_US), ST_POWER_ENTER_IDLE);
+    st_power_set_enabled(false);
+    CHECK_EQ(st_power_update(false, t += 1), ST_POWER_EXIT_IDLE);
+    CHECK_EQ(st_power_update(false, t += ST_IDLE_DELAY_US * 2), ST_POWER_NONE);
+    CHECK(!st_power_idle());
+    st_power_set_enabled(true);
+}
+
+static void test_time_wraps(void) {
+    uint32_t t = 0xFFFFFFFFu - 1000;
+    st_power_update(true, t);
+    st_power_update(false, t += 1);
+    // now_us wraps past zero before the delay is up
+    CHECK_EQ(st_power_update(false, t += ST_IDLE_DELAY_US - 1), ST_POWER_NONE);
+    CHECK_EQ(st_power_update(false, t += 1), ST_POWER_ENTER_IDLE);
+    st_power_update(true, t += 1);
+}
+
+int main(void) {
+    test_enter_and_exit();
+    test_glitch_does_not_idle();
+    test_disable_while_idle();
+    test_time_wraps();
+    return test_report("st_power");
+}
@@ -0,0 +1,100 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include "test.h"
+#include "stick_mouse.h"
+
+static void test_curve(void) {
+    stick_curve_t c = { 10, 2, 1000 };
+    CHECK_EQ(stick_curve_eval(&c, 0), 0);
+    CHECK_EQ(stick_curve_eval(&c, 10), 0);
+    CHECK_EQ(stick_curve_eval(&c, -10), 0);
+    CHECK(stick_curve_eval(&c, 11) > 0);
+
+    // Full deflection is max_speed, either way and past the axis limit
+    CHECK_EQ(stick_curve_eval(&c, 127), 1000LL * STICK_MOUSE_Q16_ONE);
+    CHECK_EQ(stick_curve_eval(&c, -127), -1000LL * STICK_MOUSE_Q16_ONE);
+    CHECK_EQ(stick_curve_eval(&c, 300), 1000LL * STICK_MOUSE_Q16_ONE);
+
+    // Monotonic and odd
+    int64_t prev = 0;
+    for (int32_t v = 0; v <= STICK_MOUSE_AXIS_MAX; v++) {
+        int64_t s = stick_curve_eval(&c, v);
+        CHECK(s >= prev);
+        CHECK_EQ(stick_curve_eval(&c, -v), -s);
+        prev = s;
+    }
+
+    // Squared: half way past the dead zone is a quarter of the speed
+    int64_t half = stick_curve_eval(&c, 10 + 117 / 2);
+    CHECK(half > 240LL * STICK_MOUSE_Q16_ONE && half < 255LL * STICK_MOUSE_Q16_ONE);
+}
+
+static void test_curve_limits(void) {
+    // Out of range settings are clamped, not trusted
+    stick_curve_t c = { 500, 0, 100 };
+    CHECK_EQ(stick_curve_eval(&c, 126), 0);
+    CHECK_EQ(stick_curve_eval(&c, 127), 100LL * STICK_MOUSE_Q16_ONE);
+    c.dead_zone = -5;
+    c.exponent = 99;
+    CHECK(stick_curve_eval(&c, 1) >= 0);
+    CHECK_EQ(stick_curve_eval(&c, 127), 100LL * STICK_MOUSE_Q16_ONE);
+}
+
+static void test_update_keeps_remainder(void) {
+    stick_curve_t c = { 0, 1, 100 };
+    int32_t dx, dy, total_x = 0, total_y = 0;
+    stick_mouse_reset();
+    // 100 counts/s in 1 ms steps: nothing per step, 100 over a second
+    for (int i = 0; i < 1000; i++) {
+        stick_mouse_update(&c, 127, -127, 1000, &dx, &dy);
+        CHECK(dx <= 1 && dy >= -1);
+        total_x += dx;
+        total_y += dy;
+    }
+    CHECK_EQ(total_x, 100);
+    CHECK_EQ(total_y, -100);
+
+    // Reset drops the part count
+    stick_mouse_update(&c, 127, 0, 5000, &dx, &dy);
+    stick_mouse_reset();
+    stick_mouse_update(&c, 127, 0, 5000, &dx, &dy);
+    CHECK_EQ(dx, 0);
+    CHECK_EQ(dy, 0);
+}
+
+static void test_enable_resets(void) {
+    stick_curve_t c = { 0, 1, 100 };
+    int32_t dx, dy;
+    stick_mouse_reset();
+    stick_mouse_update(&c, 127, 0, 9000, &dx, &dy);
+    stick_mouse_set_enabled(true);
+    CHECK(stick_mouse_enabled());
+    stick_mouse_update(&c, 127, 0, 9000, &dx, &dy);
+    CHECK_EQ(dx, 0);
+    stick_mouse_set_enabled(false);
+    CHECK(!stick_mouse_enabled());
+}
+
+int main(void) {
+    test_curve();
+    test_curve_limits();
+    test_update_keeps_remainder();
+    test_enable_resets();
+    return test_report("stick_mouse");
+}
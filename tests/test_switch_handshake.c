@@ -0,0 +1,287 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * Replays the USB handshake of a Pro Controller, as recorded from one
+ * (BetterJoy sequence), against switch_controller.c. The fake OUT pipe keeps
+ * every report sent; the test answers each with the reply the controller
+ * gave, drops replies to force retransmits, or reports the pipe busy.
+ */
+#include <string.h>
+#include "test.h"
+#include "switch_controller.h"
+#include "config.h"
+#include "telemetry.h"
+#include "tusb.h"
+#include "pico/time.h"
+
+#define DEV     3
+
+static const uint8_t rumble[8] = { 0x00, 0x01, 0x40, 0x40, 0x00, 0x01, 0x40, 0x40 };
+
+typedef struct {
+    uint8_t out[2];         // 0x80 command, or subcommand ID and argument
+    bool    sub;
+    bool    reply;
+} trace_step_t;
+
+// OUT reports of the recorded session in order, and whether it answered
+static const trace_step_t trace[] = {
+    { { 0x80, 0x02 }, false, true  },
+    { { 0x80, 0x03 }, false, true  },
+    { { 0x80, 0x02 }, false, true  },
+    { { 0x80, 0x04 }, false, false },
+    { { 0x40, 0x01 }, true,  true  },
+    { { 0x48, 0x01 }, true,  true  },
+    { { 0x03, 0x30 }, true,  true  },
+};
+#define TRACE_STEPS ((int)(sizeof(trace) / sizeof(trace[0])))
+
+// Fake host stack
+static uint8_t last_out[12];
+static uint16_t last_len;
+static int sends;
+static int busy_calls;
+static bool out_busy;
+
+bool tuh_hid_send_report(uint8_t dev_addr, uint8_t idx, uint8_t report_id, const void* report, uint16_t len) {
+    CHECK_EQ(dev_addr, DEV);
+    (void)idx; (void)report_id;
+    if (out_busy) {
+        busy_calls++;
+        return false;
+    }
+    CHECK(len <= sizeof(last_out));
+    memcpy(last_out, report, len);
+    last_len = len;
+    sends++;
+    return true;
+}
+
+bool tuh_hid_receive_report(uint8_t dev_addr, uint8_t idx) {
+    (void)dev_addr; (void)idx;
+    return true;
+}
+
+bool tuh_vid_pid_get(uint8_t dev_addr, uint16_t* vid, uint16_t* pid) {
+    (void)dev_addr;
+    *vid = SWITCH_VENDOR_ID;
+    *pid = SWITCH_PRO_CONTROLLER;
+    return true;
+}
+
+void usb_map_register_gamepad(uint8_t dev_addr, const char* name) {
+    (void)dev_addr; (void)name;
+}
+
+void usb_map_unregister_gamepad(uint8_t dev_addr) {
+    (void)dev_addr;
+}
+
+#if ENABLE_OLED_DISPLAY
+void mount_splash_show(uint32_t duration_ms, const char* title, const char* subtitle, const char* detail) {
+    (void)duration_ms; (void)title; (void)subtitle; (void)detail;
+}
+#endif
+
+static void pass_ms(uint32_t ms) {
+    host_time_us += (uint64_t)ms * 1000;
+    switch_check_delayed_init();
+}
+
+static switch_controller_t* ctrl(void) {
+    switch_controller_t* c = switch_get_controller(DEV);
+    CHECK(c != NULL);
+    return c;
+}
+
+// The last OUT report is the given step, with the given subcommand counter
+static void check_out(int step, uint8_t counter) {
+    const trace_step_t* t = &trace[step];
+    if (!t->sub) {
+        CHECK_EQ(last_len, 2);
+        CHECK(memcmp(last_out, t->out, 2) == 0);
+        return;
+    }
+    CHECK_EQ(last_len, 12);
+    CHECK_EQ(last_out[0], 0x01);
+    CHECK_EQ(last_out[1], counter);
+    CHECK(memcmp(&last_out[2], rumble, sizeof(rumble)) == 0);
+    CHECK_EQ(last_out[10], t->out[0]);
+    CHECK_EQ(last_out[11], t->out[1]);
+}
+
+// OUT transfer done, then the controller's answer, if it sends one
+static void answer(int step) {
+    const trace_step_t* t = &trace[step];
+    switch_report_sent(DEV);
+    if (!t->reply) {
+        return;
+    }
+    uint8_t r[64] = { 0 };
+    if (t->sub) {
+        r[0] = 0x21;
+        r[13] = 0x80;           // ACK
+        r[14] = t->out[0];
+        switch_process_report(DEV, r, sizeof(r));
+    } else {
+        r[0] = 0x81;
+        r[1] = t->out[1];
+        switch_process_report(DEV, r, 2);
+    }
+}
+
+static void mount(void) {
+    switch_unmount_cb(DEV);
+    sends = busy_calls = 0;
+    out_busy = false;
+    switch_mount_cb(DEV);
+    CHECK_EQ(ctrl()->hs_state, SWITCH_HS_DELAY);
+    pass_ms(999);
+    CHECK_EQ(sends, 0);
+    pass_ms(1);
+    CHECK_EQ(sends, 1);
+}
+
+static void finish_no_reply_step(int step) {
+    if (!trace[step].reply) {
+        // Nothing comes back: the step completes when the timeout runs out
+        CHECK_EQ(ctrl()->hs_state, SWITCH_HS_REPLY);
+        pass_ms(SWITCH_HS_REPLY_TIMEOUT_MS);
+    }
+}
+
+static void test_replay(void) {
+    mount();
+    uint8_t counter = 0;
+    for (int step = 0; step < TRACE_STEPS; step++) {
+        CHECK_EQ(sends, step + 1);
+        check_out(step, counter);
+        counter += trace[step].sub;
+        answer(step);
+        finish_no_reply_step(step);
+    }
+    CHECK_EQ(ctrl()->hs_state, SWITCH_HS_DONE);
+    CHECK_EQ(sends, TRACE_STEPS);
+    CHECK_EQ(switch_get_init_cmd_success(), 0x7F);
+
+    // Full mode reports go to the input parser from here on
+    uint8_t r[64] = { 0x30 };
+    r[3] = 0x08;                // A
+    switch_process_report(DEV, r, sizeof(r));
+    CHECK(ctrl()->buttons & SWITCH_BTN_A);
+}
+
+static void test_lost_replies(void) {
+    uint32_t retries = telemetry_counter(TM_SWITCH_HS_RETRY);
+    mount();
+    uint8_t counter = 0;
+    for (int step = 0; step < TRACE_STEPS; step++) {
+        check_out(step, counter);
+        counter += trace[step].sub;
+        if (step == 1 || step == 5) {
+            // Reply lost on the way back: the same step goes out again
+            switch_report_sent(DEV);
+            int before = sends;
+            pass_ms(SWITCH_HS_REPLY_TIMEOUT_MS - 1);
+            CHECK_EQ(sends, before);
+            pass_ms(1);
+            CHECK_EQ(sends, before + 1);
+            CHECK_EQ(ctrl()->hs_step, step);
+            check_out(step, counter);
+            counter += trace[step].sub;
+        }
+        answer(step);
+        finish_no_reply_step(step);
+    }
+    CHECK_EQ(ctrl()->hs_state, SWITCH_HS_DONE);
+    CHECK_EQ(sends, TRACE_STEPS + 2);
+    CHECK_EQ(switch_get_init_cmd_success(), 0x7F);
+    CHECK_EQ(telemetry_counter(TM_SWITCH_HS_RETRY), retries + 2);
+}
+
+static void test_silent_step_skipped(void) {
+    mount();
+    answer(0);
+    // The baud rate command is never answered: sent 1 + retries times
+    for (int i = 0; i <= SWITCH_HS_RETRIES; i++) {
+        CHECK_EQ(ctrl()->hs_step, 1);
+        CHECK_EQ(sends, 2 + i);
+        switch_report_sent(DEV);
+        pass_ms(SWITCH_HS_REPLY_TIMEOUT_MS);
+    }
+    CHECK_EQ(ctrl()->hs_step, 2);
+    check_out(2, 0);
+    for (int step = 2; step < TRACE_STEPS; step++) {
+        answer(step);
+        finish_no_reply_step(step);
+    }
+    CHECK_EQ(ctrl()->hs_state, SWITCH_HS_DONE);
+    CHECK_EQ(switch_get_init_cmd_success(), 0x7F & ~0x02);
+}
+
+static void test_busy_pipe(void) {
+    uint32_t skipped = telemetry_counter(TM_SWITCH_HS_BUSY);
+    mount();
+    answer(0);
+    CHECK_EQ(sends, 2);
+    answer(1);
+
+    // The pipe is busy for many main-loop passes that take no time
+    out_busy = true;
+    answer(2);
+    for (int i = 0; i < 100; i++) {
+        switch_check_delayed_init();
+    }
+    CHECK(busy_calls > 100);
+    CHECK_EQ(ctrl()->hs_step, 3);
+    CHECK_EQ(ctrl()->hs_state, SWITCH_HS_SEND);
+    CHECK_EQ(ctrl()->hs_tries, 0);
+
+    // Free again well within the limit: the step goes out as recorded
+    pass_ms(SWITCH_HS_REPLY_TIMEOUT_MS / 2);
+    out_busy = false;
+    switch_check_delayed_init();
+    CHECK_EQ(sends, 4);
+    check_out(3, 0);
+    CHECK_EQ(telemetry_counter(TM_SWITCH_HS_BUSY), skipped);
+
+    // Busy for longer than the limit: that step is given up
+    out_busy = true;
+    answer(3);
+    pass_ms(SWITCH_HS_REPLY_TIMEOUT_MS);
+    CHECK_EQ(ctrl()->hs_step, 4);
+    pass_ms(SWITCH_HS_REPLY_TIMEOUT_MS - 1);
+    CHECK_EQ(ctrl()->hs_step, 4);
+    pass_ms(1);
+    CHECK_EQ(ctrl()->hs_step, 5);
+    CHECK_EQ(telemetry_counter(TM_SWITCH_HS_BUSY), skipped + 1);
+    out_busy = false;
+    switch_check_delayed_init();
+    check_out(5, 0);
+}
+
+int main(void) {
+    test_replay();
+    test_lost_replies();
+    test_silent_step_skipped();
+    test_busy_pipe();
+    switch_unmount_cb(DEV);
+    return test_report("switch_handshake");
+}
@@ -0,0 +1,96 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <string.h>
+#include <unistd.h>
+#include "test.h"
+#include "telemetry.h"
+
+static char out[4096];
+
+// Run telemetry_print_changes() with stdout sent to a temporary file
+static const char* changes(void) {
+    fflush(stdout);
+    int saved = dup(1);
+    FILE* tmp = tmpfile();
+    dup2(fileno(tmp), 1);
+    telemetry_print_changes();
+    fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+    rewind(tmp);
+    size_t n = fread(out, 1, sizeof(out) - 1, tmp);
+    out[n] = '\0';
+    fclose(tmp);
+    return out;
+}
+
+static int lines(const char* s) {
+    int n = 0;
+    for (; *s; s++) {
+        n += (*s == '\n');
+    }
+    return n;
+}
+
+static void test_only_changes(void) {
+    changes();                          // Baseline
+    CHECK_EQ(lines(changes()), 0);      // Nothing moved
+
+    tm_add(TM_IQ_EVENTS, 3);
+    tm_set(TM_USB_HID_ACTIVE, 2);
+    const char* s = changes();
+    CHECK_EQ(lines(s), 2);
+    CHECK(strstr(s, "iq.events") && strstr(s, "+3 (3)"));
+    CHECK(strstr(s, "usb.active") != NULL);
+
+    tm_inc(TM_IQ_EVENTS);
+    s = changes();
+    CHECK_EQ(lines(s), 1);
+    CHECK(strstr(s, "+1 (4)") != NULL);
+    CHECK_EQ(lines(changes()), 0);
+}
+
+static void test_after_reset(void) {
+    tm_add(TM_IQ_APPLIED, 5);
+    changes();
+    telemetry_reset();
+    tm_inc(TM_IQ_APPLIED);
+    // The delta is what happened since the last print, not a wrapped one
+    const char* s = changes();
+    CHECK(strstr(s, "iq.applied") && strstr(s, "+1 (1)"));
+
+    // Counting past the value printed before the reset: all of it shows
+    tm_add(TM_IQ_APPLIED, 20);
+    changes();
+    telemetry_reset();
+    tm_add(TM_IQ_APPLIED, 30);
+    s = changes();
+    CHECK_EQ(lines(s), 1);
+    CHECK(strstr(s, "iq.applied") && strstr(s, "+30 (30)"));
+
+    // A reset with nothing counted since prints nothing
+    telemetry_reset();
+    CHECK_EQ(lines(changes()), 0);
+}
+
+int main(void) {
+    test_only_changes();
+    test_after_reset();
+    return test_report("telemetry");
+}
@@ -0,0 +1,240 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "test.h"
+#include "tunables.h"
+#include "NVSettings.h"
+#include "SerialPort.h"
+#include "6301.h"
+#include "core1_link.h"
+#include "sys_clock.h"
+#include "config.h"
+#include <string.h>
+
+// Fakes for the hardware behind the tunables. NVSettings counts how often it
+// is built, SerialPort and the clock remember what they were asked for.
+static Settings flash;
+static int nv_constructed;
+static int nv_writes;
+
+NVSettings::NVSettings() {
+    nv_constructed++;
+}
+
+Settings& NVSettings::get_settings() {
+    return flash;
+}
+
+void NVSettings::write() {
+    nv_writes++;
+}
+
+void NVSettings::read() {
+}
+
+static uint32_t serial_baud = IKBD_BAUD_DEFAULT;
+
+SerialPort::~SerialPort() {
+}
+
+SerialPort& SerialPort::instance() {
+    static SerialPort port;
+    return port;
+}
+
+bool SerialPort::baud_supported(uint32_t baud) {
+    return baud == 7812 || baud == 15625 || baud == 31250 || baud == 62500;
+}
+
+bool SerialPort::set_baud(uint32_t baud) {
+    if (!baud_supported(baud)) {
+        return false;
+    }
+    serial_baud = baud;
+    return true;
+}
+
+uint32_t SerialPort::get_baud() const {
+    return serial_baud;
+}
+
+static int overclock = HD6301_OVERCLOCK_NUM;
+static uint32_t cycles_per_loop = CYCLES_PER_LOOP;
+static uint32_t active_khz = DEFAULT_CPU_CLOCK_KHZ;
+static bool clock_refuses;
+static bool core1_up;
+static int core1_pauses;
+
+extern "C" {
+
+void hd6301_set_overclock(int mult) {
+    overclock = mult;
+}
+
+int hd6301_get_overclock(void) {
+    return overclock;
+}
+
+void core1_set_cycles_per_loop(uint32_t cycles) {
+    cycles_per_loop = cycles;
+}
+
+uint32_t core1_get_cycles_per_loop(void) {
+    return cycles_per_loop;
+}
+
+void core1_pause_for_bt_enumeration(void) {
+    core1_pauses++;
+}
+
+void core1_resume_after_bt_enumeration(void) {
+}
+
+void core1_wait_for_pause_active(uint32_t timeout_ms) {
+    (void)timeout_ms;
+}
+
+bool core1_launched(void) {
+    return core1_up;
+}
+
+bool sys_clock_set_khz(uint32_t khz) {
+    if (clock_refuses) {
+        return false;
+    }
+    active_khz = khz;
+    return true;
+}
+
+uint32_t sys_clock_get_khz(void) {
+    return active_khz;
+}
+
+void hid_request_ui_refresh(void) {
+}
+
+}
+
+static void test_lazy_settings(void) {
+    // Nothing touched flash before main(); the first init builds NVSettings
+    CHECK_EQ(nv_constructed, 0);
+    tunables_init();
+    CHECK_EQ(nv_constructed, 1);
+    tunables_init();
+    CHECK_EQ(nv_constructed, 1);
+    CHECK_EQ(nv_writes, 0);
+}
+
+static void test_find(void) {
+    CHECK(tunable_find("cpu_khz") != nullptr);
+    CHECK(tunable_find("cpu") == nullptr);
+    CHECK(tunable_find("") == nullptr);
+    CHECK(tunable_at(-1) == nullptr);
+    CHECK(tunable_at(tunable_count()) == nullptr);
+    for (int i = 0; i < tunable_count(); ++i) {
+        const Tunable* t = tunable_at(i);
+        CHECK(tunable_find(t->name) == t);
+        CHECK(t->min <= t->def && t->def <= t->max);
+        CHECK(t->nv_slot < NV_TUNABLE_SLOTS);
+        for (int j = 0; j < i; ++j) {
+            CHECK(t->nv_slot < 0 || tunable_at(j)->nv_slot != t->nv_slot);
+        }
+    }
+}
+
+static void test_set_range(void) {
+    const Tunable* t = tunable_find("overclock");
+    CHECK(tunable_set(t, 4));
+    CHECK_EQ(t->get(), 4);
+    CHECK_EQ(overclock, 4);
+    // Out of range never reaches the setter
+    CHECK(!tunable_set(t, t->max + 1));
+    CHECK(!tunable_set(t, t->min - 1));
+    CHECK_EQ(overclock, 4);
+    CHECK(!tunable_set(nullptr, 1));
+    tunable_set(t, t->def);
+}
+
+static void test_set_refused(void) {
+    const Tunable* t = tunable_find("cpu_khz");
+    clock_refuses = true;
+    CHECK(!tunable_set(t, 200000));
+    clock_refuses = false;
+    CHECK_EQ(t->get(), DEFAULT_CPU_CLOCK_KHZ);
+
+    // The baud setter refuses rates the UART cannot make
+    const Tunable* b = tunable_find("ikbd_baud");
+    CHECK(!tunable_set(b, 9600));
+    CHECK(tunable_set(b, 31250));
+    CHECK_EQ(serial_baud, 31250);
+    tunable_set(b, IKBD_BAUD_DEFAULT);
+}
+
+static void test_save_and_restore(void) {
+    const Tunable* cpu = tunable_find("cpu_khz");
+    const Tunable* oc = tunable_find("overclock");
+    CHECK(tunable_set(cpu, 200000));
+    CHECK(tunable_set(oc, 3));
+    tunables_save();
+    CHECK_EQ(nv_writes, 1);
+    CHECK_EQ(flash.tunable_magic, NV_TUNABLE_MAGIC);
+    CHECK_EQ(flash.tunables[cpu->nv_slot], 200000);
+
+    tunables_defaults();
+    CHECK_EQ(cpu->get(), cpu->def);
+    CHECK_EQ(overclock, oc->def);
+
+    // A saved value the hardware no longer accepts falls back to the default
+    flash.tunables[oc->nv_slot] = oc->max + 1;
+    tunables_init();
+    CHECK_EQ(cpu->get(), 200000);
+    CHECK_EQ(overclock, oc->def);
+    tunables_defaults();
+}
+
+static void test_baud_pauses_only_once_running(void) {
+    const Tunable* b = tunable_find("ikbd_baud");
+    CHECK(tunable_set(b, 31250));
+    tunables_save();
+
+    // Boot: the saved rate is applied directly, Core 1 is not up yet
+    tunable_set(b, IKBD_BAUD_DEFAULT);
+    core1_pauses = 0;
+    tunables_init();
+    CHECK_EQ(serial_baud, 31250);
+    CHECK_EQ(core1_pauses, 0);
+
+    // Console: Core 1 is parked around the change
+    core1_up = true;
+    CHECK(tunable_set(b, 62500));
+    CHECK_EQ(serial_baud, 62500);
+    CHECK_EQ(core1_pauses, 1);
+    core1_up = false;
+    tunables_defaults();
+}
+
+int main() {
+    test_lazy_settings();
+    test_find();
+    test_set_range();
+    test_set_refused();
+    test_save_and_restore();
+    test_baud_pauses_only_once_running();
+    return test_report("tunables");
+}
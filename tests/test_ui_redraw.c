@@ -0,0 +1,106 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ * The OLED redraw rate under the loads UserInterface::update() sees: a 10 ms
+ * main loop tick, device changes every tick, a serial flood, button presses.
+ */
+#include "test.h"
+#include "ui_redraw.h"
+#include "config.h"
+#include "pico/time.h"
+
+// UserInterface::PAGE
+enum { SPLASH, DEVICES, MAPPING, TELEMETRY, SERIAL, USB_DEBUG, PRO_INIT };
+
+#define TICK_US     10000
+
+static ui_redraw_t r;
+
+// Run the update loop for ms on page, invalidating pages every tick.
+// Returns the redraws.
+static int run(int page, int ms, uint32_t pages) {
+    int redraws = 0;
+    for (int t = 0; t < ms * 1000; t += TICK_US) {
+        ui_redraw_invalidate(&r, pages);
+        if (ui_redraw_due(&r, page, host_time_us)) {
+            redraws++;
+        }
+        host_time_us += TICK_US;
+    }
+    return redraws;
+}
+
+static void test_first_update_draws(void) {
+    host_time_us = 1000000;
+    ui_redraw_init(&r);
+    CHECK(ui_redraw_due(&r, SPLASH, host_time_us));
+    CHECK(!ui_redraw_due(&r, SPLASH, host_time_us));
+    host_time_us += UI_REDRAW_MIN_MS * 1000;
+    CHECK(!ui_redraw_due(&r, SPLASH, host_time_us));    // Drawn and clean
+}
+
+static void test_device_churn(void) {
+    // A device change every tick: one redraw per UI_REDRAW_MIN_MS, not per tick
+    ui_redraw_init(&r);
+    int redraws = run(DEVICES, 10000, (1u << DEVICES) | (1u << MAPPING));
+    CHECK_EQ(redraws, 10000 / UI_REDRAW_MIN_MS);
+
+    // Then quiet: the last change is drawn, and nothing after it
+    CHECK_EQ(run(DEVICES, 10000, 0), 1);
+}
+
+static void test_live_page(void) {
+    // Telemetry redraws on its own, once per UI_LIVE_REFRESH_MS
+    ui_redraw_init(&r);
+    CHECK_EQ(run(TELEMETRY, 10000, 0), 10000 / UI_LIVE_REFRESH_MS);
+    CHECK_EQ(run(USB_DEBUG, 1000, 0), 1000 / UI_REDRAW_MIN_MS);
+}
+
+static void test_serial_flood(void) {
+    // About 78 bytes per tick at 7812 bytes/s, each dirtying the serial page:
+    // on screen it redraws once per UI_LIVE_REFRESH_MS
+    ui_redraw_init(&r);
+    CHECK_EQ(run(SERIAL, 10000, 1u << SERIAL), 10000 / UI_LIVE_REFRESH_MS);
+
+    // Hidden, the flood draws nothing, and the page is stale when shown
+    CHECK_EQ(run(DEVICES, 10000, 1u << SERIAL), 1);     // The first draw of DEVICES
+    CHECK(ui_redraw_due(&r, SERIAL, host_time_us + UI_LIVE_REFRESH_MS * 1000));
+}
+
+static void test_button_bypasses_limit(void) {
+    ui_redraw_init(&r);
+    CHECK(ui_redraw_due(&r, MAPPING, host_time_us));
+    host_time_us += TICK_US;
+    ui_redraw_invalidate(&r, 1u << MAPPING);
+    CHECK(!ui_redraw_due(&r, MAPPING, host_time_us));   // Rate limited
+    ui_redraw_now(&r, MAPPING);
+    CHECK(ui_redraw_due(&r, MAPPING, host_time_us));
+    host_time_us += TICK_US;
+    CHECK(!ui_redraw_due(&r, MAPPING, host_time_us));   // And the limit starts again
+}
+
+int main(void) {
+    test_first_update_draws();
+    test_device_churn();
+    test_live_page();
+    test_serial_flood();
+    test_button_bypasses_limit();
+    return test_report("ui_redraw");
+}
@@ -0,0 +1,247 @@
+/*
+ * Atari ST RP2040 IKBD Emulator
+ * Copyright (C) 2021 Roy Hopkins
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+#include <string.h>
+#include "test.h"
+#include "xinput_host.h"
+#include "telemetry.h"
+
+#define DEV         1
+#define EP_OUT      0x02
+#define EP_IN       0x81
+
+#define GIP_CMD_ACK         0x01
+#define GIP_CMD_ANNOUNCE    0x02
+#define GIP_CMD_POWER       0x05
+#define GIP_CMD_VIRTUAL_KEY 0x07
+#define GIP_CMD_RUMBLE      0x09
+#define GIP_CMD_INPUT       0x20
+#define GIP_OPT_ACK         0x10
+
+// Fake host stack: one transfer per endpoint, completed by the test
+static bool out_busy, in_busy;
+static uint8_t* in_buf;
+static uint8_t sent[16][64];
+static uint16_t sent_len[16];
+static int sent_count;
+static int reports;
+
+void tuh_task(void) {
+}
+
+bool tuh_vid_pid_get(uint8_t dev_addr, uint16_t* vid, uint16_t* pid) {
+    (void)dev_addr;
+    *vid = 0x045e;
+    *pid = 0x0b12;      // Series pad: power on and init, no extra steps
+    return true;
+}
+
+bool tuh_edpt_open(uint8_t dev_addr, const tusb_desc_endpoint_t* desc_ep) {
+    (void)dev_addr; (void)desc_ep;
+    return true;
+}
+
+bool usbh_edpt_claim(uint8_t dev_addr, uint8_t ep_addr) {
+    (void)dev_addr;
+    bool* busy = (ep_addr == EP_IN) ? &in_busy : &out_busy;
+    if (*busy) {
+        return false;
+    }
+    *busy = true;
+    return true;
+}
+
+bool usbh_edpt_release(uint8_t dev_addr, uint8_t ep_addr) {
+    (void)dev_addr;
+    *((ep_addr == EP_IN) ? &in_busy : &out_busy) = false;
+    return true;
+}
+
+bool usbh_edpt_xfer(uint8_t dev_addr, uint8_t ep_addr, uint8_t* buffer, uint16_t total_bytes) {
+    (void)dev_addr;
+    if (ep_addr == EP_IN) {
+        in_buf = buffer;
+    } else if (sent_count < 16) {
+        memcpy(sent[sent_count], buffer, total_bytes);
+        sent_len[sent_count++] = total_bytes;
+    }
+    return true;
+}
+
+bool usbh_edpt_busy(uint8_t dev_addr, uint8_t ep_addr) {
+    (void)dev_addr;
+    return (ep_addr == EP_IN) ? in_busy : out_busy;
+}
+
+void usbh_driver_set_config_complete(uint8_t dev_addr, uint8_t itf_num) {
+    (void)dev_addr; (void)itf_num;
+}
+
+void tuh_xinput_report_received_cb(uint8_t dev_addr, uint8_t instance, xinputh_interface_t const* xid_itf, uint16_t len) {
+    (void)dev_addr; (void)instance; (void)xid_itf; (void)len;
+    reports++;
+}
+
+static const xinputh_interface_t* itf;
+
+void tuh_xinput_mount_cb(uint8_t dev_addr, uint8_t instance, const xinputh_interface_t* xinput_itf) {
+    (void)dev_addr; (void)instance;
+    itf = xinput_itf;
+}
+
+// The OUT transfer on the wire finishes; the stack frees the endpoint first
+static void out_done(void) {
+    CHECK(out_busy);
+    out_busy = false;
+    usbh_xinput_driver.xfer_cb(DEV, EP_OUT, XFER_RESULT_SUCCESS, sent_len[sent_count - 1]);
+}
+
+// The pad sends a packet
+static void in_packet(const uint8_t* pkt, uint16_t len) {
+    if (!in_busy) {
+        CHECK(tuh_xinput_receive_report(DEV, 0));
+    }
+    memcpy(in_buf, pkt, len);
+    in_busy = false;
+    usbh_xinput_driver.xfer_cb(DEV, EP_IN, XFER_RESULT_SUCCESS, len);
+}
+
+static void mount(void) {
+    static const uint8_t desc[] = {
+        9, TUSB_DESC_INTERFACE, 0, 0, 2, 0xFF, 0x47, 0xD0, 0,
+        7, TUSB_DESC_ENDPOINT, EP_OUT, 3, 64, 0, 1,
+        7, TUSB_DESC_ENDPOINT, EP_IN, 3, 64, 0, 1,
+    };
+    usbh_xinput_driver.close(DEV);
+    out_busy = in_busy = false;
+    sent_count = 0;
+    CHECK(usbh_xinput_driver.open(0, DEV, (const tusb_desc_interface_t*)desc, sizeof(desc)));
+    CHECK(usbh_xinput_driver.set_config(DEV, 0));
+}
+
+static void test_init_script(void) {
+    mount();
+    // Power on goes out at once, the next step only once it has been sent
+    CHECK_EQ(sent_count, 1);
+    CHECK_EQ(sent[0][0], GIP_CMD_POWER);
+    uint8_t seq = sent[0][2];
+    out_done();
+    CHECK_EQ(sent_count, 2);
+    CHECK_EQ(sent[1][2], (uint8_t)(seq + 1));
+    out_done();
+    CHECK_EQ(sent_count, 2);
+    CHECK(!out_busy);
+}
+
+static void test_ack_goes_first(void) {
+    const uint8_t needs_ack[] = { 0x03, GIP_OPT_ACK | 0x20, 0x42, 0x00 };
+    uint32_t acks = telemetry_counter(TM_XBOX_GIP_ACKS);
+    mount();
+    in_packet(needs_ack, sizeof(needs_ack));
+    CHECK_EQ(sent_count, 1);                    // Power on still on the wire
+
+    out_done();
+    CHECK_EQ(sent_count, 2);
+    CHECK_EQ(sent[1][0], GIP_CMD_ACK);
+    CHECK_EQ(sent[1][2], 0x42);                 // Echoes the sequence number
+    CHECK_EQ(sent[1][5], 0x03);                 // and the command
+    CHECK_EQ(telemetry_counter(TM_XBOX_GIP_ACKS), acks + 1);
+
+    out_done();                                 // Then the script carries on
+    CHECK_EQ(sent_count, 3);
+    CHECK_EQ(sent[2][0], GIP_CMD_POWER);
+    CHECK(sent[2][3] > 1);                      // The init packet
+    out_done();
+    CHECK(!out_busy);
+}
+
+static void test_announce_restarts(void) {
+    const uint8_t announce[] = { GIP_CMD_ANNOUNCE, 0x20, 0x01, 0x00 };
+    mount();
+    // Announced while power on is on the wire: that send must not count
+    // as the first step of the new script
+    in_packet(announce, sizeof(announce));
+    CHECK_EQ(sent_count, 1);
+    out_done();
+    CHECK_EQ(sent_count, 2);
+    CHECK_EQ(sent[1][3], 1);                    // Power on again
+    out_done();
+    CHECK_EQ(sent_count, 3);
+    CHECK(sent[2][3] > 1);
+    out_done();
+    CHECK_EQ(sent_count, 3);
+}
+
+static void test_rumble_queue(void) {
+    mount();
+    out_done();
+    out_done();
+    sent_count = 0;
+
+    // One on the wire, the rest wait; beyond the queue depth they are dropped
+    for (int i = 0; i < 6; i++) {
+        CHECK(tuh_xinput_set_rumble(DEV, 0, 200, 100, true));
+    }
+    CHECK_EQ(sent_count, 1);
+    CHECK_EQ(sent[0][0], GIP_CMD_RUMBLE);
+    CHECK_EQ(sent[0][8], 100);
+    CHECK_EQ(sent[0][9], 50);
+    for (int i = 0; i < 6 && out_busy; i++) {
+        out_done();
+    }
+    CHECK_EQ(sent_count, 4);
+}
+
+static void test_input(void) {
+    uint8_t in[18] = { GIP_CMD_INPUT, 0x00, 0x01, 14 };
+    const uint8_t guide_down[] = { GIP_CMD_VIRTUAL_KEY, 0x20, 0x02, 0x02, 0x01, 0x5B };
+    mount();
+    out_done();
+    out_done();
+    reports = 0;
+
+    in[4] = 1 << 4;                             // A
+    in_packet(in, sizeof(in));
+    CHECK_EQ(reports, 1);
+    CHECK_EQ(itf->pad.wButtons, XINPUT_GAMEPAD_A);
+
+    // The same state again is counted and dropped
+    uint32_t dups = telemetry_counter(TM_XBOX_GIP_DUPS);
+    in[2]++;
+    in_packet(in, sizeof(in));
+    CHECK_EQ(reports, 1);
+    CHECK_EQ(telemetry_counter(TM_XBOX_GIP_DUPS), dups + 1);
+
+    // Guide comes in its own packet and survives the next input packet
+    in_packet(guide_down, sizeof(guide_down));
+    CHECK_EQ(reports, 2);
+    in[4] = 0;
+    in_packet(in, sizeof(in));
+    CHECK_EQ(reports, 3);
+    CHECK_EQ(itf->pad.wButtons, XINPUT_GAMEPAD_GUIDE);
+}
+
+int main(void) {
+    usbh_xinput_driver.init();
+    test_init_script();
+    test_ack_goes_first();
+    test_announce_restarts();
+    test_rumble_queue();
+    test_input();
+    return test_report("xinput_gip");
+}